@@ -24,13 +24,16 @@
 #include <Protocol/SimpleWindowManager.h>
 #include <Protocol/DfciSettingAccess.h>
 #include <Protocol/MsFrontPageAuthTokenProtocol.h>
+#include <Protocol/VariableWrite.h>
 
+#include <Library/BaseLib.h>
 #include <Library/DebugLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/HiiLib.h>
 #include <Library/MsBootOptionsLib.h>
 #include <Library/PrintLib.h>
+#include <Library/SortLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
@@ -44,6 +47,12 @@
 
 #include <Settings/BootMenuSettings.h>
 
+#include "BootOptionCache.h"
+#include "BootOptionJournal.h"
+#include "BootOptionPrompts.h"
+#include "DefaultBootOptions.h"
+#include "SettingsSnapshot.h"
+
 #define BOOT_MENU_SIGNATURE  SIGNATURE_32 ('u', 'n', 'm', 'B')
 
 #define MAX_MSG_SIZE_CAPTION  100
@@ -61,16 +70,12 @@ typedef struct {
 #pragma pack()
 
 // Global variables
-EFI_BOOT_MANAGER_LOAD_OPTION  *mBootOptions           = NULL;
-UINTN                         mBootOptionCount        = 0;
-EFI_BOOT_MANAGER_LOAD_OPTION  *mDefaultLoadOptions    = NULL;
-UINTN                         mDefaultLoadOptionCount = 0;
+EFI_BOOT_MANAGER_LOAD_OPTION  *mBootOptions    = NULL;        // Shallow copy of the cached boot options.
+UINTN                         mBootOptionCount = 0;
 
 // VarStore for each of the section in the VFR
 ORDER_MENU_CONFIGURATION                mOrderConfiguration;
-SETTINGS_MENU_CONFIGURATION             mSettingsConfiguration;
-SETTINGS_GRAYOUT_CONFIGURATION          mSettingsGrayoutConfiguration;
-SETTINGS_SUPPRESS_CONFIGURATION         mSettingsSuppressConfiguration;
+BOOT_SETTINGS_CONFIGURATION             mSettingsConfiguration;
 BOOLEAN                                 mForcingExit = FALSE;
 MS_SIMPLE_WINDOW_MANAGER_PROTOCOL       *mSWMProtocol;
 EFI_EVENT                               mSWMRegisterEvent;
@@ -79,10 +84,23 @@ EFI_EVENT                               mSettingAccessRegisterEvent;
 VOID                                    *mSettingAccessRegistration;
 DFCI_SETTING_ACCESS_PROTOCOL            *mSettingAccess;
 DFCI_AUTH_TOKEN                         mAuthToken;
+
+//
+// The DFCI settings on the settings form, indexed by BOOT_SETTING_*.  They are read together,
+// see SettingsSnapshot.h.
+//
+STATIC CONST DFCI_SETTING_ID_STRING  mMenuSettingIds[BOOT_SETTING_COUNT] = {
+  DFCI_SETTING_ID__IPV6,
+  DFCI_SETTING_ID__ALT_BOOT,
+  DFCI_SETTING_ID__BOOT_ORDER_LOCK,
+  DFCI_SETTING_ID__ENABLE_USB_BOOT
+};
+
 EDKII_FORM_BROWSER_EXTENSION2_PROTOCOL  *mBrowserEx2;
 EFI_EVENT                               mAuthTokenRegisterEvent;
 VOID                                    *mAuthTokenRegistration;
 FRONT_PAGE_AUTH_TOKEN_PROTOCOL          *mAuthTokenProtocol;
+VOID                                    *mVariableWriteRegistration;
 
 HII_VENDOR_DEVICE_PATH  mHiiVendorDevicePath = {
   {
@@ -106,7 +124,40 @@ HII_VENDOR_DEVICE_PATH  mHiiVendorDevicePath = {
   }
 };
 
-#define mBootOptionLimit  ((UINT8) MIN (mBootOptionCount, MAX_BOOT_OPTIONS_SUPPORTED))
+//
+// The boot options shown in the boot order list, as indexes into mBootOptions in list order.
+//
+UINTN  mOrderOptionIndex[MAX_BOOT_OPTIONS_SUPPORTED];
+UINTN  mOrderOptionCount = 0;
+
+//
+// The prompts of the listed options, and the options last published to the form.
+//
+EFI_STRING_ID  mOrderOptionPrompt[MAX_BOOT_OPTIONS_SUPPORTED];
+EFI_STRING_ID  mPublishedPrompt[MAX_BOOT_OPTIONS_SUPPORTED];
+UINT32         mPublishedValue[MAX_BOOT_OPTIONS_SUPPORTED];
+UINTN          mPublishedCount = 0;
+BOOLEAN        mPublished      = FALSE;
+
+//
+// Key used to look up a listed boot option by option number.
+//
+typedef struct {
+  UINT16    OptionNumber;
+  UINTN     BootOption;                   // Index into mBootOptions.
+} ORDER_OPTION_KEY;
+
+//
+// Changes are made to a working copy and only written by CommitBootMenuChanges ().  While
+// mBootOrderPending is set, mBootOptions holds the edited boot options in their new order and
+// is not reread from the variables.
+//
+BOOLEAN                      mBootOrderPending   = FALSE;
+UINT16                       *mDeletedOptions    = NULL;
+UINTN                        mDeletedOptionCount = 0;
+BOOLEAN                      mSettingsPending    = FALSE;
+BOOLEAN                      mSettingsCommitted[BOOT_SETTING_COUNT]; // Setting values as last read or written.
+UINTN                        mNvWritesRequested = 0;                 // Writes the edits would have made one at a time.
 
 EFI_STATUS
 EFIAPI
@@ -136,6 +187,11 @@ DriverCallback (
   OUT EFI_BROWSER_ACTION_REQUEST            *ActionRequest
   );
 
+VOID
+CommitBootMenuChanges (
+  VOID
+  );
+
 typedef struct {
   UINTN                             Signature;
   EFI_HANDLE                        DriverHandle;
@@ -247,35 +303,32 @@ AuthTokenCallback (
   return;
 }
 
-BOOLEAN
-IsDefaultBootOption (
-  EFI_BOOT_MANAGER_LOAD_OPTION  *BootOption
-  )
-{
-  UINT32   CurrentAttributes;
-  BOOLEAN  IsDefault;
+/**
+Variable Write registration notification callback
 
-  mDefaultLoadOptions = MsBootOptionsLibGetDefaultOptions (&mDefaultLoadOptionCount);
-  if (NULL == mDefaultLoadOptions) {
-    DEBUG ((DEBUG_ERROR, "%a Error obtaining default boot options\n", __FUNCTION__));
-    return FALSE;
-  }
+@param[in] Event      Event that signalled the callback.
+@param[in] Context    Pointer to an optional event contxt.
 
-  // The actual boot option may have LOAD_OPTION_ACTIVE set or off.  Check for both.
-  CurrentAttributes       = BootOption->Attributes;
-  BootOption->Attributes |= LOAD_OPTION_ACTIVE;
-  IsDefault               = (-1 != EfiBootManagerFindLoadOption (BootOption, mDefaultLoadOptions, mDefaultLoadOptionCount));
-  if (!IsDefault) {
-    BootOption->Attributes &= ~LOAD_OPTION_ACTIVE;
-    IsDefault               = (-1 != EfiBootManagerFindLoadOption (BootOption, mDefaultLoadOptions, mDefaultLoadOptionCount));
-  }
+@retval None.
 
-  // Restore attributes
-  BootOption->Attributes = CurrentAttributes;
+**/
+VOID
+EFIAPI
+VariableWriteCallback (
+  IN  EFI_EVENT  Event,
+  IN  VOID       *Context
+  )
+{
+  EFI_STATUS  Status;
+  VOID        *Interface;
 
-  EfiBootManagerFreeLoadOptions (mDefaultLoadOptions, mDefaultLoadOptionCount);
+  Status = gBS->LocateProtocol (&gEfiVariableWriteArchProtocolGuid, NULL, &Interface);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
 
-  return IsDefault;
+  ReplayBootOptionJournal ();
+  gBS->CloseEvent (Event);
 }
 
 /**
@@ -287,24 +340,96 @@ RebuildOrderList (
   VOID
   )
 {
-  EFI_STATUS          Status;
-  VOID                *StartOpCodeHandle;
-  VOID                *EndOpCodeHandle;
-  VOID                *OptionsOpCodeHandle;
-  EFI_IFR_GUID_LABEL  *StartLabel;
-  EFI_IFR_GUID_LABEL  *EndLabel;
-  EFI_STRING_ID       Prompt;
-  UINTN               Index;
-  UINT32              OptionValue;
-  UINT8               *OpcodeBuffer;
-
-  if (mBootOptions != NULL) {
-    EfiBootManagerFreeLoadOptions (mBootOptions, mBootOptionCount);
-    mBootOptions = NULL;
+  EFI_STATUS                          Status;
+  VOID                                *StartOpCodeHandle;
+  VOID                                *EndOpCodeHandle;
+  VOID                                *OptionsOpCodeHandle;
+  EFI_IFR_GUID_LABEL                  *StartLabel;
+  EFI_IFR_GUID_LABEL                  *EndLabel;
+  EFI_STRING_ID                       Prompt;
+  UINTN                               Index;
+  UINT32                              OptionValue;
+  UINT8                               *OpcodeBuffer;
+  BOOLEAN                             PromptsChanged;
+  CONST EFI_BOOT_MANAGER_LOAD_OPTION  *BootOptions;
+
+  if (!mBootOrderPending) {
+    if (mBootOptions != NULL) {
+      FreePool (mBootOptions);
+      mBootOptions = NULL;
+    }
+
+    if (mDeletedOptions != NULL) {
+      FreePool (mDeletedOptions);
+    }
+
+    BootOptions  = GetBootOptionsView (&mBootOptionCount, NULL);
+    mBootOptions = (EFI_BOOT_MANAGER_LOAD_OPTION *)AllocateZeroPool (sizeof (EFI_BOOT_MANAGER_LOAD_OPTION) * MAX (mBootOptionCount, 1));
+    if (mBootOptions == NULL) {
+      mBootOptionCount = 0;
+    } else if (mBootOptionCount != 0) {
+      CopyMem (mBootOptions, BootOptions, sizeof (EFI_BOOT_MANAGER_LOAD_OPTION) * mBootOptionCount);
+    }
+
+    mDeletedOptions     = (UINT16 *)AllocateZeroPool (sizeof (UINT16) * MAX (mBootOptionCount, 1));
+    mDeletedOptionCount = 0;
+    ASSERT (mDeletedOptions != NULL);
   }
 
   ZeroMem (&mOrderConfiguration.OrderOptions, sizeof (mOrderConfiguration.OrderOptions));
 
+  mOrderOptionCount = 0;
+  PromptsChanged    = FALSE;
+  StartBootOptionPrompts ();
+
+  for (Index = 0; Index < mBootOptionCount; Index++) {
+    //
+    // Don't display the hidden/inactive boot options.
+    //
+    if (((mBootOptions[Index].Attributes & LOAD_OPTION_HIDDEN) != 0) ||
+        ((mBootOptions[Index].Attributes & LOAD_OPTION_CATEGORY_APP) != 0))
+    {
+      continue;
+    }
+
+    if (mOrderOptionCount == MAX_BOOT_OPTIONS_SUPPORTED) {
+      DEBUG ((DEBUG_ERROR, "%a More than %d boot options.  Boot%04x and later are not shown.\n", __FUNCTION__, MAX_BOOT_OPTIONS_SUPPORTED, mBootOptions[Index].OptionNumber));
+      break;
+    }
+
+    ASSERT (mBootOptions[Index].Description != NULL);
+
+    Prompt = GetBootOptionPrompt (mBootMenuPrivate.HiiHandle, &mBootOptions[Index], &PromptsChanged);
+
+    DEBUG ((DEBUG_INFO, "%a Indx=%d, Hash=%x, Attr=%x, %s\n", __FUNCTION__, Index, mBootOptions[Index].OptionNumber, mBootOptions[Index].Attributes, mBootOptions[Index].Description));
+
+    OptionValue = (UINT32)(mBootOptions[Index].OptionNumber + 1);
+    if ((mBootOptions[Index].Attributes & LOAD_OPTION_ACTIVE) == LOAD_OPTION_ACTIVE) {
+      OptionValue |= ORDERED_LIST_CHECKBOX_VALUE_32;
+    }
+
+    if (!IsDefaultBootOption (&mBootOptions[Index])) {
+      OptionValue |= ORDERED_LIST_ALLOW_DELETE_VALUE_32;
+    }
+
+    mOrderConfiguration.OrderOptions[mOrderOptionCount] = OptionValue;
+    mOrderOptionPrompt[mOrderOptionCount]               = Prompt;
+    mOrderOptionIndex[mOrderOptionCount++]              = Index;
+  }
+
+  EndBootOptionPrompts ();
+
+  //
+  // The form only needs to be updated when an option was added, removed or changed.
+  //
+  if (mPublished && !PromptsChanged && (mPublishedCount == mOrderOptionCount) &&
+      (CompareMem (mPublishedValue, mOrderConfiguration.OrderOptions, sizeof (UINT32) * mOrderOptionCount) == 0) &&
+      (CompareMem (mPublishedPrompt, mOrderOptionPrompt, sizeof (EFI_STRING_ID) * mOrderOptionCount) == 0))
+  {
+    DEBUG ((DEBUG_INFO, "%a Boot order list is unchanged\n", __FUNCTION__));
+    return;
+  }
+
   //
   // Init OpCode Handle and Allocate space for creation of UpdateData Buffer
   //
@@ -332,47 +457,15 @@ RebuildOrderList (
   StartLabel->Number = LABEL_ORDER_OPTIONS;
   EndLabel->Number   = LABEL_ORDER_END;
 
-  mBootOptions = EfiBootManagerGetLoadOptions (&mBootOptionCount, LoadOptionTypeBoot);
-
-  for (Index = 0; Index < mBootOptionLimit; Index++) {
-    //
-    // Don't display the hidden/inactive boot options.
-    //
-    if (((mBootOptions[Index].Attributes & LOAD_OPTION_HIDDEN) != 0) ||
-        ((mBootOptions[Index].Attributes & LOAD_OPTION_CATEGORY_APP) != 0))
-    {
-      continue;
-    }
-
-    ASSERT (mBootOptions[Index].Description != NULL);
-
-    Prompt = HiiSetString (
-               mBootMenuPrivate.HiiHandle,
-               0,
-               mBootOptions[Index].Description,
-               NULL
-               );
-
-    DEBUG ((DEBUG_INFO, "%a Indx=%d, Hash=%x, Attr=%x, %s\n", __FUNCTION__, Index, mBootOptions[Index].OptionNumber, mBootOptions[Index].Attributes, mBootOptions[Index].Description));
-
-    OptionValue = (UINT32)(mBootOptions[Index].OptionNumber + 1);
-    if ((mBootOptions[Index].Attributes & LOAD_OPTION_ACTIVE) == LOAD_OPTION_ACTIVE) {
-      OptionValue |= ORDERED_LIST_CHECKBOX_VALUE_32;
-    }
-
-    if (!IsDefaultBootOption (&mBootOptions[Index])) {
-      OptionValue |= ORDERED_LIST_ALLOW_DELETE_VALUE_32;
-    }
-
+  for (Index = 0; Index < mOrderOptionCount; Index++) {
     OpcodeBuffer = HiiCreateOneOfOptionOpCode (
                      OptionsOpCodeHandle,
-                     Prompt,
+                     mOrderOptionPrompt[Index],
                      EFI_IFR_FLAG_CALLBACK,
                      EFI_IFR_TYPE_NUM_SIZE_32,
-                     OptionValue
+                     mOrderConfiguration.OrderOptions[Index]
                      );
     ASSERT (OpcodeBuffer != NULL);
-    mOrderConfiguration.OrderOptions[Index] = OptionValue;
   }
 
   OpcodeBuffer = HiiCreateOrderedListOpCode (
@@ -385,7 +478,7 @@ RebuildOrderList (
                    EFI_IFR_FLAG_CALLBACK,        // OPTIONS_ONLY is unused - means combo ListBox
                    EFI_IFR_UNIQUE_SET | EMBEDDED_CHECKBOX | EMBEDDED_DELETE,
                    EFI_IFR_NUMERIC_SIZE_4,
-                   mBootOptionLimit,
+                   (UINT8)mOrderOptionCount,
                    OptionsOpCodeHandle,
                    NULL                        // Default Op Code is NULL
                    );
@@ -401,6 +494,12 @@ RebuildOrderList (
 
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "%a Error in HiiUpdateform.  Code=%r\n", __FUNCTION__, Status));
+    mPublished = FALSE;
+  } else {
+    CopyMem (mPublishedValue, mOrderConfiguration.OrderOptions, sizeof (UINT32) * mOrderOptionCount);
+    CopyMem (mPublishedPrompt, mOrderOptionPrompt, sizeof (EFI_STRING_ID) * mOrderOptionCount);
+    mPublishedCount = mOrderOptionCount;
+    mPublished      = TRUE;
   }
 
   if (StartOpCodeHandle != NULL) {
@@ -522,6 +621,17 @@ BootMenuEntry (
     DEBUG ((DEBUG_INFO, "AuthToken value in Bootmenu %x\n", mAuthToken));
   }
 
+  //
+  // Finish a boot option commit that was cut short, once variables can be written.
+  //
+  EfiCreateProtocolNotifyEvent (
+    &gEfiVariableWriteArchProtocolGuid,
+    TPL_CALLBACK,
+    VariableWriteCallback,
+    NULL,
+    &mVariableWriteRegistration
+    );
+
   //
   // Install Device Path Protocol and Config Access protocol to driver handle
   //
@@ -606,6 +716,7 @@ DriverCallback (
     case EFI_BROWSER_ACTION_FORM_OPEN:
       switch (QuestionId) {
         case MS_BOOT_ORDER_INIT_KEY:
+          InvalidateBootOptionCache ();       // Boot options may have changed since the form was last open.
           RebuildOrderList ();
           Status = EFI_SUCCESS;
           break;
@@ -616,6 +727,9 @@ DriverCallback (
       break;
 
     case EFI_BROWSER_ACTION_FORM_CLOSE:
+      CommitBootMenuChanges ();
+      InvalidateDefaultBootOptions ();
+      InvalidateSettingsSnapshot ();
       if (mForcingExit) {
         mForcingExit = FALSE;
         mBrowserEx2->SetScope (SystemLevel);
@@ -633,7 +747,7 @@ DriverCallback (
           // Ordered ListBox - value points to an array of N U32's(element size), May be terminated by a value of 0.
           if (Type == EFI_IFR_TYPE_BUFFER) {
             BootOrder = (UINT32 *)Value;
-            for (Index = 0; Index < mBootOptionLimit; Index++) {
+            for (Index = 0; Index < mOrderOptionCount; Index++) {
               if (*BootOrder == 0) {
                 break;
               }
@@ -666,6 +780,43 @@ DriverCallback (
   return Status;
 }
 
+/**
+  GetMenuSetting finds a setting in the snapshot of the settings form's settings
+
+  @param  Id                     The setting to find.  One of mMenuSettingIds.
+  @param  Setting                Where to store the snapshot of the setting
+
+  @retval EFI_SUCCESS            *Setting is set.
+  @retval EFI_NOT_FOUND          Id is not a setting of the settings form.
+  @retval                        Others from GetSettingsSnapshot ().
+
+**/
+EFI_STATUS
+GetMenuSetting (
+  IN  DFCI_SETTING_ID_STRING  Id,
+  OUT CONST SETTING_SNAPSHOT  **Setting
+  )
+{
+  EFI_STATUS              Status;
+  CONST SETTING_SNAPSHOT  *Snapshot;
+  UINTN                   Index;
+
+  Status = GetSettingsSnapshot (mSettingAccess, &mAuthToken, mMenuSettingIds, ARRAY_SIZE (mMenuSettingIds), &Snapshot);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a Internal error getting settings - code=%r\n", __FUNCTION__, Status));
+    return Status;
+  }
+
+  for (Index = 0; Index < ARRAY_SIZE (mMenuSettingIds); Index++) {
+    if (AsciiStrCmp (Snapshot[Index].Id, Id) == 0) {
+      *Setting = &Snapshot[Index];
+      return EFI_SUCCESS;
+    }
+  }
+
+  return EFI_NOT_FOUND;
+}
+
 /**
   GetSetting gets a setting from the settings access provider
 
@@ -681,23 +832,19 @@ GetSetting (
   IN UINT8                   *Data
   )
 {
-  EFI_STATUS          Status;
-  DFCI_SETTING_FLAGS  Flags;
-  UINTN               ValueSize;
-
-  ValueSize = sizeof (UINT8);
-  Status    = mSettingAccess->Get (
-                                mSettingAccess,
-                                Id,
-                                &mAuthToken,
-                                DFCI_SETTING_TYPE_ENABLE,
-                                &ValueSize,
-                                Data,
-                                &Flags
-                                );
+  EFI_STATUS              Status;
+  CONST SETTING_SNAPSHOT  *Setting;
+
+  Status = GetMenuSetting (Id, &Setting);
+  if (!EFI_ERROR (Status)) {
+    Status = Setting->Status;
+  }
+
   if (EFI_ERROR (Status)) {
     *Data = TRUE;
-    DEBUG ((DEBUG_ERROR, "%a Internal error getting setting id %d - code=%r\n", __FUNCTION__, Id, Status));
+    DEBUG ((DEBUG_ERROR, "%a Internal error getting setting id %a - code=%r\n", __FUNCTION__, Id, Status));
+  } else {
+    *Data = Setting->Value;
   }
 
   return Status;
@@ -718,30 +865,23 @@ GetSettingGrayoutFlag (
   IN UINT8                   *Data
   )
 {
-  EFI_STATUS          Status;
-  DFCI_SETTING_FLAGS  Flags;
-  UINT8               Temp;
-  UINTN               ValueSize;
-
-  *Data     = FALSE;  // If Get Setting fails, assume Grayed out
-  ValueSize = sizeof (Temp);
-  Status    = mSettingAccess->Get (
-                                mSettingAccess,
-                                Id,
-                                &mAuthToken,
-                                DFCI_SETTING_TYPE_ENABLE,
-                                &ValueSize,
-                                &Temp,
-                                &Flags
-                                );
+  EFI_STATUS              Status;
+  CONST SETTING_SNAPSHOT  *Setting;
+
+  *Data  = FALSE;  // If Get Setting fails, assume Grayed out
+  Status = GetMenuSetting (Id, &Setting);
+  if (!EFI_ERROR (Status)) {
+    Status = Setting->Status;
+  }
+
   if (!EFI_ERROR (Status)) {
-    if ((DFCI_SETTING_FLAGS_OUT_WRITE_ACCESS & Flags) == 0) {
-      mSettingsGrayoutConfiguration.RestrictedAccessString |= TRUE;
+    if ((DFCI_SETTING_FLAGS_OUT_WRITE_ACCESS & Setting->Flags) == 0) {
+      mSettingsConfiguration.RestrictedAccessString |= TRUE;
     } else {
       *Data = TRUE;
     }
   } else {
-    DEBUG ((DEBUG_ERROR, "%a Internal error getting Grayout %d - code=%r\n", __FUNCTION__, Id, Status));
+    DEBUG ((DEBUG_ERROR, "%a Internal error getting Grayout %a - code=%r\n", __FUNCTION__, Id, Status));
   }
 
   return Status;
@@ -762,29 +902,21 @@ GetSettingSuppressFlag (
   IN UINT8                   *Data
   )
 {
-  EFI_STATUS          Status;
-  DFCI_SETTING_FLAGS  Flags;
-  UINT8               Temp;
-  UINTN               ValueSize;
-
-  *Data     = FALSE;  // If Get Setting fails, assume setting is not suppressed
-  ValueSize = sizeof (UINT8);
-  Status    = mSettingAccess->Get (
-                                mSettingAccess,
-                                Id,
-                                &mAuthToken,
-                                DFCI_SETTING_TYPE_ENABLE,
-                                &ValueSize,
-                                &Temp,
-                                &Flags
-                                );
+  EFI_STATUS              Status;
+  CONST SETTING_SNAPSHOT  *Setting;
+
+  Status = GetMenuSetting (Id, &Setting);
+  if (!EFI_ERROR (Status)) {
+    Status = Setting->Status;
+  }
+
   if (EFI_NOT_FOUND == Status) {
     // If the specific error ID_NOT_FOUND
     *Data = TRUE;                  // Suppress this setting as there is no provider
   } else {
     *Data = FALSE;
     if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "%a Internal error getting Suppress %d - code=%r\n", __FUNCTION__, Id, Status));
+      DEBUG ((DEBUG_ERROR, "%a Internal error getting Suppress %a - code=%r\n", __FUNCTION__, Id, Status));
     }
   }
 
@@ -818,13 +950,192 @@ SetSetting (
                              Data,
                              &Flags
                              );
+  InvalidateSettingsSnapshot ();
   if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "Error setting id %d. Code = %r\n", Id, Status));
+    DEBUG ((DEBUG_ERROR, "Error setting id %a. Code = %r\n", Id, Status));
   }
 
   return Status;
 }
 
+/**
+  CommitSetting writes a setting if it changed and can be written
+
+  @param  Id                     The setting.
+  @param  Value                  The new value.
+  @param  Committed              The value as last read or written.  Updated when it is written.
+  @param  Writable               TRUE if the setting can be written (not grayed out).
+
+  @retval                        1 if the setting was written, 0 if it wasn't.
+
+**/
+UINTN
+CommitSetting (
+  IN     DFCI_SETTING_ID_STRING  Id,
+  IN     BOOLEAN                 *Value,
+  IN OUT BOOLEAN                 *Committed,
+  IN     BOOLEAN                 Writable
+  )
+{
+  if (!Writable || (*Value == *Committed)) {
+    return 0;
+  }
+
+  if (!EFI_ERROR (SetSetting (Id, Value))) {
+    *Committed = *Value;
+  }
+
+  return 1;
+}
+
+/**
+  CommitBootMenuChanges writes the changes made in the boot menu since the last commit.
+
+  Only the Boot#### variables and settings that changed are written, and BootOrder if it
+  changed.  Boot option changes are crash-consistent, see BootOptionJournal.h.
+
+**/
+VOID
+CommitBootMenuChanges (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Writes;
+  UINTN       OptionWrites;
+  UINTN       Index;
+
+  Writes = 0;
+
+  if (mBootOrderPending) {
+    Status = CommitBootOptionChanges (mBootOptions, mBootOptionCount, mDeletedOptions, mDeletedOptionCount, &OptionWrites);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a Error committing boot options. Code=%r\n", __FUNCTION__, Status));
+    }
+
+    Writes             += OptionWrites;
+    mBootOrderPending   = FALSE;
+    mDeletedOptionCount = 0;
+    InvalidateDefaultBootOptions ();
+    InvalidateBootOptionCache ();
+  }
+
+  if (mSettingsPending) {
+    for (Index = 0; Index < BOOT_SETTING_COUNT; Index++) {
+      Writes += CommitSetting (mMenuSettingIds[Index], &mSettingsConfiguration.Value[Index], &mSettingsCommitted[Index], mSettingsConfiguration.Writable[Index]);
+    }
+
+    mSettingsPending = FALSE;
+  }
+
+  if (mNvWritesRequested != 0) {
+    DEBUG ((
+      DEBUG_INFO,
+      "%a %lu NV writes for %lu edits, %lu avoided\n",
+      __FUNCTION__,
+      (UINT64)Writes,
+      (UINT64)mNvWritesRequested,
+      (UINT64)((mNvWritesRequested > Writes) ? mNvWritesRequested - Writes : 0)
+      ));
+  }
+
+  mNvWritesRequested = 0;
+}
+
+/**
+  ReorderBootOptions puts the working copy of the boot options in a new order.  Options that are
+  not in the new order are dropped.
+
+  @param  Order                  Indexes into mBootOptions, in the new order.
+  @param  OrderCount             Number of indexes.
+
+  @retval EFI_SUCCESS            mBootOptions is in the new order.
+  @retval EFI_OUT_OF_RESOURCES   mBootOptions is unchanged.
+
+**/
+EFI_STATUS
+ReorderBootOptions (
+  IN CONST UINTN  *Order,
+  IN UINTN        OrderCount
+  )
+{
+  EFI_BOOT_MANAGER_LOAD_OPTION  *Options;
+  UINTN                         Index;
+
+  Options = (EFI_BOOT_MANAGER_LOAD_OPTION *)AllocateZeroPool (sizeof (EFI_BOOT_MANAGER_LOAD_OPTION) * MAX (OrderCount, 1));
+  if (NULL == Options) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  for (Index = 0; Index < OrderCount; Index++) {
+    CopyMem (&Options[Index], &mBootOptions[Order[Index]], sizeof (EFI_BOOT_MANAGER_LOAD_OPTION));
+  }
+
+  FreePool (mBootOptions);
+  mBootOptions     = Options;
+  mBootOptionCount = OrderCount;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Sort compare function for ORDER_OPTION_KEY, by option number.
+
+  @param  Buffer1                The first key.
+  @param  Buffer2                The second key.
+
+  @retval                        <0, 0 or >0 as Buffer1 sorts before, with or after Buffer2.
+
+**/
+INTN
+EFIAPI
+CompareOrderOptionKey (
+  IN CONST VOID  *Buffer1,
+  IN CONST VOID  *Buffer2
+  )
+{
+  return (INTN)((CONST ORDER_OPTION_KEY *)Buffer1)->OptionNumber - (INTN)((CONST ORDER_OPTION_KEY *)Buffer2)->OptionNumber;
+}
+
+/**
+  FindOrderOption looks up a listed boot option by option number
+
+  @param  Keys                   Keys of the listed options, sorted by CompareOrderOptionKey ().
+  @param  KeyCount               Number of keys.
+  @param  OptionNumber           The option number to find.
+
+  @retval                        Index of the option in mBootOptions, or MAX_UINTN if it is not listed.
+
+**/
+UINTN
+FindOrderOption (
+  IN CONST ORDER_OPTION_KEY  *Keys,
+  IN UINTN                   KeyCount,
+  IN UINT16                  OptionNumber
+  )
+{
+  UINTN  Low;
+  UINTN  High;
+  UINTN  Middle;
+
+  Low  = 0;
+  High = KeyCount;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if (Keys[Middle].OptionNumber < OptionNumber) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  if ((Low < KeyCount) && (Keys[Low].OptionNumber == OptionNumber)) {
+    return Keys[Low].BootOption;
+  }
+
+  return MAX_UINTN;
+}
+
 /**
   This function processes the results of changes in configuration.
 
@@ -855,9 +1166,16 @@ RouteConfig (
   EFI_STATUS                       Status;
   UINTN                            Index;
   UINTN                            Index2;
-  UINTN                            NewBootOrderCount;
-  UINT16                           *NewBootOrder;
+  UINTN                            NewOrderCount;
+  UINTN                            *NewOrder = NULL;
   UINT16                           ThisOption;
+  UINTN                            *NewListOrder = NULL;
+  UINTN                            ListCount;
+  UINTN                            BootOption;
+  ORDER_OPTION_KEY                 *OrderKeys = NULL;
+  BOOLEAN                          *Shown     = NULL;
+  BOOLEAN                          *Listed;
+  BOOLEAN                          BootNow = FALSE;
   BOOLEAN                          PrevActive;
   BOOLEAN                          ThisActive;
   EFI_STRING                       pCaption;
@@ -867,12 +1185,10 @@ RouteConfig (
   EFI_STRING                       pMsgBox;
   EFI_STRING                       pTitle;
   SWM_MB_RESULT                    SwmResult = 0;
-  CHAR16                           OptionName[sizeof ("Boot####")];
   BOOLEAN                          AllowSetBootorder = TRUE;
   BOOLEAN                          MsBootNext;
   BOOLEAN                          EnableBootOrderLock = FALSE;
-  SETTINGS_GRAYOUT_CONFIGURATION   TempGrayoutConfiguration;
-  SETTINGS_SUPPRESS_CONFIGURATION  TempSuppressConfiguration;
+  BOOT_SETTINGS_CONFIGURATION      TempSettingsConfiguration;
 
   DEBUG ((DEBUG_INFO, "%a - Configuration=%s\n", __FUNCTION__, Configuration));
   DEBUG ((DEBUG_INFO, "%s", Configuration));
@@ -891,7 +1207,13 @@ RouteConfig (
   }
 
   if (HiiIsConfigHdrMatch (Configuration, &gMsBootMenuFormsetGuid, L"BootOrderConfig")) {
-    Status = GetSetting (DFCI_SETTING_ID__BOOT_ORDER_LOCK, &EnableBootOrderLock);
+    if (mSettingsPending) {
+      EnableBootOrderLock = mSettingsConfiguration.Value[BOOT_SETTING_BOOT_ORDER_LOCK];
+      Status              = EFI_SUCCESS;
+    } else {
+      Status = GetSetting (DFCI_SETTING_ID__BOOT_ORDER_LOCK, &EnableBootOrderLock);
+    }
+
     if (!EFI_ERROR (Status) && EnableBootOrderLock) {
       Status = EFI_SUCCESS;
       DEBUG ((DEBUG_INFO, "%a Boot Order is locked - skipping RouteConfig for BootOrderConfig\n", __FUNCTION__));
@@ -907,138 +1229,158 @@ RouteConfig (
                                     );
 
       if (!EFI_ERROR (Status)) {
-        NewBootOrderCount = 0;
-        NewBootOrder      = (UINT16 *)AllocateZeroPool (sizeof (UINT16) * mBootOptionCount);
-        ASSERT (NewBootOrder != NULL);
+        NewOrderCount = 0;
+        NewOrder      = (UINTN *)AllocateZeroPool (sizeof (UINTN) * MAX (mBootOptionCount, 1));
+        NewListOrder  = (UINTN *)AllocateZeroPool (sizeof (UINTN) * MAX (mOrderOptionCount, 1));
+        OrderKeys     = (ORDER_OPTION_KEY *)AllocateZeroPool (sizeof (ORDER_OPTION_KEY) * MAX (mOrderOptionCount, 1));
+        Shown         = (BOOLEAN *)AllocateZeroPool (sizeof (BOOLEAN) * 2 * mBootOptionCount);
+        ASSERT (NewOrder != NULL);
+        ASSERT (NewListOrder != NULL);
+        ASSERT (OrderKeys != NULL);
+        ASSERT (Shown != NULL);
+
+        if ((NULL == NewOrder) || (NULL == NewListOrder) || (NULL == OrderKeys) || (NULL == Shown)) {
+          Status = EFI_UNSUPPORTED;
+          goto Exit1;
+        }
 
-        if (NULL == NewBootOrder) {
-          return EFI_UNSUPPORTED;
+        //
+        // Index the options in the list by option number, so each entry of the new order is a
+        // binary search instead of a scan of the boot options.
+        //
+        Listed = Shown + mBootOptionCount;
+        for (Index = 0; Index < mOrderOptionCount; Index++) {
+          Shown[mOrderOptionIndex[Index]] = TRUE;
+          OrderKeys[Index].OptionNumber   = (UINT16)mBootOptions[mOrderOptionIndex[Index]].OptionNumber;
+          OrderKeys[Index].BootOption     = mOrderOptionIndex[Index];
         }
 
-        for (Index = 0; Index < mBootOptionCount; Index++) {
-          if (Index < mBootOptionLimit) {
-            if (0 != mOrderConfiguration.OrderOptions[Index]) {
-              ThisOption = (UINT16)(mOrderConfiguration.OrderOptions[Index] - 1);
-              if (mOrderConfiguration.OrderOptions[Index] & ORDERED_LIST_BOOT_VALUE_32) {
-                pTitle   = HiiGetString (mBootMenuPrivate.HiiHandle, STRING_TOKEN (STR_BOOT_BOOT_TITLE), NULL);
-                pCaption = HiiGetString (mBootMenuPrivate.HiiHandle, STRING_TOKEN (STR_BOOT_BOOT_CAPTION), NULL);
-                pConfirm = HiiGetString (mBootMenuPrivate.HiiHandle, STRING_TOKEN (STR_BOOT_BOOT_WARNING), NULL);
-
-                pMsgBox = pConfirm;
-                if (NULL == pMsgBox) {
-                  // Just in case HiiMsg is not available
-                  pMsgBox = L"Are you sure you want to boot %s?";
-                }
-
-                pTempCaption = AllocatePool (MAX_MSG_SIZE_CAPTION);
-                if ((NULL != pTempCaption) && (NULL != pCaption)) {
-                  UnicodeSPrint (pTempCaption, MAX_MSG_SIZE_CAPTION, pCaption, mBootOptions[Index].Description);
-                }
-
-                pTempConfirm = AllocatePool (MAX_MSG_SIZE_WARNING);
-                if ((NULL != pTempConfirm) && (NULL != pConfirm)) {
-                  UnicodeSPrint (pTempConfirm, MAX_MSG_SIZE_WARNING, pMsgBox, mBootOptions[Index].Description);
-                }
-
-                SwmResult = SWM_MB_IDCANCEL;
-                if (NULL != mSWMProtocol) {
-                  // Ignore delete when SWM not found.
-                  Status = SwmDialogsMessageBox (
-                             pTitle,
-                             pTempConfirm,                                          // Dialog body text.
-                             pTempCaption,                                          // Dialog caption text.
-                             SWM_MB_OKCANCEL,                                       // Show OK and CANCEL buttons.
-                             0,                                                     // No timeout
-                             &SwmResult
-                             );                                                     // Return result.
-                }
-
-                if (NULL != pCaption) {
-                  FreePool (pCaption);
-                }
-
-                if (NULL != pConfirm) {
-                  FreePool (pConfirm);
-                }
-
-                if (NULL != pTempCaption) {
-                  FreePool (pTempCaption);
-                }
-
-                if (NULL != pTempConfirm) {
-                  FreePool (pTempConfirm);
-                }
-
-                if (SWM_MB_IDOK == SwmResult) {
-                  Status = gRT->SetVariable (
-                                  L"BootNext",
-                                  &gEfiGlobalVariableGuid,
-                                  EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS | EFI_VARIABLE_NON_VOLATILE,
-                                  sizeof (ThisOption),
-                                  &ThisOption
-                                  );
-                  if (EFI_ERROR (Status)) {
-                    DEBUG ((DEBUG_ERROR, "%a: Error setting BootNext. Code=%r\n", __FUNCTION__, Status));
-                  } else {
-                    MsBootNext = TRUE;
-                    Status     = gRT->SetVariable (
-                                        L"MsBootNext",
-                                        &gMsBootMenuFormsetGuid,
-                                        EFI_VARIABLE_BOOTSERVICE_ACCESS,
-                                        sizeof (MsBootNext),
-                                        &MsBootNext
-                                        );
-                    DEBUG ((DEBUG_INFO, "%a BootNext set to BOOT%4.4x\n", __FUNCTION__, ThisOption));
-                  }
-
-                  mBrowserEx2->SetScope (SystemLevel);
-                  mBrowserEx2->ExecuteAction (BROWSER_ACTION_EXIT, 0);                    // Tell browser to Exit completely to follow the boot next action
-                  Status = EFI_SUCCESS;
-                  SetGraphicsConsoleMode (GCM_NATIVE_RES);
-                  DisplayBootGraphic (BG_SYSTEM_LOGO);
-                  return EFI_SUCCESS;                    // On a boot request, return immediately
-                }
-
-                goto Exit1;                   // Terminate processing, and don't update the boot order
+        PerformQuickSort (OrderKeys, mOrderOptionCount, sizeof (ORDER_OPTION_KEY), CompareOrderOptionKey);
+
+        ListCount = 0;
+        for (Index = 0; Index < mOrderOptionCount; Index++) {
+          if (0 == mOrderConfiguration.OrderOptions[Index]) {
+            break;
+          }
+
+          ThisOption = (UINT16)(mOrderConfiguration.OrderOptions[Index] - 1);
+          BootOption = FindOrderOption (OrderKeys, mOrderOptionCount, ThisOption);
+          if ((BootOption == MAX_UINTN) || Listed[BootOption]) {
+            DEBUG ((DEBUG_ERROR, "%a Ignoring unknown or repeated option %4.4x\n", __FUNCTION__, ThisOption));
+            continue;
+          }
+
+          if (mOrderConfiguration.OrderOptions[Index] & ORDERED_LIST_BOOT_VALUE_32) {
+            pTitle   = HiiGetString (mBootMenuPrivate.HiiHandle, STRING_TOKEN (STR_BOOT_BOOT_TITLE), NULL);
+            pCaption = HiiGetString (mBootMenuPrivate.HiiHandle, STRING_TOKEN (STR_BOOT_BOOT_CAPTION), NULL);
+            pConfirm = HiiGetString (mBootMenuPrivate.HiiHandle, STRING_TOKEN (STR_BOOT_BOOT_WARNING), NULL);
+
+            pMsgBox = pConfirm;
+            if (NULL == pMsgBox) {
+              // Just in case HiiMsg is not available
+              pMsgBox = L"Are you sure you want to boot %s?";
+            }
+
+            pTempCaption = AllocatePool (MAX_MSG_SIZE_CAPTION);
+            if ((NULL != pTempCaption) && (NULL != pCaption)) {
+              UnicodeSPrint (pTempCaption, MAX_MSG_SIZE_CAPTION, pCaption, mBootOptions[BootOption].Description);
+            }
+
+            pTempConfirm = AllocatePool (MAX_MSG_SIZE_WARNING);
+            if ((NULL != pTempConfirm) && (NULL != pConfirm)) {
+              UnicodeSPrint (pTempConfirm, MAX_MSG_SIZE_WARNING, pMsgBox, mBootOptions[BootOption].Description);
+            }
+
+            SwmResult = SWM_MB_IDCANCEL;
+            if (NULL != mSWMProtocol) {
+              // Ignore delete when SWM not found.
+              Status = SwmDialogsMessageBox (
+                         pTitle,
+                         pTempConfirm,                                          // Dialog body text.
+                         pTempCaption,                                          // Dialog caption text.
+                         SWM_MB_OKCANCEL,                                       // Show OK and CANCEL buttons.
+                         0,                                                     // No timeout
+                         &SwmResult
+                         );                                                     // Return result.
+            }
+
+            if (NULL != pCaption) {
+              FreePool (pCaption);
+            }
+
+            if (NULL != pConfirm) {
+              FreePool (pConfirm);
+            }
+
+            if (NULL != pTempCaption) {
+              FreePool (pTempCaption);
+            }
+
+            if (NULL != pTempConfirm) {
+              FreePool (pTempConfirm);
+            }
+
+            if (SWM_MB_IDOK == SwmResult) {
+              Status = gRT->SetVariable (
+                              L"BootNext",
+                              &gEfiGlobalVariableGuid,
+                              EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS | EFI_VARIABLE_NON_VOLATILE,
+                              sizeof (ThisOption),
+                              &ThisOption
+                              );
+              if (EFI_ERROR (Status)) {
+                DEBUG ((DEBUG_ERROR, "%a: Error setting BootNext. Code=%r\n", __FUNCTION__, Status));
               } else {
-                NewBootOrder[NewBootOrderCount++] = ThisOption;
-                for (Index2 = 0; Index2 < mBootOptionLimit; Index2++) {
-                  if (ThisOption == mBootOptions[Index2].OptionNumber) {
-                    PrevActive = ((mBootOptions[Index2].Attributes & LOAD_OPTION_ACTIVE) == LOAD_OPTION_ACTIVE);
-                    ThisActive = ((mOrderConfiguration.OrderOptions[Index] & ORDERED_LIST_CHECKBOX_VALUE_32) != 0);
-                    if (ThisActive != PrevActive) {
-                      mBootOptions[Index2].Attributes ^= LOAD_OPTION_ACTIVE;
-                      EfiBootManagerLoadOptionToVariable (&mBootOptions[Index2]);
-                    }
-
-                    break;
-                  }
-                }
+                MsBootNext = TRUE;
+                Status     = gRT->SetVariable (
+                                    L"MsBootNext",
+                                    &gMsBootMenuFormsetGuid,
+                                    EFI_VARIABLE_BOOTSERVICE_ACCESS,
+                                    sizeof (MsBootNext),
+                                    &MsBootNext
+                                    );
+                DEBUG ((DEBUG_INFO, "%a BootNext set to BOOT%4.4x\n", __FUNCTION__, ThisOption));
               }
+
+              CommitBootMenuChanges ();
+              mBrowserEx2->SetScope (SystemLevel);
+              mBrowserEx2->ExecuteAction (BROWSER_ACTION_EXIT, 0);                    // Tell browser to Exit completely to follow the boot next action
+              Status = EFI_SUCCESS;
+              SetGraphicsConsoleMode (GCM_NATIVE_RES);
+              DisplayBootGraphic (BG_SYSTEM_LOGO);
+              BootNow = TRUE;                        // On a boot request, return immediately
             }
-          } else {
-            NewBootOrder[NewBootOrderCount++] = (UINT16)mBootOptions[Index].OptionNumber;
+
+            goto Exit1;                   // Terminate processing, and don't update the boot order
+          }
+
+          Listed[BootOption]        = TRUE;
+          NewListOrder[ListCount++] = BootOption;
+          PrevActive                = ((mBootOptions[BootOption].Attributes & LOAD_OPTION_ACTIVE) == LOAD_OPTION_ACTIVE);
+          ThisActive                = ((mOrderConfiguration.OrderOptions[Index] & ORDERED_LIST_CHECKBOX_VALUE_32) != 0);
+          if (ThisActive != PrevActive) {
+            mBootOptions[BootOption].Attributes ^= LOAD_OPTION_ACTIVE;
+            mBootOrderPending                    = TRUE;
+            mNvWritesRequested++;
           }
         }
 
         // Any deleted options?
-        if (mBootOptionCount != NewBootOrderCount) {
+        if (ListCount != mOrderOptionCount) {
           // On the delete path, only allow setting the boot order if confirmation is YES.
           AllowSetBootorder = FALSE;
 
-          // First, mark entries as Unassigned that are in the new BootOrder list
-          for (Index = 0; Index < mBootOptionLimit; Index++) {
-            for (Index2 = 0; Index2 < NewBootOrderCount; Index2++) {
-              if (mBootOptions[Index].OptionNumber == NewBootOrder[Index2]) {
-                mBootOptions[Index].OptionNumber = LoadOptionNumberUnassigned;
-                break;
+          // Delete every listed boot option that is no longer in the list
+          for (Index = 0; Index < mBootOptionCount; Index++) {
+            if (Shown[Index] && !Listed[Index]) {
+              if (IsDefaultBootOption (&mBootOptions[Index])) {
+                // The list doesn't offer delete for default options.  Don't delete one if asked anyway.
+                DEBUG ((DEBUG_ERROR, "%a Not deleting default boot option Boot%04x\n", __FUNCTION__, mBootOptions[Index].OptionNumber));
+                Listed[Index]             = TRUE;
+                NewListOrder[ListCount++] = Index;
+                continue;
               }
-            }
-          }
 
-          // Then, delete every boot option with an OptionNumber that is left
-          for (Index = 0; Index < mBootOptionLimit; Index++) {
-            if (mBootOptions[Index].OptionNumber != LoadOptionNumberUnassigned) {
               pTitle   = HiiGetString (mBootMenuPrivate.HiiHandle, STRING_TOKEN (STR_BOOT_DELETE_TITLE), NULL);
               pCaption = HiiGetString (mBootMenuPrivate.HiiHandle, STRING_TOKEN (STR_BOOT_DELETE_CAPTION), NULL);
               pConfirm = HiiGetString (mBootMenuPrivate.HiiHandle, STRING_TOKEN (STR_BOOT_DELETE_WARNING), NULL);
@@ -1072,22 +1414,15 @@ RouteConfig (
                            );                                                   // Return result.
               }
 
-              if (SWM_MB_IDOK == SwmResult) {
-                AllowSetBootorder = TRUE;
-                EfiBootManagerDeleteLoadOptionVariable (mBootOptions[Index].OptionNumber, LoadOptionTypeBoot);
-                UnicodeSPrint (OptionName, sizeof (OptionName), L"Boot%04x", mBootOptions[Index].OptionNumber);
-                Status = gRT->SetVariable (
-                                OptionName,
-                                &gEfiGlobalVariableGuid,
-                                EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS | EFI_VARIABLE_NON_VOLATILE,
-                                0,
-                                NULL
-                                );
-                if (EFI_ERROR (Status)) {
-                  DEBUG ((DEBUG_ERROR, "%a Error deleting %s. Code=%r\n", __FUNCTION__, OptionName, Status));
-                } else {
-                  DEBUG ((DEBUG_INFO, "%a Variable %s deleted. Code=%r\n", __FUNCTION__, OptionName, Status));
-                }
+              if ((SWM_MB_IDOK == SwmResult) && (mDeletedOptions != NULL)) {
+                AllowSetBootorder                      = TRUE;
+                mDeletedOptions[mDeletedOptionCount++] = (UINT16)mBootOptions[Index].OptionNumber;
+                mNvWritesRequested                    += 2;     // BootOrder and Boot####
+                DEBUG ((DEBUG_INFO, "%a Boot%04x will be deleted\n", __FUNCTION__, mBootOptions[Index].OptionNumber));
+              } else {
+                // Keep the option, at the end of the list.
+                Listed[Index]             = TRUE;
+                NewListOrder[ListCount++] = Index;
               }
 
               if (NULL != pCaption) {
@@ -1109,97 +1444,85 @@ RouteConfig (
           }
         }
 
+        //
+        // Options that are not in the list (hidden, applications, or past the end of the list)
+        // keep their place in BootOrder.  The places of the listed options take the new list order.
+        //
+        Index2 = 0;
+        for (Index = 0; Index < mBootOptionCount; Index++) {
+          if (!Shown[Index]) {
+            NewOrder[NewOrderCount++] = Index;
+          } else if (Index2 < ListCount) {
+            NewOrder[NewOrderCount++] = NewListOrder[Index2++];
+          }
+        }
+
         if (AllowSetBootorder) {
-          Status = gRT->SetVariable (
-                          L"BootOrder",
-                          &gEfiGlobalVariableGuid,
-                          EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS | EFI_VARIABLE_NON_VOLATILE,
-                          sizeof (UINT16) * NewBootOrderCount,
-                          NewBootOrder
-                          );
+          Status = ReorderBootOptions (NewOrder, NewOrderCount);
+          if (!EFI_ERROR (Status)) {
+            mBootOrderPending = TRUE;
+            mNvWritesRequested++;
+          }
         }
 
 Exit1:
-        FreePool (NewBootOrder);
+        if (NewOrder != NULL) {
+          FreePool (NewOrder);
+        }
+
+        if (NewListOrder != NULL) {
+          FreePool (NewListOrder);
+        }
+
+        if (OrderKeys != NULL) {
+          FreePool (OrderKeys);
+        }
+
+        if (Shown != NULL) {
+          FreePool (Shown);
+        }
+
+        if (BootNow) {
+          return EFI_SUCCESS;
+        }
+
         RebuildOrderList ();
       }
 
       DEBUG ((DEBUG_INFO, "%a Size is %d, Requested is %d. Code=%r\n", __FUNCTION__, sizeof (mOrderConfiguration), BufferSize, Status));
     }
-  } else if (HiiIsConfigHdrMatch (Configuration, &gMsBootMenuFormsetGuid, L"BootGrayoutConfig")) {
-    DEBUG ((DEBUG_INFO, "%a for Grayout Settings\n", __FUNCTION__));
-    BufferSize = sizeof (SETTINGS_GRAYOUT_CONFIGURATION);
-    Status     = gHiiConfigRouting->ConfigToBlock (
-                                      gHiiConfigRouting,
-                                      Configuration,
-                                      (UINT8 *)&TempGrayoutConfiguration,
-                                      &BufferSize,
-                                      Progress
-                                      );
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "%a: ConfigToBlock GrayoutConfig error- code=%r\n", __FUNCTION__, Status));
-    }
-
-    // We don't really accept Grayout Settings changes.  This just moves Progress correctly.
-  } else if (HiiIsConfigHdrMatch (Configuration, &gMsBootMenuFormsetGuid, L"BootSuppressConfig")) {
-    DEBUG ((DEBUG_INFO, "%a for SuppressMenu Settings\n", __FUNCTION__));
-    BufferSize = sizeof (SETTINGS_SUPPRESS_CONFIGURATION);
-    Status     = gHiiConfigRouting->ConfigToBlock (
-                                      gHiiConfigRouting,
-                                      Configuration,
-                                      (UINT8 *)&TempSuppressConfiguration,
-                                      &BufferSize,
-                                      Progress
-                                      );
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "%a: ConfigToBlock SuppressConfig error- code=%r\n", __FUNCTION__, Status));
-    }
-
-    // We don't really accept Suppress Settings changes.  This just moves Progress correctly.
   } else if (HiiIsConfigHdrMatch (Configuration, &gMsBootMenuFormsetGuid, L"BootSettingsConfig")) {
     DEBUG ((DEBUG_INFO, "%a for Menu Settings\n", __FUNCTION__));
-    BufferSize = sizeof (SETTINGS_MENU_CONFIGURATION);
+    //
+    // Only the values can change.  The grayout and suppress planes are kept as they are.
+    //
+    CopyMem (&TempSettingsConfiguration, &mSettingsConfiguration, sizeof (TempSettingsConfiguration));
+    BufferSize = sizeof (BOOT_SETTINGS_CONFIGURATION);
     Status     = gHiiConfigRouting->ConfigToBlock (
                                       gHiiConfigRouting,
                                       Configuration,
-                                      (UINT8 *)&mSettingsConfiguration,
+                                      (UINT8 *)&TempSettingsConfiguration,
                                       &BufferSize,
                                       Progress
                                       );
     if (EFI_ERROR (Status)) {
       DEBUG ((DEBUG_ERROR, "%a: ConfigToBlock SettingsConfig error- code=%r\n", __FUNCTION__, Status));
     } else {
-      DEBUG ((
-        DEBUG_INFO,
-        "     EnableIPv6 = %d, EnableAltBoot = %d, EnableBootOrderLock = %d\n",
-        mSettingsConfiguration.IPv6,
-        mSettingsConfiguration.AltBoot,
-        mSettingsConfiguration.BootOrderLock
-        ));
-      DEBUG ((
-        DEBUG_INFO,
-        "Gray EnableIPv6 = %d, EnableAltBoot = %d, EnableBootOrderLock = %d\n",
-        mSettingsGrayoutConfiguration.IPv6,
-        mSettingsGrayoutConfiguration.AltBoot,
-        mSettingsGrayoutConfiguration.BootOrderLock
-        ));
-
-      Status = EFI_SUCCESS;
-      if (mSettingsGrayoutConfiguration.IPv6) {
-        Status |= SetSetting (DFCI_SETTING_ID__IPV6, &mSettingsConfiguration.IPv6);
-      }
-
-      if (mSettingsGrayoutConfiguration.AltBoot) {
-        Status |= SetSetting (DFCI_SETTING_ID__ALT_BOOT, &mSettingsConfiguration.AltBoot);
-      }
-
-      if (mSettingsGrayoutConfiguration.BootOrderLock) {
-        Status |= SetSetting (DFCI_SETTING_ID__BOOT_ORDER_LOCK, &mSettingsConfiguration.BootOrderLock);
+      CopyMem (mSettingsConfiguration.Value, TempSettingsConfiguration.Value, sizeof (mSettingsConfiguration.Value));
+      for (Index = 0; Index < BOOT_SETTING_COUNT; Index++) {
+        DEBUG ((
+          DEBUG_INFO,
+          "     %a = %d, Writable = %d\n",
+          mMenuSettingIds[Index],
+          mSettingsConfiguration.Value[Index],
+          mSettingsConfiguration.Writable[Index]
+          ));
+        mNvWritesRequested += mSettingsConfiguration.Writable[Index];
       }
 
-      if (mSettingsGrayoutConfiguration.EnableUsbBoot) {
-        Status |= SetSetting (DFCI_SETTING_ID__ENABLE_USB_BOOT, &mSettingsConfiguration.EnableUsbBoot);
-      }
+      // The settings are written by CommitBootMenuChanges ().
+      Status           = EFI_SUCCESS;
+      mSettingsPending = TRUE;
     }
   } else {
     Status = EFI_UNSUPPORTED;
@@ -1246,6 +1569,7 @@ ExtractConfig (
   )
 {
   EFI_STATUS  Status;
+  UINTN       Index;
 
   if ((Progress == NULL) || (Results == NULL)) {
     return EFI_INVALID_PARAMETER;
@@ -1277,88 +1601,34 @@ ExtractConfig (
                                   );
     DEBUG ((DEBUG_INFO, "%a Size is %d, Code=%r\n", __FUNCTION__, sizeof (mOrderConfiguration), Status));
   } else if (HiiIsConfigHdrMatch (Request, &gMsBootMenuFormsetGuid, L"BootSettingsConfig")) {
-    // Do a similar process for both BootSettings and BootGrayout - cannot predict which will
-    // come first.
-
     DEBUG ((DEBUG_INFO, "%a for Menu Settings\n", __FUNCTION__));
 
-    Status  = GetSetting (DFCI_SETTING_ID__IPV6, &mSettingsConfiguration.IPv6);
-    Status |= GetSetting (DFCI_SETTING_ID__ALT_BOOT, &mSettingsConfiguration.AltBoot);
-    Status |= GetSetting (DFCI_SETTING_ID__BOOT_ORDER_LOCK, &mSettingsConfiguration.BootOrderLock);
-    Status |= GetSetting (DFCI_SETTING_ID__ENABLE_USB_BOOT, &mSettingsConfiguration.EnableUsbBoot);
-
-    DEBUG ((
-      DEBUG_INFO,
-      "EnableIPv6 = %d, EnableAltBoot = %d, EnableBootOrderLock = %d, EnableUsbBoot = %d.\n",
-      mSettingsConfiguration.IPv6,
-      mSettingsConfiguration.AltBoot,
-      mSettingsConfiguration.BootOrderLock,
-      mSettingsConfiguration.EnableUsbBoot
-      ));
-
-    Status = gHiiConfigRouting->BlockToConfig (
-                                  gHiiConfigRouting,
-                                  Request,
-                                  (UINT8 *)&mSettingsConfiguration,
-                                  sizeof (SETTINGS_MENU_CONFIGURATION),
-                                  Results,
-                                  Progress
-                                  );
-  } else if (HiiIsConfigHdrMatch (Request, &gMsBootMenuFormsetGuid, L"BootGrayoutConfig")) {
-    // Do the similar thing for both BootSettings and BootGrayout - cannot predict which will
-    // come first.
-    mSettingsGrayoutConfiguration.RestrictedAccessString = FALSE;
-    DEBUG ((DEBUG_INFO, "%a for Grayout Settings\n", __FUNCTION__));
-
-    Status  = GetSettingGrayoutFlag (DFCI_SETTING_ID__IPV6, &mSettingsGrayoutConfiguration.IPv6);
-    Status |= GetSettingGrayoutFlag (DFCI_SETTING_ID__ALT_BOOT, &mSettingsGrayoutConfiguration.AltBoot);
-    Status |= GetSettingGrayoutFlag (DFCI_SETTING_ID__BOOT_ORDER_LOCK, &mSettingsGrayoutConfiguration.BootOrderLock);
-    Status |= GetSettingGrayoutFlag (DFCI_SETTING_ID__ENABLE_USB_BOOT, &mSettingsGrayoutConfiguration.EnableUsbBoot);
+    mSettingsConfiguration.RestrictedAccessString = FALSE;
+    for (Index = 0; Index < BOOT_SETTING_COUNT; Index++) {
+      // Changed settings that are not committed yet are returned as they are.
+      if (!mSettingsPending) {
+        GetSetting (mMenuSettingIds[Index], &mSettingsConfiguration.Value[Index]);
+        mSettingsCommitted[Index] = mSettingsConfiguration.Value[Index];
+      }
 
-    DEBUG ((
-      DEBUG_INFO,
-      "Grayout - EnableIPv6 = %d, EnableAltBoot = %d, EnableBootOrderLock = %d, EnableUsbBoot = %d.\n",
-      mSettingsGrayoutConfiguration.IPv6,
-      mSettingsGrayoutConfiguration.AltBoot,
-      mSettingsGrayoutConfiguration.BootOrderLock,
-      mSettingsGrayoutConfiguration.EnableUsbBoot
-      ));
+      GetSettingGrayoutFlag (mMenuSettingIds[Index], &mSettingsConfiguration.Writable[Index]);
+      GetSettingSuppressFlag (mMenuSettingIds[Index], &mSettingsConfiguration.Suppress[Index]);
 
-    Status = gHiiConfigRouting->BlockToConfig (
-                                  gHiiConfigRouting,
-                                  Request,
-                                  (UINT8 *)&mSettingsGrayoutConfiguration,
-                                  sizeof (SETTINGS_GRAYOUT_CONFIGURATION),
-                                  Results,
-                                  Progress
-                                  );
-  } else if (HiiIsConfigHdrMatch (Request, &gMsBootMenuFormsetGuid, L"BootSuppressConfig")) {
-    // Do the similar thing for both BootSettings and BootGrayout - cannot predict which will
-    // come first.
-    DEBUG ((DEBUG_INFO, "%a for Suppress Settings\n", __FUNCTION__));
-
-    Status  = GetSettingSuppressFlag (DFCI_SETTING_ID__IPV6, &mSettingsSuppressConfiguration.IPv6);
-    Status |= GetSettingSuppressFlag (DFCI_SETTING_ID__ALT_BOOT, &mSettingsSuppressConfiguration.AltBoot);
-    Status |= GetSettingSuppressFlag (DFCI_SETTING_ID__BOOT_ORDER_LOCK, &mSettingsSuppressConfiguration.BootOrderLock);
-    Status |= GetSettingSuppressFlag (DFCI_SETTING_ID__ENABLE_USB_BOOT, &mSettingsSuppressConfiguration.EnableUsbBoot);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "Error getting a Suppress setting\n"));
+      DEBUG ((
+        DEBUG_INFO,
+        "%a = %d, Writable = %d, Suppress = %d.\n",
+        mMenuSettingIds[Index],
+        mSettingsConfiguration.Value[Index],
+        mSettingsConfiguration.Writable[Index],
+        mSettingsConfiguration.Suppress[Index]
+        ));
     }
 
-    DEBUG ((
-      DEBUG_INFO,
-      "Suppress - EnableIPv6 = %d, EnableAltBoot = %d, EnableBootOrderLock = %d, EnableUsbBoot = %d.\n",
-      mSettingsSuppressConfiguration.IPv6,
-      mSettingsSuppressConfiguration.AltBoot,
-      mSettingsSuppressConfiguration.BootOrderLock,
-      mSettingsSuppressConfiguration.EnableUsbBoot
-      ));
-
     Status = gHiiConfigRouting->BlockToConfig (
                                   gHiiConfigRouting,
                                   Request,
-                                  (UINT8 *)&mSettingsSuppressConfiguration,
-                                  sizeof (SETTINGS_SUPPRESS_CONFIGURATION),
+                                  (UINT8 *)&mSettingsConfiguration,
+                                  sizeof (BOOT_SETTINGS_CONFIGURATION),
                                   Results,
                                   Progress
                                   );
@@ -21,12 +21,10 @@
 #define EFI_OTHER_DEVICE_CLASS            0x20
 #define EFI_GENERAL_APPLICATION_SUBCLASS  0x01
 
-#define MAX_BOOT_OPTIONS_SUPPORTED  6           // Maximum number of boot options to display in listbox
+#define MAX_BOOT_OPTIONS_SUPPORTED  255         // Maximum number of boot options to display in listbox.  MaxContainers is a UINT8, so one ordered list can't hold more.
 
 #define MS_BOOT_ORDER_VARID     0x0031
 #define MS_BOOT_SETTINGS_VARID  0x0033
-#define MS_BOOT_GRAYOUT_VARID   0x0034
-#define MS_BOOT_SUPPRESS_VARID  0x0035
 
 #define MS_BOOT_ORDER_INIT_KEY  0x0041
 
@@ -70,27 +68,21 @@ typedef struct {
   UINT32    OrderOptions[MAX_BOOT_OPTIONS_SUPPORTED];
 } ORDER_MENU_CONFIGURATION;
 
-typedef struct {
-  BOOLEAN    IPv6;
-  BOOLEAN    AltBoot;
-  BOOLEAN    BootOrderLock;
-  BOOLEAN    EnableUsbBoot;
-} SETTINGS_MENU_CONFIGURATION;
-
-typedef struct {
-  BOOLEAN    IPv6;
-  BOOLEAN    AltBoot;
-  BOOLEAN    BootOrderLock;
-  BOOLEAN    EnableUsbBoot;
-  //
-  BOOLEAN    RestrictedAccessString;
-} SETTINGS_GRAYOUT_CONFIGURATION;
+//
+// The boot settings, as indexes into the planes of BOOT_SETTINGS_CONFIGURATION.  mMenuSettingIds
+// in BootMenu.c has the DFCI setting of each one.
+//
+#define BOOT_SETTING_IPV6             0
+#define BOOT_SETTING_ALT_BOOT         1
+#define BOOT_SETTING_BOOT_ORDER_LOCK  2
+#define BOOT_SETTING_ENABLE_USB_BOOT  3
+#define BOOT_SETTING_COUNT            4
 
 typedef struct {
-  BOOLEAN    IPv6;
-  BOOLEAN    AltBoot;
-  BOOLEAN    BootOrderLock;
-  BOOLEAN    EnableUsbBoot;
-} SETTINGS_SUPPRESS_CONFIGURATION;
+  BOOLEAN    Value[BOOT_SETTING_COUNT];         // The settings.
+  BOOLEAN    Writable[BOOT_SETTING_COUNT];      // The setting is grayed out if FALSE.
+  BOOLEAN    Suppress[BOOT_SETTING_COUNT];      // The setting has no provider, and is hidden.
+  BOOLEAN    RestrictedAccessString;            // Some setting is not writable.
+} BOOT_SETTINGS_CONFIGURATION;
 
 #endif // _BOOT_MENU_H_
@@ -0,0 +1,227 @@
+/** @file
+  Cache of the parsed boot options for BootMenu.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Guid/GlobalVariable.h>
+
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PrintLib.h>
+#include <Library/UefiBootManagerLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+
+#include "BootOptionCache.h"
+
+STATIC EFI_BOOT_MANAGER_LOAD_OPTION  *mCachedOptions    = NULL;
+STATIC UINT32                        *mCachedCrc        = NULL;     // CRC32 of each option's Boot#### variable.
+STATIC UINTN                         mCachedOptionCount = 0;
+STATIC UINT64                        mGeneration        = 0;
+STATIC BOOLEAN                       mStale             = TRUE;
+
+/**
+  Finds a cached option that can be reused.
+
+  @param[in]  OptionNumber  The option number.
+  @param[in]  Crc           CRC32 of the option's Boot#### variable.
+  @param[in]  Hint          Where the option is most likely to be.
+  @param[in]  Reused        TRUE for the cached options that are already reused.
+
+  @return     Index of the cached option, or MAX_UINTN if there is none.
+
+**/
+STATIC
+UINTN
+FindCachedOption (
+  IN  UINT16         OptionNumber,
+  IN  UINT32         Crc,
+  IN  UINTN          Hint,
+  IN  CONST BOOLEAN  *Reused
+  )
+{
+  UINTN  Index;
+
+  if ((Hint < mCachedOptionCount) && !Reused[Hint] &&
+      (mCachedOptions[Hint].OptionNumber == OptionNumber) && (mCachedCrc[Hint] == Crc))
+  {
+    return Hint;
+  }
+
+  for (Index = 0; Index < mCachedOptionCount; Index++) {
+    if (!Reused[Index] && (mCachedOptions[Index].OptionNumber == OptionNumber) && (mCachedCrc[Index] == Crc)) {
+      return Index;
+    }
+  }
+
+  return MAX_UINTN;
+}
+
+/**
+  Brings the cache up to date with BootOrder and the Boot#### variables.  Options whose variable
+  is unchanged are kept as they are.  If memory runs out, the cache is left as it was.
+
+**/
+STATIC
+VOID
+RefreshBootOptionCache (
+  VOID
+  )
+{
+  UINT16                        *BootOrder;
+  UINTN                         BootOrderSize;
+  UINTN                         OrderCount;
+  EFI_BOOT_MANAGER_LOAD_OPTION  *Options;
+  UINT32                        *Crc;
+  BOOLEAN                       *Reused;
+  UINTN                         Count;
+  UINTN                         Parsed;
+  UINTN                         Index;
+  UINTN                         Position;
+  CHAR16                        OptionName[sizeof ("Boot####")];
+  VOID                          *Variable;
+  UINTN                         VariableSize;
+  BOOLEAN                       Changed;
+  EFI_STATUS                    Status;
+
+  BootOrder = NULL;
+  GetEfiGlobalVariable2 (EFI_BOOT_ORDER_VARIABLE_NAME, (VOID **)&BootOrder, &BootOrderSize);
+  OrderCount = (BootOrder == NULL) ? 0 : BootOrderSize / sizeof (UINT16);
+
+  Options = (EFI_BOOT_MANAGER_LOAD_OPTION *)AllocateZeroPool (sizeof (EFI_BOOT_MANAGER_LOAD_OPTION) * MAX (OrderCount, 1));
+  Crc     = (UINT32 *)AllocateZeroPool (sizeof (UINT32) * MAX (OrderCount, 1));
+  Reused  = (BOOLEAN *)AllocateZeroPool (sizeof (BOOLEAN) * MAX (mCachedOptionCount, 1));
+  if ((Options == NULL) || (Crc == NULL) || (Reused == NULL)) {
+    DEBUG ((DEBUG_ERROR, "%a Out of resources.  The boot option cache was not refreshed.\n", __FUNCTION__));
+    if (Options != NULL) {
+      FreePool (Options);
+    }
+
+    if (Crc != NULL) {
+      FreePool (Crc);
+    }
+
+    if (Reused != NULL) {
+      FreePool (Reused);
+    }
+
+    if (BootOrder != NULL) {
+      FreePool (BootOrder);
+    }
+
+    return;
+  }
+
+  Count   = 0;
+  Parsed  = 0;
+  Changed = FALSE;
+  for (Index = 0; Index < OrderCount; Index++) {
+    UnicodeSPrint (OptionName, sizeof (OptionName), L"Boot%04x", BootOrder[Index]);
+    Status = GetEfiGlobalVariable2 (OptionName, &Variable, &VariableSize);
+    if (EFI_ERROR (Status)) {
+      continue;                           // In BootOrder, but gone.
+    }
+
+    gBS->CalculateCrc32 (Variable, VariableSize, &Crc[Count]);
+    FreePool (Variable);
+
+    Position = FindCachedOption (BootOrder[Index], Crc[Count], Count, Reused);
+    if (Position != MAX_UINTN) {
+      CopyMem (&Options[Count], &mCachedOptions[Position], sizeof (EFI_BOOT_MANAGER_LOAD_OPTION));
+      Reused[Position] = TRUE;
+      Changed         |= (BOOLEAN)(Position != Count);
+    } else {
+      Status = EfiBootManagerVariableToLoadOption (OptionName, &Options[Count]);
+      if (EFI_ERROR (Status)) {
+        continue;
+      }
+
+      Parsed++;
+      Changed = TRUE;
+    }
+
+    Count++;
+  }
+
+  Changed |= (BOOLEAN)(Count != mCachedOptionCount);
+
+  for (Index = 0; Index < mCachedOptionCount; Index++) {
+    if (!Reused[Index]) {
+      EfiBootManagerFreeLoadOption (&mCachedOptions[Index]);
+    }
+  }
+
+  if (mCachedOptions != NULL) {
+    FreePool (mCachedOptions);
+  }
+
+  if (mCachedCrc != NULL) {
+    FreePool (mCachedCrc);
+  }
+
+  if (BootOrder != NULL) {
+    FreePool (BootOrder);
+  }
+
+  FreePool (Reused);
+
+  mCachedOptions     = Options;
+  mCachedCrc         = Crc;
+  mCachedOptionCount = Count;
+  mStale             = FALSE;
+  if (Changed) {
+    mGeneration++;
+  }
+
+  DEBUG ((DEBUG_INFO, "%a %lu boot options, %lu parsed.  Generation %lu\n", __FUNCTION__, (UINT64)Count, (UINT64)Parsed, mGeneration));
+}
+
+/**
+  Gets the boot options in BootOrder order.  The cache is refreshed first if it is stale.
+
+  The options belong to the cache.  They must not be changed or freed, and must not be used
+  after the cache is next refreshed.  A shallow copy of an option may be changed, as long as
+  its pointers are not freed.
+
+  @param[out] Count         Number of boot options.
+  @param[out] Generation    [Optional] The generation of the view.
+
+  @return     The boot options.  NULL if there are none.
+
+**/
+CONST EFI_BOOT_MANAGER_LOAD_OPTION *
+GetBootOptionsView (
+  OUT UINTN   *Count,
+  OUT UINT64  *Generation OPTIONAL
+  )
+{
+  if (mStale) {
+    RefreshBootOptionCache ();
+  }
+
+  *Count = mCachedOptionCount;
+  if (Generation != NULL) {
+    *Generation = mGeneration;
+  }
+
+  return (mCachedOptionCount == 0) ? NULL : mCachedOptions;
+}
+
+/**
+  Marks the cache stale, so the next GetBootOptionsView () checks the variables again.  Called
+  after BootMenu writes Boot#### or BootOrder, and when the boot order form opens.
+
+**/
+VOID
+InvalidateBootOptionCache (
+  VOID
+  )
+{
+  mStale = TRUE;
+}
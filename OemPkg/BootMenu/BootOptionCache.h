@@ -0,0 +1,47 @@
+/** @file
+  Cache of the parsed boot options for BootMenu.
+
+  The boot options are parsed once and handed out as a read-only view, which stays valid until
+  the cache is next refreshed.  UEFI has no notification for variable writes, so the cache is
+  marked stale when BootMenu writes the boot options and when the boot order form opens.  A
+  refresh reads BootOrder and the Boot#### variables and only parses the options whose
+  variable changed, going by its CRC32.  The generation counts the refreshes that found a change.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _BOOT_OPTION_CACHE_H_
+#define _BOOT_OPTION_CACHE_H_
+
+/**
+  Gets the boot options in BootOrder order.  The cache is refreshed first if it is stale.
+
+  The options belong to the cache.  They must not be changed or freed, and must not be used
+  after the cache is next refreshed.  A shallow copy of an option may be changed, as long as
+  its pointers are not freed.
+
+  @param[out] Count         Number of boot options.
+  @param[out] Generation    [Optional] The generation of the view.
+
+  @return     The boot options.  NULL if there are none.
+
+**/
+CONST EFI_BOOT_MANAGER_LOAD_OPTION *
+GetBootOptionsView (
+  OUT UINTN   *Count,
+  OUT UINT64  *Generation OPTIONAL
+  );
+
+/**
+  Marks the cache stale, so the next GetBootOptionsView () checks the variables again.  Called
+  after BootMenu writes Boot#### or BootOrder, and when the boot order form opens.
+
+**/
+VOID
+InvalidateBootOptionCache (
+  VOID
+  );
+
+#endif
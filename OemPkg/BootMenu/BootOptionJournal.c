@@ -0,0 +1,453 @@
+/** @file
+  Crash-consistent commit of BootMenu's boot option changes.
+
+  A commit is applied in three steps: LOAD_OPTION_ACTIVE changes, then BootOrder, then the
+  deletes, so BootOrder never names an option that is already gone.  Every step can be repeated,
+  which is what lets a journal be replayed after a power cut in any step.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Guid/GlobalVariable.h>
+#include <Guid/MsBootMenuGuid.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PrintLib.h>
+#include <Library/SortLib.h>
+#include <Library/UefiBootManagerLib.h>
+#include <Library/UefiLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+
+#include "BootOptionJournal.h"
+
+#define BOOT_VARIABLE_ATTRIBUTES  (EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS | EFI_VARIABLE_NON_VOLATILE)
+
+/**
+  Sort compare function for option numbers.
+
+  @param[in]  Buffer1   The first option number.
+  @param[in]  Buffer2   The second option number.
+
+  @return     <0, 0 or >0 as Buffer1 sorts before, with or after Buffer2.
+
+**/
+STATIC
+INTN
+EFIAPI
+CompareOptionNumber (
+  IN  CONST VOID  *Buffer1,
+  IN  CONST VOID  *Buffer2
+  )
+{
+  return (INTN)*(CONST UINT16 *)Buffer1 - (INTN)*(CONST UINT16 *)Buffer2;
+}
+
+/**
+  Finds an option number in a sorted array.
+
+  @param[in]  Sorted        Option numbers sorted by CompareOptionNumber ().
+  @param[in]  Count         Number of option numbers.
+  @param[in]  OptionNumber  The option number to find.
+
+  @return     Index of OptionNumber in Sorted, or MAX_UINTN if it is not there.
+
+**/
+STATIC
+UINTN
+FindOptionNumber (
+  IN  CONST UINT16  *Sorted,
+  IN        UINTN   Count,
+  IN        UINT16  OptionNumber
+  )
+{
+  UINTN  Low;
+  UINTN  High;
+  UINTN  Middle;
+
+  Low  = 0;
+  High = Count;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if (Sorted[Middle] < OptionNumber) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  if ((Low < Count) && (Sorted[Low] == OptionNumber)) {
+    return Low;
+  }
+
+  return MAX_UINTN;
+}
+
+/**
+  Reads LOAD_OPTION_ACTIVE from a Boot#### variable.
+
+  @param[in]  OptionNumber  The boot option.
+  @param[out] Active        TRUE if the option is active.
+
+  @retval     EFI_SUCCESS   Active is set.
+  @retval     Others        The variable could not be read.
+
+**/
+STATIC
+EFI_STATUS
+GetBootOptionActive (
+  IN  UINT16   OptionNumber,
+  OUT BOOLEAN  *Active
+  )
+{
+  EFI_STATUS  Status;
+  CHAR16      OptionName[sizeof ("Boot####")];
+  UINT32      *Attributes;
+  UINTN       Size;
+
+  UnicodeSPrint (OptionName, sizeof (OptionName), L"Boot%04x", OptionNumber);
+  Status = GetEfiGlobalVariable2 (OptionName, (VOID **)&Attributes, &Size);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (Size < sizeof (UINT32)) {
+    Status = EFI_VOLUME_CORRUPTED;
+  } else {
+    *Active = (BOOLEAN)((*Attributes & LOAD_OPTION_ACTIVE) != 0);
+  }
+
+  FreePool (Attributes);
+  return Status;
+}
+
+/**
+  Sets or clears LOAD_OPTION_ACTIVE in a Boot#### variable.  The variable is only written if
+  the attribute changes.
+
+  @param[in]  OptionNumber  The boot option.
+  @param[in]  Active        TRUE to set LOAD_OPTION_ACTIVE, FALSE to clear it.
+
+  @retval     EFI_SUCCESS   The option has the attribute.
+  @retval     Others        The variable could not be read or written.
+
+**/
+STATIC
+EFI_STATUS
+SetBootOptionActive (
+  IN  UINT16   OptionNumber,
+  IN  BOOLEAN  Active
+  )
+{
+  EFI_STATUS                    Status;
+  CHAR16                        OptionName[sizeof ("Boot####")];
+  EFI_BOOT_MANAGER_LOAD_OPTION  Option;
+  UINT32                        Attributes;
+
+  UnicodeSPrint (OptionName, sizeof (OptionName), L"Boot%04x", OptionNumber);
+  Status = EfiBootManagerVariableToLoadOption (OptionName, &Option);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Attributes = Active ? (Option.Attributes | LOAD_OPTION_ACTIVE) : (Option.Attributes & ~LOAD_OPTION_ACTIVE);
+  if (Attributes != Option.Attributes) {
+    Option.Attributes = Attributes;
+    Status            = EfiBootManagerLoadOptionToVariable (&Option);
+  }
+
+  EfiBootManagerFreeLoadOption (&Option);
+  return Status;
+}
+
+/**
+  Applies a journal to the variables.
+
+  @param[in]  Journal   The journal.
+
+  @retval     EFI_SUCCESS   Every change was written.
+  @retval     Others        Error from the last write that failed.  The other writes were made.
+
+**/
+STATIC
+EFI_STATUS
+ApplyBootOptionJournal (
+  IN  CONST BOOT_OPTION_JOURNAL  *Journal
+  )
+{
+  EFI_STATUS                Status;
+  EFI_STATUS                Result = EFI_SUCCESS;
+  CONST BOOT_OPTION_CHANGE  *Changes;
+  CONST UINT16              *BootOrder;
+  CHAR16                    OptionName[sizeof ("Boot####")];
+  UINTN                     Index;
+
+  Changes   = (CONST BOOT_OPTION_CHANGE *)(Journal + 1);
+  BootOrder = (CONST UINT16 *)(Changes + Journal->ChangeCount);
+
+  for (Index = 0; Index < Journal->ChangeCount; Index++) {
+    if (Changes[Index].Action != BOOT_OPTION_DELETE) {
+      Status = SetBootOptionActive (Changes[Index].OptionNumber, (BOOLEAN)(Changes[Index].Action == BOOT_OPTION_ACTIVATE));
+      if (EFI_ERROR (Status)) {
+        DEBUG ((DEBUG_ERROR, "%a Error updating Boot%04x. Code=%r\n", __FUNCTION__, Changes[Index].OptionNumber, Status));
+        Result = Status;
+      }
+    }
+  }
+
+  if ((Journal->Flags & BOOT_OPTION_JOURNAL_WRITE_BOOT_ORDER) != 0) {
+    Status = gRT->SetVariable (
+                    EFI_BOOT_ORDER_VARIABLE_NAME,
+                    &gEfiGlobalVariableGuid,
+                    BOOT_VARIABLE_ATTRIBUTES,
+                    Journal->OrderCount * sizeof (UINT16),
+                    (VOID *)BootOrder
+                    );
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a Error writing BootOrder. Code=%r\n", __FUNCTION__, Status));
+      Result = Status;
+    }
+  }
+
+  for (Index = 0; Index < Journal->ChangeCount; Index++) {
+    if (Changes[Index].Action == BOOT_OPTION_DELETE) {
+      UnicodeSPrint (OptionName, sizeof (OptionName), L"Boot%04x", Changes[Index].OptionNumber);
+      Status = gRT->SetVariable (OptionName, &gEfiGlobalVariableGuid, BOOT_VARIABLE_ATTRIBUTES, 0, NULL);
+      if (EFI_ERROR (Status) && (Status != EFI_NOT_FOUND)) {
+        DEBUG ((DEBUG_ERROR, "%a Error deleting %s. Code=%r\n", __FUNCTION__, OptionName, Status));
+        Result = Status;
+      } else {
+        DEBUG ((DEBUG_INFO, "%a Variable %s deleted\n", __FUNCTION__, OptionName));
+      }
+    }
+  }
+
+  return Result;
+}
+
+/**
+  Writes the changes made to the boot options.  Only Boot#### variables whose LOAD_OPTION_ACTIVE
+  attribute changed, deleted options and a changed BootOrder are written.
+
+  Options are written in the order given.  Boot options that are in BootOrder but not in Options
+  or Deleted were added by someone else since BootMenu read them, and are kept at the end.
+
+  @param[in]  Options       The boot options, in their new order and with their new attributes.
+  @param[in]  OptionCount   Number of Options.
+  @param[in]  Deleted       Option numbers of the deleted boot options.
+  @param[in]  DeletedCount  Number of Deleted.
+  @param[out] WriteCount    Number of variable writes made, including the journal.
+
+  @retval     EFI_SUCCESS             The changes were written.
+  @retval     EFI_OUT_OF_RESOURCES    The journal could not be allocated.
+  @retval     Others                  Error writing the journal or a variable.  A journal that
+                                      was written is replayed on the next boot.
+
+**/
+EFI_STATUS
+CommitBootOptionChanges (
+  IN  CONST EFI_BOOT_MANAGER_LOAD_OPTION  *Options,
+  IN        UINTN                         OptionCount,
+  IN  CONST UINT16                        *Deleted,
+  IN        UINTN                         DeletedCount,
+  OUT       UINTN                         *WriteCount
+  )
+{
+  EFI_STATUS           Status = EFI_SUCCESS;
+  UINT16               *OldOrder;
+  UINTN                OldOrderSize;
+  UINTN                OldCount;
+  UINT16               *SortedOld     = NULL;
+  UINT16               *SortedDeleted = NULL;
+  BOOLEAN              *Kept          = NULL;
+  BOOT_OPTION_JOURNAL  *Journal       = NULL;
+  BOOT_OPTION_CHANGE   *Changes;
+  UINT16               *NewOrder;
+  UINTN                JournalSize;
+  UINTN                ChangeCount;
+  UINTN                NewCount;
+  UINTN                Writes;
+  UINTN                Index;
+  UINTN                Position;
+  UINT16               OptionNumber;
+  BOOLEAN              Active;
+  BOOLEAN              OrderChanged;
+
+  *WriteCount = 0;
+
+  OldOrder = NULL;
+  GetEfiGlobalVariable2 (EFI_BOOT_ORDER_VARIABLE_NAME, (VOID **)&OldOrder, &OldOrderSize);
+  OldCount = (OldOrder == NULL) ? 0 : OldOrderSize / sizeof (UINT16);
+
+  JournalSize = sizeof (BOOT_OPTION_JOURNAL) +
+                (OptionCount + DeletedCount) * sizeof (BOOT_OPTION_CHANGE) +
+                (OptionCount + OldCount) * sizeof (UINT16);
+  Journal       = AllocateZeroPool (JournalSize);
+  SortedOld     = AllocateZeroPool (MAX (OldCount, 1) * sizeof (UINT16));
+  SortedDeleted = AllocateZeroPool (MAX (DeletedCount, 1) * sizeof (UINT16));
+  Kept          = AllocateZeroPool (MAX (OldCount, 1) * sizeof (BOOLEAN));
+  if ((Journal == NULL) || (SortedOld == NULL) || (SortedDeleted == NULL) || (Kept == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  CopyMem (SortedOld, OldOrder, OldCount * sizeof (UINT16));
+  CopyMem (SortedDeleted, Deleted, DeletedCount * sizeof (UINT16));
+  PerformQuickSort (SortedOld, OldCount, sizeof (UINT16), CompareOptionNumber);
+  PerformQuickSort (SortedDeleted, DeletedCount, sizeof (UINT16), CompareOptionNumber);
+
+  //
+  // Options whose LOAD_OPTION_ACTIVE changed, then the deleted options.
+  //
+  Changes     = (BOOT_OPTION_CHANGE *)(Journal + 1);
+  ChangeCount = 0;
+  for (Index = 0; Index < OptionCount; Index++) {
+    OptionNumber = (UINT16)Options[Index].OptionNumber;
+    if (EFI_ERROR (GetBootOptionActive (OptionNumber, &Active))) {
+      continue;                           // Deleted by someone else.
+    }
+
+    if (Active != ((Options[Index].Attributes & LOAD_OPTION_ACTIVE) != 0)) {
+      Changes[ChangeCount].OptionNumber = OptionNumber;
+      Changes[ChangeCount].Action       = Active ? BOOT_OPTION_DEACTIVATE : BOOT_OPTION_ACTIVATE;
+      ChangeCount++;
+    }
+  }
+
+  for (Index = 0; Index < DeletedCount; Index++) {
+    Changes[ChangeCount].OptionNumber = Deleted[Index];
+    Changes[ChangeCount].Action       = BOOT_OPTION_DELETE;
+    ChangeCount++;
+  }
+
+  //
+  // The new BootOrder: the options in their new order, then any options added since.
+  //
+  NewOrder = (UINT16 *)(Changes + ChangeCount);
+  NewCount = 0;
+  for (Index = 0; Index < OptionCount; Index++) {
+    OptionNumber = (UINT16)Options[Index].OptionNumber;
+    Position     = FindOptionNumber (SortedOld, OldCount, OptionNumber);
+    if ((Position != MAX_UINTN) && !Kept[Position]) {
+      Kept[Position]       = TRUE;
+      NewOrder[NewCount++] = OptionNumber;
+    }
+  }
+
+  for (Index = 0; Index < OldCount; Index++) {
+    Position = FindOptionNumber (SortedOld, OldCount, OldOrder[Index]);
+    if (!Kept[Position] && (FindOptionNumber (SortedDeleted, DeletedCount, OldOrder[Index]) == MAX_UINTN)) {
+      Kept[Position]       = TRUE;
+      NewOrder[NewCount++] = OldOrder[Index];
+    }
+  }
+
+  OrderChanged = (BOOLEAN)((NewCount != OldCount) || (CompareMem (NewOrder, OldOrder, NewCount * sizeof (UINT16)) != 0));
+
+  Journal->Signature   = BOOT_OPTION_JOURNAL_SIGNATURE;
+  Journal->Flags       = OrderChanged ? BOOT_OPTION_JOURNAL_WRITE_BOOT_ORDER : 0;
+  Journal->ChangeCount = (UINT16)ChangeCount;
+  Journal->OrderCount  = OrderChanged ? (UINT16)NewCount : 0;
+  JournalSize          = sizeof (BOOT_OPTION_JOURNAL) +
+                         Journal->ChangeCount * sizeof (BOOT_OPTION_CHANGE) +
+                         Journal->OrderCount * sizeof (UINT16);
+
+  Writes = ChangeCount + (OrderChanged ? 1 : 0);
+  if (Writes == 0) {
+    goto Done;
+  }
+
+  //
+  // A single write is atomic by itself.  More than one goes through the journal.
+  //
+  if (Writes > 1) {
+    Status = gRT->SetVariable (
+                    BOOT_OPTION_JOURNAL_VARIABLE_NAME,
+                    &gMsBootMenuFormsetGuid,
+                    EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_NON_VOLATILE,
+                    JournalSize,
+                    Journal
+                    );
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a Error writing the journal. Nothing was changed. Code=%r\n", __FUNCTION__, Status));
+      goto Done;
+    }
+
+    *WriteCount += 1;
+  }
+
+  Status       = ApplyBootOptionJournal (Journal);
+  *WriteCount += Writes;
+
+  if (!EFI_ERROR (Status) && (Writes > 1)) {
+    gRT->SetVariable (BOOT_OPTION_JOURNAL_VARIABLE_NAME, &gMsBootMenuFormsetGuid, 0, 0, NULL);
+    *WriteCount += 1;
+  }
+
+Done:
+  if (OldOrder != NULL) {
+    FreePool (OldOrder);
+  }
+
+  if (SortedOld != NULL) {
+    FreePool (SortedOld);
+  }
+
+  if (SortedDeleted != NULL) {
+    FreePool (SortedDeleted);
+  }
+
+  if (Kept != NULL) {
+    FreePool (Kept);
+  }
+
+  if (Journal != NULL) {
+    FreePool (Journal);
+  }
+
+  return Status;
+}
+
+/**
+  Finishes a commit that was cut short, if a journal was left behind.  Called once variable
+  writes are available, before BDS reads BootOrder.
+
+**/
+VOID
+ReplayBootOptionJournal (
+  VOID
+  )
+{
+  EFI_STATUS           Status;
+  BOOT_OPTION_JOURNAL  *Journal;
+  UINTN                Size;
+
+  Status = GetVariable2 (BOOT_OPTION_JOURNAL_VARIABLE_NAME, &gMsBootMenuFormsetGuid, (VOID **)&Journal, &Size);
+  if (EFI_ERROR (Status)) {
+    return;                               // The last commit finished.
+  }
+
+  if ((Size < sizeof (BOOT_OPTION_JOURNAL)) ||
+      (Journal->Signature != BOOT_OPTION_JOURNAL_SIGNATURE) ||
+      (Size != sizeof (BOOT_OPTION_JOURNAL) + Journal->ChangeCount * sizeof (BOOT_OPTION_CHANGE) + Journal->OrderCount * sizeof (UINT16)))
+  {
+    DEBUG ((DEBUG_ERROR, "%a Discarding an invalid journal\n", __FUNCTION__));
+    Status = EFI_SUCCESS;
+  } else {
+    DEBUG ((DEBUG_INFO, "%a Finishing an interrupted commit of %d changes\n", __FUNCTION__, Journal->ChangeCount));
+    Status = ApplyBootOptionJournal (Journal);
+  }
+
+  // A journal that could not be applied is kept for the next boot.
+  if (!EFI_ERROR (Status)) {
+    gRT->SetVariable (BOOT_OPTION_JOURNAL_VARIABLE_NAME, &gMsBootMenuFormsetGuid, 0, 0, NULL);
+  }
+
+  FreePool (Journal);
+}
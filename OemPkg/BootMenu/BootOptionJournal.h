@@ -0,0 +1,83 @@
+/** @file
+  Crash-consistent commit of BootMenu's boot option changes.
+
+  BootMenu keeps its edits in memory and commits them when the form closes.  A commit that
+  needs more than one variable write first saves the whole change as one journal variable,
+  applies it, and then deletes the journal.  A journal left behind by a power cut is replayed
+  on the next boot, so either the old or the new boot configuration survives.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _BOOT_OPTION_JOURNAL_H_
+#define _BOOT_OPTION_JOURNAL_H_
+
+#define BOOT_OPTION_JOURNAL_VARIABLE_NAME  L"BootMenuJournal"
+#define BOOT_OPTION_JOURNAL_SIGNATURE      SIGNATURE_32 ('B', 'M', 'J', 'L')
+
+#define BOOT_OPTION_JOURNAL_WRITE_BOOT_ORDER  BIT0
+
+#define BOOT_OPTION_ACTIVATE    0
+#define BOOT_OPTION_DEACTIVATE  1
+#define BOOT_OPTION_DELETE      2
+
+#pragma pack(1)
+
+typedef struct {
+  UINT16    OptionNumber;
+  UINT16    Action;                       // BOOT_OPTION_ACTIVATE, _DEACTIVATE or _DELETE
+} BOOT_OPTION_CHANGE;
+
+typedef struct {
+  UINT32    Signature;                    // BOOT_OPTION_JOURNAL_SIGNATURE
+  UINT16    Flags;                        // BOOT_OPTION_JOURNAL_WRITE_BOOT_ORDER
+  UINT16    ChangeCount;
+  UINT16    OrderCount;
+  UINT16    Reserved;
+  // BOOT_OPTION_CHANGE  Changes[ChangeCount];
+  // UINT16              BootOrder[OrderCount];
+} BOOT_OPTION_JOURNAL;
+
+#pragma pack()
+
+/**
+  Writes the changes made to the boot options.  Only Boot#### variables whose LOAD_OPTION_ACTIVE
+  attribute changed, deleted options and a changed BootOrder are written.
+
+  Options are written in the order given.  Boot options that are in BootOrder but not in Options
+  or Deleted were added by someone else since BootMenu read them, and are kept at the end.
+
+  @param[in]  Options       The boot options, in their new order and with their new attributes.
+  @param[in]  OptionCount   Number of Options.
+  @param[in]  Deleted       Option numbers of the deleted boot options.
+  @param[in]  DeletedCount  Number of Deleted.
+  @param[out] WriteCount    Number of variable writes made, including the journal.
+
+  @retval     EFI_SUCCESS             The changes were written.
+  @retval     EFI_OUT_OF_RESOURCES    The journal could not be allocated.
+  @retval     Others                  Error writing the journal or a variable.  A journal that
+                                      was written is replayed on the next boot.
+
+**/
+EFI_STATUS
+CommitBootOptionChanges (
+  IN  CONST EFI_BOOT_MANAGER_LOAD_OPTION  *Options,
+  IN        UINTN                         OptionCount,
+  IN  CONST UINT16                        *Deleted,
+  IN        UINTN                         DeletedCount,
+  OUT       UINTN                         *WriteCount
+  );
+
+/**
+  Finishes a commit that was cut short, if a journal was left behind.  Called once variable
+  writes are available, before BDS reads BootOrder.
+
+**/
+VOID
+ReplayBootOptionJournal (
+  VOID
+  );
+
+#endif // _BOOT_OPTION_JOURNAL_H_
@@ -0,0 +1,144 @@
+/** @file
+  HII strings for the boot options in BootMenu's boot order list.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HiiLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootManagerLib.h>
+
+#include "BootMenu.h"
+#include "BootOptionPrompts.h"
+
+typedef struct {
+  EFI_STRING_ID    StringId;
+  BOOLEAN          InUse;             // The string belongs to OptionNumber.
+  BOOLEAN          Shown;             // The option is shown by the current rebuild.
+  UINT16           OptionNumber;
+  CHAR16           *Description;      // The string's current text.
+} BOOT_OPTION_PROMPT;
+
+//
+// A rebuild shows at most MAX_BOOT_OPTIONS_SUPPORTED options.  The strings of the options the
+// last rebuild showed stay in use until EndBootOptionPrompts (), even if those options are gone,
+// so a rebuild that replaces every option needs twice that many.
+//
+STATIC BOOT_OPTION_PROMPT  mPrompts[2 * MAX_BOOT_OPTIONS_SUPPORTED];
+STATIC UINTN               mPromptCount = 0;
+
+/**
+  Starts a rebuild of the boot order list.
+
+**/
+VOID
+StartBootOptionPrompts (
+  VOID
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < mPromptCount; Index++) {
+    mPrompts[Index].Shown = FALSE;
+  }
+}
+
+/**
+  Gets the string for a boot option's description.
+
+  @param[in]  HiiHandle     The HII package list of the form.
+  @param[in]  BootOption    The boot option.  Options are identified by their option number.
+  @param[out] Changed       Set to TRUE if the string was created or set.  Left as is otherwise.
+
+  @return     The string ID, or 0 if the string could not be set.
+
+**/
+EFI_STRING_ID
+GetBootOptionPrompt (
+  IN     EFI_HII_HANDLE                      HiiHandle,
+  IN     CONST EFI_BOOT_MANAGER_LOAD_OPTION  *BootOption,
+  IN OUT BOOLEAN                             *Changed
+  )
+{
+  BOOT_OPTION_PROMPT  *Prompt;
+  EFI_STRING_ID       StringId;
+  UINTN               Index;
+
+  Prompt = NULL;
+  for (Index = 0; Index < mPromptCount; Index++) {
+    if (mPrompts[Index].InUse && (mPrompts[Index].OptionNumber == (UINT16)BootOption->OptionNumber)) {
+      Prompt = &mPrompts[Index];
+      break;
+    }
+  }
+
+  if (Prompt == NULL) {
+    //
+    // A new option takes the string of an option that is gone, if there is one.
+    //
+    for (Index = 0; Index < mPromptCount; Index++) {
+      if (!mPrompts[Index].InUse) {
+        Prompt = &mPrompts[Index];
+        break;
+      }
+    }
+
+    if (Prompt == NULL) {
+      if (mPromptCount == ARRAY_SIZE (mPrompts)) {
+        ASSERT (FALSE);
+        return 0;
+      }
+
+      Prompt = &mPrompts[mPromptCount++];
+    }
+
+    Prompt->InUse        = TRUE;
+    Prompt->OptionNumber = (UINT16)BootOption->OptionNumber;
+  }
+
+  Prompt->Shown = TRUE;
+  if ((Prompt->StringId != 0) && (Prompt->Description != NULL) && (StrCmp (Prompt->Description, BootOption->Description) == 0)) {
+    return Prompt->StringId;
+  }
+
+  StringId = HiiSetString (HiiHandle, Prompt->StringId, BootOption->Description, NULL);
+  if (StringId == 0) {
+    DEBUG ((DEBUG_ERROR, "%a Unable to set the string for Boot%04x\n", __FUNCTION__, BootOption->OptionNumber));
+    return 0;
+  }
+
+  if (Prompt->Description != NULL) {
+    FreePool (Prompt->Description);
+  }
+
+  Prompt->StringId    = StringId;
+  Prompt->Description = AllocateCopyPool (StrSize (BootOption->Description), BootOption->Description);
+  *Changed            = TRUE;
+
+  return StringId;
+}
+
+/**
+  Ends a rebuild of the boot order list.  The strings of options that were not shown are kept
+  for reuse.
+
+**/
+VOID
+EndBootOptionPrompts (
+  VOID
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < mPromptCount; Index++) {
+    if (mPrompts[Index].InUse && !mPrompts[Index].Shown) {
+      mPrompts[Index].InUse = FALSE;
+    }
+  }
+}
@@ -0,0 +1,56 @@
+/** @file
+  HII strings for the boot options in BootMenu's boot order list.
+
+  Every boot option keeps its string while it is shown.  A string is only set again when the
+  description of its option changes, and the strings of options that a rebuild did not show are
+  reused for new options by later rebuilds, so the string package does not grow each time the
+  boot order form is opened.  It holds at most twice MAX_BOOT_OPTIONS_SUPPORTED strings.
+
+  A rebuild of the list is a StartBootOptionPrompts () call, a GetBootOptionPrompt () call for
+  each option shown, then an EndBootOptionPrompts () call.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _BOOT_OPTION_PROMPTS_H_
+#define _BOOT_OPTION_PROMPTS_H_
+
+/**
+  Starts a rebuild of the boot order list.
+
+**/
+VOID
+StartBootOptionPrompts (
+  VOID
+  );
+
+/**
+  Gets the string for a boot option's description.
+
+  @param[in]  HiiHandle     The HII package list of the form.
+  @param[in]  BootOption    The boot option.  Options are identified by their option number.
+  @param[out] Changed       Set to TRUE if the string was created or set.  Left as is otherwise.
+
+  @return     The string ID, or 0 if the string could not be set.
+
+**/
+EFI_STRING_ID
+GetBootOptionPrompt (
+  IN     EFI_HII_HANDLE                      HiiHandle,
+  IN     CONST EFI_BOOT_MANAGER_LOAD_OPTION  *BootOption,
+  IN OUT BOOLEAN                             *Changed
+  );
+
+/**
+  Ends a rebuild of the boot order list.  The strings of options that were not shown are kept
+  for reuse.
+
+**/
+VOID
+EndBootOptionPrompts (
+  VOID
+  );
+
+#endif
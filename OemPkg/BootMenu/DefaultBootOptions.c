@@ -0,0 +1,223 @@
+/** @file
+  Index of the platform default boot options for BootMenu.
+
+  The index is an open addressing hash table of the default boot options, keyed by the CRC32 of
+  their device paths.  It is sized to at least twice the number of options, so probes are short.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Protocol/DevicePath.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/DevicePathLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MsBootOptionsLib.h>
+#include <Library/UefiBootManagerLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+#include "DefaultBootOptions.h"
+
+typedef struct {
+  UINT32    Hash;
+  UINT32    Option;                       // Index into mDefaultLoadOptions + 1.  0 for an empty slot.
+} DEFAULT_OPTION_SLOT;
+
+STATIC EFI_BOOT_MANAGER_LOAD_OPTION  *mDefaultLoadOptions    = NULL;
+STATIC UINTN                         mDefaultLoadOptionCount = 0;
+STATIC DEFAULT_OPTION_SLOT           *mDefaultIndex          = NULL;
+STATIC UINTN                         mDefaultIndexMask       = 0;
+
+/**
+  Hashes the device path of a boot option.
+
+  @param[in]  BootOption    The boot option.
+
+  @return     CRC32 of the device path.  0 if it has none.
+
+**/
+STATIC
+UINT32
+HashBootOption (
+  IN  CONST EFI_BOOT_MANAGER_LOAD_OPTION  *BootOption
+  )
+{
+  UINT32  Hash = 0;
+
+  if (BootOption->FilePath != NULL) {
+    gBS->CalculateCrc32 (BootOption->FilePath, GetDevicePathSize (BootOption->FilePath), &Hash);
+  }
+
+  return Hash;
+}
+
+/**
+  Compares two boot options the way EfiBootManagerFindLoadOption () does, except that
+  LOAD_OPTION_ACTIVE is ignored.
+
+  @param[in]  Option1   A boot option.
+  @param[in]  Option2   Another boot option.
+
+  @retval     TRUE      The options match.
+  @retval     FALSE     They don't.
+
+**/
+STATIC
+BOOLEAN
+IsSameBootOption (
+  IN  CONST EFI_BOOT_MANAGER_LOAD_OPTION  *Option1,
+  IN  CONST EFI_BOOT_MANAGER_LOAD_OPTION  *Option2
+  )
+{
+  UINTN  PathSize;
+
+  if ((Option1->OptionType != Option2->OptionType) ||
+      (((Option1->Attributes ^ Option2->Attributes) & ~LOAD_OPTION_ACTIVE) != 0) ||
+      (Option1->OptionalDataSize != Option2->OptionalDataSize))
+  {
+    return FALSE;
+  }
+
+  if ((Option1->FilePath == NULL) || (Option2->FilePath == NULL)) {
+    return (BOOLEAN)(Option1->FilePath == Option2->FilePath);
+  }
+
+  PathSize = GetDevicePathSize (Option1->FilePath);
+  if ((PathSize != GetDevicePathSize (Option2->FilePath)) ||
+      (CompareMem (Option1->FilePath, Option2->FilePath, PathSize) != 0))
+  {
+    return FALSE;
+  }
+
+  if ((Option1->OptionalDataSize != 0) &&
+      (CompareMem (Option1->OptionalData, Option2->OptionalData, Option1->OptionalDataSize) != 0))
+  {
+    return FALSE;
+  }
+
+  if ((Option1->Description == NULL) || (Option2->Description == NULL)) {
+    return (BOOLEAN)(Option1->Description == Option2->Description);
+  }
+
+  return (BOOLEAN)(StrCmp (Option1->Description, Option2->Description) == 0);
+}
+
+/**
+  Gets the default boot options and indexes them.
+
+  @retval     TRUE      The index is ready.
+  @retval     FALSE     The default boot options, or memory for the index, are not available.
+
+**/
+STATIC
+BOOLEAN
+BuildDefaultIndex (
+  VOID
+  )
+{
+  UINTN   Index;
+  UINTN   Slot;
+  UINTN   SlotCount;
+  UINT32  Hash;
+
+  mDefaultLoadOptions = MsBootOptionsLibGetDefaultOptions (&mDefaultLoadOptionCount);
+  if (NULL == mDefaultLoadOptions) {
+    DEBUG ((DEBUG_ERROR, "%a Error obtaining default boot options\n", __FUNCTION__));
+    mDefaultLoadOptionCount = 0;
+    return FALSE;
+  }
+
+  SlotCount = 8;
+  while (SlotCount < mDefaultLoadOptionCount * 2) {
+    SlotCount *= 2;
+  }
+
+  mDefaultIndex = AllocateZeroPool (SlotCount * sizeof (DEFAULT_OPTION_SLOT));
+  if (NULL == mDefaultIndex) {
+    InvalidateDefaultBootOptions ();
+    return FALSE;
+  }
+
+  mDefaultIndexMask = SlotCount - 1;
+
+  for (Index = 0; Index < mDefaultLoadOptionCount; Index++) {
+    Hash = HashBootOption (&mDefaultLoadOptions[Index]);
+    for (Slot = Hash & mDefaultIndexMask; mDefaultIndex[Slot].Option != 0; Slot = (Slot + 1) & mDefaultIndexMask) {
+    }
+
+    mDefaultIndex[Slot].Hash   = Hash;
+    mDefaultIndex[Slot].Option = (UINT32)(Index + 1);
+  }
+
+  DEBUG ((DEBUG_INFO, "%a %d default boot options in %d slots\n", __FUNCTION__, mDefaultLoadOptionCount, SlotCount));
+
+  return TRUE;
+}
+
+/**
+  Checks if a boot option is one of the platform default boot options.  Default boot options
+  can't be deleted from BootMenu.
+
+  The LOAD_OPTION_ACTIVE attribute is ignored, as the user may have disabled a default option.
+
+  @param[in]  BootOption    The boot option.
+
+  @retval     TRUE          BootOption is a default boot option.
+  @retval     FALSE         It isn't, or the default boot options are not available.
+
+**/
+BOOLEAN
+IsDefaultBootOption (
+  IN  CONST EFI_BOOT_MANAGER_LOAD_OPTION  *BootOption
+  )
+{
+  UINTN                         Slot;
+  UINT32                        Hash;
+  EFI_BOOT_MANAGER_LOAD_OPTION  *Default;
+
+  if ((NULL == mDefaultIndex) && !BuildDefaultIndex ()) {
+    return FALSE;
+  }
+
+  Hash = HashBootOption (BootOption);
+  for (Slot = Hash & mDefaultIndexMask; mDefaultIndex[Slot].Option != 0; Slot = (Slot + 1) & mDefaultIndexMask) {
+    if (mDefaultIndex[Slot].Hash == Hash) {
+      Default = &mDefaultLoadOptions[mDefaultIndex[Slot].Option - 1];
+      if (IsSameBootOption (BootOption, Default)) {
+        return TRUE;
+      }
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+  Frees the default boot option index, so the next lookup rebuilds it.  Called when the form
+  closes and after BootMenu writes Boot#### variables.
+
+**/
+VOID
+InvalidateDefaultBootOptions (
+  VOID
+  )
+{
+  if (mDefaultIndex != NULL) {
+    FreePool (mDefaultIndex);
+    mDefaultIndex = NULL;
+  }
+
+  if (mDefaultLoadOptions != NULL) {
+    EfiBootManagerFreeLoadOptions (mDefaultLoadOptions, mDefaultLoadOptionCount);
+    mDefaultLoadOptions = NULL;
+  }
+
+  mDefaultLoadOptionCount = 0;
+  mDefaultIndexMask       = 0;
+}
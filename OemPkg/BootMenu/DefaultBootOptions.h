@@ -0,0 +1,43 @@
+/** @file
+  Index of the platform default boot options for BootMenu.
+
+  MsBootOptionsLib builds the default boot options on every call, so BootMenu builds them once
+  per form session and indexes them by a hash of their device path.  Looking up a boot option
+  is then one hash and, usually, one compare.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _DEFAULT_BOOT_OPTIONS_H_
+#define _DEFAULT_BOOT_OPTIONS_H_
+
+/**
+  Checks if a boot option is one of the platform default boot options.  Default boot options
+  can't be deleted from BootMenu.
+
+  The LOAD_OPTION_ACTIVE attribute is ignored, as the user may have disabled a default option.
+
+  @param[in]  BootOption    The boot option.
+
+  @retval     TRUE          BootOption is a default boot option.
+  @retval     FALSE         It isn't, or the default boot options are not available.
+
+**/
+BOOLEAN
+IsDefaultBootOption (
+  IN  CONST EFI_BOOT_MANAGER_LOAD_OPTION  *BootOption
+  );
+
+/**
+  Frees the default boot option index, so the next lookup rebuilds it.  Called when the form
+  closes and after BootMenu writes Boot#### variables.
+
+**/
+VOID
+InvalidateDefaultBootOptions (
+  VOID
+  );
+
+#endif // _DEFAULT_BOOT_OPTIONS_H_
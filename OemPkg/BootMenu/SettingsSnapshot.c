@@ -0,0 +1,110 @@
+/** @file
+  Snapshot of a group of DFCI settings for BootMenu.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <DfciSystemSettingTypes.h>
+
+#include <Protocol/DfciSettingAccess.h>
+
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+#include "SettingsSnapshot.h"
+
+STATIC SETTING_SNAPSHOT              *mSnapshot     = NULL;
+STATIC UINTN                         mSnapshotCount = 0;
+STATIC CONST DFCI_SETTING_ID_STRING  *mSnapshotIds  = NULL;
+
+/**
+  Gets a snapshot of a group of settings.  The settings are read when the group is first asked
+  for, and after the snapshot is invalidated.
+
+  @param[in]  SettingAccess   The setting access protocol.
+  @param[in]  AuthToken       Auth token to read the settings with.
+  @param[in]  Ids             The settings in the group.  The array must stay valid while the
+                              snapshot is used, as it identifies the group.
+  @param[in]  Count           Number of settings in the group.
+  @param[out] Snapshot        Count entries, in the order of Ids.  Each one has the status of
+                              its own Get.  The snapshot stays valid until it is invalidated.
+
+  @retval     EFI_SUCCESS             Snapshot is set.
+  @retval     EFI_INVALID_PARAMETER   A parameter is NULL or Count is 0.
+  @retval     EFI_OUT_OF_RESOURCES    The snapshot could not be allocated.
+
+**/
+EFI_STATUS
+GetSettingsSnapshot (
+  IN  DFCI_SETTING_ACCESS_PROTOCOL  *SettingAccess,
+  IN  CONST DFCI_AUTH_TOKEN         *AuthToken,
+  IN  CONST DFCI_SETTING_ID_STRING  *Ids,
+  IN  UINTN                         Count,
+  OUT CONST SETTING_SNAPSHOT        **Snapshot
+  )
+{
+  UINTN  Index;
+  UINTN  ValueSize;
+
+  if ((SettingAccess == NULL) || (AuthToken == NULL) || (Ids == NULL) || (Count == 0) || (Snapshot == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if ((mSnapshot != NULL) && (mSnapshotIds == Ids) && (mSnapshotCount == Count)) {
+    *Snapshot = mSnapshot;
+    return EFI_SUCCESS;
+  }
+
+  InvalidateSettingsSnapshot ();
+
+  mSnapshot = (SETTING_SNAPSHOT *)AllocateZeroPool (sizeof (SETTING_SNAPSHOT) * Count);
+  if (mSnapshot == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    mSnapshot[Index].Id     = Ids[Index];
+    ValueSize               = sizeof (mSnapshot[Index].Value);
+    mSnapshot[Index].Status = SettingAccess->Get (
+                                               SettingAccess,
+                                               Ids[Index],
+                                               AuthToken,
+                                               DFCI_SETTING_TYPE_ENABLE,
+                                               &ValueSize,
+                                               &mSnapshot[Index].Value,
+                                               &mSnapshot[Index].Flags
+                                               );
+    if (EFI_ERROR (mSnapshot[Index].Status)) {
+      DEBUG ((DEBUG_ERROR, "%a Error getting setting %a - code=%r\n", __FUNCTION__, Ids[Index], mSnapshot[Index].Status));
+    }
+  }
+
+  mSnapshotIds   = Ids;
+  mSnapshotCount = Count;
+  *Snapshot      = mSnapshot;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Drops the snapshot, so the next GetSettingsSnapshot () reads the settings again.  Called after
+  any setting is set and when the form closes.
+
+**/
+VOID
+InvalidateSettingsSnapshot (
+  VOID
+  )
+{
+  if (mSnapshot != NULL) {
+    FreePool (mSnapshot);
+    mSnapshot = NULL;
+  }
+
+  mSnapshotIds   = NULL;
+  mSnapshotCount = 0;
+}
@@ -0,0 +1,60 @@
+/** @file
+  Snapshot of a group of DFCI settings for BootMenu.
+
+  Every DFCI Get does its own authentication and permission checks, and each one returns the
+  value and the permission flags of the setting together.  The form builds its settings, grayout
+  and suppress varstores from the same few settings, so they are read once into a snapshot that
+  serves all three.  The snapshot is kept until a setting is set or the form closes.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _SETTINGS_SNAPSHOT_H_
+#define _SETTINGS_SNAPSHOT_H_
+
+typedef struct {
+  DFCI_SETTING_ID_STRING    Id;
+  EFI_STATUS                Status;   // Status of the Get.  EFI_NOT_FOUND if the setting has no provider.
+  UINT8                     Value;    // Only valid if Status is EFI_SUCCESS.
+  DFCI_SETTING_FLAGS        Flags;    // DFCI_SETTING_FLAGS_OUT_*.  Only valid if Status is EFI_SUCCESS.
+} SETTING_SNAPSHOT;
+
+/**
+  Gets a snapshot of a group of settings.  The settings are read when the group is first asked
+  for, and after the snapshot is invalidated.
+
+  @param[in]  SettingAccess   The setting access protocol.
+  @param[in]  AuthToken       Auth token to read the settings with.
+  @param[in]  Ids             The settings in the group.  The array must stay valid while the
+                              snapshot is used, as it identifies the group.
+  @param[in]  Count           Number of settings in the group.
+  @param[out] Snapshot        Count entries, in the order of Ids.  Each one has the status of
+                              its own Get.  The snapshot stays valid until it is invalidated.
+
+  @retval     EFI_SUCCESS             Snapshot is set.
+  @retval     EFI_INVALID_PARAMETER   A parameter is NULL or Count is 0.
+  @retval     EFI_OUT_OF_RESOURCES    The snapshot could not be allocated.
+
+**/
+EFI_STATUS
+GetSettingsSnapshot (
+  IN  DFCI_SETTING_ACCESS_PROTOCOL  *SettingAccess,
+  IN  CONST DFCI_AUTH_TOKEN         *AuthToken,
+  IN  CONST DFCI_SETTING_ID_STRING  *Ids,
+  IN  UINTN                         Count,
+  OUT CONST SETTING_SNAPSHOT        **Snapshot
+  );
+
+/**
+  Drops the snapshot, so the next GetSettingsSnapshot () reads the settings again.  Called after
+  any setting is set and when the form closes.
+
+**/
+VOID
+InvalidateSettingsSnapshot (
+  VOID
+  );
+
+#endif
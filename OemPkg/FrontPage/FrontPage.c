@@ -13,6 +13,12 @@
 #include "String.h"
 #include "FrontPageUi.h"
 #include "FrontPageConfigAccess.h"
+#include "FrontPageBitmapCache.h"
+#include "FrontPageCompositor.h"
+#include "FrontPageFmpSnapshot.h"
+#include "FrontPageFormNavigation.h"
+#include "FrontPageFormsetRegistry.h"
+#include "FrontPageTiming.h"
 
 #include <IndustryStandard/SmBios.h>
 
@@ -28,11 +34,11 @@
 #include <Pi/PiFirmwareFile.h>
 
 #include <Protocol/GraphicsOutput.h>
-#include <Protocol/Smbios.h>
 #include <Protocol/OnScreenKeyboard.h>
 #include <Protocol/SimpleWindowManager.h>
 #include <Protocol/FirmwareManagement.h>
 #include <Protocol/VariablePolicy.h>
+#include <Protocol/OemConnectAllComplete.h>
 
 #include <Library/DebugLib.h>
 #include <Library/BaseMemoryLib.h>
@@ -56,11 +62,15 @@
 #include <Library/MuSecureBootKeySelectorLib.h>
 #include <Library/SecureBootKeyStoreLib.h>
 #include <Library/SwmDialogsLib.h>
+#include <Library/TimerLib.h>
+#include <Library/SmbiosStringLib.h>
+#include <Library/PasswordStoreSessionLib.h>
 
 #include <MsDisplayEngine.h>
 #include <UIToolKit/SimpleUIToolKit.h>
 
-#define FP_OSK_WIDTH_PERCENT  75            // On-screen keyboard is 75% the width of the screen.
+#define FP_OSK_WIDTH_PERCENT       75                                    // On-screen keyboard is 75% the width of the screen.
+#define FP_DEFERRED_CONNECT_DELAY  EFI_TIMER_PERIOD_MILLISECONDS (100)   // Lets the browser show the first form before the deferred connect.
 
 UINTN       mCallbackKey;
 EFI_HANDLE  mImageHandle;
@@ -75,6 +85,11 @@ EFI_HII_FONT_PROTOCOL         *mFont;
 UINT32   mTitleBarWidth, mTitleBarHeight;
 UINT32   mMasterFrameWidth, mMasterFrameHeight;
 ListBox  *mTopMenu;
+
+// Off-screen surfaces for the FrontPage chrome.  The master frame surface also holds the top menu.
+//
+FP_SURFACE  *mTitleBarSurface    = NULL;
+FP_SURFACE  *mMasterFrameSurface = NULL;
 BOOLEAN  mShowFullMenu = FALSE;     // By default we won't show the full FrontPage menu (requires validation if there's a system password).
 
 // Master Frame - Form Notifications.
@@ -89,9 +104,35 @@ DFCI_AUTHENTICATION_PROTOCOL     *mAuthProtocol               = NULL;
 EFI_HII_CONFIG_ROUTING_PROTOCOL  *mHiiConfigRouting;
 DFCI_SETTING_ACCESS_PROTOCOL     *mSettingAccess;
 DFCI_AUTH_TOKEN                  mAuthToken;
+PASSWORD_STORE_SESSION_TOKEN     mPasswordSession;            // Started at the first unlock, ended when FrontPage exits.
 SECURE_BOOT_PAYLOAD_INFO         *mSecureBootKeys     = NULL;
 UINT8                            mSecureBootKeysCount = 0;
 
+// Staged controller connection.
+//
+BOOLEAN    mDeferredConnectPending = FALSE;
+EFI_EVENT  mDeferredConnectEvent   = NULL;
+
+// String IDs of the firmware version list, one pair per FMP descriptor.  Kept so that the list
+// can be rebuilt without adding strings to the package.
+//
+typedef struct {
+  EFI_STRING_ID    ImageIdName;
+  EFI_STRING_ID    VersionName;
+} FP_FW_VERSION_STRINGS;
+
+FP_FW_VERSION_STRINGS  *mFwVersionStrings     = NULL;
+UINTN                  mFwVersionStringsCount = 0;
+
+// Persistent form-browser session and form switch timing.
+//
+BOOLEAN  mPersistentSession    = FALSE;
+BOOLEAN  mNavigationQueued     = FALSE;
+UINT64   mFormSwitchStartTicks = 0;
+UINT64   mFormSwitchTotalUs    = 0;
+UINT64   mFormSwitchMaxUs      = 0;
+UINTN    mFormSwitchCount      = 0;
+
 extern EFI_HII_HANDLE  gStringPackHandle;
 extern EFI_GUID        gMsEventMasterFrameNotifyGroupGuid;
 
@@ -106,25 +147,25 @@ MS_ONSCREEN_KEYBOARD_PROTOCOL      *mOSKProtocol;
 MS_SIMPLE_WINDOW_MANAGER_PROTOCOL  *mSWMProtocol;
 EDKII_VARIABLE_POLICY_PROTOCOL     *mVariablePolicyProtocol;
 
-// Map Top Menu entries to HII Form IDs.
+// Top Menu entries provided by FrontPage.  Other drivers add entries by installing
+// FRONT_PAGE_MENU_ENTRY_PROTOCOL.
 //
-#define UNUSED_INDEX  (UINT16)-1
-struct {
-  UINT16           FullMenuIndex;       // Master Frame full menu index.
-  UINT16           LimitedMenuIndex;    // Master Frame limited menu index.
+STATIC CONST struct {
+  UINT16           Position;            // Master Frame menu position.
+  BOOLEAN          LimitedMenu;         // Shown in the limited menu as well as the full menu.
   EFI_STRING_ID    MenuString;          // Master Frame menu string.
   EFI_GUID         FormSetGUID;         // HII FormSet GUID.
   EFI_FORM_ID      FormId;              // HII Form ID.
 } mFormMap[] =
 {
-  //    Index (Full)  Index (Limited)     String                                      Formset Guid                       Form ID
+  //    Position                           Limited  String                                      Formset Guid                       Form ID
   // -------------------------------------------------------------------------------------------------------------------------------------------------------------------
-  { 0, 0,            STRING_TOKEN (STR_MF_MENU_OP_PCINFO),    FRONT_PAGE_CONFIG_FORMSET_GUID, FRONT_PAGE_FORM_ID_PCINFO   },                           // PC info
-  { 1, UNUSED_INDEX, STRING_TOKEN (STR_MF_MENU_OP_SECURITY),  FRONT_PAGE_CONFIG_FORMSET_GUID, FRONT_PAGE_FORM_ID_SECURITY },                           // Security
-  { 2, UNUSED_INDEX, STRING_TOKEN (STR_MF_MENU_OP_BOOTORDER), MS_BOOT_MENU_FORMSET_GUID,      MS_BOOT_ORDER_FORM_ID       },                           // Boot Order
-  { 3, 1,            STRING_TOKEN (STR_MF_MENU_OP_DFCI),      DFCI_MENU_FORMSET_GUID,         DFCI_MENU_FORM_ID           },                           // DFCI
-  { 4, UNUSED_INDEX, STRING_TOKEN (STR_MF_MENU_OP_HWH),       HWH_MENU_FORMSET_GUID,          HWH_MENU_FORM_ID            },                           // HWH
-  { 5, 2,            STRING_TOKEN (STR_MF_MENU_OP_EXIT),      FRONT_PAGE_CONFIG_FORMSET_GUID, FRONT_PAGE_FORM_ID_EXIT     }                            // Exit
+  { FRONT_PAGE_MENU_POSITION_PCINFO,    TRUE,  STRING_TOKEN (STR_MF_MENU_OP_PCINFO),    FRONT_PAGE_CONFIG_FORMSET_GUID, FRONT_PAGE_FORM_ID_PCINFO   },       // PC info
+  { FRONT_PAGE_MENU_POSITION_SECURITY,  FALSE, STRING_TOKEN (STR_MF_MENU_OP_SECURITY),  FRONT_PAGE_CONFIG_FORMSET_GUID, FRONT_PAGE_FORM_ID_SECURITY },       // Security
+  { FRONT_PAGE_MENU_POSITION_BOOTORDER, FALSE, STRING_TOKEN (STR_MF_MENU_OP_BOOTORDER), MS_BOOT_MENU_FORMSET_GUID,      MS_BOOT_ORDER_FORM_ID       },       // Boot Order
+  { FRONT_PAGE_MENU_POSITION_DFCI,      TRUE,  STRING_TOKEN (STR_MF_MENU_OP_DFCI),      DFCI_MENU_FORMSET_GUID,         DFCI_MENU_FORM_ID           },       // DFCI
+  { FRONT_PAGE_MENU_POSITION_HWH,       FALSE, STRING_TOKEN (STR_MF_MENU_OP_HWH),       HWH_MENU_FORMSET_GUID,          HWH_MENU_FORM_ID            },       // HWH
+  { FRONT_PAGE_MENU_POSITION_EXIT,      TRUE,  STRING_TOKEN (STR_MF_MENU_OP_EXIT),      FRONT_PAGE_CONFIG_FORMSET_GUID, FRONT_PAGE_FORM_ID_EXIT     }        // Exit
 };
 
 // Frontpage form set GUID
@@ -184,57 +225,6 @@ GetAndDisplayBitmap (
   BOOLEAN   XCoordAdj
   );
 
-/**
-
-  Acquire the string associated with the Index from smbios structure and return it.
-  The caller is responsible for free the string buffer.
-
-  @param    OptionalStrStart  The start position to search the string
-  @param    Index             The index of the string to extract
-  @param    String            The string that is extracted
-
-  @retval   EFI_SUCCESS       The function returns EFI_SUCCESS if found the string.
-  @retval   EFI_NOT_FOUND     If the target string is not found.
-
-**/
-STATIC
-EFI_STATUS
-GetOptionalStringByIndex (
-  IN  CHAR8   *OptionalStrStart,
-  UINT8       Index,
-  OUT CHAR16  **String
-  )
-{
-  UINTN  StrSize;
-
-  if (Index == 0) {
-    *String = AllocateZeroPool (sizeof (CHAR16));
-    return EFI_SUCCESS;
-  }
-
-  StrSize = 0;
-  do {
-    Index--;
-    OptionalStrStart += StrSize;
-    StrSize           = AsciiStrSize (OptionalStrStart);
-  } while (OptionalStrStart[StrSize] != 0 && Index != 0);
-
-  if ((Index != 0) || (StrSize == 1)) {
-    //
-    // Meet the end of strings set but Index is non-zero, or
-    // Find an empty string
-    //
-    FreePool (*String);
-    *String = NULL;
-    return EFI_NOT_FOUND;
-  } else {
-    *String = AllocatePool (StrSize * sizeof (CHAR16));
-    AsciiStrToUnicodeStrS (OptionalStrStart, *String, StrSize);
-  }
-
-  return EFI_SUCCESS;
-}
-
 /**
   Updates HII display strings based on associated EFI variable state.
 
@@ -249,31 +239,19 @@ UpdateDisplayStrings (
   IN EFI_HII_HANDLE  HiiHandle
   )
 {
-  EFI_STATUS  Status = EFI_SUCCESS;
-  CHAR16      *NewString;
-
-  EFI_SMBIOS_PROTOCOL      *SmbiosProtocol;
-  EFI_SMBIOS_HANDLE        SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
-  EFI_SMBIOS_TABLE_HEADER  *Record;
-  SMBIOS_TYPE              Type;
-  SMBIOS_TABLE_TYPE1       *Type1Record;
-  SMBIOS_TABLE_TYPE3       *Type3Record;
-
-  Status = gBS->LocateProtocol (&gEfiSmbiosProtocolGuid, NULL, (VOID **)&SmbiosProtocol);
-  if (EFI_ERROR (Status)) {
-    DEBUG ((EFI_D_ERROR, "Could not locate SMBIOS protocol.  %r\n", Status));
-    return Status;
-  }
+  EFI_STATUS                     Status;
+  CHAR16                         *NewString;
+  CONST CHAR16                   *SmbiosString;
+  CONST EFI_SMBIOS_TABLE_HEADER  *Record;
+  CONST SMBIOS_TABLE_TYPE1       *Type1Record;
+  CONST SMBIOS_TABLE_TYPE3       *Type3Record;
 
-  SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;      // Reset handle
-  Type         = SMBIOS_TYPE_SYSTEM_INFORMATION; // Smbios type1
-  Status       = SmbiosProtocol->GetNext (SmbiosProtocol, &SmbiosHandle, &Type, &Record, NULL);
+  Status = SmbiosStringGetRecord (SMBIOS_TYPE_SYSTEM_INFORMATION, 0, &Record);
   if (!EFI_ERROR (Status)) {
-    Type1Record = (SMBIOS_TABLE_TYPE1 *)Record;
-    Status      = GetOptionalStringByIndex ((CHAR8 *)((UINT8 *)Type1Record + Type1Record->Hdr.Length), Type1Record->ProductName, &NewString);
+    Type1Record = (CONST SMBIOS_TABLE_TYPE1 *)Record;
+    Status      = SmbiosStringGetUnicode (SMBIOS_TYPE_SYSTEM_INFORMATION, 0, Type1Record->ProductName, &SmbiosString, NULL);
     if (!EFI_ERROR (Status)) {
-      HiiSetString (HiiHandle, STRING_TOKEN (STR_INF_VIEW_PC_MODEL_VALUE), NewString, NULL);
-      FreePool (NewString);
+      HiiSetString (HiiHandle, STRING_TOKEN (STR_INF_VIEW_PC_MODEL_VALUE), (EFI_STRING)SmbiosString, NULL);
     }
 
     NewString = AllocatePool ((GUID_STRING_LENGTH + 1) * sizeof (CHAR16));
@@ -290,21 +268,17 @@ UpdateDisplayStrings (
     }
   }
 
-  SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;    // Reset handle
-  Type         = SMBIOS_TYPE_SYSTEM_ENCLOSURE; // Smbios type3
-  Status       = SmbiosProtocol->GetNext (SmbiosProtocol, &SmbiosHandle, &Type, &Record, NULL);
+  Status = SmbiosStringGetRecord (SMBIOS_TYPE_SYSTEM_ENCLOSURE, 0, &Record);
   if (!EFI_ERROR (Status)) {
-    Type3Record = (SMBIOS_TABLE_TYPE3 *)Record;
-    Status      = GetOptionalStringByIndex ((CHAR8 *)((UINT8 *)Type3Record + Type3Record->Hdr.Length), Type3Record->AssetTag, &NewString);
+    Type3Record = (CONST SMBIOS_TABLE_TYPE3 *)Record;
+    Status      = SmbiosStringGetUnicode (SMBIOS_TYPE_SYSTEM_ENCLOSURE, 0, Type3Record->AssetTag, &SmbiosString, NULL);
     if (!EFI_ERROR (Status)) {
-      HiiSetString (HiiHandle, STRING_TOKEN (STR_INF_VIEW_PC_ASSET_TAG_VALUE), NewString, NULL);
-      FreePool (NewString);
+      HiiSetString (HiiHandle, STRING_TOKEN (STR_INF_VIEW_PC_ASSET_TAG_VALUE), (EFI_STRING)SmbiosString, NULL);
     }
 
-    Status = GetOptionalStringByIndex ((CHAR8 *)((UINT8 *)Type3Record + Type3Record->Hdr.Length), Type3Record->SerialNumber, &NewString);
+    Status = SmbiosStringGetUnicode (SMBIOS_TYPE_SYSTEM_ENCLOSURE, 0, Type3Record->SerialNumber, &SmbiosString, NULL);
     if (!EFI_ERROR (Status)) {
-      HiiSetString (HiiHandle, STRING_TOKEN (STR_INF_VIEW_PC_SERIALNUM_VALUE), NewString, NULL);
-      FreePool (NewString);
+      HiiSetString (HiiHandle, STRING_TOKEN (STR_INF_VIEW_PC_SERIALNUM_VALUE), (EFI_STRING)SmbiosString, NULL);
     }
   }
 
@@ -315,36 +289,32 @@ UpdateDisplayStrings (
 Function to populate the PC INFO firmware version form with the current fw versions
 found using FMP.
 
+Every descriptor of every FMP instance is shown.  The descriptors come from the FMP
+snapshot, which is captured once per boot and recaptured after a capsule update.
+
+The form can be rebuilt, e.g. after the deferred connect.  The n-th descriptor reuses the
+string IDs of the n-th descriptor of the previous build, so only descriptors beyond the
+previous count add strings.
+
 **/
 VOID
 UpdateFormWithFirmwareVersions (
   IN EFI_HII_HANDLE  HiiHandle
   )
 {
-  EFI_STATUS          Status;
-  VOID                *StartOpCodeHandle;
-  VOID                *EndOpCodeHandle = NULL;
-  EFI_IFR_GUID_LABEL  *StartLabel;
-  EFI_IFR_GUID_LABEL  *EndLabel;
-  EFI_STRING_ID       StringId;
-  EFI_STRING_ID       StringId1;
-
-  EFI_FIRMWARE_MANAGEMENT_PROTOCOL  **FmpList;
-  UINTN                             FmpCount;
-  UINTN                             Index;
-  EFI_FIRMWARE_MANAGEMENT_PROTOCOL  *Fmp;
-  UINTN                             DescriptorSize;
-  EFI_FIRMWARE_IMAGE_DESCRIPTOR     *FmpImageInfoBuf;
-  UINT8                             FmpImageInfoCount;
-  UINT32                            FmpImageInfoDescriptorVer;
-  UINTN                             ImageInfoSize;
-  UINT32                            PackageVersion;
-  CHAR16                            *PackageVersionName;
-
-  FmpImageInfoBuf    = NULL;
-  Fmp                = NULL;
-  FmpList            = NULL;
-  PackageVersionName = NULL;
+  EFI_STATUS                 Status;
+  VOID                       *StartOpCodeHandle;
+  VOID                       *EndOpCodeHandle = NULL;
+  EFI_IFR_GUID_LABEL         *StartLabel;
+  EFI_IFR_GUID_LABEL         *EndLabel;
+  EFI_STRING_ID              StringId;
+  EFI_STRING_ID              StringId1;
+  CONST FMP_SNAPSHOT_HEADER  *Snapshot;
+  FMP_SNAPSHOT_ENTRY         *Entry;
+  CHAR16                     *ImageIdName;
+  CHAR16                     *VersionName;
+  UINT32                     Index;
+  FP_FW_VERSION_STRINGS      *Strings;
 
   do {
     //
@@ -378,85 +348,61 @@ UpdateFormWithFirmwareVersions (
     EndLabel->Number   = LABEL_PCINFO_FW_VERSION_TAG_END;
 
     //
-    // Get all FMP instances and then use the descriptor to get string name and version
+    // Get the descriptors of all FMP instances and use them to get string name and version
     //
-    Status = EfiLocateProtocolBuffer (&gEfiFirmwareManagementProtocolGuid, &FmpCount, (VOID *)&FmpList);
+    Status = GetFmpSnapshot (&Snapshot);
     if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "EfiLocateProtocolBuffer(gEfiFirmwareManagementProtocolGuid) returned error.  %r \n", Status));
+      DEBUG ((DEBUG_ERROR, "%a - Unable to get FMP descriptor snapshot.  %r \n", __FUNCTION__, Status));
       break;
     }
 
-    for (Index = 0; Index < FmpCount; Index++) {
-      Fmp = (EFI_FIRMWARE_MANAGEMENT_PROTOCOL *)(FmpList[Index]);
-      // get the GetImageInfo for the FMP
-
-      ImageInfoSize = 0;
-      //
-      // get necessary descriptor size
-      // this should return TOO SMALL
-      Status = Fmp->GetImageInfo (
-                      Fmp,                        // FMP Pointer
-                      &ImageInfoSize,             // Buffer Size (in this case 0)
-                      NULL,                       // NULL so we can get size
-                      &FmpImageInfoDescriptorVer, // DescriptorVersion
-                      &FmpImageInfoCount,         // DescriptorCount
-                      &DescriptorSize,            // DescriptorSize
-                      &PackageVersion,            // PackageVersion
-                      &PackageVersionName         // PackageVersionName
-                      );
-
-      if (Status != EFI_BUFFER_TOO_SMALL) {
-        DEBUG ((DEBUG_ERROR, "%a - Unexpected Failure in GetImageInfo.  Status = %r\n", __FUNCTION__, Status));
-        continue;
-      }
-
-      FmpImageInfoBuf = NULL;
-      FmpImageInfoBuf = AllocateZeroPool (ImageInfoSize);
-      if (FmpImageInfoBuf == NULL) {
-        DEBUG ((DEBUG_ERROR, "%a - Failed to get memory for descriptors.\n", __FUNCTION__));
-        continue;
+    //
+    // Grow the string ID table for descriptors that the previous build did not have.
+    //
+    if (Snapshot->EntryCount > mFwVersionStringsCount) {
+      Strings = AllocateZeroPool (Snapshot->EntryCount * sizeof (FP_FW_VERSION_STRINGS));
+      if (Strings == NULL) {
+        DEBUG ((DEBUG_ERROR, "%a - Unable to allocate the firmware version string IDs.\n", __FUNCTION__));
+        break;
       }
 
-      PackageVersionName = NULL;
-      Status             = Fmp->GetImageInfo (
-                                  Fmp,
-                                  &ImageInfoSize,             // ImageInfoSize
-                                  FmpImageInfoBuf,            // ImageInfo
-                                  &FmpImageInfoDescriptorVer, // DescriptorVersion
-                                  &FmpImageInfoCount,         // DescriptorCount
-                                  &DescriptorSize,            // DescriptorSize
-                                  &PackageVersion,            // PackageVersion
-                                  &PackageVersionName         // PackageVersionName
-                                  );
-
-      if (EFI_ERROR (Status)) {
-        DEBUG ((DEBUG_ERROR, "%a - Failure in GetImageInfo.  Status = %r\n", __FUNCTION__, Status));
-        goto FmpCleanUp;
+      if (mFwVersionStrings != NULL) {
+        CopyMem (Strings, mFwVersionStrings, mFwVersionStringsCount * sizeof (FP_FW_VERSION_STRINGS));
+        FreePool (mFwVersionStrings);
       }
 
-      if (FmpImageInfoCount == 0) {
-        DEBUG ((DEBUG_INFO, "%a - No Image Info descriptors.\n", __FUNCTION__));
-        goto FmpCleanUp;
-      }
+      mFwVersionStrings      = Strings;
+      mFwVersionStringsCount = Snapshot->EntryCount;
+    }
 
-      if (FmpImageInfoCount > 1) {
-        DEBUG ((DEBUG_INFO, "%a - Found %d descriptors.  For FrontPage we only show the 1st descriptor.\n", __FUNCTION__, FmpImageInfoCount));
-      }
+    Entry = FMP_SNAPSHOT_FIRST_ENTRY (Snapshot);
+    for (Index = 0; Index < Snapshot->EntryCount; Index++, Entry = FMP_SNAPSHOT_NEXT_ENTRY (Entry)) {
+      ImageIdName = FMP_SNAPSHOT_ENTRY_STRING (Entry, Entry->ImageIdNameOffset);
+      VersionName = FMP_SNAPSHOT_ENTRY_STRING (Entry, Entry->VersionNameOffset);
+      Strings     = &mFwVersionStrings[Index];
+      StringId    = STRING_TOKEN (STR_NULL_STRING);
+      StringId1   = STRING_TOKEN (STR_NULL_STRING);
 
-      if (FmpImageInfoBuf->ImageIdName != NULL) {
-        if ((StringId = HiiSetString (HiiHandle, 0, FmpImageInfoBuf->ImageIdName, NULL)) == 0) {
-          DEBUG ((DEBUG_ERROR, "%a - Failed to set string for fmp ImageIdName: %s. \n", __FUNCTION__, FmpImageInfoBuf->ImageIdName));
-          goto FmpCleanUp;
+      // HiiSetString () only adds a string when the ID is 0.  Otherwise it replaces that string.
+      //
+      if (ImageIdName != NULL) {
+        if ((StringId = HiiSetString (HiiHandle, Strings->ImageIdName, ImageIdName, NULL)) == 0) {
+          DEBUG ((DEBUG_ERROR, "%a - Failed to set string for fmp ImageIdName: %s. \n", __FUNCTION__, ImageIdName));
+          continue;
         }
+
+        Strings->ImageIdName = StringId;
       } else {
         DEBUG ((DEBUG_ERROR, "%a - FMP ImageIdName is null\n", __FUNCTION__));
       }
 
-      if (FmpImageInfoBuf->VersionName != NULL) {
-        if ((StringId1 = HiiSetString (HiiHandle, 0, FmpImageInfoBuf->VersionName, NULL)) == 0) {
-          DEBUG ((DEBUG_ERROR, "%a - Failed to set string for fmp VersionName: %s. \n", __FUNCTION__, FmpImageInfoBuf->VersionName));
-          goto FmpCleanUp;
+      if (VersionName != NULL) {
+        if ((StringId1 = HiiSetString (HiiHandle, Strings->VersionName, VersionName, NULL)) == 0) {
+          DEBUG ((DEBUG_ERROR, "%a - Failed to set string for fmp VersionName: %s. \n", __FUNCTION__, VersionName));
+          continue;
         }
+
+        Strings->VersionName = StringId1;
       } else {
         DEBUG ((DEBUG_ERROR, "%a - FMP VersionName is null\n", __FUNCTION__));
       }
@@ -493,21 +439,7 @@ UpdateFormWithFirmwareVersions (
         STRING_TOKEN (STR_NULL_STRING),
         STRING_TOKEN (STR_NULL_STRING)
         );
-
-FmpCleanUp:
-      // clean up -
-      FreePool (FmpImageInfoBuf);
-      FmpImageInfoBuf = NULL;
-      if (PackageVersionName != NULL) {
-        FreePool (PackageVersionName);
-        PackageVersionName = NULL;
-      }
-    } // for loop for all fmp handles
-
-    // Free up the FmpList of pointers
-    if (FmpList != NULL) {
-      FreePool (FmpList);
-    }
+    } // for loop for all fmp descriptors
 
     Status = HiiUpdateForm (
                HiiHandle,                      // HII handle
@@ -527,6 +459,159 @@ FmpCleanUp:
   }
 }
 
+/**
+  Determines whether all controllers have already been connected in this boot.
+
+  BDS, through the BootManagerPolicyDxe override, or an earlier FrontPage instance installs
+  gOemConnectAllCompleteGuid after calling EfiBootManagerConnectAll ().
+
+  @retval  TRUE     A full connect has already been done in this boot.
+  @retval  FALSE    No full connect has been recorded.
+
+**/
+STATIC
+BOOLEAN
+IsConnectAllComplete (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  VOID        *Dummy;   // There is no protocol interface - just the existence that it is published
+
+  Status = gBS->LocateProtocol (&gOemConnectAllCompleteGuid, NULL, (VOID **)&Dummy);
+
+  return !EFI_ERROR (Status);
+}
+
+/**
+  Connects all controllers and records that the full connect is complete for this boot.
+
+**/
+STATIC
+VOID
+ConnectAllControllers (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  EFI_HANDLE  Handle = NULL;
+
+  FpTimingBegin (FpPhaseConnectAll);
+  EfiBootManagerConnectAll ();
+  FpTimingEnd (FpPhaseConnectAll);
+
+  Status = gBS->InstallMultipleProtocolInterfaces (
+                  &Handle,
+                  &gOemConnectAllCompleteGuid,
+                  NULL,
+                  NULL
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - Failed to install connect-all marker. %r\n", __FUNCTION__, Status));
+  }
+}
+
+/**
+  Connects the remaining (non-console) controllers once FrontPage has painted its title bar
+  and master frame, then rebuilds the firmware version list for the FMP instances of the
+  newly connected devices.
+
+  Called from the deferred connect timer at TPL_CALLBACK once the form browser is up, and
+  from UefiMain at TPL_APPLICATION before FrontPage boots anything or exits, in case the
+  timer has not fired.
+
+**/
+STATIC
+VOID
+CompleteDeferredConnect (
+  VOID
+  )
+{
+  UINT64  StartTicks;
+
+  // Closing the timer first means it cannot fire once UefiMain has taken over.
+  //
+  if (mDeferredConnectEvent != NULL) {
+    gBS->CloseEvent (mDeferredConnectEvent);
+    mDeferredConnectEvent = NULL;
+  }
+
+  if (!mDeferredConnectPending) {
+    return;
+  }
+
+  mDeferredConnectPending = FALSE;
+
+  StartTicks = GetPerformanceCounter ();
+  ConnectAllControllers ();
+  DEBUG ((DEBUG_INFO, "INFO [FP]: Deferred connect completed in %ld us.\n", ElapsedMicroseconds (StartTicks, GetPerformanceCounter ())));
+
+  if (mFrontPagePrivate.HiiHandle != NULL) {
+    FpTimingBegin (FpPhaseFirmwareVersions);
+    UpdateFormWithFirmwareVersions (mFrontPagePrivate.HiiHandle);
+    FpTimingEnd (FpPhaseFirmwareVersions);
+  }
+}
+
+/**
+  Deferred connect timer.  Runs the deferred connect while the form browser waits for input.
+
+  @param[in]  Event     The timer event.
+  @param[in]  Context   Not used.
+
+**/
+STATIC
+VOID
+EFIAPI
+DeferredConnectTimerCallback (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  CompleteDeferredConnect ();
+}
+
+/**
+  Schedules the deferred connect to run shortly after the form browser starts.
+
+  The connect runs from a timer at TPL_CALLBACK, so the first form is on the screen while the
+  remaining controllers are connected.  Input is processed once the connect is done.  If the
+  timer can't be set, the connect runs now.
+
+**/
+STATIC
+VOID
+ScheduleDeferredConnect (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+
+  if (!mDeferredConnectPending) {
+    return;
+  }
+
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  DeferredConnectTimerCallback,
+                  NULL,
+                  &mDeferredConnectEvent
+                  );
+  if (!EFI_ERROR (Status)) {
+    Status = gBS->SetTimer (mDeferredConnectEvent, TimerRelative, FP_DEFERRED_CONNECT_DELAY);
+    if (EFI_ERROR (Status)) {
+      gBS->CloseEvent (mDeferredConnectEvent);
+      mDeferredConnectEvent = NULL;
+    }
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - Unable to defer the connect, connecting now. %r\n", __FUNCTION__, Status));
+    CompleteDeferredConnect ();
+  }
+}
+
 /**
   Initialize HII information for the FrontPage
 
@@ -544,6 +629,7 @@ InitializeFrontPage (
 {
   EFI_STATUS      Status = EFI_SUCCESS;
   EFI_HII_HANDLE  HiiHandle;
+  UINTN           Index;
 
   if (InitializeHiiData) {
     mCallbackKey = 0;
@@ -561,6 +647,10 @@ InitializeFrontPage (
       return Status;
     }
 
+    if (FeaturePcdGet (PcdFrontPagePersistentSession)) {
+      mPersistentSession = !EFI_ERROR (FormNavigationInitialize ());
+    }
+
     Status = gBS->LocateProtocol (&gEdkiiVariablePolicyProtocolGuid, NULL, (VOID **)&mVariablePolicyProtocol);
     if (EFI_ERROR (Status)) {
       return Status;
@@ -593,15 +683,45 @@ InitializeFrontPage (
     if (mFrontPagePrivate.HiiHandle == NULL) {
       return EFI_OUT_OF_RESOURCES;
     }
+
+    //
+    // Register the top menu entries.  FrontPage's own formset is registered first so
+    // its handle is the first one passed to SendForm ().
+    //
+    Status = FormsetRegistryInitialize ();
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    for (Index = 0; Index < ARRAY_SIZE (mFormMap); Index++) {
+      FormsetRegistryAddMenuEntry (
+        &mFormMap[Index].FormSetGUID,
+        mFormMap[Index].FormId,
+        mFrontPagePrivate.HiiHandle,
+        mFormMap[Index].MenuString,
+        mFormMap[Index].Position,
+        mFormMap[Index].LimitedMenu
+        );
+    }
+
+    FormsetRegistryAddPublishedMenuEntries ();
   }
 
   HiiHandle = mFrontPagePrivate.HiiHandle;
 
   // Update PC information display strings from EFI variables.
   //
+  FpTimingBegin (FpPhaseSmbiosStrings);
   UpdateDisplayStrings (HiiHandle);
+  FpTimingEnd (FpPhaseSmbiosStrings);
+
+  FpTimingBegin (FpPhaseFirmwareVersions);
   UpdateFormWithFirmwareVersions (HiiHandle);
+  FpTimingEnd (FpPhaseFirmwareVersions);
+
+  FpTimingBegin (FpPhaseSecureBootStatus);
   UpdateSecureBootStatusStrings (FALSE);
+  FpTimingEnd (FpPhaseSecureBootStatus);
 
   return Status;
 }
@@ -623,6 +743,10 @@ UninitializeFrontPage (
 {
   EFI_STATUS  Status = EFI_SUCCESS;
 
+  // End the password session, so nothing after FrontPage skips the password hash.
+  PasswordStoreEndSession (&mPasswordSession);
+  ZeroMem (&mPasswordSession, sizeof (mPasswordSession));
+
   // Dispose the auth token we acquired for the front page.
   if (mAuthProtocol != NULL) {
     Status = mAuthProtocol->DisposeAuthToken (mAuthProtocol, &mAuthToken);
@@ -655,6 +779,7 @@ UninitializeFrontPage (
   //
   // Remove our published HII data
   //
+  FormsetRegistryUninitialize ();
   HiiRemovePackages (mFrontPagePrivate.HiiHandle);
   if (mFrontPagePrivate.LanguageToken != NULL) {
     FreePool (mFrontPagePrivate.LanguageToken);
@@ -663,6 +788,22 @@ UninitializeFrontPage (
 
   gBS->CloseEvent (mMasterFrameNotifyEvent);
 
+  BitmapCacheFlush ();
+  FreeStringCache ();
+
+  // The string IDs went with the HII package.
+  //
+  if (mFwVersionStrings != NULL) {
+    FreePool (mFwVersionStrings);
+    mFwVersionStrings      = NULL;
+    mFwVersionStringsCount = 0;
+  }
+
+  FpSurfaceDestroy (mTitleBarSurface);
+  mTitleBarSurface = NULL;
+  FpSurfaceDestroy (mMasterFrameSurface);
+  mMasterFrameSurface = NULL;
+
   return Status;
 }
 
@@ -679,57 +820,25 @@ CallFrontPage (
   )
 {
   EFI_STATUS                  Status = EFI_SUCCESS;
-  UINT16                      Count, Index = 0;
   EFI_BROWSER_ACTION_REQUEST  ActionRequest;
-
-  #define MAX_FORMSET_HANDLES  5
-  EFI_HII_HANDLE  Handles[MAX_FORMSET_HANDLES];
-  UINTN           HandleCount;
-
-  // Locate Boot Menu form - this should already be registered.
-  //
-  EFI_GUID        BootMenu    = MS_BOOT_MENU_FORMSET_GUID;
-  EFI_HII_HANDLE  *BootHandle = HiiGetHiiHandles (&BootMenu);
-  EFI_HII_HANDLE  *DfciHandle = HiiGetHiiHandles (&gDfciMenuFormsetGuid);
-  EFI_HII_HANDLE  *HwhHandle  =  HiiGetHiiHandles (&gHwhMenuFormsetGuid);
-
-  Handles[0]  = mFrontPagePrivate.HiiHandle;
-  HandleCount = 1;
-
-  if (BootHandle != NULL) {
-    Handles[HandleCount++] = BootHandle[0];
-    FreePool (BootHandle);
-  }
-
-  if (DfciHandle != NULL) {
-    Handles[HandleCount++] = DfciHandle[0];
-    FreePool (DfciHandle);
-  }
-
-  if (HwhHandle != NULL) {
-    Handles[HandleCount++] = HwhHandle[0];
-    FreePool (HwhHandle);
-  }
-
-  DEBUG ((DEBUG_INFO, "MAX_FORMSET_HANDLES=%d, CurrentFormsetHandles=%d\n", MAX_FORMSET_HANDLES, HandleCount));
-  ASSERT (HandleCount < MAX_FORMSET_HANDLES);
+  CONST FP_MENU_ENTRY         *MenuEntry;
+  EFI_HII_HANDLE              *Handles;
+  UINTN                       HandleCount;
 
   ActionRequest = EFI_BROWSER_ACTION_REQUEST_NONE;
 
-  // Search through the form mapping table to find the form set GUID and ID corresponding to the selected index.
+  // Find the form set GUID and ID corresponding to the selected index.  If we didn't find it, exit with an error.
   //
-  for (Count = 0; Count < (sizeof (mFormMap) / sizeof (mFormMap[0])); Count++) {
-    Index = ((FALSE == mShowFullMenu) ? mFormMap[Count].LimitedMenuIndex : mFormMap[Count].FullMenuIndex);
-
-    if (Index == FormIndex) {
-      break;
-    }
+  MenuEntry = FormsetRegistryGetMenuEntry (FormIndex, mShowFullMenu);
+  if (MenuEntry == NULL) {
+    Status = EFI_NOT_FOUND;
+    goto Exit;
   }
 
-  // If we didn't find it, exit with an error.
+  // The registry keeps the HII handles current, so no HII database scan is needed here.
   //
-  if (Index != FormIndex) {
-    Status = EFI_NOT_FOUND;
+  Status = FormsetRegistryGetHandles (&Handles, &HandleCount);
+  if (EFI_ERROR (Status)) {
     goto Exit;
   }
 
@@ -739,12 +848,17 @@ CallFrontPage (
                             mFormBrowser2,
                             Handles,
                             HandleCount,
-                            &mFormMap[Count].FormSetGUID,
-                            mFormMap[Count].FormId,
+                            &MenuEntry->FormSetGuid,
+                            MenuEntry->FormId,
                             (EFI_SCREEN_DESCRIPTOR *)NULL,
                             &ActionRequest
                             );
 
+  // A switch queued as a browser navigation that was not consumed made the browser return
+  // instead.  mTerminateFrontPage is still clear, so the selected form is relaunched.
+  //
+  mNavigationQueued = FALSE;
+
   // If the user selected the "Restart now" button to exit the Frontpage, set the exit flag.
   //
   if (ActionRequest == EFI_BROWSER_ACTION_REQUEST_EXIT) {
@@ -762,6 +876,78 @@ Exit:
   return Status;
 }
 
+/**
+  Queues a switch to another top menu form as a navigation in the running browser.
+
+  @param[in]  FormIndex     Top menu index of the target form.
+
+  @retval EFI_SUCCESS           The switch is queued.
+  @retval EFI_UNSUPPORTED       Persistent sessions are not available, or the target is in another formset.
+  @retval EFI_NOT_FOUND         FormIndex is not a top menu entry.
+  @retval EFI_OUT_OF_RESOURCES  Unable to allocate the history entry.
+
+**/
+STATIC
+EFI_STATUS
+QueueFormNavigation (
+  IN UINT32  FormIndex
+  )
+{
+  CONST FP_MENU_ENTRY  *MenuEntry;
+
+  if (!mPersistentSession) {
+    return EFI_UNSUPPORTED;
+  }
+
+  MenuEntry = FormsetRegistryGetMenuEntry (FormIndex, mShowFullMenu);
+  if (MenuEntry == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  return FormNavigationQueue (&MenuEntry->FormSetGuid, MenuEntry->FormId);
+}
+
+/**
+  Records the latency of a top menu switch once the new form is drawn.  If the browser
+  navigated to the new form, SendForm () has not returned, so FrontPage terminates when it
+  does unless another switch is made.
+
+**/
+STATIC
+VOID
+CompleteFormSwitch (
+  VOID
+  )
+{
+  UINT64  ElapsedUs;
+
+  // The display engine clears the close request once the current form has closed.  A redraw
+  // before that is still the previous form.
+  //
+  if ((mFormSwitchStartTicks == 0) || mDisplayEngineState.CloseFormRequest) {
+    return;
+  }
+
+  ElapsedUs             = ElapsedMicroseconds (mFormSwitchStartTicks, GetPerformanceCounter ());
+  mFormSwitchStartTicks = 0;
+  mFormSwitchTotalUs   += ElapsedUs;
+  mFormSwitchMaxUs      = MAX (mFormSwitchMaxUs, ElapsedUs);
+  mFormSwitchCount++;
+
+  DEBUG ((
+    DEBUG_INFO,
+    "INFO [FP]: Switch to form %d took %ld us (%a).\n",
+    mCurrentFormIndex,
+    ElapsedUs,
+    mNavigationQueued ? "navigated" : "relaunched"
+    ));
+
+  if (mNavigationQueued) {
+    mNavigationQueued   = FALSE;
+    mTerminateFrontPage = TRUE;
+  }
+}
+
 /**
   IsDfciEnabledForDisplay
 
@@ -809,46 +995,6 @@ IsHwhEnabledForDisplay (
   return !EFI_ERROR (Status);
 }
 
-/**
-  RemoveMenuFromList -
-    Updates mFormMap so that the menu item specified by MenuId is omitted.
-    The item in question will have FullMenuIndex and LimitedMenuIndex set
-    to UNUSED_INDEX, and the other indexes in the list are adjusted accordingly.
-*/
-VOID
-RemoveMenuFromList (
-  UINT16  MenuId
-  )
-{
-  BOOLEAN  FullMenuRemoved    = FALSE;
-  BOOLEAN  LimitedMenuRemoved = FALSE;
-  UINTN    Count;
-
-  UINT16  MenuOptionCount = (sizeof (mFormMap) / sizeof (mFormMap[0]));
-
-  for (Count = 0; Count < MenuOptionCount; Count++) {
-    if (mFormMap[Count].MenuString == MenuId) {
-      if (mFormMap[Count].FullMenuIndex != UNUSED_INDEX) {
-        FullMenuRemoved               = TRUE;
-        mFormMap[Count].FullMenuIndex = UNUSED_INDEX;
-      }
-
-      if (mFormMap[Count].LimitedMenuIndex != UNUSED_INDEX) {
-        LimitedMenuRemoved               = TRUE;
-        mFormMap[Count].LimitedMenuIndex = UNUSED_INDEX;
-      }
-    }
-
-    if (FullMenuRemoved && (mFormMap[Count].FullMenuIndex != UNUSED_INDEX)) {
-      mFormMap[Count].FullMenuIndex -= 1;
-    }
-
-    if (LimitedMenuRemoved && (mFormMap[Count].LimitedMenuIndex != UNUSED_INDEX)) {
-      mFormMap[Count].LimitedMenuIndex -= 1;
-    }
-  }
-}
-
 /**
   Creates the top-level menu in the Master Frame for selecting amongst the various HII forms.
 
@@ -881,9 +1027,12 @@ CreateTopMenu (
   // If the user doesn't know the password, they can dismiss the dialog and will see a limited-functionality menu.
   //
   if (GetAuthToken (NULL) != EFI_SUCCESS) {
+    FpTimingBegin (FpPhasePasswordChallenge);
     if (TRUE == ChallengeUserPassword (PcdGet8 (PcdMaxPasswordAttempts))) {
       mShowFullMenu = TRUE;
     }
+
+    FpTimingEnd (FpPhasePasswordChallenge);
   } else {
     // If no password is set, show the full menu.
     //
@@ -902,33 +1051,34 @@ CreateTopMenu (
   // then only a limited menu is available.
   //
   //
-  UINT16           Count, Index;
-  UINT16           MenuOptionCount = (sizeof (mFormMap) / sizeof (mFormMap[0]));
-  UIT_LB_CELLDATA  *MenuOptions    = AllocateZeroPool ((MenuOptionCount + 1) * sizeof (UIT_LB_CELLDATA));  // NOTE: the list relies on a zero-initialized list terminator (hence +1).
-
-  ASSERT (NULL != MenuOptions);
-  if (NULL == MenuOptions) {
-    return NULL;
-  }
+  UINTN                Index;
+  UINTN                MenuOptionCount;
+  UIT_LB_CELLDATA      *MenuOptions;
+  CONST FP_MENU_ENTRY  *MenuEntry;
 
   //
   // If Dfci is Enabled, always display the DfciMenu.
   // If Dfci is Disabled, only display the Dfci menu if Dfci Enrolled
   //
   if (!IsDfciEnabledForDisplay ()) {
-    RemoveMenuFromList (STRING_TOKEN (STR_MF_MENU_OP_DFCI));
+    FormsetRegistryHideMenuEntries (&gDfciMenuFormsetGuid);
   }
 
   if (!IsHwhEnabledForDisplay ()) {
-    RemoveMenuFromList (STRING_TOKEN (STR_MF_MENU_OP_HWH));
+    FormsetRegistryHideMenuEntries (&gHwhMenuFormsetGuid);
   }
 
-  for (Count = 0; Count < MenuOptionCount; Count++) {
-    Index = ((FALSE == mShowFullMenu) ? mFormMap[Count].LimitedMenuIndex : mFormMap[Count].FullMenuIndex);
+  MenuOptionCount = FormsetRegistryGetMenuCount (mShowFullMenu);
+  MenuOptions     = AllocateZeroPool ((MenuOptionCount + 1) * sizeof (UIT_LB_CELLDATA));   // NOTE: the list relies on a zero-initialized list terminator (hence +1).
 
-    if ((UNUSED_INDEX != Index) && (Index < MenuOptionCount)) {
-      MenuOptions[Index].CellText = HiiGetString (mFrontPagePrivate.HiiHandle, mFormMap[Count].MenuString, NULL);
-    }
+  ASSERT (NULL != MenuOptions);
+  if (NULL == MenuOptions) {
+    return NULL;
+  }
+
+  for (Index = 0; Index < MenuOptionCount; Index++) {
+    MenuEntry                   = FormsetRegistryGetMenuEntry (Index, mShowFullMenu);
+    MenuOptions[Index].CellText = GetCachedString (MenuEntry->StringHandle, MenuEntry->MenuString);
   }
 
   // Create the ListBox that encapsulates the top-level menu.
@@ -961,6 +1111,46 @@ CreateTopMenu (
   return TopMenu;
 }
 
+/**
+  Draws the top-level menu into the master frame surface, then pushes whatever changed to the
+  screen.  The ListBox redraws every cell, but only the cells that look different are pushed.
+
+  Anything on the screen that is not captured (if the toolkit draws without the window manager)
+  is drawn after the surface has been flushed, so it is not covered.
+
+  @param[in]  ShowHighlight     Passed to the ListBox Draw ().
+  @param[in]  InputState        Passed to the ListBox Draw ().
+  @param[out] SelectionContext  Passed to the ListBox Draw ().
+
+  @return   The ListBox state returned by Draw ().
+
+**/
+STATIC
+OBJECT_STATE
+DrawTopMenu (
+  IN  BOOLEAN          ShowHighlight,
+  IN  SWM_INPUT_STATE  *InputState,
+  OUT VOID             **SelectionContext
+  )
+{
+  OBJECT_STATE  MenuState;
+
+  FpSurfaceFlush (mMasterFrameSurface);
+
+  FpSurfaceBeginCapture (mMasterFrameSurface);
+  MenuState = mTopMenu->Base.Draw (
+                               mTopMenu,
+                               ShowHighlight,
+                               InputState,
+                               SelectionContext
+                               );
+  FpSurfaceEndCapture ();
+
+  FpSurfaceFlush (mMasterFrameSurface);
+
+  return MenuState;
+}
+
 /**
   Draws the Front Page Title Bar.
 
@@ -984,20 +1174,22 @@ RenderTitlebar (
   UINTN                      DataSize;
   UINT8                      *RebootReason;
 
-  // Draw the titlebar background.
-  //
-  mGop->Blt (
-          mGop,
-          &gMsColorTable.TitleBarBackgroundColor,
-          EfiBltVideoFill,
-          0,
-          0,
-          0,
-          0,
-          mTitleBarWidth,
-          mTitleBarHeight,
-          mTitleBarWidth * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL)
-          );
+  ASSERT (NULL != mTitleBarSurface);
+  if (NULL == mTitleBarSurface) {
+    return EFI_NOT_READY;
+  }
+
+  // Compose the titlebar off-screen: background, bitmaps, then text.  Only the regions that
+  // changed are pushed to the screen at the end.
+  //
+  FpSurfaceFill (
+    mTitleBarSurface,
+    &gMsColorTable.TitleBarBackgroundColor,
+    0,
+    0,
+    mTitleBarWidth,
+    mTitleBarHeight
+    );
 
   GetAndDisplayBitmap (PcdGetPtr (PcdFrontPageLogoFile), (mMasterFrameWidth  * FP_TBAR_MSLOGO_X_PERCENT) / 100, FALSE);   // 2nd param is x coordinate
 
@@ -1061,9 +1253,9 @@ RenderTitlebar (
     goto Exit;
   }
 
-  pBltBuffer->Width        = (UINT16)mBootHorizontalResolution;
-  pBltBuffer->Height       = (UINT16)mBootVerticalResolution;
-  pBltBuffer->Image.Screen = mGop;
+  pBltBuffer->Width        = (UINT16)mTitleBarSurface->Width;
+  pBltBuffer->Height       = (UINT16)mTitleBarSurface->Height;
+  pBltBuffer->Image.Bitmap = mTitleBarSurface->Buffer;
 
   // Select a font (size & style) and font colors.
   //
@@ -1078,9 +1270,11 @@ RenderTitlebar (
   //
   UINT32    MaxDescent;
   SWM_RECT  StringRect;
+  UINT32    TextX;
+  UINT32    TextY;
 
   GetTextStringBitmapSize (
-    HiiGetString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_FRONT_PAGE_TITLE), NULL),
+    GetCachedString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_FRONT_PAGE_TITLE)),
     &StringInfo.FontInfo,
     FALSE,
     EFI_HII_OUT_FLAG_CLIP |
@@ -1090,24 +1284,39 @@ RenderTitlebar (
     &MaxDescent
     );
 
-  // Render the string to the screen, vertically centered.
+  // Render the string into the titlebar surface, vertically centered.
   //
+  TextX = ((mMasterFrameWidth  * FP_TBAR_TEXT_X_PERCENT) / 100);                                   // Based on Master Frame width - so the logo bitmap aligns with the text in the menu.
+  TextY = ((mTitleBarHeight / 2) - ((StringRect.Bottom - StringRect.Top + 1) / 2));                // Vertically center.
+
   mSWMProtocol->StringToWindow (
                   mSWMProtocol,
                   mImageHandle,
                   EFI_HII_OUT_FLAG_CLIP |
                   EFI_HII_OUT_FLAG_CLIP_CLEAN_X | EFI_HII_OUT_FLAG_CLIP_CLEAN_Y |
-                  EFI_HII_IGNORE_LINE_BREAK | EFI_HII_DIRECT_TO_SCREEN,
-                  HiiGetString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_FRONT_PAGE_TITLE), NULL),
+                  EFI_HII_IGNORE_LINE_BREAK,
+                  GetCachedString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_FRONT_PAGE_TITLE)),
                   &StringInfo,
                   &pBltBuffer,
-                  ((mMasterFrameWidth  * FP_TBAR_TEXT_X_PERCENT) / 100),                                     // Based on Master Frame width - so the logo bitmap aligns with the text in the menu.
-                  ((mTitleBarHeight / 2) - ((StringRect.Bottom - StringRect.Top + 1) / 2)),                  // Vertically center.
+                  TextX,
+                  TextY,
                   NULL,
                   NULL,
                   NULL
                   );
 
+  FpSurfaceMarkDirty (
+    mTitleBarSurface,
+    TextX,
+    TextY,
+    (StringRect.Right - StringRect.Left + 1),
+    (StringRect.Bottom - StringRect.Top + 1)
+    );
+
+  // Push the changed regions of the titlebar to the screen.
+  //
+  Status = FpSurfaceFlush (mTitleBarSurface);
+
 Exit:
 
   if (NULL != pBltBuffer) {
@@ -1142,44 +1351,35 @@ RenderMasterFrame (
     goto Exit;
   }
 
-  // Draw the master frame background.
-  //
-  mGop->Blt (
-          mGop,
-          &gMsColorTable.MasterFrameBackgroundColor,
-          EfiBltVideoFill,
-          0,
-          0,
-          0,
-          mTitleBarHeight,
-          mMasterFrameWidth,
-          mMasterFrameHeight,
-          0
-          );
-
-  // Draw divider line.
-  //
-  mGop->Blt (
-          mGop,
-          &gMsColorTable.TitleBarBackgroundColor,
-          EfiBltVideoFill,
-          0,
-          0,
-          (mMasterFrameWidth - FP_MFRAME_DIVIDER_LINE_WIDTH_PIXELS),
-          mTitleBarHeight,
-          FP_MFRAME_DIVIDER_LINE_WIDTH_PIXELS,
-          mMasterFrameHeight,
-          0
-          );
-
-  // Draw the top-level menu.
-  //
-  mTopMenu->Base.Draw (
-                   mTopMenu,
-                   FALSE,
-                   NULL,
-                   &pContext
-                   );
+  ASSERT (NULL != mMasterFrameSurface);
+  if (NULL == mMasterFrameSurface) {
+    Status = EFI_NOT_READY;
+    goto Exit;
+  }
+
+  // Compose the master frame background and divider line off-screen.
+  //
+  FpSurfaceFill (
+    mMasterFrameSurface,
+    &gMsColorTable.MasterFrameBackgroundColor,
+    0,
+    0,
+    (mMasterFrameWidth - FP_MFRAME_DIVIDER_LINE_WIDTH_PIXELS),
+    mMasterFrameHeight
+    );
+
+  FpSurfaceFill (
+    mMasterFrameSurface,
+    &gMsColorTable.TitleBarBackgroundColor,
+    (mMasterFrameWidth - FP_MFRAME_DIVIDER_LINE_WIDTH_PIXELS),
+    0,
+    FP_MFRAME_DIVIDER_LINE_WIDTH_PIXELS,
+    mMasterFrameHeight
+    );
+
+  // Draw the top-level menu over it.  This pushes the whole frame to the screen.
+  //
+  DrawTopMenu (FALSE, NULL, &pContext);
 
 Exit:
 
@@ -1219,9 +1419,9 @@ NotifyUserOfAlerts (
   //
   if (SecViolation) {
     DEBUG ((DEBUG_INFO, "FrontPage::%a - SecureBoot violation detected! Warning user...\n", __FUNCTION__));
-    SbViolationMessage = (CHAR16 *)HiiGetString (gStringPackHandle, STRING_TOKEN (STR_SB_VIOLATION_WARNING), NULL);
+    SbViolationMessage = GetCachedString (gStringPackHandle, STRING_TOKEN (STR_SB_VIOLATION_WARNING));
     Status             = SwmDialogsMessageBox (
-                           (CHAR16 *)HiiGetString (gStringPackHandle, STRING_TOKEN (STR_SB_VIOLATION_TITLE), NULL), // Dialog titlebar text.
+                           GetCachedString (gStringPackHandle, STRING_TOKEN (STR_SB_VIOLATION_TITLE)), // Dialog titlebar text.
                            SbViolationMessage,                                                                      // Dialog body text.
                            L"",                                                                                     // Dialog caption text.
                            SWM_MB_OK,                                                                               // Show Ok button only.
@@ -1271,12 +1471,17 @@ MasterFrameNotifyCallback (
   // If we just need to redraw, do that and exit.
   //
   if (REDRAW == mDisplayEngineState.NotificationType) {
-    mTopMenu->Base.Draw (
-                     mTopMenu,
-                     mDisplayEngineState.ShowTopMenuHighlight,
-                     &mDisplayEngineState.InputState,
-                     &pSelectionContext
-                     );
+    CompleteFormSwitch ();
+
+    // The display engine asks for a redraw when the master frame may have been drawn over, so
+    // the whole frame is pushed again from the surface.
+    //
+    FpSurfaceInvalidate (mMasterFrameSurface);
+    DrawTopMenu (
+      mDisplayEngineState.ShowTopMenuHighlight,
+      &mDisplayEngineState.InputState,
+      &pSelectionContext
+      );
 
     goto Exit;
   }
@@ -1292,14 +1497,13 @@ MasterFrameNotifyCallback (
   if ((SWM_INPUT_TYPE_TOUCH == pInputState->InputType /* && (pInputState->State.TouchState.ActiveButtons & 0x1) */) ||
       (SWM_INPUT_TYPE_KEY   == pInputState->InputType))
   {
-    // Draw the top-level menu in the master frame.
+    // Draw the top-level menu in the master frame.  Only the cells that changed reach the screen.
     //
-    MenuState = mTopMenu->Base.Draw (
-                                 mTopMenu,
-                                 mDisplayEngineState.ShowTopMenuHighlight,
-                                 &mDisplayEngineState.InputState,
-                                 &pSelectionContext
-                                 );
+    MenuState = DrawTopMenu (
+                  mDisplayEngineState.ShowTopMenuHighlight,
+                  &mDisplayEngineState.InputState,
+                  &pSelectionContext
+                  );
 
     // If nothing was selected (user may simply have moved the highlighted cell), there's no action to take.
     //
@@ -1319,7 +1523,13 @@ MasterFrameNotifyCallback (
     if (SelectedIndex != mCurrentFormIndex) {
       // Update the current form ID to the new one.
       //
-      mCurrentFormIndex = SelectedIndex;
+      mCurrentFormIndex     = SelectedIndex;
+      mFormSwitchStartTicks = GetPerformanceCounter ();
+
+      // In a persistent session, a switch within the formset being displayed is a browser
+      // navigation.  Otherwise SendForm () returns and the new form is launched.
+      //
+      mNavigationQueued = !EFI_ERROR (QueueFormNavigation (SelectedIndex));
 
       // Signal the form (browser) to close so the new form will be displayed.
       //
@@ -1366,11 +1576,28 @@ InitializeFrontPageUI (
   UINT32  MasterFrameMenuOrigY = mTitleBarHeight;
   UINT32  CellTextXOffset      = ((mMasterFrameWidth * FP_MFRAME_MENU_TEXT_OFFSET_PERCENT) / 100);
 
+  // Create the off-screen surfaces used to compose the TitleBar and Master Frame.  Both are pushed
+  // to the screen through the window manager.
+  //
+  FpCompositorInitialize (mSWMProtocol, mImageHandle);
+
+  Status = FpSurfaceCreate (0, 0, mTitleBarWidth, mTitleBarHeight, &mTitleBarSurface);
+  if (!EFI_ERROR (Status)) {
+    Status = FpSurfaceCreate (0, mTitleBarHeight, mMasterFrameWidth, mMasterFrameHeight, &mMasterFrameSurface);
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "ERROR [FP]: Failed to create the FrontPage surfaces.  Status = %r\r\n", Status));
+    goto Exit;
+  }
+
   // Determine whether there are any events that require user notification.
   // NOTE: This should come before CreateTopMenu() because it needs to happen before the
   //       Admin Password prompt.
   //
+  FpTimingBegin (FpPhaseUserAlerts);
   NotifyUserOfAlerts ();
+  FpTimingEnd (FpPhaseUserAlerts);
 
   // Create the top-level menu in the Master Frame.
   //
@@ -1396,6 +1623,16 @@ InitializeFrontPageUI (
   //
   RenderMasterFrame ();
 
+  FpTimingEnd (FpPhaseFirstPaint);
+  FpTimingPublish ();
+
+  DEBUG ((
+    DEBUG_INFO,
+    "INFO [FP]: Time to first paint: %ld us (staged connect %a).\r\n",
+    FpTimingGetDurationUs (FpPhaseFirstPaint),
+    (FeaturePcdGet (PcdFrontPageStagedConnect) ? "enabled" : "disabled")
+    ));
+
   // Create the Master Frame notification event.  This event is signalled by the display engine to note that
   // there is a user input event outside the form area to consider.
   //
@@ -1503,6 +1740,9 @@ UefiMain (
   EFI_STATUS  Status  = EFI_SUCCESS;
   UINT32      OSKMode = 0;
 
+  FpTimingStart ();
+  FpTimingBegin (FpPhaseFirstPaint);
+
   // Delete BootNext if entry to BootManager.
   Status = gRT->SetVariable (
                   L"BootNext",
@@ -1538,13 +1778,26 @@ UefiMain (
     DEBUG ((DEBUG_ERROR, "%a Couldn't fetch platform key store %r!\n", __FUNCTION__, Status));
   }
 
-  // Force-connect all controllers.
-  //
-  EfiBootManagerConnectAll ();
+  // Connect controllers.  Skip the full connect if BDS already did one in this boot.  In staged
+  // mode only the console devices (GOP, keyboard, pointer) are connected now; the rest are
+  // connected once the title bar and master frame have been painted.
+  //
+  if (IsConnectAllComplete ()) {
+    DEBUG ((DEBUG_INFO, "INFO [FP]: Controllers already connected in this boot.  Skipping connect-all.\r\n"));
+  } else if (FeaturePcdGet (PcdFrontPageStagedConnect)) {
+    FpTimingBegin (FpPhaseConnectConsoles);
+    EfiBootManagerConnectAllDefaultConsoles ();
+    FpTimingEnd (FpPhaseConnectConsoles);
+    mDeferredConnectPending = TRUE;
+  } else {
+    ConnectAllControllers ();
+  }
 
   // Set console mode: *not* VGA, no splashscreen logo.
   // Insure Gop is in Big Display mode prior to accessing GOP.
+  FpTimingBegin (FpPhaseSetGraphicsConsoleMode);
   SetGraphicsConsoleMode (GCM_NATIVE_RES);
+  FpTimingEnd (FpPhaseSetGraphicsConsoleMode);
 
   //
   // After the console is ready, get current video resolution
@@ -1639,7 +1892,9 @@ UefiMain (
 
   // Initialize the Simple UI ToolKit.
   //
+  FpTimingBegin (FpPhaseInitializeUIToolKit);
   Status = InitializeUIToolKit (ImageHandle);
+  FpTimingEnd (FpPhaseInitializeUIToolKit);
 
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "ERROR [FP]: Failed to initialize the UI toolkit (%r).\r\n", Status));
@@ -1652,7 +1907,9 @@ UefiMain (
 
   // Initialize HII data (ex: register strings, etc.).
   //
+  FpTimingBegin (FpPhaseInitializeFrontPage);
   InitializeFrontPage (TRUE);
+  FpTimingEnd (FpPhaseInitializeFrontPage);
 
   // Initialize the FrontPage User Interface.
   //
@@ -1663,6 +1920,10 @@ UefiMain (
     goto Exit;
   }
 
+  // The first paint is done.  Connect the remaining controllers once the form browser is up.
+  //
+  ScheduleDeferredConnect ();
+
   // Set the default form ID to show on the canvas.
   //
   mCurrentFormIndex = 0;
@@ -1678,6 +1939,22 @@ UefiMain (
     CallFrontPage (mCurrentFormIndex);
   } while (FALSE == mTerminateFrontPage);
 
+  if (mFormSwitchCount != 0) {
+    DEBUG ((
+      DEBUG_INFO,
+      "INFO [FP]: %lu form switches, average %lu us, maximum %lu us.\n",
+      (UINT64)mFormSwitchCount,
+      DivU64x32 (mFormSwitchTotalUs, (UINT32)mFormSwitchCount),
+      mFormSwitchMaxUs
+      ));
+  }
+
+  // Finish the deferred connect if the timer has not run it, so BootNext can be connected.
+  // Then republish the timings so they include it.
+  //
+  CompleteDeferredConnect ();
+  FpTimingPublish ();
+
   if (mResetRequired) {
     ResetSystemWithSubtype (EfiResetCold, &gFrontPageResetGuid);
   }
@@ -1690,6 +1967,8 @@ UefiMain (
 
 Exit:
 
+  CompleteDeferredConnect ();
+
   return Status;
 }
 
@@ -1701,41 +1980,15 @@ GetAndDisplayBitmap (
   )
 {
   EFI_STATUS                     Status;
-  UINT8                          *BMPData    = NULL;
-  UINTN                          BMPDataSize = 0;
-  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *BltBuffer  = NULL;
-  UINTN                          BltBufferSize;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *BltBuffer = NULL;
   UINTN                          BitmapHeight;
   UINTN                          BitmapWidth;
+  BOOLEAN                        Cached;
 
-  // Get the specified image from FV.
+  // Get the specified image in GOP framebuffer-compatible form (cached after the first use).
   //
-  Status = GetSectionFromAnyFv (
-             FileGuid,
-             EFI_SECTION_RAW,
-             0,
-             (VOID **)&BMPData,
-             &BMPDataSize
-             );
-
+  Status = BitmapCacheGet (FileGuid, &BltBuffer, &BitmapWidth, &BitmapHeight, &Cached);
   if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "ERROR [DE]: Failed to find bitmap file (GUID=%g) (%r).\r\n", FileGuid, Status));
-    return Status;
-  }
-
-  // Convert the bitmap from BMP format to a GOP framebuffer-compatible form.
-  //
-  Status = TranslateBmpToGopBlt (
-             BMPData,
-             BMPDataSize,
-             &BltBuffer,
-             &BltBufferSize,
-             &BitmapHeight,
-             &BitmapWidth
-             );
-  if (EFI_ERROR (Status)) {
-    FreePool (BMPData);
-    DEBUG ((DEBUG_ERROR, "ERROR [DE]: Failed to convert bitmap file to GOP format (%r).\r\n", Status));
     return Status;
   }
 
@@ -1743,21 +1996,21 @@ GetAndDisplayBitmap (
     XCoord -= BitmapWidth;
   }
 
-  mGop->Blt (
-          mGop,
-          BltBuffer,
-          EfiBltBufferToVideo,
-          0,
-          0,
-          XCoord,       // Upper Right corner
-          ((mTitleBarHeight / 2) - (BitmapHeight / 2)),
-          BitmapWidth,
-          BitmapHeight,
-          0
-          );
-
-  FreePool (BMPData);
-  FreePool (BltBuffer);
+  // Compose the bitmap into the titlebar surface, vertically centered.  RenderTitlebar() pushes it to the screen.
+  //
+  FpSurfaceBlt (
+    mTitleBarSurface,
+    BltBuffer,
+    (UINT32)XCoord,       // Upper Right corner
+    (UINT32)((mTitleBarHeight / 2) - (BitmapHeight / 2)),
+    (UINT32)BitmapWidth,
+    (UINT32)BitmapHeight
+    );
+
+  if (!Cached) {
+    FreePool (BltBuffer);
+  }
+
   return Status;
 }
 
@@ -0,0 +1,270 @@
+/** @file
+  Cache of FV bitmaps already converted to GOP BLT format for the FrontPage.
+
+  Title bar redraws display the same few bitmaps (logo and entry indicators) each
+  time.  Entries are kept on a most-recently-used list and evicted from the tail
+  when the PcdFrontPageBitmapCacheSize budget would be exceeded.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Pi/PiFirmwareFile.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/BmpSupportLib.h>
+#include <Library/DebugLib.h>
+#include <Library/DxeServicesLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
+
+#include "FrontPageBitmapCache.h"
+
+#define BITMAP_CACHE_ENTRY_SIGNATURE  SIGNATURE_32 ('F', 'P', 'B', 'C')
+
+typedef struct {
+  UINT32                           Signature;
+  LIST_ENTRY                       Link;          // Position in the MRU list (head = most recently used).
+  EFI_GUID                         FileGuid;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL    *BltBuffer;
+  UINTN                            BltBufferSize;
+  UINTN                            Width;
+  UINTN                            Height;
+} BITMAP_CACHE_ENTRY;
+
+#define BITMAP_CACHE_ENTRY_FROM_LINK(a)  CR (a, BITMAP_CACHE_ENTRY, Link, BITMAP_CACHE_ENTRY_SIGNATURE)
+
+STATIC LIST_ENTRY          mBitmapCacheList = INITIALIZE_LIST_HEAD_VARIABLE (mBitmapCacheList);
+STATIC BITMAP_CACHE_STATS  mBitmapCacheStats;
+
+/**
+  Frees a cache entry and removes it from the MRU list.
+
+  @param[in]  Entry     The entry to free.
+
+**/
+STATIC
+VOID
+FreeCacheEntry (
+  IN BITMAP_CACHE_ENTRY  *Entry
+  )
+{
+  RemoveEntryList (&Entry->Link);
+  mBitmapCacheStats.BytesCached -= Entry->BltBufferSize;
+
+  FreePool (Entry->BltBuffer);
+  FreePool (Entry);
+}
+
+/**
+  Evicts least-recently-used entries until Required more bytes fit in the budget.
+
+  @param[in]  Required    Size of the BLT buffer about to be cached.
+
+**/
+STATIC
+VOID
+EvictForSize (
+  IN UINTN  Required
+  )
+{
+  UINTN  Budget;
+
+  Budget = PcdGet32 (PcdFrontPageBitmapCacheSize);
+
+  while (!IsListEmpty (&mBitmapCacheList) && (mBitmapCacheStats.BytesCached + Required > Budget)) {
+    DEBUG_CODE_BEGIN ();
+    mBitmapCacheStats.Evictions++;
+    DEBUG_CODE_END ();
+
+    FreeCacheEntry (BITMAP_CACHE_ENTRY_FROM_LINK (GetPreviousNode (&mBitmapCacheList, &mBitmapCacheList)));
+  }
+}
+
+/**
+  Returns the GOP BLT buffer for the bitmap stored in the FV file identified by FileGuid.
+
+  On a cache hit no FV scan or BMP decode takes place.  On a miss the bitmap is read
+  and converted, then cached (evicting least-recently-used entries to stay within
+  PcdFrontPageBitmapCacheSize) unless it is larger than the whole budget.
+
+  @param[in]  FileGuid      FFS file name of the raw BMP section.
+  @param[out] BltBuffer     GOP BLT buffer for the bitmap.
+  @param[out] Width         Bitmap width in pixels.
+  @param[out] Height        Bitmap height in pixels.
+  @param[out] Cached        TRUE if BltBuffer is owned by the cache.  FALSE if the caller
+                            must free BltBuffer with FreePool ().
+
+  @retval  EFI_SUCCESS            BltBuffer, Width and Height are valid.
+  @retval  EFI_INVALID_PARAMETER  A parameter is NULL.
+  @retval  Others                 The bitmap could not be read or converted.
+
+**/
+EFI_STATUS
+BitmapCacheGet (
+  IN  EFI_GUID                       *FileGuid,
+  OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL  **BltBuffer,
+  OUT UINTN                          *Width,
+  OUT UINTN                          *Height,
+  OUT BOOLEAN                        *Cached
+  )
+{
+  EFI_STATUS                     Status;
+  LIST_ENTRY                     *Link;
+  BITMAP_CACHE_ENTRY             *Entry;
+  UINT8                          *BMPData    = NULL;
+  UINTN                          BMPDataSize = 0;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *NewBlt     = NULL;
+  UINTN                          NewBltSize;
+  UINTN                          NewHeight;
+  UINTN                          NewWidth;
+
+  if ((FileGuid == NULL) || (BltBuffer == NULL) || (Width == NULL) || (Height == NULL) || (Cached == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  // Look for an existing entry.  On a hit, move it to the head of the MRU list.
+  //
+  for (Link = GetFirstNode (&mBitmapCacheList); !IsNull (&mBitmapCacheList, Link); Link = GetNextNode (&mBitmapCacheList, Link)) {
+    Entry = BITMAP_CACHE_ENTRY_FROM_LINK (Link);
+    if (CompareGuid (&Entry->FileGuid, FileGuid)) {
+      RemoveEntryList (&Entry->Link);
+      InsertHeadList (&mBitmapCacheList, &Entry->Link);
+
+      DEBUG_CODE_BEGIN ();
+      mBitmapCacheStats.Hits++;
+      DEBUG_CODE_END ();
+
+      *BltBuffer = Entry->BltBuffer;
+      *Width     = Entry->Width;
+      *Height    = Entry->Height;
+      *Cached    = TRUE;
+      return EFI_SUCCESS;
+    }
+  }
+
+  DEBUG_CODE_BEGIN ();
+  mBitmapCacheStats.Misses++;
+  DEBUG_CODE_END ();
+
+  // Get the specified image from FV.
+  //
+  Status = GetSectionFromAnyFv (
+             FileGuid,
+             EFI_SECTION_RAW,
+             0,
+             (VOID **)&BMPData,
+             &BMPDataSize
+             );
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "ERROR [DE]: Failed to find bitmap file (GUID=%g) (%r).\r\n", FileGuid, Status));
+    return Status;
+  }
+
+  // Convert the bitmap from BMP format to a GOP framebuffer-compatible form.
+  //
+  Status = TranslateBmpToGopBlt (
+             BMPData,
+             BMPDataSize,
+             &NewBlt,
+             &NewBltSize,
+             &NewHeight,
+             &NewWidth
+             );
+  FreePool (BMPData);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "ERROR [DE]: Failed to convert bitmap file to GOP format (%r).\r\n", Status));
+    return Status;
+  }
+
+  *BltBuffer = NewBlt;
+  *Width     = NewWidth;
+  *Height    = NewHeight;
+  *Cached    = FALSE;
+
+  // Bitmaps larger than the whole budget are handed back uncached.
+  //
+  if (NewBltSize > PcdGet32 (PcdFrontPageBitmapCacheSize)) {
+    return EFI_SUCCESS;
+  }
+
+  Entry = AllocateZeroPool (sizeof (BITMAP_CACHE_ENTRY));
+  if (Entry == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  EvictForSize (NewBltSize);
+
+  Entry->Signature     = BITMAP_CACHE_ENTRY_SIGNATURE;
+  Entry->BltBuffer     = NewBlt;
+  Entry->BltBufferSize = NewBltSize;
+  Entry->Width         = NewWidth;
+  Entry->Height        = NewHeight;
+  CopyGuid (&Entry->FileGuid, FileGuid);
+  InsertHeadList (&mBitmapCacheList, &Entry->Link);
+  mBitmapCacheStats.BytesCached += NewBltSize;
+
+  *Cached = TRUE;
+
+  DEBUG_CODE_BEGIN ();
+  DEBUG ((
+    DEBUG_VERBOSE,
+    "VERBOSE [FP]: Bitmap cache miss %g (%lu bytes).  Hits=%lu Misses=%lu Evictions=%lu Cached=%lu bytes.\r\n",
+    FileGuid,
+    (UINT64)NewBltSize,
+    (UINT64)mBitmapCacheStats.Hits,
+    (UINT64)mBitmapCacheStats.Misses,
+    (UINT64)mBitmapCacheStats.Evictions,
+    (UINT64)mBitmapCacheStats.BytesCached
+    ));
+  DEBUG_CODE_END ();
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Releases every cached bitmap.
+
+**/
+VOID
+BitmapCacheFlush (
+  VOID
+  )
+{
+  DEBUG_CODE_BEGIN ();
+  DEBUG ((
+    DEBUG_INFO,
+    "INFO [FP]: Bitmap cache flush.  Hits=%lu Misses=%lu Evictions=%lu Cached=%lu bytes.\r\n",
+    (UINT64)mBitmapCacheStats.Hits,
+    (UINT64)mBitmapCacheStats.Misses,
+    (UINT64)mBitmapCacheStats.Evictions,
+    (UINT64)mBitmapCacheStats.BytesCached
+    ));
+  DEBUG_CODE_END ();
+
+  while (!IsListEmpty (&mBitmapCacheList)) {
+    FreeCacheEntry (BITMAP_CACHE_ENTRY_FROM_LINK (GetFirstNode (&mBitmapCacheList)));
+  }
+}
+
+/**
+  Returns the bitmap cache counters.  Hits, misses and evictions are only counted in
+  DEBUG builds.
+
+  @param[out] Stats     Current counters.
+
+**/
+VOID
+BitmapCacheGetStats (
+  OUT BITMAP_CACHE_STATS  *Stats
+  )
+{
+  if (Stats != NULL) {
+    CopyMem (Stats, &mBitmapCacheStats, sizeof (BITMAP_CACHE_STATS));
+  }
+}
@@ -0,0 +1,70 @@
+/** @file
+  Cache of FV bitmaps already converted to GOP BLT format for the FrontPage.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _FRONT_PAGE_BITMAP_CACHE_H_
+#define _FRONT_PAGE_BITMAP_CACHE_H_
+
+#include <Protocol/GraphicsOutput.h>
+
+typedef struct {
+  UINTN    Hits;
+  UINTN    Misses;
+  UINTN    Evictions;
+  UINTN    BytesCached;
+} BITMAP_CACHE_STATS;
+
+/**
+  Returns the GOP BLT buffer for the bitmap stored in the FV file identified by FileGuid.
+
+  On a cache hit no FV scan or BMP decode takes place.  On a miss the bitmap is read
+  and converted, then cached (evicting least-recently-used entries to stay within
+  PcdFrontPageBitmapCacheSize) unless it is larger than the whole budget.
+
+  @param[in]  FileGuid      FFS file name of the raw BMP section.
+  @param[out] BltBuffer     GOP BLT buffer for the bitmap.
+  @param[out] Width         Bitmap width in pixels.
+  @param[out] Height        Bitmap height in pixels.
+  @param[out] Cached        TRUE if BltBuffer is owned by the cache.  FALSE if the caller
+                            must free BltBuffer with FreePool ().
+
+  @retval  EFI_SUCCESS            BltBuffer, Width and Height are valid.
+  @retval  EFI_INVALID_PARAMETER  A parameter is NULL.
+  @retval  Others                 The bitmap could not be read or converted.
+
+**/
+EFI_STATUS
+BitmapCacheGet (
+  IN  EFI_GUID                       *FileGuid,
+  OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL  **BltBuffer,
+  OUT UINTN                          *Width,
+  OUT UINTN                          *Height,
+  OUT BOOLEAN                        *Cached
+  );
+
+/**
+  Releases every cached bitmap.
+
+**/
+VOID
+BitmapCacheFlush (
+  VOID
+  );
+
+/**
+  Returns the bitmap cache counters.  Hits, misses and evictions are only counted in
+  DEBUG builds.
+
+  @param[out] Stats     Current counters.
+
+**/
+VOID
+BitmapCacheGetStats (
+  OUT BITMAP_CACHE_STATS  *Stats
+  );
+
+#endif // _FRONT_PAGE_BITMAP_CACHE_H_
@@ -0,0 +1,907 @@
+/** @file
+  Off-screen compositor for the FrontPage chrome (title bar, master frame and top menu).
+
+  The UI toolkit draws the top menu through the window manager with FrontPage's image handle.
+  To capture it, the BltWindow and StringToWindow members of the window manager protocol are
+  swapped for the ones below, only for the length of a menu draw.  Calls made for any other
+  image handle are passed on untouched.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Protocol/HiiFont.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+#include "FrontPageCompositor.h"
+
+STATIC MS_SIMPLE_WINDOW_MANAGER_PROTOCOL  *mSwm = NULL;
+STATIC MS_SIMPLE_WINDOW_MANAGER_PROTOCOL  mSwmOriginal;     // The window manager members before any capture.
+STATIC EFI_HANDLE                         mClientImage    = NULL;
+STATIC FP_SURFACE                         *mCaptureSurface = NULL;
+
+/**
+  Clips a surface-relative rectangle to the surface bounds.
+
+  @retval  TRUE     Rect holds the non-empty clipped rectangle (inclusive bounds).
+  @retval  FALSE    The rectangle lies entirely outside the surface.
+
+**/
+STATIC
+BOOLEAN
+ClipToSurface (
+  IN  FP_SURFACE  *Surface,
+  IN  UINT32      X,
+  IN  UINT32      Y,
+  IN  UINT32      Width,
+  IN  UINT32      Height,
+  OUT SWM_RECT    *Rect
+  )
+{
+  if ((Width == 0) || (Height == 0) || (X >= Surface->Width) || (Y >= Surface->Height)) {
+    return FALSE;
+  }
+
+  Rect->Left   = X;
+  Rect->Top    = Y;
+  Rect->Right  = X + MIN (Width, Surface->Width - X) - 1;
+  Rect->Bottom = Y + MIN (Height, Surface->Height - Y) - 1;
+
+  return TRUE;
+}
+
+/**
+  Clips a screen rectangle to a surface.
+
+  @param[in]  Surface     The surface.
+  @param[in]  ScreenX     Screen x-coordinate of the rectangle.
+  @param[in]  ScreenY     Screen y-coordinate of the rectangle.
+  @param[in]  Width       Rectangle width.
+  @param[in]  Height      Rectangle height.
+  @param[out] Rect        Surface-relative part of the rectangle that the surface covers.
+  @param[out] Inside      TRUE if the surface covers the whole rectangle.
+
+  @retval  TRUE     The surface covers part of the rectangle.
+  @retval  FALSE    The rectangle lies entirely outside the surface.
+
+**/
+STATIC
+BOOLEAN
+ScreenToSurface (
+  IN  FP_SURFACE  *Surface,
+  IN  UINTN       ScreenX,
+  IN  UINTN       ScreenY,
+  IN  UINTN       Width,
+  IN  UINTN       Height,
+  OUT SWM_RECT    *Rect,
+  OUT BOOLEAN     *Inside
+  )
+{
+  UINTN  Left;
+  UINTN  Top;
+  UINTN  Right;
+  UINTN  Bottom;
+
+  if ((Width == 0) || (Height == 0)) {
+    return FALSE;
+  }
+
+  Left   = MAX (ScreenX, Surface->OrigX);
+  Top    = MAX (ScreenY, Surface->OrigY);
+  Right  = MIN (ScreenX + Width, (UINTN)Surface->OrigX + Surface->Width);
+  Bottom = MIN (ScreenY + Height, (UINTN)Surface->OrigY + Surface->Height);
+
+  if ((Left >= Right) || (Top >= Bottom)) {
+    return FALSE;
+  }
+
+  Rect->Left   = (UINT32)(Left - Surface->OrigX);
+  Rect->Top    = (UINT32)(Top - Surface->OrigY);
+  Rect->Right  = (UINT32)(Right - Surface->OrigX - 1);
+  Rect->Bottom = (UINT32)(Bottom - Surface->OrigY - 1);
+
+  *Inside = (Left == ScreenX) && (Top == ScreenY) && (Right == ScreenX + Width) && (Bottom == ScreenY + Height);
+
+  return TRUE;
+}
+
+/**
+  Returns TRUE if two rectangles overlap or are adjacent.
+
+**/
+STATIC
+BOOLEAN
+RectsTouch (
+  IN SWM_RECT  *A,
+  IN SWM_RECT  *B
+  )
+{
+  return (A->Left <= B->Right + 1) && (B->Left <= A->Right + 1) &&
+         (A->Top <= B->Bottom + 1) && (B->Top <= A->Bottom + 1);
+}
+
+/**
+  Adds a clipped rectangle to the dirty list, merging it with any rectangles it touches.
+
+**/
+STATIC
+VOID
+AddDirtyRect (
+  IN FP_SURFACE  *Surface,
+  IN SWM_RECT    *Rect
+  )
+{
+  SWM_RECT  New;
+  UINTN     Index;
+  BOOLEAN   Merged;
+
+  CopyMem (&New, Rect, sizeof (SWM_RECT));
+
+  // Keep merging until the new rectangle touches nothing else in the list.
+  //
+  do {
+    Merged = FALSE;
+    for (Index = 0; Index < Surface->DirtyCount; Index++) {
+      if (RectsTouch (&New, &Surface->Dirty[Index])) {
+        New.Left   = MIN (New.Left, Surface->Dirty[Index].Left);
+        New.Top    = MIN (New.Top, Surface->Dirty[Index].Top);
+        New.Right  = MAX (New.Right, Surface->Dirty[Index].Right);
+        New.Bottom = MAX (New.Bottom, Surface->Dirty[Index].Bottom);
+
+        Surface->DirtyCount--;
+        CopyMem (&Surface->Dirty[Index], &Surface->Dirty[Surface->DirtyCount], sizeof (SWM_RECT));
+        Merged = TRUE;
+        break;
+      }
+    }
+  } while (Merged);
+
+  // If the list is full, fold everything into a single bounding rectangle.
+  //
+  if (Surface->DirtyCount == FP_SURFACE_MAX_DIRTY_RECTS) {
+    for (Index = 0; Index < Surface->DirtyCount; Index++) {
+      New.Left   = MIN (New.Left, Surface->Dirty[Index].Left);
+      New.Top    = MIN (New.Top, Surface->Dirty[Index].Top);
+      New.Right  = MAX (New.Right, Surface->Dirty[Index].Right);
+      New.Bottom = MAX (New.Bottom, Surface->Dirty[Index].Bottom);
+    }
+
+    Surface->DirtyCount = 0;
+  }
+
+  CopyMem (&Surface->Dirty[Surface->DirtyCount++], &New, sizeof (SWM_RECT));
+}
+
+/**
+  Copies part of a BLT buffer into a clipped surface rectangle and marks it dirty.
+
+  @param[in]  Surface     Target surface.
+  @param[in]  Rect        Clipped surface-relative destination.
+  @param[in]  Source      Source BLT buffer.
+  @param[in]  SourceX     Source x-coordinate of the pixel copied to Rect->Left.
+  @param[in]  SourceY     Source y-coordinate of the pixel copied to Rect->Top.
+  @param[in]  Delta       Bytes per source row.
+
+**/
+STATIC
+VOID
+CopyToSurface (
+  IN FP_SURFACE                     *Surface,
+  IN SWM_RECT                       *Rect,
+  IN EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Source,
+  IN UINTN                          SourceX,
+  IN UINTN                          SourceY,
+  IN UINTN                          Delta
+  )
+{
+  UINTN   RowBytes;
+  UINT32  Row;
+
+  RowBytes = (Rect->Right - Rect->Left + 1) * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL);
+
+  for (Row = Rect->Top; Row <= Rect->Bottom; Row++) {
+    CopyMem (
+      &Surface->Buffer[(UINTN)Row * Surface->Width + Rect->Left],
+      (UINT8 *)Source + (SourceY + Row - Rect->Top) * Delta + SourceX * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL),
+      RowBytes
+      );
+  }
+
+  AddDirtyRect (Surface, Rect);
+}
+
+/**
+  Fills a clipped surface rectangle and marks it dirty.
+
+**/
+STATIC
+VOID
+FillSurface (
+  IN FP_SURFACE                     *Surface,
+  IN SWM_RECT                       *Rect,
+  IN EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Color
+  )
+{
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Pixel;
+  UINT32                         Row;
+  UINT32                         Column;
+
+  for (Row = Rect->Top; Row <= Rect->Bottom; Row++) {
+    Pixel = &Surface->Buffer[(UINTN)Row * Surface->Width + Rect->Left];
+    for (Column = Rect->Left; Column <= Rect->Right; Column++) {
+      *Pixel++ = *Color;
+    }
+  }
+
+  AddDirtyRect (Surface, Rect);
+}
+
+/**
+  Finds the pixels of a back buffer row that differ from the front buffer.
+
+  @param[in]  Surface     The surface.
+  @param[in]  Row         Surface row.
+  @param[in]  Left        First column to compare.
+  @param[in]  Right       Last column to compare.
+  @param[out] First       First column that differs.
+  @param[out] Last        Last column that differs.
+
+  @retval  TRUE     Some pixels differ.
+  @retval  FALSE    The row is unchanged between Left and Right.
+
+**/
+STATIC
+BOOLEAN
+RowChanged (
+  IN  FP_SURFACE  *Surface,
+  IN  UINT32      Row,
+  IN  UINT32      Left,
+  IN  UINT32      Right,
+  OUT UINT32      *First,
+  OUT UINT32      *Last
+  )
+{
+  UINT32  *Back;
+  UINT32  *Front;
+  UINT32  Column;
+
+  Back  = (UINT32 *)&Surface->Buffer[(UINTN)Row * Surface->Width];
+  Front = (UINT32 *)&Surface->Front[(UINTN)Row * Surface->Width];
+
+  for (Column = Left; (Column <= Right) && (Back[Column] == Front[Column]); Column++) {
+  }
+
+  if (Column > Right) {
+    return FALSE;
+  }
+
+  *First = Column;
+  for (Column = Right; Back[Column] == Front[Column]; Column--) {
+  }
+
+  *Last = Column;
+  return TRUE;
+}
+
+/**
+  BltWindow for FrontPage's calls while a surface captures.
+
+  See MS_SIMPLE_WINDOW_MANAGER_PROTOCOL.BltWindow for the parameters.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CaptureBltWindow (
+  IN  MS_SIMPLE_WINDOW_MANAGER_PROTOCOL  *This,
+  IN  EFI_HANDLE                         ImageHandle,
+  IN  EFI_GRAPHICS_OUTPUT_BLT_PIXEL      *BltBuffer OPTIONAL,
+  IN  EFI_GRAPHICS_OUTPUT_BLT_OPERATION  BltOperation,
+  IN  UINTN                              SourceX,
+  IN  UINTN                              SourceY,
+  IN  UINTN                              DestinationX,
+  IN  UINTN                              DestinationY,
+  IN  UINTN                              Width,
+  IN  UINTN                              Height,
+  IN  UINTN                              Delta OPTIONAL
+  )
+{
+  FP_SURFACE  *Surface;
+  SWM_RECT    Rect;
+  SWM_RECT    SourceRect;
+  BOOLEAN     Inside;
+  UINTN       Row;
+  UINTN       Line;
+  UINTN       RowBytes;
+
+  Surface = mCaptureSurface;
+  if ((Surface == NULL) || (ImageHandle != mClientImage)) {
+    goto PassThrough;
+  }
+
+  if (Delta == 0) {
+    Delta = Width * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL);
+  }
+
+  RowBytes = Width * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL);
+
+  switch (BltOperation) {
+    case EfiBltVideoFill:
+      if ((BltBuffer == NULL) || !ScreenToSurface (Surface, DestinationX, DestinationY, Width, Height, &Rect, &Inside)) {
+        goto PassThrough;
+      }
+
+      FillSurface (Surface, &Rect, BltBuffer);
+      break;
+
+    case EfiBltBufferToVideo:
+      if ((BltBuffer == NULL) || !ScreenToSurface (Surface, DestinationX, DestinationY, Width, Height, &Rect, &Inside)) {
+        goto PassThrough;
+      }
+
+      CopyToSurface (
+        Surface,
+        &Rect,
+        BltBuffer,
+        SourceX + (Surface->OrigX + Rect.Left - DestinationX),
+        SourceY + (Surface->OrigY + Rect.Top - DestinationY),
+        Delta
+        );
+      break;
+
+    case EfiBltVideoToBltBuffer:
+      // Reads must see what was drawn since the last flush, so they come from the back buffer.
+      //
+      if ((BltBuffer == NULL) || !ScreenToSurface (Surface, SourceX, SourceY, Width, Height, &Rect, &Inside) || !Inside) {
+        goto PassThrough;
+      }
+
+      for (Row = 0; Row < Height; Row++) {
+        CopyMem (
+          (UINT8 *)BltBuffer + (DestinationY + Row) * Delta + DestinationX * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL),
+          &Surface->Buffer[(Rect.Top + Row) * Surface->Width + Rect.Left],
+          RowBytes
+          );
+      }
+
+      return EFI_SUCCESS;
+
+    case EfiBltVideoToVideo:
+      if (!ScreenToSurface (Surface, SourceX, SourceY, Width, Height, &SourceRect, &Inside) || !Inside ||
+          !ScreenToSurface (Surface, DestinationX, DestinationY, Width, Height, &Rect, &Inside) || !Inside)
+      {
+        goto PassThrough;
+      }
+
+      // Copy in the order that reads each source row before it is overwritten.
+      //
+      for (Row = 0; Row < Height; Row++) {
+        Line = (Rect.Top > SourceRect.Top) ? (Height - 1 - Row) : Row;
+        CopyMem (
+          &Surface->Buffer[(Rect.Top + Line) * Surface->Width + Rect.Left],
+          &Surface->Buffer[(SourceRect.Top + Line) * Surface->Width + SourceRect.Left],
+          RowBytes
+          );
+      }
+
+      AddDirtyRect (Surface, &Rect);
+      return EFI_SUCCESS;
+
+    default:
+      goto PassThrough;
+  }
+
+  // Part of a fill or copy may lie outside the surface.  The surface keeps its share and the
+  // screen still gets all of it, so the two agree.
+  //
+  if (Inside) {
+    return EFI_SUCCESS;
+  }
+
+PassThrough:
+  // A screen-to-screen copy that lands in the surface leaves the screen out of step with it.
+  //
+  if ((Surface != NULL) && (ImageHandle == mClientImage) && (BltOperation == EfiBltVideoToVideo) &&
+      ScreenToSurface (Surface, DestinationX, DestinationY, Width, Height, &Rect, &Inside))
+  {
+    FpSurfaceInvalidate (Surface);
+  }
+
+  return mSwmOriginal.BltWindow (
+                        This,
+                        ImageHandle,
+                        BltBuffer,
+                        BltOperation,
+                        SourceX,
+                        SourceY,
+                        DestinationX,
+                        DestinationY,
+                        Width,
+                        Height,
+                        Delta
+                        );
+}
+
+/**
+  StringToWindow for FrontPage's calls while a surface captures.  A string drawn straight to
+  the screen at a position inside the surface is drawn into the back buffer instead.
+
+  See MS_SIMPLE_WINDOW_MANAGER_PROTOCOL.StringToWindow for the parameters.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CaptureStringToWindow (
+  IN       MS_SIMPLE_WINDOW_MANAGER_PROTOCOL  *This,
+  IN       EFI_HANDLE                         ImageHandle,
+  IN       EFI_HII_OUT_FLAGS                  Flags,
+  IN CONST EFI_STRING                         String,
+  IN CONST EFI_FONT_DISPLAY_INFO              *StringInfo,
+  IN OUT   EFI_IMAGE_OUTPUT                   **Blt,
+  IN       UINTN                              BltX,
+  IN       UINTN                              BltY,
+  OUT      EFI_HII_ROW_INFO                   **RowInfoArray    OPTIONAL,
+  OUT      UINTN                              *RowInfoArraySize OPTIONAL,
+  OUT      UINTN                              *ColumnInfoArray  OPTIONAL
+  )
+{
+  EFI_STATUS        Status;
+  FP_SURFACE        *Surface;
+  EFI_IMAGE_OUTPUT  Target;
+  EFI_IMAGE_OUTPUT  *TargetPtr;
+  EFI_HII_ROW_INFO  *LocalRowInfo;
+  UINTN             LocalRowCount;
+  EFI_HII_ROW_INFO  **Rows;
+  UINTN             *RowCount;
+  UINTN             Index;
+  UINT32            TextWidth;
+  UINT32            TextHeight;
+
+  Surface = mCaptureSurface;
+  if ((Surface == NULL) || (ImageHandle != mClientImage) || (Blt == NULL) || (*Blt == NULL) ||
+      ((Flags & EFI_HII_DIRECT_TO_SCREEN) == 0) ||
+      (BltX < Surface->OrigX) || (BltX >= (UINTN)Surface->OrigX + Surface->Width) ||
+      (BltY < Surface->OrigY) || (BltY >= (UINTN)Surface->OrigY + Surface->Height))
+  {
+    return mSwmOriginal.StringToWindow (
+                          This,
+                          ImageHandle,
+                          Flags,
+                          String,
+                          StringInfo,
+                          Blt,
+                          BltX,
+                          BltY,
+                          RowInfoArray,
+                          RowInfoArraySize,
+                          ColumnInfoArray
+                          );
+  }
+
+  ZeroMem (&Target, sizeof (Target));
+  Target.Width        = (UINT16)Surface->Width;
+  Target.Height       = (UINT16)Surface->Height;
+  Target.Image.Bitmap = Surface->Buffer;
+  TargetPtr           = &Target;
+
+  // The row information gives the extent of the string, which is what gets marked dirty.
+  //
+  LocalRowInfo  = NULL;
+  LocalRowCount = 0;
+  Rows          = (RowInfoArray != NULL) ? RowInfoArray : &LocalRowInfo;
+  RowCount      = (RowInfoArraySize != NULL) ? RowInfoArraySize : &LocalRowCount;
+
+  Status = mSwmOriginal.StringToWindow (
+                          This,
+                          ImageHandle,
+                          Flags & ~EFI_HII_DIRECT_TO_SCREEN,
+                          String,
+                          StringInfo,
+                          &TargetPtr,
+                          BltX - Surface->OrigX,
+                          BltY - Surface->OrigY,
+                          Rows,
+                          RowCount,
+                          ColumnInfoArray
+                          );
+
+  if (!EFI_ERROR (Status) && (*Rows != NULL)) {
+    TextWidth  = 0;
+    TextHeight = 0;
+    for (Index = 0; Index < *RowCount; Index++) {
+      TextWidth   = MAX (TextWidth, (UINT32)(*Rows)[Index].LineWidth);
+      TextHeight += (UINT32)(*Rows)[Index].LineHeight;
+    }
+
+    FpSurfaceMarkDirty (Surface, (UINT32)(BltX - Surface->OrigX), (UINT32)(BltY - Surface->OrigY), TextWidth, TextHeight);
+  } else {
+    FpSurfaceMarkDirty (Surface, (UINT32)(BltX - Surface->OrigX), (UINT32)(BltY - Surface->OrigY), Surface->Width, Surface->Height);
+  }
+
+  if (LocalRowInfo != NULL) {
+    FreePool (LocalRowInfo);
+  }
+
+  return Status;
+}
+
+/**
+  Sets the window manager and client image used to push surfaces to the screen and to capture
+  toolkit drawing.  Must be called before any surface is flushed.
+
+  @param[in]  Swm           Simple window manager protocol.
+  @param[in]  ImageHandle   FrontPage image handle, the window manager client.
+
+**/
+VOID
+FpCompositorInitialize (
+  IN MS_SIMPLE_WINDOW_MANAGER_PROTOCOL  *Swm,
+  IN EFI_HANDLE                         ImageHandle
+  )
+{
+  ASSERT (mCaptureSurface == NULL);
+
+  mSwm         = Swm;
+  mClientImage = ImageHandle;
+  if (Swm != NULL) {
+    CopyMem (&mSwmOriginal, Swm, sizeof (mSwmOriginal));
+  }
+}
+
+/**
+  Creates an off-screen surface for a screen region.  The surface starts out fully dirty.
+
+  @param[in]  OrigX       Screen x-coordinate of the region.
+  @param[in]  OrigY       Screen y-coordinate of the region.
+  @param[in]  Width       Region width in pixels.
+  @param[in]  Height      Region height in pixels.
+  @param[out] Surface     The new surface.
+
+  @retval  EFI_SUCCESS            The surface was created.
+  @retval  EFI_INVALID_PARAMETER  Surface is NULL or the region is empty.
+  @retval  EFI_OUT_OF_RESOURCES   The buffers could not be allocated.
+
+**/
+EFI_STATUS
+FpSurfaceCreate (
+  IN  UINT32      OrigX,
+  IN  UINT32      OrigY,
+  IN  UINT32      Width,
+  IN  UINT32      Height,
+  OUT FP_SURFACE  **Surface
+  )
+{
+  FP_SURFACE  *NewSurface;
+  UINTN       BufferSize;
+
+  if ((Surface == NULL) || (Width == 0) || (Height == 0) || (Width > MAX_UINT16) || (Height > MAX_UINT16)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  NewSurface = AllocateZeroPool (sizeof (FP_SURFACE));
+  if (NewSurface == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  BufferSize          = (UINTN)Width * Height * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL);
+  NewSurface->Buffer  = AllocateZeroPool (BufferSize);
+  NewSurface->Front   = AllocateZeroPool (BufferSize);
+  if ((NewSurface->Buffer == NULL) || (NewSurface->Front == NULL)) {
+    FpSurfaceDestroy (NewSurface);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  NewSurface->OrigX  = OrigX;
+  NewSurface->OrigY  = OrigY;
+  NewSurface->Width  = Width;
+  NewSurface->Height = Height;
+  FpSurfaceInvalidate (NewSurface);
+
+  *Surface = NewSurface;
+  return EFI_SUCCESS;
+}
+
+/**
+  Frees a surface created by FpSurfaceCreate ().
+
+  @param[in]  Surface     The surface to free.  May be NULL.
+
+**/
+VOID
+FpSurfaceDestroy (
+  IN FP_SURFACE  *Surface
+  )
+{
+  if (Surface == NULL) {
+    return;
+  }
+
+  ASSERT (mCaptureSurface != Surface);
+
+  DEBUG_CODE_BEGIN ();
+  DEBUG ((
+    DEBUG_INFO,
+    "INFO [FP]: Surface %ux%u at (%u,%u).  Blts=%lu Dirty=%lu Pushed=%lu pixels.\r\n",
+    Surface->Width,
+    Surface->Height,
+    Surface->OrigX,
+    Surface->OrigY,
+    Surface->BltCount,
+    Surface->PixelsDirty,
+    Surface->PixelsPushed
+    ));
+  DEBUG_CODE_END ();
+
+  if (Surface->Buffer != NULL) {
+    FreePool (Surface->Buffer);
+  }
+
+  if (Surface->Front != NULL) {
+    FreePool (Surface->Front);
+  }
+
+  FreePool (Surface);
+}
+
+/**
+  Fills a surface-relative rectangle with a solid color.
+
+  @param[in]  Surface     Target surface.
+  @param[in]  Color       Fill color.
+  @param[in]  X           Surface-relative x-coordinate.
+  @param[in]  Y           Surface-relative y-coordinate.
+  @param[in]  Width       Rectangle width.
+  @param[in]  Height      Rectangle height.
+
+**/
+VOID
+FpSurfaceFill (
+  IN FP_SURFACE                     *Surface,
+  IN EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Color,
+  IN UINT32                         X,
+  IN UINT32                         Y,
+  IN UINT32                         Width,
+  IN UINT32                         Height
+  )
+{
+  SWM_RECT  Rect;
+
+  if ((Surface != NULL) && (Color != NULL) && ClipToSurface (Surface, X, Y, Width, Height, &Rect)) {
+    FillSurface (Surface, &Rect, Color);
+  }
+}
+
+/**
+  Copies a BLT buffer into the surface.
+
+  @param[in]  Surface     Target surface.
+  @param[in]  Source      Source BLT buffer (Width * Height pixels).
+  @param[in]  X           Surface-relative x-coordinate.
+  @param[in]  Y           Surface-relative y-coordinate.
+  @param[in]  Width       Source width.
+  @param[in]  Height      Source height.
+
+**/
+VOID
+FpSurfaceBlt (
+  IN FP_SURFACE                     *Surface,
+  IN EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Source,
+  IN UINT32                         X,
+  IN UINT32                         Y,
+  IN UINT32                         Width,
+  IN UINT32                         Height
+  )
+{
+  SWM_RECT  Rect;
+
+  if ((Surface != NULL) && (Source != NULL) && ClipToSurface (Surface, X, Y, Width, Height, &Rect)) {
+    CopyToSurface (Surface, &Rect, Source, 0, 0, Width * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+  }
+}
+
+/**
+  Marks a surface-relative rectangle dirty.  Used after drawing into Surface->Buffer directly.
+
+  @param[in]  Surface     Target surface.
+  @param[in]  X           Surface-relative x-coordinate.
+  @param[in]  Y           Surface-relative y-coordinate.
+  @param[in]  Width       Rectangle width.
+  @param[in]  Height      Rectangle height.
+
+**/
+VOID
+FpSurfaceMarkDirty (
+  IN FP_SURFACE  *Surface,
+  IN UINT32      X,
+  IN UINT32      Y,
+  IN UINT32      Width,
+  IN UINT32      Height
+  )
+{
+  SWM_RECT  Rect;
+
+  if ((Surface != NULL) && ClipToSurface (Surface, X, Y, Width, Height, &Rect)) {
+    AddDirtyRect (Surface, &Rect);
+  }
+}
+
+/**
+  Marks the whole surface dirty and forgets what the screen shows, e.g. after something else
+  has drawn over its screen region.  The next flush pushes the whole surface.
+
+  @param[in]  Surface     Target surface.
+
+**/
+VOID
+FpSurfaceInvalidate (
+  IN FP_SURFACE  *Surface
+  )
+{
+  if (Surface == NULL) {
+    return;
+  }
+
+  Surface->FrontValid      = FALSE;
+  Surface->DirtyCount      = 1;
+  Surface->Dirty[0].Left   = 0;
+  Surface->Dirty[0].Top    = 0;
+  Surface->Dirty[0].Right  = Surface->Width - 1;
+  Surface->Dirty[0].Bottom = Surface->Height - 1;
+}
+
+/**
+  Pushes the changed parts of the dirty rectangles of a surface to the screen, one Blt per
+  run of changed rows.
+
+  @param[in]  Surface     Surface to flush.
+
+  @retval  EFI_SUCCESS    All changes were pushed.
+  @retval  EFI_NOT_READY  FpCompositorInitialize () has not been called.
+  @retval  Others         Error returned by the window manager.
+
+**/
+EFI_STATUS
+FpSurfaceFlush (
+  IN FP_SURFACE  *Surface
+  )
+{
+  EFI_STATUS  Status = EFI_SUCCESS;
+  UINTN       Index;
+  SWM_RECT    *Rect;
+  SWM_RECT    Run;
+  UINT32      Row;
+  UINT32      First;
+  UINT32      Last;
+  UINTN       RowBytes;
+
+  if (Surface == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (mSwm == NULL) {
+    return EFI_NOT_READY;
+  }
+
+  for (Index = 0; (Index < Surface->DirtyCount) && !EFI_ERROR (Status); Index++) {
+    Rect                  = &Surface->Dirty[Index];
+    Surface->PixelsDirty += (UINT64)(Rect->Right - Rect->Left + 1) * (Rect->Bottom - Rect->Top + 1);
+
+    Row = Rect->Top;
+    while (Row <= Rect->Bottom) {
+      if (!Surface->FrontValid) {
+        CopyMem (&Run, Rect, sizeof (SWM_RECT));
+        Row = Rect->Bottom + 1;
+      } else {
+        // Skip rows that did not change, then take every changed row that follows.
+        //
+        if (!RowChanged (Surface, Row, Rect->Left, Rect->Right, &First, &Last)) {
+          Row++;
+          continue;
+        }
+
+        Run.Left  = First;
+        Run.Right = Last;
+        Run.Top   = Row;
+        for (Row++; (Row <= Rect->Bottom) && RowChanged (Surface, Row, Rect->Left, Rect->Right, &First, &Last); Row++) {
+          Run.Left  = MIN (Run.Left, First);
+          Run.Right = MAX (Run.Right, Last);
+        }
+
+        Run.Bottom = Row - 1;
+      }
+
+      Status = mSwmOriginal.BltWindow (
+                              mSwm,
+                              mClientImage,
+                              Surface->Buffer,
+                              EfiBltBufferToVideo,
+                              Run.Left,
+                              Run.Top,
+                              Surface->OrigX + Run.Left,
+                              Surface->OrigY + Run.Top,
+                              (Run.Right - Run.Left + 1),
+                              (Run.Bottom - Run.Top + 1),
+                              Surface->Width * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL)
+                              );
+      if (EFI_ERROR (Status)) {
+        DEBUG ((DEBUG_ERROR, "ERROR [FP]: %a - Blt failed (%r).\r\n", __FUNCTION__, Status));
+        break;
+      }
+
+      Surface->BltCount++;
+      Surface->PixelsPushed += (UINT64)(Run.Right - Run.Left + 1) * (Run.Bottom - Run.Top + 1);
+
+      RowBytes = (Run.Right - Run.Left + 1) * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL);
+      for (First = Run.Top; First <= Run.Bottom; First++) {
+        CopyMem (
+          &Surface->Front[(UINTN)First * Surface->Width + Run.Left],
+          &Surface->Buffer[(UINTN)First * Surface->Width + Run.Left],
+          RowBytes
+          );
+      }
+    }
+  }
+
+  // After a failed Blt the screen is unknown, so the next flush pushes everything.
+  //
+  if (EFI_ERROR (Status)) {
+    FpSurfaceInvalidate (Surface);
+    return Status;
+  }
+
+  Surface->FrontValid = TRUE;
+  Surface->DirtyCount = 0;
+
+  return Status;
+}
+
+/**
+  Starts drawing FrontPage's window manager calls into a surface.  Fills, BLT copies and
+  strings that lie within the surface go to its back buffer.  Anything else still reaches the
+  screen, and the surface is invalidated if it overlaps.
+
+  Calls are captured until FpSurfaceEndCapture ().  Captures do not nest.
+
+  @param[in]  Surface     Surface to draw into.
+
+**/
+VOID
+FpSurfaceBeginCapture (
+  IN FP_SURFACE  *Surface
+  )
+{
+  ASSERT (mCaptureSurface == NULL);
+  if ((mSwm == NULL) || (Surface == NULL) || (mCaptureSurface != NULL)) {
+    return;
+  }
+
+  mCaptureSurface      = Surface;
+  mSwm->BltWindow      = CaptureBltWindow;
+  mSwm->StringToWindow = CaptureStringToWindow;
+}
+
+/**
+  Stops the capture started by FpSurfaceBeginCapture ().  The surface is not flushed.
+
+**/
+VOID
+FpSurfaceEndCapture (
+  VOID
+  )
+{
+  if (mCaptureSurface == NULL) {
+    return;
+  }
+
+  mSwm->BltWindow      = mSwmOriginal.BltWindow;
+  mSwm->StringToWindow = mSwmOriginal.StringToWindow;
+  mCaptureSurface      = NULL;
+}
@@ -0,0 +1,200 @@
+/** @file
+  Off-screen compositor for the FrontPage chrome (title bar, master frame and top menu).
+
+  Each surface is an in-memory copy of a screen region.  Drawing goes to the back buffer and
+  marks rectangles dirty.  A flush compares each dirty rectangle with a front buffer that holds
+  what was last pushed, and pushes only the rows that changed, one Blt per run of changed rows.
+
+  The top menu is drawn by the UI toolkit through the window manager.  While a surface captures,
+  the window manager calls that FrontPage makes are drawn into the surface instead of the screen.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _FRONT_PAGE_COMPOSITOR_H_
+#define _FRONT_PAGE_COMPOSITOR_H_
+
+#include <Protocol/GraphicsOutput.h>
+#include <Protocol/SimpleWindowManager.h>
+
+#define FP_SURFACE_MAX_DIRTY_RECTS  8
+
+typedef struct {
+  UINT32                           OrigX;       // Screen position of the surface.
+  UINT32                           OrigY;
+  UINT32                           Width;
+  UINT32                           Height;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL    *Buffer;     // Width * Height back buffer.
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL    *Front;      // What the last flush left on the screen.
+  BOOLEAN                          FrontValid;  // FALSE when the screen may no longer match Front.
+  UINTN                            DirtyCount;
+  SWM_RECT                         Dirty[FP_SURFACE_MAX_DIRTY_RECTS];   // Surface-relative, inclusive bounds.
+  UINT64                           BltCount;    // Blts pushed by flushes.
+  UINT64                           PixelsDirty; // Pixels in the dirty rectangles that were flushed.
+  UINT64                           PixelsPushed;
+} FP_SURFACE;
+
+/**
+  Sets the window manager and client image used to push surfaces to the screen and to capture
+  toolkit drawing.  Must be called before any surface is flushed.
+
+  @param[in]  Swm           Simple window manager protocol.
+  @param[in]  ImageHandle   FrontPage image handle, the window manager client.
+
+**/
+VOID
+FpCompositorInitialize (
+  IN MS_SIMPLE_WINDOW_MANAGER_PROTOCOL  *Swm,
+  IN EFI_HANDLE                         ImageHandle
+  );
+
+/**
+  Creates an off-screen surface for a screen region.  The surface starts out fully dirty.
+
+  @param[in]  OrigX       Screen x-coordinate of the region.
+  @param[in]  OrigY       Screen y-coordinate of the region.
+  @param[in]  Width       Region width in pixels.
+  @param[in]  Height      Region height in pixels.
+  @param[out] Surface     The new surface.
+
+  @retval  EFI_SUCCESS            The surface was created.
+  @retval  EFI_INVALID_PARAMETER  Surface is NULL or the region is empty.
+  @retval  EFI_OUT_OF_RESOURCES   The buffers could not be allocated.
+
+**/
+EFI_STATUS
+FpSurfaceCreate (
+  IN  UINT32      OrigX,
+  IN  UINT32      OrigY,
+  IN  UINT32      Width,
+  IN  UINT32      Height,
+  OUT FP_SURFACE  **Surface
+  );
+
+/**
+  Frees a surface created by FpSurfaceCreate ().
+
+  @param[in]  Surface     The surface to free.  May be NULL.
+
+**/
+VOID
+FpSurfaceDestroy (
+  IN FP_SURFACE  *Surface
+  );
+
+/**
+  Fills a surface-relative rectangle with a solid color.
+
+  @param[in]  Surface     Target surface.
+  @param[in]  Color       Fill color.
+  @param[in]  X           Surface-relative x-coordinate.
+  @param[in]  Y           Surface-relative y-coordinate.
+  @param[in]  Width       Rectangle width.
+  @param[in]  Height      Rectangle height.
+
+**/
+VOID
+FpSurfaceFill (
+  IN FP_SURFACE                     *Surface,
+  IN EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Color,
+  IN UINT32                         X,
+  IN UINT32                         Y,
+  IN UINT32                         Width,
+  IN UINT32                         Height
+  );
+
+/**
+  Copies a BLT buffer into the surface.
+
+  @param[in]  Surface     Target surface.
+  @param[in]  Source      Source BLT buffer (Width * Height pixels).
+  @param[in]  X           Surface-relative x-coordinate.
+  @param[in]  Y           Surface-relative y-coordinate.
+  @param[in]  Width       Source width.
+  @param[in]  Height      Source height.
+
+**/
+VOID
+FpSurfaceBlt (
+  IN FP_SURFACE                     *Surface,
+  IN EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Source,
+  IN UINT32                         X,
+  IN UINT32                         Y,
+  IN UINT32                         Width,
+  IN UINT32                         Height
+  );
+
+/**
+  Marks a surface-relative rectangle dirty.  Used after drawing into Surface->Buffer directly.
+
+  @param[in]  Surface     Target surface.
+  @param[in]  X           Surface-relative x-coordinate.
+  @param[in]  Y           Surface-relative y-coordinate.
+  @param[in]  Width       Rectangle width.
+  @param[in]  Height      Rectangle height.
+
+**/
+VOID
+FpSurfaceMarkDirty (
+  IN FP_SURFACE  *Surface,
+  IN UINT32      X,
+  IN UINT32      Y,
+  IN UINT32      Width,
+  IN UINT32      Height
+  );
+
+/**
+  Marks the whole surface dirty and forgets what the screen shows, e.g. after something else
+  has drawn over its screen region.  The next flush pushes the whole surface.
+
+  @param[in]  Surface     Target surface.
+
+**/
+VOID
+FpSurfaceInvalidate (
+  IN FP_SURFACE  *Surface
+  );
+
+/**
+  Pushes the changed parts of the dirty rectangles of a surface to the screen, one Blt per
+  run of changed rows.
+
+  @param[in]  Surface     Surface to flush.
+
+  @retval  EFI_SUCCESS    All changes were pushed.
+  @retval  EFI_NOT_READY  FpCompositorInitialize () has not been called.
+  @retval  Others         Error returned by the window manager.
+
+**/
+EFI_STATUS
+FpSurfaceFlush (
+  IN FP_SURFACE  *Surface
+  );
+
+/**
+  Starts drawing FrontPage's window manager calls into a surface.  Fills, BLT copies and
+  strings that lie within the surface go to its back buffer.  Anything else still reaches the
+  screen, and the surface is invalidated if it overlaps.
+
+  Calls are captured until FpSurfaceEndCapture ().  Captures do not nest.
+
+  @param[in]  Surface     Surface to draw into.
+
+**/
+VOID
+FpSurfaceBeginCapture (
+  IN FP_SURFACE  *Surface
+  );
+
+/**
+  Stops the capture started by FpSurfaceBeginCapture ().  The surface is not flushed.
+
+**/
+VOID
+FpSurfaceEndCapture (
+  VOID
+  );
+
+#endif // _FRONT_PAGE_COMPOSITOR_H_
@@ -0,0 +1,356 @@
+/** @file
+  Snapshot of the FMP image descriptors used to build the PC Info firmware version form.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Guid/CapsuleReport.h>
+
+#include <Protocol/FirmwareManagement.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+
+#include "FrontPageFmpSnapshot.h"
+
+// Initial GetImageInfo () buffer.  Most FMP instances fit, which saves the sizing call.
+//
+#define FMP_IMAGE_INFO_INITIAL_SIZE  SIZE_1KB
+
+typedef struct {
+  EFI_FIRMWARE_IMAGE_DESCRIPTOR    *Descriptors;
+  UINT8                            DescriptorCount;
+  UINTN                            DescriptorSize;
+  UINT32                           PackageVersion;
+} FMP_IMAGE_INFO;
+
+/**
+  Reads CapsuleLast, which changes each time a capsule is processed.
+
+  @param[out] CapsuleLast   Receives the variable, or an empty string if it does not exist.
+
+**/
+STATIC
+VOID
+GetCapsuleLast (
+  OUT CHAR16  CapsuleLast[FMP_SNAPSHOT_CAPSULE_LAST_LENGTH]
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Size;
+
+  ZeroMem (CapsuleLast, FMP_SNAPSHOT_CAPSULE_LAST_LENGTH * sizeof (CHAR16));
+
+  Size   = (FMP_SNAPSHOT_CAPSULE_LAST_LENGTH - 1) * sizeof (CHAR16);
+  Status = gRT->GetVariable (L"CapsuleLast", &gEfiCapsuleReportGuid, NULL, &Size, CapsuleLast);
+  if (EFI_ERROR (Status)) {
+    ZeroMem (CapsuleLast, FMP_SNAPSHOT_CAPSULE_LAST_LENGTH * sizeof (CHAR16));
+  }
+}
+
+/**
+  Calls GetImageInfo () on one FMP instance.
+
+  @param[in]  Fmp         The FMP instance.
+  @param[out] ImageInfo   Receives the descriptors.  Descriptors must be freed by the caller.
+
+  @retval  EFI_SUCCESS    ImageInfo is valid.
+  @retval  Others         GetImageInfo () failed.
+
+**/
+STATIC
+EFI_STATUS
+ReadImageInfo (
+  IN  EFI_FIRMWARE_MANAGEMENT_PROTOCOL  *Fmp,
+  OUT FMP_IMAGE_INFO                    *ImageInfo
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       ImageInfoSize;
+  UINT32      DescriptorVersion;
+  CHAR16      *PackageVersionName;
+
+  ImageInfoSize          = FMP_IMAGE_INFO_INITIAL_SIZE;
+  ImageInfo->Descriptors = AllocateZeroPool (ImageInfoSize);
+  if (ImageInfo->Descriptors == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  PackageVersionName = NULL;
+  Status             = Fmp->GetImageInfo (
+                              Fmp,
+                              &ImageInfoSize,
+                              ImageInfo->Descriptors,
+                              &DescriptorVersion,
+                              &ImageInfo->DescriptorCount,
+                              &ImageInfo->DescriptorSize,
+                              &ImageInfo->PackageVersion,
+                              &PackageVersionName
+                              );
+
+  // Retry once with the size the instance asked for.
+  //
+  if (Status == EFI_BUFFER_TOO_SMALL) {
+    FreePool (ImageInfo->Descriptors);
+    ImageInfo->Descriptors = AllocateZeroPool (ImageInfoSize);
+    if (ImageInfo->Descriptors == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    PackageVersionName = NULL;
+    Status             = Fmp->GetImageInfo (
+                                Fmp,
+                                &ImageInfoSize,
+                                ImageInfo->Descriptors,
+                                &DescriptorVersion,
+                                &ImageInfo->DescriptorCount,
+                                &ImageInfo->DescriptorSize,
+                                &ImageInfo->PackageVersion,
+                                &PackageVersionName
+                                );
+  }
+
+  if (PackageVersionName != NULL) {
+    FreePool (PackageVersionName);
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - Failure in GetImageInfo.  Status = %r\n", __FUNCTION__, Status));
+    FreePool (ImageInfo->Descriptors);
+    ImageInfo->Descriptors = NULL;
+  }
+
+  return Status;
+}
+
+/**
+  Returns the size of a string in the snapshot (0 for NULL).
+
+**/
+STATIC
+UINTN
+SnapshotStrSize (
+  IN CONST CHAR16  *String
+  )
+{
+  return (String == NULL) ? 0 : StrSize (String);
+}
+
+/**
+  Captures a new snapshot from every FMP instance.
+
+  @param[in]  CapsuleLast   Current value of CapsuleLast.
+  @param[out] Snapshot      The new snapshot.
+
+**/
+STATIC
+EFI_STATUS
+CaptureFmpSnapshot (
+  IN  CHAR16               CapsuleLast[FMP_SNAPSHOT_CAPSULE_LAST_LENGTH],
+  OUT FMP_SNAPSHOT_HEADER  **Snapshot
+  )
+{
+  EFI_STATUS                        Status;
+  EFI_FIRMWARE_MANAGEMENT_PROTOCOL  **FmpList;
+  UINTN                             FmpCount;
+  FMP_IMAGE_INFO                    *ImageInfo;
+  EFI_FIRMWARE_IMAGE_DESCRIPTOR     *Descriptor;
+  FMP_SNAPSHOT_HEADER               *Header;
+  FMP_SNAPSHOT_ENTRY                *Entry;
+  UINTN                             TotalSize;
+  UINTN                             EntrySize;
+  UINTN                             NameSize;
+  UINTN                             VersionSize;
+  UINTN                             Index;
+  UINTN                             DescIndex;
+
+  Status = EfiLocateProtocolBuffer (&gEfiFirmwareManagementProtocolGuid, &FmpCount, (VOID *)&FmpList);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "EfiLocateProtocolBuffer(gEfiFirmwareManagementProtocolGuid) returned error.  %r \n", Status));
+    return Status;
+  }
+
+  ImageInfo = AllocateZeroPool (FmpCount * sizeof (FMP_IMAGE_INFO));
+  if (ImageInfo == NULL) {
+    FreePool (FmpList);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  // Query every instance once, and size the snapshot.
+  //
+  TotalSize = sizeof (FMP_SNAPSHOT_HEADER);
+  for (Index = 0; Index < FmpCount; Index++) {
+    if (EFI_ERROR (ReadImageInfo (FmpList[Index], &ImageInfo[Index]))) {
+      continue;
+    }
+
+    for (DescIndex = 0; DescIndex < ImageInfo[Index].DescriptorCount; DescIndex++) {
+      Descriptor = (EFI_FIRMWARE_IMAGE_DESCRIPTOR *)((UINT8 *)ImageInfo[Index].Descriptors + DescIndex * ImageInfo[Index].DescriptorSize);
+      EntrySize  = sizeof (FMP_SNAPSHOT_ENTRY) + SnapshotStrSize (Descriptor->ImageIdName) + SnapshotStrSize (Descriptor->VersionName);
+      TotalSize += ALIGN_VALUE (EntrySize, sizeof (UINT64));
+    }
+  }
+
+  Header = AllocateZeroPool (TotalSize);
+  if (Header == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Cleanup;
+  }
+
+  Header->Signature = FMP_SNAPSHOT_SIGNATURE;
+  Header->Version   = FMP_SNAPSHOT_VERSION;
+  Header->Size      = (UINT32)TotalSize;
+  Header->FmpCount  = (UINT32)FmpCount;
+  CopyMem (Header->CapsuleLast, CapsuleLast, sizeof (Header->CapsuleLast));
+
+  // Serialize every descriptor of every instance.
+  //
+  Entry = FMP_SNAPSHOT_FIRST_ENTRY (Header);
+  for (Index = 0; Index < FmpCount; Index++) {
+    for (DescIndex = 0; DescIndex < ImageInfo[Index].DescriptorCount; DescIndex++) {
+      Descriptor  = (EFI_FIRMWARE_IMAGE_DESCRIPTOR *)((UINT8 *)ImageInfo[Index].Descriptors + DescIndex * ImageInfo[Index].DescriptorSize);
+      NameSize    = SnapshotStrSize (Descriptor->ImageIdName);
+      VersionSize = SnapshotStrSize (Descriptor->VersionName);
+
+      Entry->Size           = (UINT32)ALIGN_VALUE (sizeof (FMP_SNAPSHOT_ENTRY) + NameSize + VersionSize, sizeof (UINT64));
+      Entry->FmpInstance    = (UINT32)Index;
+      Entry->ImageIndex     = Descriptor->ImageIndex;
+      Entry->Version        = Descriptor->Version;
+      Entry->PackageVersion = ImageInfo[Index].PackageVersion;
+      CopyGuid (&Entry->ImageTypeId, &Descriptor->ImageTypeId);
+
+      if (NameSize != 0) {
+        Entry->ImageIdNameOffset = sizeof (FMP_SNAPSHOT_ENTRY);
+        CopyMem ((UINT8 *)Entry + Entry->ImageIdNameOffset, Descriptor->ImageIdName, NameSize);
+      }
+
+      if (VersionSize != 0) {
+        Entry->VersionNameOffset = (UINT32)(sizeof (FMP_SNAPSHOT_ENTRY) + NameSize);
+        CopyMem ((UINT8 *)Entry + Entry->VersionNameOffset, Descriptor->VersionName, VersionSize);
+      }
+
+      Header->EntryCount++;
+      Entry = FMP_SNAPSHOT_NEXT_ENTRY (Entry);
+    }
+  }
+
+  *Snapshot = Header;
+  Status    = EFI_SUCCESS;
+
+Cleanup:
+  for (Index = 0; Index < FmpCount; Index++) {
+    if (ImageInfo[Index].Descriptors != NULL) {
+      FreePool (ImageInfo[Index].Descriptors);
+    }
+  }
+
+  FreePool (ImageInfo);
+  FreePool (FmpList);
+
+  return Status;
+}
+
+/**
+  Returns the FMP descriptor snapshot for this boot, capturing it if there is none or
+  the existing one is stale.
+
+  @param[out] Snapshot    The snapshot.  Owned by the protocol interface; do not free.
+
+  @retval  EFI_SUCCESS            Snapshot is valid.
+  @retval  EFI_INVALID_PARAMETER  Snapshot is NULL.
+  @retval  EFI_NOT_FOUND          There are no FMP instances.
+  @retval  EFI_OUT_OF_RESOURCES   The snapshot could not be allocated.
+  @retval  Others                 The snapshot could not be published.
+
+**/
+EFI_STATUS
+GetFmpSnapshot (
+  OUT CONST FMP_SNAPSHOT_HEADER  **Snapshot
+  )
+{
+  EFI_STATUS           Status;
+  FMP_SNAPSHOT_HEADER  *Existing;
+  FMP_SNAPSHOT_HEADER  *New;
+  CHAR16               CapsuleLast[FMP_SNAPSHOT_CAPSULE_LAST_LENGTH];
+  EFI_HANDLE           *Handles;
+  UINTN                HandleCount;
+  EFI_HANDLE           SnapshotHandle;
+  UINTN                Size;
+
+  if (Snapshot == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  GetCapsuleLast (CapsuleLast);
+
+  HandleCount = 0;
+  Status      = gBS->LocateHandleBuffer (ByProtocol, &gEfiFirmwareManagementProtocolGuid, NULL, &HandleCount, &Handles);
+  if (!EFI_ERROR (Status)) {
+    FreePool (Handles);
+  }
+
+  // Reuse the snapshot from earlier in this boot if nothing has changed since.  It is installed
+  // under FrontPage's file GUID, on a handle of its own.
+  //
+  Existing       = NULL;
+  SnapshotHandle = NULL;
+  Size           = sizeof (SnapshotHandle);
+  Status         = gBS->LocateHandle (ByProtocol, &gEfiCallerIdGuid, NULL, &Size, &SnapshotHandle);
+  if (!EFI_ERROR (Status)) {
+    Status = gBS->HandleProtocol (SnapshotHandle, &gEfiCallerIdGuid, (VOID **)&Existing);
+    if (EFI_ERROR (Status)) {
+      Existing = NULL;
+    }
+  }
+
+  if ((Existing != NULL) &&
+      (Existing->Signature == FMP_SNAPSHOT_SIGNATURE) &&
+      (Existing->Version == FMP_SNAPSHOT_VERSION) &&
+      (Existing->FmpCount == HandleCount) &&
+      (CompareMem (Existing->CapsuleLast, CapsuleLast, sizeof (CapsuleLast)) == 0))
+  {
+    *Snapshot = Existing;
+    return EFI_SUCCESS;
+  }
+
+  if (HandleCount == 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  DEBUG ((DEBUG_INFO, "%a - Capturing FMP snapshot (%lu instances).\n", __FUNCTION__, (UINT64)HandleCount));
+
+  Status = CaptureFmpSnapshot (CapsuleLast, &New);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (Existing != NULL) {
+    Status = gBS->ReinstallProtocolInterface (SnapshotHandle, &gEfiCallerIdGuid, Existing, New);
+  } else {
+    SnapshotHandle = NULL;
+    Status         = gBS->InstallProtocolInterface (&SnapshotHandle, &gEfiCallerIdGuid, EFI_NATIVE_INTERFACE, New);
+  }
+
+  if (EFI_ERROR (Status)) {
+    // The snapshot is owned by the protocol interface, so one that isn't published can't be handed out.
+    DEBUG ((DEBUG_ERROR, "%a - Failed to publish FMP snapshot.  %r\n", __FUNCTION__, Status));
+    FreePool (New);
+    return Status;
+  }
+
+  if (Existing != NULL) {
+    FreePool (Existing);
+  }
+
+  *Snapshot = New;
+  return EFI_SUCCESS;
+}
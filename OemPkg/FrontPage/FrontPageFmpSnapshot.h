@@ -0,0 +1,70 @@
+/** @file
+  Snapshot of the FMP image descriptors used to build the PC Info firmware version form.
+
+  The snapshot is captured once per boot and installed as a protocol interface under
+  FrontPage's file GUID, so later FrontPage launches in the same boot do not call
+  GetImageInfo () again.  It is recaptured if the number of FMP instances changes or a
+  capsule has been processed since it was taken (CapsuleLast changed).
+
+  The snapshot is boot services data and the protocol is private to FrontPage.  Nothing of
+  it is left for the OS: both go away at ExitBootServices.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _FRONT_PAGE_FMP_SNAPSHOT_H_
+#define _FRONT_PAGE_FMP_SNAPSHOT_H_
+
+#define FMP_SNAPSHOT_SIGNATURE  SIGNATURE_32 ('F', 'M', 'P', 'S')
+#define FMP_SNAPSHOT_VERSION    1
+
+#define FMP_SNAPSHOT_CAPSULE_LAST_LENGTH  (sizeof ("Capsule####"))
+
+typedef struct {
+  UINT32    Signature;
+  UINT32    Version;
+  UINT32    Size;                                             // Total size, including all entries.
+  UINT32    FmpCount;                                         // Number of FMP instances when captured.
+  CHAR16    CapsuleLast[FMP_SNAPSHOT_CAPSULE_LAST_LENGTH];    // Value of CapsuleLast when captured.
+  UINT32    EntryCount;
+  // FMP_SNAPSHOT_ENTRY Entries[EntryCount];
+} FMP_SNAPSHOT_HEADER;
+
+typedef struct {
+  UINT32      Size;                 // Size of this entry, including the strings that follow it.
+  UINT32      FmpInstance;          // Index of the FMP instance the descriptor came from.
+  UINT32      Version;
+  UINT32      PackageVersion;
+  EFI_GUID    ImageTypeId;
+  UINT8       ImageIndex;
+  UINT8       Reserved[3];
+  UINT32      ImageIdNameOffset;    // Offset of the image name from the start of the entry.  0 if none.
+  UINT32      VersionNameOffset;    // Offset of the version string from the start of the entry.  0 if none.
+} FMP_SNAPSHOT_ENTRY;
+
+#define FMP_SNAPSHOT_FIRST_ENTRY(Header)  ((FMP_SNAPSHOT_ENTRY *)((UINT8 *)(Header) + sizeof (FMP_SNAPSHOT_HEADER)))
+#define FMP_SNAPSHOT_NEXT_ENTRY(Entry)    ((FMP_SNAPSHOT_ENTRY *)((UINT8 *)(Entry) + (Entry)->Size))
+#define FMP_SNAPSHOT_ENTRY_STRING(Entry, Offset) \
+  (((Offset) == 0) ? NULL : (CHAR16 *)((UINT8 *)(Entry) + (Offset)))
+
+/**
+  Returns the FMP descriptor snapshot for this boot, capturing it if there is none or
+  the existing one is stale.
+
+  @param[out] Snapshot    The snapshot.  Owned by the protocol interface; do not free.
+
+  @retval  EFI_SUCCESS            Snapshot is valid.
+  @retval  EFI_INVALID_PARAMETER  Snapshot is NULL.
+  @retval  EFI_NOT_FOUND          There are no FMP instances.
+  @retval  EFI_OUT_OF_RESOURCES   The snapshot could not be allocated.
+  @retval  Others                 The snapshot could not be published.
+
+**/
+EFI_STATUS
+GetFmpSnapshot (
+  OUT CONST FMP_SNAPSHOT_HEADER  **Snapshot
+  );
+
+#endif // _FRONT_PAGE_FMP_SNAPSHOT_H_
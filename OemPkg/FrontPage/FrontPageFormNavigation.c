@@ -0,0 +1,135 @@
+/** @file
+  Navigation between forms of one formset inside a running form browser session.
+
+  When a form closes, the browser returns to the closest earlier form of the same formset in
+  its view history.  The target form is placed in the history just before the current form.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Protocol/FormBrowserEx2.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+#include "FrontPageFormNavigation.h"
+
+STATIC EDKII_FORM_BROWSER_EXTENSION2_PROTOCOL  *mFormBrowserEx2 = NULL;
+
+/**
+  Locates the form browser extension and checks that its version is supported.
+
+  @retval EFI_SUCCESS       Form switches can be queued.
+  @retval EFI_UNSUPPORTED   The extension is missing or its version is not supported.  Every
+                            switch relaunches the browser.
+
+**/
+EFI_STATUS
+FormNavigationInitialize (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+
+  mFormBrowserEx2 = NULL;
+
+  Status = gBS->LocateProtocol (&gEdkiiFormBrowserEx2ProtocolGuid, NULL, (VOID **)&mFormBrowserEx2);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "WARN [FP]: Form browser extension not found, top menu switches will relaunch the browser.\n"));
+    mFormBrowserEx2 = NULL;
+    return EFI_UNSUPPORTED;
+  }
+
+  // The view history layout and the way the browser walks it are only known for version 1.
+  //
+  if (mFormBrowserEx2->Version != FORM_BROWSER_EXTENSION2_VERSION_1) {
+    DEBUG ((
+      DEBUG_WARN,
+      "WARN [FP]: Form browser extension version 0x%x is not supported, top menu switches will relaunch the browser.\n",
+      mFormBrowserEx2->Version
+      ));
+    mFormBrowserEx2 = NULL;
+    return EFI_UNSUPPORTED;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Queues a switch to another form of the formset being displayed, so the browser navigates
+  to it when the current form closes instead of returning from SendForm ().  The formset
+  stays loaded and its configuration is not extracted again.
+
+  @param[in]  FormSetGuid   Formset of the target form.
+  @param[in]  FormId        The target form.
+
+  @retval EFI_SUCCESS           The switch is queued.
+  @retval EFI_UNSUPPORTED       Queuing is not available, or the target is in another formset.
+  @retval EFI_OUT_OF_RESOURCES  Unable to allocate the history entry.
+
+**/
+EFI_STATUS
+FormNavigationQueue (
+  IN CONST EFI_GUID  *FormSetGuid,
+  IN EFI_FORM_ID     FormId
+  )
+{
+  LIST_ENTRY       *HistoryHead;
+  LIST_ENTRY       *Link;
+  FORM_ENTRY_INFO  *CurrentMenu;
+  FORM_ENTRY_INFO  *TargetMenu;
+  FORM_ENTRY_INFO  *Menu;
+
+  if (mFormBrowserEx2 == NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
+  HistoryHead = &mFormBrowserEx2->FormViewHistoryHead;
+  if (IsListEmpty (HistoryHead)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  CurrentMenu = FORM_ENTRY_INFO_FROM_LINK (GetPreviousNode (HistoryHead, HistoryHead));
+  if (!CompareGuid (&CurrentMenu->FormSetGuid, FormSetGuid)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  // Reuse the history entry of the target form if this session already visited it.
+  //
+  TargetMenu = NULL;
+  for (Link = GetFirstNode (HistoryHead); Link != &CurrentMenu->Link; Link = GetNextNode (HistoryHead, Link)) {
+    Menu = FORM_ENTRY_INFO_FROM_LINK (Link);
+    if ((Menu->HiiHandle == CurrentMenu->HiiHandle) &&
+        (Menu->FormId == FormId) &&
+        CompareGuid (&Menu->FormSetGuid, &CurrentMenu->FormSetGuid))
+    {
+      TargetMenu = Menu;
+      RemoveEntryList (&TargetMenu->Link);
+      break;
+    }
+  }
+
+  // The browser frees history entries with FreePool () when the session ends.
+  //
+  if (TargetMenu == NULL) {
+    TargetMenu = AllocateZeroPool (sizeof (FORM_ENTRY_INFO));
+    if (TargetMenu == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    TargetMenu->Signature = FORM_ENTRY_INFO_SIGNATURE;
+    TargetMenu->HiiHandle = CurrentMenu->HiiHandle;
+    TargetMenu->FormId    = FormId;
+    CopyGuid (&TargetMenu->FormSetGuid, &CurrentMenu->FormSetGuid);
+  }
+
+  InsertTailList (&CurrentMenu->Link, &TargetMenu->Link);
+  return EFI_SUCCESS;
+}
@@ -0,0 +1,49 @@
+/** @file
+  Navigation between forms of one formset inside a running form browser session.
+
+  There is no public "go to form" request for a running SendForm (), so a switch is queued by
+  inserting the target form into the browser view history of EDKII_FORM_BROWSER_EXTENSION2_PROTOCOL.
+  How the browser walks that history is not part of the protocol, so queuing is only enabled for
+  the protocol version whose behavior is known, and it is kept to this file.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _FRONT_PAGE_FORM_NAVIGATION_H_
+#define _FRONT_PAGE_FORM_NAVIGATION_H_
+
+/**
+  Locates the form browser extension and checks that its version is supported.
+
+  @retval EFI_SUCCESS       Form switches can be queued.
+  @retval EFI_UNSUPPORTED   The extension is missing or its version is not supported.  Every
+                            switch relaunches the browser.
+
+**/
+EFI_STATUS
+FormNavigationInitialize (
+  VOID
+  );
+
+/**
+  Queues a switch to another form of the formset being displayed, so the browser navigates
+  to it when the current form closes instead of returning from SendForm ().  The formset
+  stays loaded and its configuration is not extracted again.
+
+  @param[in]  FormSetGuid   Formset of the target form.
+  @param[in]  FormId        The target form.
+
+  @retval EFI_SUCCESS           The switch is queued.
+  @retval EFI_UNSUPPORTED       Queuing is not available, or the target is in another formset.
+  @retval EFI_OUT_OF_RESOURCES  Unable to allocate the history entry.
+
+**/
+EFI_STATUS
+FormNavigationQueue (
+  IN CONST EFI_GUID  *FormSetGuid,
+  IN EFI_FORM_ID     FormId
+  );
+
+#endif // _FRONT_PAGE_FORM_NAVIGATION_H_
@@ -0,0 +1,576 @@
+/** @file
+  Registry of the formsets and top-level menu entries FrontPage displays.
+
+  Each formset is looked up in the HII database once, when it is registered.  After
+  that its HII handle is kept current by HII database notifications: a new or added
+  forms package that declares a registered formset sets the handle, and removing
+  the forms packages of a package list clears it.  HiiUpdateForm () on a formset is
+  a remove followed by an add on the same handle.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Uefi/UefiInternalFormRepresentation.h>
+#include <Protocol/HiiDatabase.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HiiLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiHiiServicesLib.h>
+
+#include "FrontPageFormsetRegistry.h"
+
+#define FORMSET_REGISTRY_GROW_COUNT  8
+
+typedef struct {
+  EFI_GUID          FormSetGuid;
+  EFI_HII_HANDLE    HiiHandle;        // NULL while the formset is not in the HII database.
+} FP_FORMSET;
+
+STATIC FP_FORMSET      *mFormsets          = NULL;
+STATIC UINTN           mFormsetCount       = 0;
+STATIC UINTN           mFormsetCapacity    = 0;
+STATIC FP_MENU_ENTRY   *mMenuEntries       = NULL;      // Sorted by Position.
+STATIC UINTN           mMenuEntryCount     = 0;
+STATIC UINTN           mMenuEntryCapacity  = 0;
+STATIC EFI_HII_HANDLE  *mHandles           = NULL;      // Cached SendForm () handle array.
+STATIC UINTN           mHandleCount        = 0;
+STATIC BOOLEAN         mHandlesValid       = FALSE;
+STATIC EFI_HANDLE      mNewPackNotify      = NULL;
+STATIC EFI_HANDLE      mAddPackNotify      = NULL;
+STATIC EFI_HANDLE      mRemovePackNotify   = NULL;
+
+/**
+  Grows a registry array so it can hold one more element.
+
+  @param[in, out] Array         The array.
+  @param[in]      Count         Number of elements in use.
+  @param[in, out] Capacity      Number of elements allocated.
+  @param[in]      ElementSize   Size of an element.
+
+  @retval EFI_SUCCESS           The array has room for another element.
+  @retval EFI_OUT_OF_RESOURCES  Unable to grow the array.
+
+**/
+STATIC
+EFI_STATUS
+GrowArray (
+  IN OUT VOID   **Array,
+  IN     UINTN  Count,
+  IN OUT UINTN  *Capacity,
+  IN     UINTN  ElementSize
+  )
+{
+  VOID  *NewArray;
+
+  if (Count < *Capacity) {
+    return EFI_SUCCESS;
+  }
+
+  NewArray = ReallocatePool (
+               *Capacity * ElementSize,
+               (*Capacity + FORMSET_REGISTRY_GROW_COUNT) * ElementSize,
+               *Array
+               );
+  if (NewArray == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  *Array     = NewArray;
+  *Capacity += FORMSET_REGISTRY_GROW_COUNT;
+  return EFI_SUCCESS;
+}
+
+/**
+  Finds a registered formset.
+
+  @param[in]  FormSetGuid   Formset GUID.
+
+  @return     The formset, or NULL if it is not registered.
+
+**/
+STATIC
+FP_FORMSET *
+FindFormset (
+  IN CONST EFI_GUID  *FormSetGuid
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < mFormsetCount; Index++) {
+    if (CompareGuid (&mFormsets[Index].FormSetGuid, FormSetGuid)) {
+      return &mFormsets[Index];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Registers a formset, looking up its HII handle.  This is the only HII database scan
+  the registry performs for the formset.
+
+  @param[in]  FormSetGuid   Formset GUID.
+
+  @return     The formset, or NULL if the registry could not be grown.
+
+**/
+STATIC
+FP_FORMSET *
+RegisterFormset (
+  IN CONST EFI_GUID  *FormSetGuid
+  )
+{
+  FP_FORMSET      *Formset;
+  EFI_HII_HANDLE  *HiiHandles;
+
+  Formset = FindFormset (FormSetGuid);
+  if (Formset != NULL) {
+    return Formset;
+  }
+
+  if (EFI_ERROR (GrowArray ((VOID **)&mFormsets, mFormsetCount, &mFormsetCapacity, sizeof (FP_FORMSET)))) {
+    return NULL;
+  }
+
+  Formset = &mFormsets[mFormsetCount++];
+  CopyGuid (&Formset->FormSetGuid, FormSetGuid);
+  Formset->HiiHandle = NULL;
+
+  HiiHandles = HiiGetHiiHandles (FormSetGuid);
+  if (HiiHandles != NULL) {
+    Formset->HiiHandle = HiiHandles[0];
+    FreePool (HiiHandles);
+  }
+
+  DEBUG ((DEBUG_INFO, "%a - %g HiiHandle=%p\n", __FUNCTION__, FormSetGuid, Formset->HiiHandle));
+  mHandlesValid = FALSE;
+  return Formset;
+}
+
+/**
+  Keeps the HII handles of the registered formsets current as forms packages are
+  added to and removed from the HII database.
+
+  @param[in]  PackageType   EFI_HII_PACKAGE_FORMS.
+  @param[in]  PackageGuid   Not used.
+  @param[in]  Package       The forms package.
+  @param[in]  Handle        Package list the forms package belongs to.
+  @param[in]  NotifyType    New, add or remove.
+
+  @retval EFI_SUCCESS   Always.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+FormsetRegistryPackageNotify (
+  IN UINT8                         PackageType,
+  IN CONST EFI_GUID                *PackageGuid,
+  IN CONST EFI_HII_PACKAGE_HEADER  *Package,
+  IN EFI_HII_HANDLE                Handle,
+  IN EFI_HII_DATABASE_NOTIFY_TYPE  NotifyType
+  )
+{
+  EFI_IFR_OP_HEADER  *OpCode;
+  UINT8              *End;
+  FP_FORMSET         *Formset;
+  UINTN              Index;
+
+  if (NotifyType == EFI_HII_DATABASE_NOTIFY_REMOVE_PACK) {
+    for (Index = 0; Index < mFormsetCount; Index++) {
+      if (mFormsets[Index].HiiHandle == Handle) {
+        mFormsets[Index].HiiHandle = NULL;
+        mHandlesValid              = FALSE;
+      }
+    }
+
+    return EFI_SUCCESS;
+  }
+
+  if (Package == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  OpCode = (EFI_IFR_OP_HEADER *)(Package + 1);
+  End    = (UINT8 *)Package + Package->Length;
+  while (((UINT8 *)OpCode + sizeof (EFI_IFR_OP_HEADER) <= End) && (OpCode->Length != 0)) {
+    if (OpCode->OpCode == EFI_IFR_FORM_SET_OP) {
+      Formset = FindFormset (&((EFI_IFR_FORM_SET *)OpCode)->Guid);
+      if ((Formset != NULL) && (Formset->HiiHandle != Handle)) {
+        Formset->HiiHandle = Handle;
+        mHandlesValid      = FALSE;
+      }
+    }
+
+    OpCode = (EFI_IFR_OP_HEADER *)((UINT8 *)OpCode + OpCode->Length);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Initializes the registry and registers for HII database notifications.
+
+  @retval EFI_SUCCESS   The registry is ready.
+  @retval Others        The HII database notifications could not be registered.
+
+**/
+EFI_STATUS
+FormsetRegistryInitialize (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = gHiiDatabase->RegisterPackageNotify (
+                           gHiiDatabase,
+                           EFI_HII_PACKAGE_FORMS,
+                           NULL,
+                           FormsetRegistryPackageNotify,
+                           EFI_HII_DATABASE_NOTIFY_NEW_PACK,
+                           &mNewPackNotify
+                           );
+  if (!EFI_ERROR (Status)) {
+    Status = gHiiDatabase->RegisterPackageNotify (
+                             gHiiDatabase,
+                             EFI_HII_PACKAGE_FORMS,
+                             NULL,
+                             FormsetRegistryPackageNotify,
+                             EFI_HII_DATABASE_NOTIFY_ADD_PACK,
+                             &mAddPackNotify
+                             );
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Status = gHiiDatabase->RegisterPackageNotify (
+                             gHiiDatabase,
+                             EFI_HII_PACKAGE_FORMS,
+                             NULL,
+                             FormsetRegistryPackageNotify,
+                             EFI_HII_DATABASE_NOTIFY_REMOVE_PACK,
+                             &mRemovePackNotify
+                             );
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - Unable to register HII package notifications. %r\n", __FUNCTION__, Status));
+    FormsetRegistryUninitialize ();
+  }
+
+  return Status;
+}
+
+/**
+  Unregisters the HII database notifications and frees the registry.
+
+**/
+VOID
+FormsetRegistryUninitialize (
+  VOID
+  )
+{
+  if (mNewPackNotify != NULL) {
+    gHiiDatabase->UnregisterPackageNotify (gHiiDatabase, mNewPackNotify);
+    mNewPackNotify = NULL;
+  }
+
+  if (mAddPackNotify != NULL) {
+    gHiiDatabase->UnregisterPackageNotify (gHiiDatabase, mAddPackNotify);
+    mAddPackNotify = NULL;
+  }
+
+  if (mRemovePackNotify != NULL) {
+    gHiiDatabase->UnregisterPackageNotify (gHiiDatabase, mRemovePackNotify);
+    mRemovePackNotify = NULL;
+  }
+
+  if (mFormsets != NULL) {
+    FreePool (mFormsets);
+    mFormsets = NULL;
+  }
+
+  if (mMenuEntries != NULL) {
+    FreePool (mMenuEntries);
+    mMenuEntries = NULL;
+  }
+
+  if (mHandles != NULL) {
+    FreePool (mHandles);
+    mHandles = NULL;
+  }
+
+  mFormsetCount      = 0;
+  mFormsetCapacity   = 0;
+  mMenuEntryCount    = 0;
+  mMenuEntryCapacity = 0;
+  mHandleCount       = 0;
+  mHandlesValid      = FALSE;
+}
+
+/**
+  Adds a top-level menu entry.  The formset of the entry is registered if it is not already.
+
+  @param[in]  FormSetGuid   Formset to display when the entry is selected.
+  @param[in]  FormId        Form within the formset.
+  @param[in]  StringHandle  Package list that contains MenuString.  NULL for the package list of the formset.
+  @param[in]  MenuString    Master Frame menu string.
+  @param[in]  Position      Sort key, see FRONT_PAGE_MENU_POSITION_*.
+  @param[in]  LimitedMenu   TRUE to show the entry in the limited menu as well as the full menu.
+
+  @retval EFI_SUCCESS           The entry was added.
+  @retval EFI_NOT_FOUND         StringHandle is NULL and the formset is not in the HII database.
+  @retval EFI_OUT_OF_RESOURCES  Unable to grow the registry.
+
+**/
+EFI_STATUS
+FormsetRegistryAddMenuEntry (
+  IN CONST EFI_GUID  *FormSetGuid,
+  IN EFI_FORM_ID     FormId,
+  IN EFI_HII_HANDLE  StringHandle  OPTIONAL,
+  IN EFI_STRING_ID   MenuString,
+  IN UINT16          Position,
+  IN BOOLEAN         LimitedMenu
+  )
+{
+  FP_FORMSET     *Formset;
+  FP_MENU_ENTRY  *Entry;
+  UINTN          Index;
+
+  Formset = RegisterFormset (FormSetGuid);
+  if (Formset == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  if (StringHandle == NULL) {
+    StringHandle = Formset->HiiHandle;
+    if (StringHandle == NULL) {
+      return EFI_NOT_FOUND;
+    }
+  }
+
+  if (EFI_ERROR (GrowArray ((VOID **)&mMenuEntries, mMenuEntryCount, &mMenuEntryCapacity, sizeof (FP_MENU_ENTRY)))) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  // Insert after any entries with the same Position so that ties keep registration order.
+  //
+  Index = mMenuEntryCount;
+  while ((Index > 0) && (mMenuEntries[Index - 1].Position > Position)) {
+    Index--;
+  }
+
+  CopyMem (&mMenuEntries[Index + 1], &mMenuEntries[Index], (mMenuEntryCount - Index) * sizeof (FP_MENU_ENTRY));
+  mMenuEntryCount++;
+
+  Entry = &mMenuEntries[Index];
+  CopyGuid (&Entry->FormSetGuid, FormSetGuid);
+  Entry->FormId       = FormId;
+  Entry->StringHandle = StringHandle;
+  Entry->MenuString   = MenuString;
+  Entry->Position     = Position;
+  Entry->LimitedMenu  = LimitedMenu;
+  Entry->Hidden       = FALSE;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Adds the menu entries other drivers published with FRONT_PAGE_MENU_ENTRY_PROTOCOL.
+
+**/
+VOID
+FormsetRegistryAddPublishedMenuEntries (
+  VOID
+  )
+{
+  EFI_STATUS                      Status;
+  EFI_HANDLE                      *HandleBuffer;
+  UINTN                           HandleCount;
+  UINTN                           Index;
+  FRONT_PAGE_MENU_ENTRY_PROTOCOL  *MenuEntry;
+
+  Status = gBS->LocateHandleBuffer (ByProtocol, &gMsFrontPageMenuEntryProtocolGuid, NULL, &HandleCount, &HandleBuffer);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  for (Index = 0; Index < HandleCount; Index++) {
+    Status = gBS->HandleProtocol (HandleBuffer[Index], &gMsFrontPageMenuEntryProtocolGuid, (VOID **)&MenuEntry);
+    if (EFI_ERROR (Status) || (MenuEntry->Revision < FRONT_PAGE_MENU_ENTRY_PROTOCOL_REVISION)) {
+      continue;
+    }
+
+    Status = FormsetRegistryAddMenuEntry (
+               &MenuEntry->FormSetGuid,
+               MenuEntry->FormId,
+               NULL,
+               MenuEntry->MenuString,
+               MenuEntry->Position,
+               MenuEntry->LimitedMenu
+               );
+    DEBUG ((DEBUG_INFO, "%a - %g Form %d: %r\n", __FUNCTION__, &MenuEntry->FormSetGuid, MenuEntry->FormId, Status));
+  }
+
+  FreePool (HandleBuffer);
+}
+
+/**
+  Hides every menu entry of a formset.
+
+  @param[in]  FormSetGuid   Formset whose entries are hidden.
+
+**/
+VOID
+FormsetRegistryHideMenuEntries (
+  IN CONST EFI_GUID  *FormSetGuid
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < mMenuEntryCount; Index++) {
+    if (CompareGuid (&mMenuEntries[Index].FormSetGuid, FormSetGuid)) {
+      mMenuEntries[Index].Hidden = TRUE;
+    }
+  }
+}
+
+/**
+  Returns whether an entry is shown in a menu.
+
+  @param[in]  Entry         Menu entry.
+  @param[in]  FullMenu      TRUE for the full menu, FALSE for the limited menu.
+
+**/
+STATIC
+BOOLEAN
+IsMenuEntryShown (
+  IN CONST FP_MENU_ENTRY  *Entry,
+  IN BOOLEAN              FullMenu
+  )
+{
+  return (BOOLEAN)(!Entry->Hidden && (FullMenu || Entry->LimitedMenu));
+}
+
+/**
+  Returns the number of entries shown in a menu.
+
+  @param[in]  FullMenu      TRUE for the full menu, FALSE for the limited menu.
+
+  @return     Number of entries.
+
+**/
+UINTN
+FormsetRegistryGetMenuCount (
+  IN BOOLEAN  FullMenu
+  )
+{
+  UINTN  Index;
+  UINTN  Count;
+
+  Count = 0;
+  for (Index = 0; Index < mMenuEntryCount; Index++) {
+    if (IsMenuEntryShown (&mMenuEntries[Index], FullMenu)) {
+      Count++;
+    }
+  }
+
+  return Count;
+}
+
+/**
+  Returns an entry of a menu.
+
+  @param[in]  MenuIndex     Index of the entry in the menu.
+  @param[in]  FullMenu      TRUE for the full menu, FALSE for the limited menu.
+
+  @return     The entry, or NULL if MenuIndex is past the end of the menu.
+
+**/
+CONST FP_MENU_ENTRY *
+FormsetRegistryGetMenuEntry (
+  IN UINTN    MenuIndex,
+  IN BOOLEAN  FullMenu
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < mMenuEntryCount; Index++) {
+    if (IsMenuEntryShown (&mMenuEntries[Index], FullMenu)) {
+      if (MenuIndex == 0) {
+        return &mMenuEntries[Index];
+      }
+
+      MenuIndex--;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Returns the HII handles of every registered formset that is in the HII database, for SendForm ().
+
+  The array is owned by the registry and is valid until the next call.
+
+  @param[out] Handles       Array of HII handles.
+  @param[out] HandleCount   Number of handles in the array.
+
+  @retval EFI_SUCCESS           Handles returned.
+  @retval EFI_OUT_OF_RESOURCES  Unable to allocate the array.
+
+**/
+EFI_STATUS
+FormsetRegistryGetHandles (
+  OUT EFI_HII_HANDLE  **Handles,
+  OUT UINTN           *HandleCount
+  )
+{
+  UINTN  Index;
+  UINTN  Search;
+
+  if (!mHandlesValid) {
+    if (mHandles != NULL) {
+      FreePool (mHandles);
+    }
+
+    mHandleCount = 0;
+    mHandles     = AllocatePool (MAX (mFormsetCount, 1) * sizeof (EFI_HII_HANDLE));
+    if (mHandles == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    // Registration order is kept, so FrontPage's own formset stays first.  A package list
+    // may hold more than one registered formset; it is passed to SendForm () once.
+    //
+    for (Index = 0; Index < mFormsetCount; Index++) {
+      if (mFormsets[Index].HiiHandle == NULL) {
+        continue;
+      }
+
+      for (Search = 0; Search < mHandleCount; Search++) {
+        if (mHandles[Search] == mFormsets[Index].HiiHandle) {
+          break;
+        }
+      }
+
+      if (Search == mHandleCount) {
+        mHandles[mHandleCount++] = mFormsets[Index].HiiHandle;
+      }
+    }
+
+    mHandlesValid = TRUE;
+    DEBUG ((DEBUG_INFO, "%a - %d formsets, %d handles\n", __FUNCTION__, mFormsetCount, mHandleCount));
+  }
+
+  *Handles     = mHandles;
+  *HandleCount = mHandleCount;
+  return EFI_SUCCESS;
+}
@@ -0,0 +1,140 @@
+/** @file
+  Registry of the formsets and top-level menu entries FrontPage displays.
+
+  HII handles are looked up once when a formset is registered and are then kept
+  current by HII database notifications, so selecting a menu entry does not scan
+  the HII database.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _FRONT_PAGE_FORMSET_REGISTRY_H_
+#define _FRONT_PAGE_FORMSET_REGISTRY_H_
+
+#include <Protocol/MsFrontPageMenuEntryProtocol.h>
+
+typedef struct {
+  EFI_GUID          FormSetGuid;      // Formset to display when the entry is selected.
+  EFI_FORM_ID       FormId;           // Form within the formset.
+  EFI_HII_HANDLE    StringHandle;     // Package list that contains MenuString.
+  EFI_STRING_ID     MenuString;       // Master Frame menu string.
+  UINT16            Position;         // Sort key, see FRONT_PAGE_MENU_POSITION_*.
+  BOOLEAN           LimitedMenu;      // Shown in the limited menu as well as the full menu.
+  BOOLEAN           Hidden;           // Not shown in either menu.
+} FP_MENU_ENTRY;
+
+/**
+  Initializes the registry and registers for HII database notifications.
+
+  @retval EFI_SUCCESS   The registry is ready.
+  @retval Others        The HII database notifications could not be registered.
+
+**/
+EFI_STATUS
+FormsetRegistryInitialize (
+  VOID
+  );
+
+/**
+  Unregisters the HII database notifications and frees the registry.
+
+**/
+VOID
+FormsetRegistryUninitialize (
+  VOID
+  );
+
+/**
+  Adds a top-level menu entry.  The formset of the entry is registered if it is not already.
+
+  @param[in]  FormSetGuid   Formset to display when the entry is selected.
+  @param[in]  FormId        Form within the formset.
+  @param[in]  StringHandle  Package list that contains MenuString.  NULL for the package list of the formset.
+  @param[in]  MenuString    Master Frame menu string.
+  @param[in]  Position      Sort key, see FRONT_PAGE_MENU_POSITION_*.
+  @param[in]  LimitedMenu   TRUE to show the entry in the limited menu as well as the full menu.
+
+  @retval EFI_SUCCESS           The entry was added.
+  @retval EFI_NOT_FOUND         StringHandle is NULL and the formset is not in the HII database.
+  @retval EFI_OUT_OF_RESOURCES  Unable to grow the registry.
+
+**/
+EFI_STATUS
+FormsetRegistryAddMenuEntry (
+  IN CONST EFI_GUID  *FormSetGuid,
+  IN EFI_FORM_ID     FormId,
+  IN EFI_HII_HANDLE  StringHandle  OPTIONAL,
+  IN EFI_STRING_ID   MenuString,
+  IN UINT16          Position,
+  IN BOOLEAN         LimitedMenu
+  );
+
+/**
+  Adds the menu entries other drivers published with FRONT_PAGE_MENU_ENTRY_PROTOCOL.
+
+**/
+VOID
+FormsetRegistryAddPublishedMenuEntries (
+  VOID
+  );
+
+/**
+  Hides every menu entry of a formset.
+
+  @param[in]  FormSetGuid   Formset whose entries are hidden.
+
+**/
+VOID
+FormsetRegistryHideMenuEntries (
+  IN CONST EFI_GUID  *FormSetGuid
+  );
+
+/**
+  Returns the number of entries shown in a menu.
+
+  @param[in]  FullMenu      TRUE for the full menu, FALSE for the limited menu.
+
+  @return     Number of entries.
+
+**/
+UINTN
+FormsetRegistryGetMenuCount (
+  IN BOOLEAN  FullMenu
+  );
+
+/**
+  Returns an entry of a menu.
+
+  @param[in]  MenuIndex     Index of the entry in the menu.
+  @param[in]  FullMenu      TRUE for the full menu, FALSE for the limited menu.
+
+  @return     The entry, or NULL if MenuIndex is past the end of the menu.
+
+**/
+CONST FP_MENU_ENTRY *
+FormsetRegistryGetMenuEntry (
+  IN UINTN    MenuIndex,
+  IN BOOLEAN  FullMenu
+  );
+
+/**
+  Returns the HII handles of every registered formset that is in the HII database, for SendForm ().
+
+  The array is owned by the registry and is valid until the next call.
+
+  @param[out] Handles       Array of HII handles.
+  @param[out] HandleCount   Number of handles in the array.
+
+  @retval EFI_SUCCESS           Handles returned.
+  @retval EFI_OUT_OF_RESOURCES  Unable to allocate the array.
+
+**/
+EFI_STATUS
+FormsetRegistryGetHandles (
+  OUT EFI_HII_HANDLE  **Handles,
+  OUT UINTN           *HandleCount
+  );
+
+#endif // _FRONT_PAGE_FORMSET_REGISTRY_H_
@@ -0,0 +1,214 @@
+/** @file
+  Busy indicator for long FrontPage operations.
+
+  The bar is filled straight to the screen with GOP along the bottom of the titlebar, because
+  the password challenge runs before the titlebar is first rendered.  Hiding the bar fills its
+  rows with the titlebar background, then pushes the titlebar surface again if it is already on
+  the screen, so nothing under the bar is lost.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MsColorTableLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+#include "FrontPageCompositor.h"
+#include "FrontPageProgress.h"
+
+#define FP_PROGRESS_BAR_HEIGHT_PERCENT  6                                      // Bar height, as a percentage of the titlebar height.
+#define FP_PROGRESS_BAR_MIN_HEIGHT      2                                      // Pixels.
+#define FP_PROGRESS_SWEEP_PERIOD        EFI_TIMER_PERIOD_MILLISECONDS (33)     // Sweep animation frame period.
+#define FP_PROGRESS_SWEEP_STEPS         48                                     // Frames for one pass across the screen.
+
+extern EFI_GRAPHICS_OUTPUT_PROTOCOL  *mGop;
+extern UINT32                        mTitleBarWidth, mTitleBarHeight;
+extern FP_SURFACE                    *mTitleBarSurface;
+
+STATIC EFI_EVENT  mSweepEvent = NULL;
+STATIC UINTN      mSweepStep  = 0;
+STATIC BOOLEAN    mBarShown   = FALSE;
+
+/**
+  Returns the height of the bar in pixels.
+
+**/
+STATIC
+UINT32
+GetBarHeight (
+  VOID
+  )
+{
+  return MIN (MAX ((mTitleBarHeight * FP_PROGRESS_BAR_HEIGHT_PERCENT) / 100, FP_PROGRESS_BAR_MIN_HEIGHT), mTitleBarHeight);
+}
+
+/**
+  Draws the bar with one filled span.
+
+  @param[in]  FilledX       Start of the filled span.
+  @param[in]  FilledWidth   Width of the filled span.  May be 0.
+
+**/
+STATIC
+VOID
+DrawBar (
+  IN UINT32  FilledX,
+  IN UINT32  FilledWidth
+  )
+{
+  UINT32  BarHeight;
+  UINT32  BarY;
+
+  if ((mGop == NULL) || (mTitleBarWidth == 0) || (mTitleBarHeight == 0)) {
+    return;
+  }
+
+  BarHeight = GetBarHeight ();
+  BarY      = mTitleBarHeight - BarHeight;
+
+  if (FilledX > 0) {
+    mGop->Blt (mGop, &gMsColorTable.TitleBarBackgroundColor, EfiBltVideoFill, 0, 0, 0, BarY, FilledX, BarHeight, 0);
+  }
+
+  if (FilledWidth > 0) {
+    mGop->Blt (mGop, &gMsColorTable.TitleBarTextColor, EfiBltVideoFill, 0, 0, FilledX, BarY, FilledWidth, BarHeight, 0);
+  }
+
+  if (FilledX + FilledWidth < mTitleBarWidth) {
+    mGop->Blt (
+            mGop,
+            &gMsColorTable.TitleBarBackgroundColor,
+            EfiBltVideoFill,
+            0,
+            0,
+            FilledX + FilledWidth,
+            BarY,
+            mTitleBarWidth - (FilledX + FilledWidth),
+            BarHeight,
+            0
+            );
+  }
+
+  mBarShown = TRUE;
+}
+
+/**
+  Timer callback that moves the sweeping segment one step.
+
+  @param[in]  Event     The sweep timer event.
+  @param[in]  Context   Not used.
+
+**/
+STATIC
+VOID
+EFIAPI
+SweepTimerCallback (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  UINT32  SegmentWidth;
+  UINT32  Travel;
+  UINT32  Lead;
+  UINT32  Start;
+
+  // The leading edge travels from 0 to the full width plus the segment, so the segment enters
+  // from the left and leaves on the right.
+  //
+  SegmentWidth = mTitleBarWidth / 4;
+  Travel       = mTitleBarWidth + SegmentWidth;
+  Lead         = (UINT32)((Travel * mSweepStep) / FP_PROGRESS_SWEEP_STEPS);
+  Start        = MIN ((Lead > SegmentWidth) ? (Lead - SegmentWidth) : 0, mTitleBarWidth);
+
+  DrawBar (Start, MIN (Lead, mTitleBarWidth) - Start);
+
+  mSweepStep = (mSweepStep + 1) % (FP_PROGRESS_SWEEP_STEPS + 1);
+}
+
+/**
+  Shows the busy indicator filled to a percentage.
+
+  @param[in]  Percent     Percentage complete, 0 to 100.
+
+**/
+VOID
+FpProgressShow (
+  IN UINTN  Percent
+  )
+{
+  DrawBar (0, (UINT32)((mTitleBarWidth * MIN (Percent, 100)) / 100));
+}
+
+/**
+  Starts the sweeping busy indicator, for operations that don't report progress.  It keeps
+  moving until FpProgressHide () is called, as long as the caller runs below TPL_CALLBACK.
+
+  @retval  EFI_SUCCESS    The indicator is running.
+  @retval  Others         The timer event could not be created.
+
+**/
+EFI_STATUS
+FpProgressStartSweep (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+
+  if (mSweepEvent != NULL) {
+    return EFI_SUCCESS;
+  }
+
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  SweepTimerCallback,
+                  NULL,
+                  &mSweepEvent
+                  );
+  if (!EFI_ERROR (Status)) {
+    mSweepStep = 0;
+    Status     = gBS->SetTimer (mSweepEvent, TimerPeriodic, FP_PROGRESS_SWEEP_PERIOD);
+    if (EFI_ERROR (Status)) {
+      gBS->CloseEvent (mSweepEvent);
+      mSweepEvent = NULL;
+    }
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - Unable to start the busy indicator. %r\n", __FUNCTION__, Status));
+  }
+
+  return Status;
+}
+
+/**
+  Stops and removes the busy indicator.
+
+**/
+VOID
+FpProgressHide (
+  VOID
+  )
+{
+  if (mSweepEvent != NULL) {
+    gBS->CloseEvent (mSweepEvent);
+    mSweepEvent = NULL;
+  }
+
+  if (!mBarShown) {
+    return;
+  }
+
+  DrawBar (0, 0);
+  mBarShown = FALSE;
+
+  if ((mTitleBarSurface != NULL) && mTitleBarSurface->FrontValid) {
+    FpSurfaceInvalidate (mTitleBarSurface);
+    FpSurfaceFlush (mTitleBarSurface);
+  }
+}
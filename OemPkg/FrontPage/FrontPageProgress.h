@@ -0,0 +1,49 @@
+/** @file
+  Busy indicator for long FrontPage operations, such as hashing a password.
+
+  The indicator is a thin bar along the bottom edge of the titlebar.  It shows a percentage
+  when the operation reports progress, and otherwise a segment that sweeps across it from a
+  periodic timer event, so it keeps moving while the BSP is busy.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _FRONT_PAGE_PROGRESS_H_
+#define _FRONT_PAGE_PROGRESS_H_
+
+/**
+  Shows the busy indicator filled to a percentage.
+
+  @param[in]  Percent     Percentage complete, 0 to 100.
+
+**/
+VOID
+FpProgressShow (
+  IN UINTN  Percent
+  );
+
+/**
+  Starts the sweeping busy indicator, for operations that don't report progress.  It keeps
+  moving until FpProgressHide () is called, as long as the caller runs below TPL_CALLBACK.
+
+  @retval  EFI_SUCCESS    The indicator is running.
+  @retval  Others         The timer event could not be created.
+
+**/
+EFI_STATUS
+FpProgressStartSweep (
+  VOID
+  );
+
+/**
+  Stops and removes the busy indicator.
+
+**/
+VOID
+FpProgressHide (
+  VOID
+  );
+
+#endif // _FRONT_PAGE_PROGRESS_H_
@@ -0,0 +1,221 @@
+/** @file
+  FrontPage startup phase timing.
+
+  Phases are timed with the performance counter.  Each phase keeps the start of its
+  first run and the total of all its runs, so a phase that runs again later (for
+  example the firmware version list after a deferred connect) is still one entry.
+
+  The password prompt and the alert dialogs wait for the user.  Their time is taken
+  out of every phase they run inside, so the first paint time does not depend on how
+  long the user takes to type.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/PerformanceLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+
+#include "FrontPageTiming.h"
+
+//
+// Performance record strings, indexed by FRONT_PAGE_TIMING_PHASE.
+//
+STATIC CONST CHAR8  *mPhaseNames[FpPhaseMax] = {
+  "FpFirstPaint",
+  "FpConnectConsoles",
+  "FpConnectAll",
+  "FpSetGraphicsConsoleMode",
+  "FpInitializeUIToolKit",
+  "FpInitializeFrontPage",
+  "FpSmbiosStrings",
+  "FpFirmwareVersions",
+  "FpSecureBootStatus",
+  "FpPasswordChallenge",
+  "FpUserAlerts"
+};
+
+STATIC UINT64                    mEntryTicks;
+STATIC UINT64                    mPhaseStartTicks[FpPhaseMax];
+STATIC UINT64                    mUserWaitUs;                        // Total time spent waiting for the user.
+STATIC UINT64                    mPhaseStartUserWaitUs[FpPhaseMax];  // mUserWaitUs when each phase began.
+STATIC FRONT_PAGE_TIMING_RECORD  mTimingRecord;
+
+/**
+  Converts an elapsed performance counter delta into microseconds.
+
+  @param[in]  StartTicks    Performance counter value at the start of the interval.
+  @param[in]  EndTicks      Performance counter value at the end of the interval.
+
+  @retval     Elapsed time in microseconds.
+
+**/
+UINT64
+ElapsedMicroseconds (
+  IN UINT64  StartTicks,
+  IN UINT64  EndTicks
+  )
+{
+  UINT64  CounterStart;
+  UINT64  CounterEnd;
+
+  GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+
+  // Handle counters that count down.
+  //
+  if (CounterStart > CounterEnd) {
+    return DivU64x32 (GetTimeInNanoSecond (StartTicks - EndTicks), 1000);
+  }
+
+  return DivU64x32 (GetTimeInNanoSecond (EndTicks - StartTicks), 1000);
+}
+
+/**
+  Determines whether a phase waits for user input.
+
+  @param[in]  Phase     The phase.
+
+  @retval     TRUE if the phase waits for the user.
+
+**/
+STATIC
+BOOLEAN
+IsUserWaitPhase (
+  IN FRONT_PAGE_TIMING_PHASE  Phase
+  )
+{
+  return (BOOLEAN)((Phase == FpPhasePasswordChallenge) || (Phase == FpPhaseUserAlerts));
+}
+
+/**
+  Records UefiMain entry.  Phase start times are relative to it.
+
+**/
+VOID
+FpTimingStart (
+  VOID
+  )
+{
+  UINTN  Phase;
+
+  mEntryTicks = GetPerformanceCounter ();
+  mUserWaitUs = 0;
+
+  ZeroMem (&mTimingRecord, sizeof (mTimingRecord));
+  mTimingRecord.Signature  = FRONT_PAGE_TIMING_SIGNATURE;
+  mTimingRecord.Version    = FRONT_PAGE_TIMING_VERSION;
+  mTimingRecord.EntryCount = FpPhaseMax;
+  mTimingRecord.EntryUs    = DivU64x32 (GetTimeInNanoSecond (mEntryTicks), 1000);
+  for (Phase = 0; Phase < FpPhaseMax; Phase++) {
+    mTimingRecord.Entries[Phase].Phase = (UINT32)Phase;
+  }
+}
+
+/**
+  Marks the start of a phase.
+
+  @param[in]  Phase     The phase.
+
+**/
+VOID
+FpTimingBegin (
+  IN FRONT_PAGE_TIMING_PHASE  Phase
+  )
+{
+  ASSERT (Phase < FpPhaseMax);
+  if (Phase >= FpPhaseMax) {
+    return;
+  }
+
+  PERF_INMODULE_BEGIN (mPhaseNames[Phase]);
+  mPhaseStartTicks[Phase]      = GetPerformanceCounter ();
+  mPhaseStartUserWaitUs[Phase] = mUserWaitUs;
+
+  if (mTimingRecord.Entries[Phase].Count == 0) {
+    mTimingRecord.Entries[Phase].StartUs = ElapsedMicroseconds (mEntryTicks, mPhaseStartTicks[Phase]);
+  }
+}
+
+/**
+  Marks the end of a phase and adds its duration, less any user wait inside it, to the phase total.
+
+  @param[in]  Phase     The phase.
+
+**/
+VOID
+FpTimingEnd (
+  IN FRONT_PAGE_TIMING_PHASE  Phase
+  )
+{
+  UINT64  DurationUs;
+
+  ASSERT (Phase < FpPhaseMax);
+  if (Phase >= FpPhaseMax) {
+    return;
+  }
+
+  DurationUs = ElapsedMicroseconds (mPhaseStartTicks[Phase], GetPerformanceCounter ());
+  PERF_INMODULE_END (mPhaseNames[Phase]);
+
+  if (IsUserWaitPhase (Phase)) {
+    mUserWaitUs += DurationUs;
+  } else {
+    DurationUs -= MIN (DurationUs, mUserWaitUs - mPhaseStartUserWaitUs[Phase]);
+  }
+
+  mTimingRecord.Entries[Phase].Count++;
+  mTimingRecord.Entries[Phase].DurationUs += DurationUs;
+
+  DEBUG ((DEBUG_INFO, "INFO [FP]: %a took %ld us.\n", mPhaseNames[Phase], DurationUs));
+}
+
+/**
+  Returns the total recorded for a phase.
+
+  @param[in]  Phase     The phase.
+
+  @retval     Total of all runs of the phase in microseconds, less user wait time.
+
+**/
+UINT64
+FpTimingGetDurationUs (
+  IN FRONT_PAGE_TIMING_PHASE  Phase
+  )
+{
+  ASSERT (Phase < FpPhaseMax);
+  if (Phase >= FpPhaseMax) {
+    return 0;
+  }
+
+  return mTimingRecord.Entries[Phase].DurationUs;
+}
+
+/**
+  Publishes the phase timings in the FrontPageTiming variable.
+
+**/
+VOID
+FpTimingPublish (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = gRT->SetVariable (
+                  FRONT_PAGE_TIMING_VARIABLE_NAME,
+                  &gOemFrontPageTimingGuid,
+                  FRONT_PAGE_TIMING_VARIABLE_ATTRS,
+                  sizeof (mTimingRecord),
+                  &mTimingRecord
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - Failed to publish FrontPage timing. %r\n", __FUNCTION__, Status));
+  }
+}
@@ -0,0 +1,86 @@
+/** @file
+  FrontPage startup phase timing.
+
+  Each phase is bracketed with FpTimingBegin () and FpTimingEnd ().  The phases are logged as
+  in-module performance records, so they appear in the FPDT when the platform has performance
+  measurement enabled, and are published in the FrontPageTiming variable.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _FRONT_PAGE_TIMING_H_
+#define _FRONT_PAGE_TIMING_H_
+
+#include <Guid/FrontPageTiming.h>
+
+/**
+  Converts an elapsed performance counter delta into microseconds.
+
+  @param[in]  StartTicks    Performance counter value at the start of the interval.
+  @param[in]  EndTicks      Performance counter value at the end of the interval.
+
+  @retval     Elapsed time in microseconds.
+
+**/
+UINT64
+ElapsedMicroseconds (
+  IN UINT64  StartTicks,
+  IN UINT64  EndTicks
+  );
+
+/**
+  Records UefiMain entry.  Phase start times are relative to it.
+
+**/
+VOID
+FpTimingStart (
+  VOID
+  );
+
+/**
+  Marks the start of a phase.
+
+  @param[in]  Phase     The phase.
+
+**/
+VOID
+FpTimingBegin (
+  IN FRONT_PAGE_TIMING_PHASE  Phase
+  );
+
+/**
+  Marks the end of a phase and adds its duration, less any user wait inside it, to the phase total.
+
+  @param[in]  Phase     The phase.
+
+**/
+VOID
+FpTimingEnd (
+  IN FRONT_PAGE_TIMING_PHASE  Phase
+  );
+
+/**
+  Returns the total recorded for a phase.
+
+  @param[in]  Phase     The phase.
+
+  @retval     Total of all runs of the phase in microseconds, less user wait time.
+
+**/
+UINT64
+FpTimingGetDurationUs (
+  IN FRONT_PAGE_TIMING_PHASE  Phase
+  );
+
+/**
+  Publishes the phase timings in the FrontPageTiming variable.
+
+**/
+VOID
+FpTimingPublish (
+  VOID
+  );
+
+#endif // _FRONT_PAGE_TIMING_H_
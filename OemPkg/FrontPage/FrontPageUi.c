@@ -7,7 +7,9 @@
 **/
 
 #include "FrontPage.h"
+#include "FrontPageProgress.h"
 #include "FrontPageUi.h"
+#include "String.h"
 
 #include <PiDxe.h>          // This has to be here so Protocol/FirmwareVolume2.h doesn't puke errors.
 #include <UefiSecureBoot.h>
@@ -42,6 +44,7 @@
 #include <Library/MuSecureBootKeySelectorLib.h>
 #include <Library/SecureBootKeyStoreLib.h>
 #include <Library/PasswordPolicyLib.h>
+#include <Library/PasswordStoreSessionLib.h>
 
 #include <Settings/DfciSettings.h>
 #include <Settings/FrontPageSettings.h>
@@ -50,10 +53,13 @@ extern EFI_HII_HANDLE                  gStringPackHandle;
 extern BOOLEAN                         mResetRequired;
 extern DFCI_SETTING_ACCESS_PROTOCOL    *mSettingAccess;
 extern UINTN                           mAuthToken;
+extern PASSWORD_STORE_SESSION_TOKEN    mPasswordSession;
 extern EDKII_VARIABLE_POLICY_PROTOCOL  *mVariablePolicyProtocol;
 extern SECURE_BOOT_PAYLOAD_INFO        *mSecureBootKeys;
 extern UINT8                           mSecureBootKeysCount;
 
+#define FP_PASSWORD_HASH_POLL_US  1000      // Wait between checks on a password hash running on an AP.
+
 STATIC
 EFI_STATUS
 SetSystemPassword (
@@ -299,6 +305,73 @@ UiCallback (
   return Status;
 }
 
+/**
+  Hashes a new password in the background while the busy indicator shows the progress.
+  Input is read while the hash runs, and Escape cancels it.
+
+  @param[in]  Password            The new password.
+  @param[out] PasswordHash        The password hash.  Caller must free it.
+  @param[out] PasswordHashSize    Size of the password hash.
+  @param[out] Cancelled           TRUE if the user cancelled the hash.
+
+  @retval  EFI_SUCCESS    The password hash was returned.
+  @retval  EFI_ABORTED    The user cancelled the hash.
+  @retval  Others         The hash could not be generated.
+
+**/
+STATIC
+EFI_STATUS
+GeneratePasswordHashWithProgress (
+  IN  CONST CHAR16   *Password,
+  OUT PASSWORD_HASH  *PasswordHash,
+  OUT UINTN          *PasswordHashSize,
+  OUT BOOLEAN        *Cancelled
+  )
+{
+  EFI_STATUS          Status;
+  PASSWORD_HASH_TASK  *Task;
+  EFI_INPUT_KEY       Key;
+  UINTN               Percent;
+  UINTN               ShownPercent;
+
+  *Cancelled = FALSE;
+
+  Status = PasswordPolicyStartPasswordHash (NULL, Password, &Task);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  ShownPercent = MAX_UINTN;
+  do {
+    Status = PasswordPolicyPollPasswordHash (Task, &Percent);
+    if (Percent != ShownPercent) {
+      FpProgressShow (Percent);
+      ShownPercent = Percent;
+    }
+
+    // Drain the keyboard, so keys pressed while hashing don't act on the form afterwards.
+    //
+    while (!EFI_ERROR (gST->ConIn->ReadKeyStroke (gST->ConIn, &Key))) {
+      if (Key.ScanCode == SCAN_ESC) {
+        *Cancelled = TRUE;
+      }
+    }
+
+    if (*Cancelled) {
+      DEBUG ((DEBUG_INFO, "INFO: [FP] %a: Cancelled by the user.\r\n", __FUNCTION__));
+      break;
+    }
+
+    if (Status == EFI_NOT_READY) {
+      gBS->Stall (FP_PASSWORD_HASH_POLL_US);
+    }
+  } while (Status == EFI_NOT_READY);
+
+  FpProgressHide ();
+
+  return PasswordPolicyFinishPasswordHash (Task, (*Cancelled ? NULL : PasswordHash), PasswordHashSize);
+}
+
 STATIC
 EFI_STATUS
 SetSystemPassword (
@@ -309,10 +382,11 @@ SetSystemPassword (
   EFI_STATUS          Status          = EFI_SUCCESS;
   SWM_MB_RESULT       Result          = 0;
   PW_TEST_BITMAP      PwdValidBitmap  = 0;
-  CHAR16              *pErrorMessage  = (CHAR16 *)HiiGetString (gStringPackHandle, STRING_TOKEN (STR_NULL_STRING), NULL);
+  CHAR16              *pErrorMessage  = GetCachedString (gStringPackHandle, STRING_TOKEN (STR_NULL_STRING));
   CHAR16              *PasswordBuffer = NULL;  // This will be allocated by PasswordDialog(). Needs to be tracked, wiped, and freed.
   PASSWORD_HASH       PasswordHash;
   UINTN               PasswordHashSize;
+  BOOLEAN             Cancelled;
   DFCI_SETTING_FLAGS  Flags = 0;
 
   DEBUG ((DEBUG_INFO, "INFO: [FP] SetSystemPassword: ENTER\r\n"));
@@ -321,9 +395,9 @@ SetSystemPassword (
   //
   do {
     Status = SwmDialogsPasswordPrompt (
-               HiiGetString (gStringPackHandle, STRING_TOKEN (STR_PWD_ENTER_PWD_TITLEBARTEXT), NULL),                               // Dialog titlebar text.
-               HiiGetString (gStringPackHandle, STRING_TOKEN (STR_PWD_CAPTION), NULL),                                              // Dialog caption text.
-               HiiGetString (gStringPackHandle, STRING_TOKEN (STR_PWD_SET_BODYTEXT), NULL),                                         // Dialog body text.
+               GetCachedString (gStringPackHandle, STRING_TOKEN (STR_PWD_ENTER_PWD_TITLEBARTEXT)),                               // Dialog titlebar text.
+               GetCachedString (gStringPackHandle, STRING_TOKEN (STR_PWD_CAPTION)),                                              // Dialog caption text.
+               GetCachedString (gStringPackHandle, STRING_TOKEN (STR_PWD_SET_BODYTEXT)),                                         // Dialog body text.
                pErrorMessage,
                SWM_PWD_TYPE_SET_PASSWORD,
                &Result,
@@ -347,19 +421,35 @@ SetSystemPassword (
         if (PwdValidBitmap & PW_TEST_STRING_TOO_SHORT) {
           // Password is too short.
           //
-          pErrorMessage = (CHAR16 *)HiiGetString (gStringPackHandle, STRING_TOKEN (STR_PWD_ERRORMSG_TOOSHORT), NULL);
+          pErrorMessage = GetCachedString (gStringPackHandle, STRING_TOKEN (STR_PWD_ERRORMSG_TOOSHORT));
         } else if (PwdValidBitmap & PW_TEST_STRING_TOO_LONG) {
           // Password is too long.
           //
-          pErrorMessage = (CHAR16 *)HiiGetString (gStringPackHandle, STRING_TOKEN (STR_PWD_ERRORMSG_TOOLONG), NULL);
+          pErrorMessage = GetCachedString (gStringPackHandle, STRING_TOKEN (STR_PWD_ERRORMSG_TOOLONG));
         } else if (PwdValidBitmap & PW_TEST_STRING_INVALID_CHAR) {
           // Password contains invalid characters.
           //
-          pErrorMessage = (CHAR16 *)HiiGetString (gStringPackHandle, STRING_TOKEN (STR_PWD_ERRORMSG_INVALID_CHAR), NULL);
+          pErrorMessage = GetCachedString (gStringPackHandle, STRING_TOKEN (STR_PWD_ERRORMSG_INVALID_CHAR));
+        } else if (PwdValidBitmap & PW_TEST_STRING_TOO_FEW_CLASSES) {
+          // Password doesn't mix enough kinds of characters.
+          //
+          pErrorMessage = GetCachedString (gStringPackHandle, STRING_TOKEN (STR_PWD_ERRORMSG_FEW_CLASSES));
+        } else if (PwdValidBitmap & PW_TEST_STRING_REPEATED_CHAR) {
+          // Password repeats a character too often.
+          //
+          pErrorMessage = GetCachedString (gStringPackHandle, STRING_TOKEN (STR_PWD_ERRORMSG_REPEATED_CHAR));
+        } else if (PwdValidBitmap & PW_TEST_STRING_SEQUENCE) {
+          // Password contains a run like abcd.
+          //
+          pErrorMessage = GetCachedString (gStringPackHandle, STRING_TOKEN (STR_PWD_ERRORMSG_SEQUENCE));
+        } else if (PwdValidBitmap & PW_TEST_STRING_BANNED) {
+          // Password is in the banned password list.
+          //
+          pErrorMessage = GetCachedString (gStringPackHandle, STRING_TOKEN (STR_PWD_ERRORMSG_BANNED));
         } else {
           // Some other (non-specific) failure.
           //
-          pErrorMessage = (CHAR16 *)HiiGetString (gStringPackHandle, STRING_TOKEN (STR_PWD_ERRORMSG_SET_GENFAILURE), NULL);
+          pErrorMessage = GetCachedString (gStringPackHandle, STRING_TOKEN (STR_PWD_ERRORMSG_SET_GENFAILURE));
         }
 
         // If password buffer was used, make sure it's freed.
@@ -375,8 +465,13 @@ SetSystemPassword (
 
       //
       // Otherwise, try setting the password.  If it fails, free the password buffer and try again.
+      // Cancelling the hash is the same as cancelling the dialog.
       //
-      Status = PasswordPolicyGeneratePasswordHash (NULL, PasswordBuffer, &PasswordHash, &PasswordHashSize);
+      Status = GeneratePasswordHashWithProgress (PasswordBuffer, &PasswordHash, &PasswordHashSize, &Cancelled);
+      if (Cancelled) {
+        Status = EFI_SUCCESS;
+        break;
+      }
 
       if (!EFI_ERROR (Status)) {
         Status = mSettingAccess->Set (
@@ -397,11 +492,11 @@ SetSystemPassword (
         if (EFI_SECURITY_VIOLATION == Status) {
           // Password authentication error.
           //
-          pErrorMessage = (CHAR16 *)HiiGetString (gStringPackHandle, STRING_TOKEN (STR_PWD_ERRORMSG_AUTHERROR), NULL);
+          pErrorMessage = GetCachedString (gStringPackHandle, STRING_TOKEN (STR_PWD_ERRORMSG_AUTHERROR));
         } else {
           // Some other (non-specific) failure.
           //
-          pErrorMessage = (CHAR16 *)HiiGetString (gStringPackHandle, STRING_TOKEN (STR_PWD_ERRORMSG_SET_GENFAILURE), NULL);
+          pErrorMessage = GetCachedString (gStringPackHandle, STRING_TOKEN (STR_PWD_ERRORMSG_SET_GENFAILURE));
         }
 
         // If password buffer was used, make sure it's freed.
@@ -472,9 +567,9 @@ HandleInfoPopup (
   //
   // Next, attempt to load the string.
   if (!EFI_ERROR (Status)) {
-    TitleBarText = (CHAR16 *)HiiGetString (mFrontPagePrivate.HiiHandle, TitleId, NULL);
-    CaptionText  = (CHAR16 *)HiiGetString (mFrontPagePrivate.HiiHandle, CaptionId, NULL);
-    InfoMessage  = (CHAR16 *)HiiGetString (mFrontPagePrivate.HiiHandle, MessageId, NULL);
+    TitleBarText = GetCachedString (mFrontPagePrivate.HiiHandle, TitleId);
+    CaptionText  = GetCachedString (mFrontPagePrivate.HiiHandle, CaptionId);
+    InfoMessage  = GetCachedString (mFrontPagePrivate.HiiHandle, MessageId);
     if ((NULL == InfoMessage) || (NULL == TitleBarText)) {
       Status = EFI_NOT_FOUND;
     }
@@ -522,9 +617,9 @@ HandleSecureBootChange (
 
   //
   // Load UI dialog strings.
-  DialogTitleBarText = (CHAR16 *)HiiGetString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_SB_CONFIG_TITLEBARTEXT), NULL);
-  DialogCaptionText  = (CHAR16 *)HiiGetString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_SB_CONFIG_CAPTION), NULL);
-  DialogBodyText     = (CHAR16 *)HiiGetString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_SB_CONFIG_BODY), NULL);
+  DialogTitleBarText = GetCachedString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_SB_CONFIG_TITLEBARTEXT));
+  DialogCaptionText  = GetCachedString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_SB_CONFIG_CAPTION));
+  DialogBodyText     = GetCachedString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_SB_CONFIG_BODY));
 
   OptionsCount = mSecureBootKeysCount + 1;
   Options      = AllocatePool (OptionsCount * sizeof (CHAR16 *));
@@ -538,7 +633,7 @@ HandleSecureBootChange (
     Options[Index] = (CHAR16 *)mSecureBootKeys[Index].SecureBootKeyName;
   }
 
-  Options[mSecureBootKeysCount] = (CHAR16 *)HiiGetString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_GENERIC_TEXT_NONE), NULL);
+  Options[mSecureBootKeysCount] = GetCachedString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_GENERIC_TEXT_NONE));
 
   //
   // Display the dialog to the user.
@@ -587,8 +682,8 @@ HandleSecureBootChange (
       UpdateSecureBootStatusStrings (TRUE);
     } else {
       DEBUG ((DEBUG_ERROR, "ERROR [SFP] %a - Failed to update SecureBoot config! %r\n", __FUNCTION__, Status));
-      DialogTitleBarText = (CHAR16 *)HiiGetString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_SB_UPDATE_FAILURE_TITLE), NULL);
-      DialogBodyText     = (CHAR16 *)HiiGetString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_SB_UPDATE_FAILURE), NULL);
+      DialogTitleBarText = GetCachedString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_SB_UPDATE_FAILURE_TITLE));
+      DialogBodyText     = GetCachedString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_SB_UPDATE_FAILURE));
       SwmDialogsMessageBox (
         DialogTitleBarText,                            // Dialog title bar text.
         DialogBodyText,                                // Dialog body text.
@@ -632,7 +727,7 @@ UpdateSecureBootStatusStrings (
 
   //
   // No matter what the mode is, we need the preamble.
-  PreambleSubstring = (CHAR16 *)HiiGetString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_SEC_SB_STATE_PREAMBLE), NULL);
+  PreambleSubstring = GetCachedString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_SEC_SB_STATE_PREAMBLE));
 
   //
   // Determine whether SecureBoot is enabled.
@@ -642,15 +737,15 @@ UpdateSecureBootStatusStrings (
   // If enabled, determine the current config.
   if (IsEnabled) {
     // Use the "Enabled" substring.
-    StateSubstring  = (CHAR16 *)HiiGetString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_SEC_SB_STATE_ENABLED), NULL);
-    SuffixSubstring = (CHAR16 *)HiiGetString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_SEC_SB_KEY_CONFIG_TEXT), NULL);
+    StateSubstring  = GetCachedString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_SEC_SB_STATE_ENABLED));
+    SuffixSubstring = GetCachedString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_SEC_SB_KEY_CONFIG_TEXT));
 
     // Determine the ConfigSubstring.
     CurrentConfig = GetCurrentSecureBootConfig ();
     if (MU_SB_CONFIG_NONE == CurrentConfig) {
-      ConfigSubstring = (CHAR16 *)HiiGetString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_GENERIC_TEXT_NONE), NULL);
+      ConfigSubstring = GetCachedString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_GENERIC_TEXT_NONE));
     } else if (mSecureBootKeysCount <= CurrentConfig) {
-      ConfigSubstring = (CHAR16 *)HiiGetString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_SEC_SB_CUSTOM_CONFIG_TEXT), NULL);
+      ConfigSubstring = GetCachedString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_SEC_SB_CUSTOM_CONFIG_TEXT));
     } else {
       ConfigSubstring = (CHAR16 *)mSecureBootKeys[CurrentConfig].SecureBootKeyName;
     }
@@ -668,7 +763,7 @@ UpdateSecureBootStatusStrings (
   //
   // If disabled, just present the state string.
   else {
-    StateSubstring = (CHAR16 *)HiiGetString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_SEC_SB_STATE_DISABLED), NULL);
+    StateSubstring = GetCachedString (mFrontPagePrivate.HiiHandle, STRING_TOKEN (STR_SEC_SB_STATE_DISABLED));
     UnicodeSPrint (StateString, sizeof (StateString), L"%s %s", PreambleSubstring, StateSubstring);
   }
 
@@ -703,7 +798,7 @@ ChallengeUserPassword (
 {
   EFI_STATUS     Status;
   SWM_MB_RESULT  SwmResult = 0;
-  CHAR16         *pErrorMessage = (CHAR16 *)HiiGetString (gStringPackHandle, STRING_TOKEN (STR_NULL_STRING), NULL);
+  CHAR16         *pErrorMessage = GetCachedString (gStringPackHandle, STRING_TOKEN (STR_NULL_STRING));
   CHAR16         *PasswordBuffer = NULL;           // This will be allocated by PasswordPrompt(). Needs to be tracked, wiped, and freed.
   BOOLEAN        Result = FALSE, AttemptsExpired = FALSE;
 
@@ -715,9 +810,9 @@ ChallengeUserPassword (
     // Present the password dialog to prompt the user.
     //
     Status = SwmDialogsPasswordPrompt (
-               HiiGetString (gStringPackHandle, STRING_TOKEN (STR_PWD_ENTER_PWD_TITLEBARTEXT), NULL),                               // Dialog titlebar text.
-               HiiGetString (gStringPackHandle, STRING_TOKEN (STR_PWD_CAPTION), NULL),                                              // Dialog caption text.
-               HiiGetString (gStringPackHandle, STRING_TOKEN (STR_PWD_ENTER_BODYTEXT), NULL),                                       // Dialog body text.
+               GetCachedString (gStringPackHandle, STRING_TOKEN (STR_PWD_ENTER_PWD_TITLEBARTEXT)),                               // Dialog titlebar text.
+               GetCachedString (gStringPackHandle, STRING_TOKEN (STR_PWD_CAPTION)),                                              // Dialog caption text.
+               GetCachedString (gStringPackHandle, STRING_TOKEN (STR_PWD_ENTER_BODYTEXT)),                                       // Dialog body text.
                pErrorMessage,
                SWM_PWD_TYPE_PROMPT_PASSWORD,
                &SwmResult,
@@ -733,7 +828,20 @@ ChallengeUserPassword (
     // If the user selected "OK", check whether the password provided is valid.
     //
     if (SWM_MB_IDOK == SwmResult) {
-      if (GetAuthToken (PasswordBuffer) == EFI_SUCCESS) {
+      // The password is hashed once, when the session starts, so the BSP is busy until it
+      // returns.  The sweeping indicator runs from a timer event meanwhile.  DFCI, and anything
+      // else that checks this password before FrontPage exits, is answered by the session.
+      //
+      FpProgressStartSweep ();
+      if (PasswordStoreStartSession (PasswordBuffer, &mPasswordSession)) {
+        Status = GetAuthToken (PasswordBuffer);
+      } else {
+        Status = EFI_SECURITY_VIOLATION;
+      }
+
+      FpProgressHide ();
+
+      if (Status == EFI_SUCCESS) {
         // Password authentication successful.  Display the full menu.
         //
         Result = TRUE;
@@ -741,7 +849,7 @@ ChallengeUserPassword (
       } else {
         // Password authentication error.  Display error text and ask the user for the password again.
         //
-        pErrorMessage = (CHAR16 *)HiiGetString (gStringPackHandle, STRING_TOKEN (STR_PWD_ERRORMSG_AUTHERROR), NULL);
+        pErrorMessage = GetCachedString (gStringPackHandle, STRING_TOKEN (STR_PWD_ERRORMSG_AUTHERROR));
 
         // If password buffer was used, make sure it's freed.
         //
@@ -771,9 +879,9 @@ ChallengeUserPassword (
   if (TRUE == AttemptsExpired) {
     DEBUG ((DEBUG_INFO, "FrontPage::%a - Max password attempts elapsed!!\n", __FUNCTION__));
     Status = SwmDialogsMessageBox (
-               (CHAR16 *)HiiGetString (gStringPackHandle, STRING_TOKEN (STR_PWD_ATTEMPTS_EXPIRED_TITLE), NULL),    // Dialog titlebar text.
-               (CHAR16 *)HiiGetString (gStringPackHandle, STRING_TOKEN (STR_PWD_ATTEMPTS_EXPIRED_BODYTEXT), NULL), // Dialog body text.
-               (CHAR16 *)HiiGetString (gStringPackHandle, STRING_TOKEN (STR_PWD_ATTEMPTS_EXPIRED_CAPTION), NULL),  // Dialog caption text.
+               GetCachedString (gStringPackHandle, STRING_TOKEN (STR_PWD_ATTEMPTS_EXPIRED_TITLE)),    // Dialog titlebar text.
+               GetCachedString (gStringPackHandle, STRING_TOKEN (STR_PWD_ATTEMPTS_EXPIRED_BODYTEXT)), // Dialog body text.
+               GetCachedString (gStringPackHandle, STRING_TOKEN (STR_PWD_ATTEMPTS_EXPIRED_CAPTION)),  // Dialog caption text.
                SWM_MB_OK,                                                                                          // Show only Ok button.
                0,                                                                                                  // No timeout
                &SwmResult
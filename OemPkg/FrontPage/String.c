@@ -9,13 +9,159 @@
 **/
 
 #include "FrontPage.h"
+#include "String.h"
 
+#include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/HiiLib.h>
 
 EFI_HII_HANDLE  gStringPackHandle;
 
+//
+// String cache.  Strings fetched from HII are copied into an arena and indexed by
+// (HII handle, string ID) so that repeated lookups neither walk the HII database nor
+// allocate.  The arena is released in one go by FreeStringCache().
+//
+#define STRING_CACHE_BUCKETS        64              // Must be a power of 2.
+#define STRING_ARENA_MIN_CHUNK_SIZE  SIZE_4KB
+
+typedef struct _STRING_ARENA_CHUNK STRING_ARENA_CHUNK;
+
+struct _STRING_ARENA_CHUNK {
+  STRING_ARENA_CHUNK    *Next;
+  UINTN                 Size;         // Usable bytes following this header.
+  UINTN                 Used;
+};
+
+typedef struct _STRING_CACHE_ENTRY STRING_CACHE_ENTRY;
+
+struct _STRING_CACHE_ENTRY {
+  STRING_CACHE_ENTRY    *Next;
+  EFI_HII_HANDLE        HiiHandle;
+  EFI_STRING_ID         Id;
+  CHAR16                *String;
+};
+
+STATIC STRING_ARENA_CHUNK  *mStringArena = NULL;
+STATIC STRING_CACHE_ENTRY  *mStringCache[STRING_CACHE_BUCKETS];
+
+/**
+  Carves Size bytes out of the string arena, adding a chunk if needed.
+
+  @param  Size    Number of bytes required.
+
+  @retval  VOID *   Pointer to the (pointer-aligned) block.
+  @retval  NULL     Out of resources.
+
+**/
+STATIC
+VOID *
+ArenaAllocate (
+  IN UINTN  Size
+  )
+{
+  STRING_ARENA_CHUNK  *Chunk;
+  VOID                *Block;
+
+  Size = ALIGN_VALUE (Size, sizeof (UINTN));
+
+  Chunk = mStringArena;
+  if ((Chunk == NULL) || ((Chunk->Size - Chunk->Used) < Size)) {
+    Chunk = AllocatePool (sizeof (STRING_ARENA_CHUNK) + MAX (Size, STRING_ARENA_MIN_CHUNK_SIZE));
+    if (Chunk == NULL) {
+      return NULL;
+    }
+
+    Chunk->Size  = MAX (Size, STRING_ARENA_MIN_CHUNK_SIZE);
+    Chunk->Used  = 0;
+    Chunk->Next  = mStringArena;
+    mStringArena = Chunk;
+  }
+
+  Block        = (UINT8 *)(Chunk + 1) + Chunk->Used;
+  Chunk->Used += Size;
+
+  return Block;
+}
+
+/**
+  Get a string from the HII database, using the FrontPage string cache.
+
+  The returned string is owned by the cache and must not be freed or modified.
+  It remains valid until FreeStringCache() is called.
+
+  @param HiiHandle       HII handle of the package list that contains the string.
+  @param Id              String ID.
+
+  @retval  CHAR16 *  String from ID.
+  @retval  NULL      If error occurs.
+
+**/
+CHAR16 *
+GetCachedString (
+  IN  EFI_HII_HANDLE  HiiHandle,
+  IN  EFI_STRING_ID   Id
+  )
+{
+  STRING_CACHE_ENTRY  *Entry;
+  UINTN               Bucket;
+  EFI_STRING          HiiString;
+  UINTN               StringSize;
+
+  Bucket = (((UINTN)HiiHandle >> 3) ^ Id) & (STRING_CACHE_BUCKETS - 1);
+
+  for (Entry = mStringCache[Bucket]; Entry != NULL; Entry = Entry->Next) {
+    if ((Entry->HiiHandle == HiiHandle) && (Entry->Id == Id)) {
+      return Entry->String;
+    }
+  }
+
+  HiiString = HiiGetString (HiiHandle, Id, NULL);
+  if (HiiString == NULL) {
+    return NULL;
+  }
+
+  StringSize = StrSize (HiiString);
+  Entry      = ArenaAllocate (sizeof (STRING_CACHE_ENTRY) + StringSize);
+  if (Entry == NULL) {
+    FreePool (HiiString);
+    return NULL;
+  }
+
+  Entry->HiiHandle = HiiHandle;
+  Entry->Id        = Id;
+  Entry->String    = (CHAR16 *)(Entry + 1);
+  CopyMem (Entry->String, HiiString, StringSize);
+  FreePool (HiiString);
+
+  Entry->Next          = mStringCache[Bucket];
+  mStringCache[Bucket] = Entry;
+
+  return Entry->String;
+}
+
+/**
+  Release every string held by the FrontPage string cache.
+
+**/
+VOID
+FreeStringCache (
+  VOID
+  )
+{
+  STRING_ARENA_CHUNK  *Chunk;
+
+  while (mStringArena != NULL) {
+    Chunk        = mStringArena;
+    mStringArena = Chunk->Next;
+    FreePool (Chunk);
+  }
+
+  ZeroMem (mStringCache, sizeof (mStringCache));
+}
+
 EFI_GUID  mFrontPageStringPackGuid = {
   // {9CA9EC7A-BC96-45E4-A500-1D4B79141553}
   0x9ca9ec7a, 0xbc96, 0x45e4, { 0xa5, 0x0, 0x1d, 0x4b, 0x79, 0x14, 0x15, 0x53 }
@@ -41,6 +187,7 @@ InitializeStringSupport (
 /**
   Get string by string id from HII Interface
 
+  The returned string is owned by the string cache and must not be freed.
 
   @param Id              String ID.
 
@@ -53,5 +200,5 @@ GetStringById (
   IN  EFI_STRING_ID  Id
   )
 {
-  return HiiGetString (gStringPackHandle, Id, NULL);
+  return GetCachedString (gStringPackHandle, Id);
 }
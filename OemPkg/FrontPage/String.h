@@ -23,6 +23,7 @@ extern UINT8  FrontPageStrings[];
 /**
   Get string by string id from HII Interface
 
+  The returned string is owned by the string cache and must not be freed.
 
   @param Id              String ID.
 
@@ -35,6 +36,34 @@ GetStringById (
   IN  EFI_STRING_ID  Id
   );
 
+/**
+  Get a string from the HII database, using the FrontPage string cache.
+
+  The returned string is owned by the cache and must not be freed or modified.
+  It remains valid until FreeStringCache() is called.
+
+  @param HiiHandle       HII handle of the package list that contains the string.
+  @param Id              String ID.
+
+  @retval  CHAR16 *  String from ID.
+  @retval  NULL      If error occurs.
+
+**/
+CHAR16 *
+GetCachedString (
+  IN  EFI_HII_HANDLE  HiiHandle,
+  IN  EFI_STRING_ID   Id
+  );
+
+/**
+  Release every string held by the FrontPage string cache.
+
+**/
+VOID
+FreeStringCache (
+  VOID
+  );
+
 /**
   Initialize HII global accessor for string support.
 
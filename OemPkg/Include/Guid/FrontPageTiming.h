@@ -0,0 +1,59 @@
+/** @file FrontPageTiming.h
+
+  This file defines the GUID, variable name and layout of the FrontPage startup timing record.
+
+  FrontPage publishes the time spent in each phase of its startup in a volatile variable that
+  the OS can read.  OemPkg/Scripts/DecodeFrontPageTiming.py decodes it on the host.  The phase
+  values and the layout are shared with the decoder and must only be extended, never reordered.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __FRONT_PAGE_TIMING_GUID_H__
+#define __FRONT_PAGE_TIMING_GUID_H__
+
+#define FRONT_PAGE_TIMING_VARIABLE_NAME   L"FrontPageTiming"
+#define FRONT_PAGE_TIMING_VARIABLE_ATTRS  (EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS)     // Volatile, readable from the OS.
+
+#define FRONT_PAGE_TIMING_SIGNATURE  SIGNATURE_32 ('F', 'P', 'T', 'M')
+#define FRONT_PAGE_TIMING_VERSION    1
+
+typedef enum {
+  FpPhaseFirstPaint = 0,                // UefiMain entry to the end of the first master frame paint, less user wait time.
+  FpPhaseConnectConsoles,               // EfiBootManagerConnectAllDefaultConsoles () (staged connect only).
+  FpPhaseConnectAll,                    // EfiBootManagerConnectAll (), immediate or deferred.
+  FpPhaseSetGraphicsConsoleMode,
+  FpPhaseInitializeUIToolKit,
+  FpPhaseInitializeFrontPage,
+  FpPhaseSmbiosStrings,                 // InitializeFrontPage () sub-step.
+  FpPhaseFirmwareVersions,              // InitializeFrontPage () sub-step, repeated after a deferred connect.
+  FpPhaseSecureBootStatus,              // InitializeFrontPage () sub-step.
+  FpPhasePasswordChallenge,             // CreateTopMenu () password prompt, includes user think time.
+  FpPhaseUserAlerts,                    // NotifyUserOfAlerts () dialogs, includes user think time.
+  FpPhaseMax
+} FRONT_PAGE_TIMING_PHASE;
+
+#pragma pack(1)
+
+typedef struct {
+  UINT32    Phase;                      // FRONT_PAGE_TIMING_PHASE
+  UINT32    Count;                      // Number of times the phase ran.  0 if it did not run.
+  UINT64    StartUs;                    // Start of the first run, relative to UefiMain entry.
+  UINT64    DurationUs;                 // Total of all runs.
+} FRONT_PAGE_TIMING_ENTRY;
+
+typedef struct {
+  UINT32                     Signature; // FRONT_PAGE_TIMING_SIGNATURE
+  UINT16                     Version;   // FRONT_PAGE_TIMING_VERSION
+  UINT16                     EntryCount;
+  UINT64                     EntryUs;   // UefiMain entry, in microseconds of the performance counter.
+  FRONT_PAGE_TIMING_ENTRY    Entries[FpPhaseMax];
+} FRONT_PAGE_TIMING_RECORD;
+
+#pragma pack()
+
+extern EFI_GUID  gOemFrontPageTimingGuid;
+
+#endif
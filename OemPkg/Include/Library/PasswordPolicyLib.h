@@ -18,14 +18,23 @@
 
 typedef UINT8 *PASSWORD_HASH;
 
+//
+// Handle for a password hash that is being computed in the background.
+//
+typedef struct _PASSWORD_HASH_TASK PASSWORD_HASH_TASK;
+
 //
 // Definitions for the test failures for the password.
 //
 typedef UINT32 PW_TEST_BITMAP;
-#define PW_TEST_STRING_NULL          (1 << 0)
-#define PW_TEST_STRING_TOO_SHORT     (1 << 1)
-#define PW_TEST_STRING_TOO_LONG      (1 << 2)
-#define PW_TEST_STRING_INVALID_CHAR  (1 << 3)
+#define PW_TEST_STRING_NULL             (1 << 0)
+#define PW_TEST_STRING_TOO_SHORT        (1 << 1)
+#define PW_TEST_STRING_TOO_LONG         (1 << 2)
+#define PW_TEST_STRING_INVALID_CHAR     (1 << 3)
+#define PW_TEST_STRING_TOO_FEW_CLASSES  (1 << 4)
+#define PW_TEST_STRING_REPEATED_CHAR    (1 << 5)
+#define PW_TEST_STRING_SEQUENCE         (1 << 6)
+#define PW_TEST_STRING_BANNED           (1 << 7)
 
 /**
   Copies a password to a buffer, but will only copy the maximum
@@ -65,6 +74,27 @@ PasswordPolicyCleansePwBuffer (
   IN  UINTN   Size
   );
 
+/**
+  Public interface for random bytes, such as salts, session keys and nonces.
+
+  The bytes come from a CTR_DRBG (NIST SP 800-90A) that is seeded from the RNG protocol and
+  RngLib on first use, and reseeded periodically.
+
+  @param[out] Buffer  Buffer for the random bytes.
+  @param[in]  Size    Number of random bytes.
+
+  @retval     EFI_SUCCESS             Buffer holds Size random bytes.
+  @retval     EFI_INVALID_PARAMETER   Buffer is NULL.
+  @retval     EFI_DEVICE_ERROR        There is no entropy, or the DRBG failed.
+
+**/
+EFI_STATUS
+EFIAPI
+PasswordPolicyGetRandomBytes (
+  OUT UINT8  *Buffer,
+  IN  UINTN  Size
+  );
+
 /**
   Public interface for validating password strings.
 
@@ -125,8 +155,8 @@ PasswordPolicyValidatePasswordHash (
   @param[in]  Password              Pointer to a buffer containing the clear text password.
                                     If Password == NULL, generate a no-password "hash"
   @param[out] PasswordHash          Pointer to a pointer that will contain the address of the password hash
-                                    OldSalt == NULL : Version, Salt, and Key fields stored.
-                                    OldSalt != NULL : Key field updated using existing Version and Salt.
+                                    OldSalt == NULL : Current version with a new Salt and calibrated parameters.
+                                    OldSalt != NULL : Key field updated using existing Version, Salt and parameters.
   @param[out] PasswordHashSize      Pointer where to store the new has size
 
 
@@ -147,4 +177,102 @@ PasswordPolicyGeneratePasswordHash (
   OUT       UINTN          *PasswordHashSize
   );
 
+/**
+  Public interface for determining whether a password hash was built with the current
+  version and parameters.
+
+  A hash that is not current still validates.  Callers that have just authenticated the
+  password should replace it with a new hash from PasswordPolicyGeneratePasswordHash().
+
+  @param[in]  PasswordHash            Pointer to the buffer containing the hash.
+  @param[in]  PasswordHashSize        Size of the buffer containing the hash.
+
+  @retval     TRUE      The hash is current, or is the no-password hash.
+  @retval     FALSE     The hash should be regenerated.
+
+**/
+BOOLEAN
+EFIAPI
+PasswordPolicyIsPasswordHashCurrent (
+  IN  CONST PASSWORD_HASH  PasswordHash,
+  IN        UINTN          PasswordHashSize
+  );
+
+/**
+  Public interface for starting a password hash in the background.
+
+  Takes the same inputs as PasswordPolicyGeneratePasswordHash ().  The key derivation runs on
+  an application processor when MP Services can start one.  Otherwise it runs a slice at a
+  time from PasswordPolicyPollPasswordHash ().
+
+  The password is not needed after this returns.
+
+  @param[in]  OldSalt               Pass in old PASSWORD_HASH to use the existing salt
+  @param[in]  Password              Pointer to a buffer containing the clear text password.
+                                    If Password == NULL, generate a no-password "hash"
+  @param[out] Task                  The new task.  Must be passed to PasswordPolicyFinishPasswordHash ().
+
+  @retval   EFI_SUCCESS             The task was started.
+  @retval   EFI_INVALID_PARAMETER   Task is NULL.
+  @retval   EFI_OUT_OF_RESOURCES    The task could not be allocated.
+
+**/
+EFI_STATUS
+EFIAPI
+PasswordPolicyStartPasswordHash (
+  IN   CONST PASSWORD_HASH       OldSalt   OPTIONAL,
+  IN   CONST CHAR16              *Password  OPTIONAL,
+  OUT        PASSWORD_HASH_TASK  **Task
+  );
+
+/**
+  Public interface for checking on a background password hash.
+
+  If the task is not running on an application processor, runs the next slice of it.
+  Callers should keep the UI going between calls.
+
+  @param[in]  Task                  Task from PasswordPolicyStartPasswordHash ().
+  @param[out] PercentComplete       [Optional] Progress of the hash, 0 to 100.
+
+  @retval   EFI_NOT_READY           The hash is still being computed.
+  @retval   EFI_INVALID_PARAMETER   Task is not a password hash task.
+  @retval   <other>                 The hash is done.  This is the result
+                                    PasswordPolicyFinishPasswordHash () will return.
+
+**/
+EFI_STATUS
+EFIAPI
+PasswordPolicyPollPasswordHash (
+  IN         PASSWORD_HASH_TASK  *Task,
+  OUT        UINTN               *PercentComplete OPTIONAL
+  );
+
+/**
+  Public interface for completing or cancelling a background password hash.
+
+  If the hash is not done, waits for it, or cancels it when PasswordHash is NULL.  The task is
+  freed in either case.
+
+  @param[in]  Task                  Task from PasswordPolicyStartPasswordHash ().
+  @param[out] PasswordHash          [Optional] Receives the password hash, as from
+                                    PasswordPolicyGeneratePasswordHash ().  NULL to cancel the task.
+  @param[out] PasswordHashSize      [Optional] Receives the size of the password hash.
+
+  @retval   EFI_SUCCESS             The password hash was returned.
+  @retval   EFI_ABORTED             The task was cancelled.
+  @retval   EFI_INVALID_PARAMETER   Task is not a password hash task, or PasswordHash is present
+                                    without PasswordHashSize.
+  @retval   <other>                 The hash could not be generated.
+
+  Caller is responsible for freeing the returned PASSWORD_HASH
+
+**/
+EFI_STATUS
+EFIAPI
+PasswordPolicyFinishPasswordHash (
+  IN         PASSWORD_HASH_TASK  *Task,
+  OUT        PASSWORD_HASH       *PasswordHash OPTIONAL,
+  OUT        UINTN               *PasswordHashSize OPTIONAL
+  );
+
 #endif // _PASSWORD_POLICY_LIB_H_
@@ -0,0 +1,71 @@
+/** @file -- PasswordStoreSessionLib.h
+
+  Session interface to the platform administrator password.
+
+  A module that asks the user for the password starts a session with it and keeps the token.
+  While the session lasts, AuthenticateSession accepts the token, and PasswordStoreLib accepts
+  the password that started it, both without rerunning the password hash.  The session ends
+  when its owner ends it, when the password changes, when another session starts, or at
+  ReadyToBoot.
+
+  PasswordStoreLib implements this class, so a platform that maps it must include
+  PasswordStoreDxe.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _PASSWORD_STORE_SESSION_LIB_H_
+#define _PASSWORD_STORE_SESSION_LIB_H_
+
+#include <Protocol/PasswordStoreProtocol.h>
+
+/**
+  Validates a password with the hash and, if it matches a set password, starts a session.
+
+  @param[in]  Password  String being evaluated.
+  @param[out] Token     Receives the token of the session.  Zeroed if no session was started,
+                        including when no password is set.
+
+  @retval     TRUE      Password matches the stored password.
+  @retval     TRUE      No password is currently set.
+  @retval     FALSE     Password is NULL, does not match, or PasswordStoreProtocol is not
+                        installed.
+
+**/
+BOOLEAN
+EFIAPI
+PasswordStoreStartSession (
+  IN  CONST CHAR16                  *Password,
+  OUT PASSWORD_STORE_SESSION_TOKEN  *Token
+  );
+
+/**
+  Checks a token from PasswordStoreStartSession () without the password hash.
+
+  @param[in]  Token     Token of the session.
+
+  @retval     TRUE      The session is still current, or no password is set.
+  @retval     FALSE     Not, or PasswordStoreProtocol is not installed.
+
+**/
+BOOLEAN
+EFIAPI
+PasswordStoreAuthenticateSession (
+  IN  CONST PASSWORD_STORE_SESSION_TOKEN  *Token
+  );
+
+/**
+  Ends the session of a token from PasswordStoreStartSession (), if it is still current.
+
+  @param[in]  Token     Token of the session.
+
+**/
+VOID
+EFIAPI
+PasswordStoreEndSession (
+  IN  CONST PASSWORD_STORE_SESSION_TOKEN  *Token
+  );
+
+#endif // _PASSWORD_STORE_SESSION_LIB_H_
@@ -0,0 +1,95 @@
+/** @file -- SmbiosStringLib.h
+
+  Interface to SmbiosStringLib.
+
+  The library parses the SMBIOS table once into an index keyed by record type,
+  instance and string number.  Every string is kept in both ASCII and UCS-2 form
+  so lookups return a pointer into the index and never allocate.  The index is
+  rebuilt on the next lookup after the SMBIOS table is republished.
+
+  Pointers returned by this library are owned by the library.  They must not be
+  freed, and they are only valid until the SMBIOS table next changes.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _SMBIOS_STRING_LIB_H_
+#define _SMBIOS_STRING_LIB_H_
+
+#include <Protocol/Smbios.h>
+
+/**
+  Returns the formatted area of an SMBIOS record.
+
+  @param[in]  Type          SMBIOS record type.
+  @param[in]  Instance      Zero based instance of the record type.
+  @param[out] Record        Pointer to the formatted area of the record.
+
+  @retval EFI_SUCCESS           Record returned.
+  @retval EFI_INVALID_PARAMETER Record is NULL.
+  @retval EFI_NOT_FOUND         The record does not exist, or the SMBIOS table is not available.
+
+**/
+EFI_STATUS
+EFIAPI
+SmbiosStringGetRecord (
+  IN  SMBIOS_TYPE                    Type,
+  IN  UINTN                          Instance,
+  OUT CONST EFI_SMBIOS_TABLE_HEADER  **Record
+  );
+
+/**
+  Returns an ASCII string of an SMBIOS record.
+
+  String number 0 means "no string" in SMBIOS and returns an empty string.
+
+  @param[in]  Type          SMBIOS record type.
+  @param[in]  Instance      Zero based instance of the record type.
+  @param[in]  StringNumber  One based string number, as stored in the formatted area.
+  @param[out] String        Pointer to the string.
+  @param[out] Size          Optional size of the string in bytes, including the NULL terminator.
+
+  @retval EFI_SUCCESS           String returned.
+  @retval EFI_INVALID_PARAMETER String is NULL.
+  @retval EFI_NOT_FOUND         The record or the string does not exist.
+
+**/
+EFI_STATUS
+EFIAPI
+SmbiosStringGetAscii (
+  IN  SMBIOS_TYPE          Type,
+  IN  UINTN                Instance,
+  IN  SMBIOS_TABLE_STRING  StringNumber,
+  OUT CONST CHAR8          **String,
+  OUT UINTN                *Size   OPTIONAL
+  );
+
+/**
+  Returns a UCS-2 string of an SMBIOS record.
+
+  String number 0 means "no string" in SMBIOS and returns an empty string.
+
+  @param[in]  Type          SMBIOS record type.
+  @param[in]  Instance      Zero based instance of the record type.
+  @param[in]  StringNumber  One based string number, as stored in the formatted area.
+  @param[out] String        Pointer to the string.
+  @param[out] Size          Optional size of the string in bytes, including the NULL terminator.
+
+  @retval EFI_SUCCESS           String returned.
+  @retval EFI_INVALID_PARAMETER String is NULL.
+  @retval EFI_NOT_FOUND         The record or the string does not exist.
+
+**/
+EFI_STATUS
+EFIAPI
+SmbiosStringGetUnicode (
+  IN  SMBIOS_TYPE          Type,
+  IN  UINTN                Instance,
+  IN  SMBIOS_TABLE_STRING  StringNumber,
+  OUT CONST CHAR16         **String,
+  OUT UINTN                *Size   OPTIONAL
+  );
+
+#endif // _SMBIOS_STRING_LIB_H_
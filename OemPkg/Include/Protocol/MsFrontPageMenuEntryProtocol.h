@@ -0,0 +1,40 @@
+/** @file
+  MsFrontPageMenuEntryProtocol lets a driver add a top-level menu entry to the FrontPage master frame.
+  The driver publishes its formset with HiiAddPackages () and installs this protocol on any handle.  FrontPage
+  discovers the installed entries when it starts and shows them in Position order alongside its own entries.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _FRONT_PAGE_MENU_ENTRY_PROTOCOL_H
+#define _FRONT_PAGE_MENU_ENTRY_PROTOCOL_H
+
+#define FRONT_PAGE_MENU_ENTRY_PROTOCOL_REVISION  1
+
+//
+// Positions of the entries FrontPage provides itself.  Pick a Position between two of these
+// to place an entry between them.
+//
+#define FRONT_PAGE_MENU_POSITION_PCINFO     0x0100
+#define FRONT_PAGE_MENU_POSITION_SECURITY   0x0200
+#define FRONT_PAGE_MENU_POSITION_BOOTORDER  0x0300
+#define FRONT_PAGE_MENU_POSITION_DFCI       0x0400
+#define FRONT_PAGE_MENU_POSITION_HWH        0x0500
+#define FRONT_PAGE_MENU_POSITION_EXIT       0xFF00
+
+typedef struct _FRONT_PAGE_MENU_ENTRY_PROTOCOL FRONT_PAGE_MENU_ENTRY_PROTOCOL;
+
+struct _FRONT_PAGE_MENU_ENTRY_PROTOCOL {
+  UINT32           Revision;         // FRONT_PAGE_MENU_ENTRY_PROTOCOL_REVISION
+  EFI_GUID         FormSetGuid;      // Formset to display when the entry is selected.
+  EFI_FORM_ID      FormId;           // Form within the formset.
+  EFI_STRING_ID    MenuString;       // Menu text, from the HII package list that contains the formset.
+  UINT16           Position;         // Entries are shown in ascending Position order.
+  BOOLEAN          LimitedMenu;      // TRUE to also show the entry when the system password was not entered.
+};
+
+extern EFI_GUID  gMsFrontPageMenuEntryProtocolGuid;
+
+#endif
@@ -0,0 +1,23 @@
+/** @file
+  Marker protocol, with a NULL interface, installed once EfiBootManagerConnectAll () has
+  completed in this boot.  The BootManagerPolicyDxe override installs it after each connect-all
+  it does for BDS, and FrontPage after its own, so that later consumers can skip a redundant
+  full controller connect.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _OEM_CONNECT_ALL_COMPLETE_PROTOCOL_H_
+#define _OEM_CONNECT_ALL_COMPLETE_PROTOCOL_H_
+
+// {33F0C39B-388F-43AE-8159-AF4D1E6CD1BB}
+#define OEM_CONNECT_ALL_COMPLETE_PROTOCOL_GUID \
+  { \
+    0x33f0c39b, 0x388f, 0x43ae, { 0x81, 0x59, 0xaf, 0x4d, 0x1e, 0x6c, 0xd1, 0xbb } \
+  }
+
+extern EFI_GUID  gOemConnectAllCompleteGuid;
+
+#endif // _OEM_CONNECT_ALL_COMPLETE_PROTOCOL_H_
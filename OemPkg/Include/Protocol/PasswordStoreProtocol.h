@@ -0,0 +1,150 @@
+/** @file
+  PasswordStoreProtocol is installed by PasswordStoreDxe.  That driver reads the password variable
+  once, keeps the stored hash in memory and updates it when the password is set or cleared.
+  PasswordStoreLib forwards its calls here, so the modules that link it neither read the variable
+  nor hash anything to answer IsPasswordSet.
+
+  A caller that verifies the password through AuthenticatePassword can ask for a session token.
+  Until EndSession, ReadyToBoot, the password is changed, or another session starts,
+  AuthenticateSession accepts that token without rerunning the password hash, and
+  AuthenticatePassword accepts the password that started the session without it too.  The token
+  is only returned to the caller that supplied the password.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _PASSWORD_STORE_PROTOCOL_H_
+#define _PASSWORD_STORE_PROTOCOL_H_
+
+#define PASSWORD_STORE_PROTOCOL_REVISION  2
+
+#define PASSWORD_STORE_SESSION_TOKEN_SIZE  32
+
+typedef struct _PASSWORD_STORE_PROTOCOL PASSWORD_STORE_PROTOCOL;
+
+//
+// Opaque proof of an earlier AuthenticatePassword.  Callers keep it and pass it back; they should
+// zero it when they are done with it.
+//
+typedef struct {
+  UINT8    Bytes[PASSWORD_STORE_SESSION_TOKEN_SIZE];
+} PASSWORD_STORE_SESSION_TOKEN;
+
+/**
+  Determines whether a password is set.
+
+  @param[in]  This      A pointer to the PASSWORD_STORE_PROTOCOL instance.
+
+  @retval     TRUE      A password is set.
+  @retval     FALSE     No password is set, or the store could not be read.
+
+**/
+typedef
+BOOLEAN
+(EFIAPI *PASSWORD_STORE_IS_PASSWORD_SET)(
+  IN  PASSWORD_STORE_PROTOCOL *This
+  );
+
+/**
+  Validates a password against the stored hash.  See PasswordStoreAuthenticatePassword ().
+
+  @param[in]  This      A pointer to the PASSWORD_STORE_PROTOCOL instance.
+  @param[in]  Password  Password to check.
+  @param[out] Token     [Optional] If the password matches a set password, receives the token of
+                        a new session, and any earlier session ends.  Zeroed in every other case,
+                        including when no session could be started.
+
+  @retval     TRUE      The password matches, or no password is set.  Without Token, the
+                        password that started the current session matches without the hash.
+  @retval     FALSE     Not, or Password is NULL.
+
+**/
+typedef
+BOOLEAN
+(EFIAPI *PASSWORD_STORE_AUTHENTICATE_PASSWORD)(
+  IN  PASSWORD_STORE_PROTOCOL       *This,
+  IN  CONST CHAR16                  *Password,
+  OUT PASSWORD_STORE_SESSION_TOKEN  *Token OPTIONAL
+  );
+
+/**
+  Checks a session token from an earlier AuthenticatePassword, without the password hash.
+
+  @param[in]  This      A pointer to the PASSWORD_STORE_PROTOCOL instance.
+  @param[in]  Token     Token from AuthenticatePassword.
+
+  @retval     TRUE      Token belongs to the current session, and the password has not changed
+                        since; or no password is set.
+  @retval     FALSE     Not, Token is NULL, or ReadyToBoot has been signaled.
+
+**/
+typedef
+BOOLEAN
+(EFIAPI *PASSWORD_STORE_AUTHENTICATE_SESSION)(
+  IN  PASSWORD_STORE_PROTOCOL             *This,
+  IN  CONST PASSWORD_STORE_SESSION_TOKEN  *Token
+  );
+
+/**
+  Ends the session of a token, if it is the current one.
+
+  @param[in]  This      A pointer to the PASSWORD_STORE_PROTOCOL instance.
+  @param[in]  Token     Token from AuthenticatePassword.
+
+**/
+typedef
+VOID
+(EFIAPI *PASSWORD_STORE_END_SESSION)(
+  IN  PASSWORD_STORE_PROTOCOL             *This,
+  IN  CONST PASSWORD_STORE_SESSION_TOKEN  *Token
+  );
+
+/**
+  Stores a new password hash.
+
+  @param[in]  This              A pointer to the PASSWORD_STORE_PROTOCOL instance.
+  @param[in]  PasswordHash      The password hash, from PasswordPolicyGeneratePasswordHash ().
+  @param[in]  PasswordHashSize  Size of PasswordHash.
+
+  @retval     EFI_SUCCESS       The hash is stored.
+  @retval     Others            The hash is not valid, or could not be stored.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *PASSWORD_STORE_SET_PASSWORD)(
+  IN  PASSWORD_STORE_PROTOCOL *This,
+  IN  CONST UINT8             *PasswordHash,
+  IN  UINTN                   PasswordHashSize
+  );
+
+/**
+  Deletes the password variable, returning the store to factory condition.
+
+  @param[in]  This      A pointer to the PASSWORD_STORE_PROTOCOL instance.
+
+  @retval     EFI_SUCCESS   The store is reset.
+  @retval     Others        The variable could not be deleted.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *PASSWORD_STORE_RESET)(
+  IN  PASSWORD_STORE_PROTOCOL *This
+  );
+
+struct _PASSWORD_STORE_PROTOCOL {
+  UINT32                                  Revision;           // PASSWORD_STORE_PROTOCOL_REVISION
+  PASSWORD_STORE_IS_PASSWORD_SET          IsPasswordSet;
+  PASSWORD_STORE_AUTHENTICATE_PASSWORD    AuthenticatePassword;
+  PASSWORD_STORE_SET_PASSWORD             SetPassword;
+  PASSWORD_STORE_RESET                    Reset;
+  PASSWORD_STORE_AUTHENTICATE_SESSION     AuthenticateSession;
+  PASSWORD_STORE_END_SESSION              EndSession;
+};
+
+extern EFI_GUID  gOemPasswordStoreProtocolGuid;
+
+#endif
@@ -17,60 +17,61 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/MemoryAllocationLib.h>
 
 #include <Uefi/UefiInternalFormRepresentation.h>
-#include <Protocol/Smbios.h>
+#include <Library/SmbiosStringLib.h>
 
 #define ID_NOT_FOUND  "Not Found"
 
-// Note: This protocol will guarantee to be met by the Depex and located at the
-// constructor of this library, thus no null-pointer check in library code flow.
-EFI_SMBIOS_PROTOCOL  *mSmbiosProtocol;
-
 /**
 
-  Acquire the string associated with the Index from smbios structure and return it.
+  Acquire a string of the first SMBIOS record of a type and return a copy of it.
   The caller is responsible for free the string buffer.
 
-  @param    OptionalStrStart  The start position to search the string
-  @param    Index             The index of the string to extract
+  @param    Type              The SMBIOS record type
+  @param    FieldOffset       Offset of the string number within the formatted area of the record
   @param    String            The string that is extracted
   @param    Size              Optional pointer to hold size of returned string
 
-  @retval   EFI_SUCCESS       The function returns EFI_SUCCESS always.
+  @retval   EFI_SUCCESS           The string, or "Not Found", was returned.
+  @retval   EFI_NOT_FOUND         The SMBIOS record does not exist.
+  @retval   EFI_OUT_OF_RESOURCES  Unable to allocate the copy.
 
 **/
+STATIC
 EFI_STATUS
-GetOptionalStringByIndex (
-  IN      CHAR8  *OptionalStrStart,
-  IN      UINT8  Index,
-  OUT     CHAR8  **String,
-  OUT     UINTN  *Size   OPTIONAL
+GetSmbiosString (
+  IN      SMBIOS_TYPE  Type,
+  IN      UINTN        FieldOffset,
+  OUT     CHAR8        **String,
+  OUT     UINTN        *Size   OPTIONAL
   )
 {
-  UINTN  StrSize;
+  EFI_STATUS                     Status;
+  CONST EFI_SMBIOS_TABLE_HEADER  *Record;
+  SMBIOS_TABLE_STRING            StringNumber;
+  CONST CHAR8                    *SmbiosString;
+  UINTN                          StrSize;
 
-  if (Index == 0) {
+  Status = SmbiosStringGetRecord (Type, 0, &Record);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - SMBIOS type %d not found. %r\n", __FUNCTION__, Type, Status));
+    return Status;
+  }
+
+  StringNumber = *((CONST UINT8 *)Record + FieldOffset);
+  if (StringNumber == 0) {
     *String = AllocateZeroPool (sizeof (CHAR16));
-    return EFI_SUCCESS;
+    return (*String == NULL) ? EFI_OUT_OF_RESOURCES : EFI_SUCCESS;
   }
 
-  StrSize = 0;
-  do {
-    Index--;
-    OptionalStrStart += StrSize;
-    StrSize           = AsciiStrSize (OptionalStrStart);
-  } while (OptionalStrStart[StrSize] != 0 && Index != 0);
+  Status = SmbiosStringGetAscii (Type, 0, StringNumber, &SmbiosString, &StrSize);
+  if (EFI_ERROR (Status) || (StrSize == 1)) {
+    SmbiosString = ID_NOT_FOUND;
+    StrSize      = sizeof (ID_NOT_FOUND);
+  }
 
-  if ((Index != 0) || (StrSize == 1)) {
-    //
-    // Meet the end of strings set but Index is non-zero, or
-    // Find an empty string
-    //
-    StrSize = sizeof (ID_NOT_FOUND);
-    *String = AllocatePool (StrSize);
-    CopyMem (*String, ID_NOT_FOUND, StrSize);
-  } else {
-    *String = AllocatePool (StrSize);
-    CopyMem (*String, OptionalStrStart, StrSize);
+  *String = AllocateCopyPool (StrSize, SmbiosString);
+  if (*String == NULL) {
+    return EFI_OUT_OF_RESOURCES;
   }
 
   if (Size != NULL) {
@@ -95,21 +96,10 @@ DfciIdSupportV1GetSerialNumber (
   OUT UINTN  *SerialNumber
   )
 {
-  EFI_STATUS               Status;
-  CHAR8                    *NewString;
-  EFI_SMBIOS_HANDLE        SmbiosHandle;
-  EFI_SMBIOS_TABLE_HEADER  *Record;
-  SMBIOS_TYPE              Type;
-  SMBIOS_TABLE_TYPE1       *Type1Record;
-
-  SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;      // Reset handle
-  Type         = SMBIOS_TYPE_SYSTEM_INFORMATION; // Smbios type1
-  Status       = mSmbiosProtocol->GetNext (mSmbiosProtocol, &SmbiosHandle, &Type, &Record, NULL);
-  if (!EFI_ERROR (Status)) {
-    Type1Record = (SMBIOS_TABLE_TYPE1 *)Record;
-  }
+  EFI_STATUS  Status;
+  CHAR8       *NewString;
 
-  Status = GetOptionalStringByIndex ((CHAR8 *)((UINT8 *)Type1Record + Type1Record->Hdr.Length), Type1Record->SerialNumber, &NewString, NULL);
+  Status = GetSmbiosString (SMBIOS_TYPE_SYSTEM_INFORMATION, OFFSET_OF (SMBIOS_TABLE_TYPE1, SerialNumber), &NewString, NULL);
   if (!EFI_ERROR (Status)) {
     CopyMem (SerialNumber, NewString, sizeof (UINTN));
     FreePool (NewString);
@@ -135,25 +125,11 @@ DfciIdSupportGetManufacturer (
   UINTN  *ManufacturerSize   OPTIONAL
   )
 {
-  EFI_STATUS               Status;
-  EFI_SMBIOS_HANDLE        SmbiosHandle;
-  EFI_SMBIOS_TABLE_HEADER  *Record;
-  SMBIOS_TYPE              Type;
-  SMBIOS_TABLE_TYPE1       *Type1Record;
-
   if (Manufacturer == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
-  SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;      // Reset handle
-  Type         = SMBIOS_TYPE_SYSTEM_INFORMATION; // Smbios type1
-  Status       = mSmbiosProtocol->GetNext (mSmbiosProtocol, &SmbiosHandle, &Type, &Record, NULL);
-  if (!EFI_ERROR (Status)) {
-    Type1Record = (SMBIOS_TABLE_TYPE1 *)Record;
-  }
-
-  Status = GetOptionalStringByIndex ((CHAR8 *)((UINT8 *)Type1Record + Type1Record->Hdr.Length), Type1Record->Manufacturer, Manufacturer, ManufacturerSize);
-  return Status;
+  return GetSmbiosString (SMBIOS_TYPE_SYSTEM_INFORMATION, OFFSET_OF (SMBIOS_TABLE_TYPE1, Manufacturer), Manufacturer, ManufacturerSize);
 }
 
 /**
@@ -173,25 +149,11 @@ DfciIdSupportGetProductName (
   UINTN  *ProductNameSize  OPTIONAL
   )
 {
-  EFI_STATUS               Status;
-  EFI_SMBIOS_HANDLE        SmbiosHandle;
-  EFI_SMBIOS_TABLE_HEADER  *Record;
-  SMBIOS_TYPE              Type;
-  SMBIOS_TABLE_TYPE1       *Type1Record;
-
   if (ProductName == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
-  SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;      // Reset handle
-  Type         = SMBIOS_TYPE_SYSTEM_INFORMATION; // Smbios type1
-  Status       = mSmbiosProtocol->GetNext (mSmbiosProtocol, &SmbiosHandle, &Type, &Record, NULL);
-  if (!EFI_ERROR (Status)) {
-    Type1Record = (SMBIOS_TABLE_TYPE1 *)Record;
-  }
-
-  Status = GetOptionalStringByIndex ((CHAR8 *)((UINT8 *)Type1Record + Type1Record->Hdr.Length), Type1Record->ProductName, ProductName, ProductNameSize);
-  return Status;
+  return GetSmbiosString (SMBIOS_TYPE_SYSTEM_INFORMATION, OFFSET_OF (SMBIOS_TABLE_TYPE1, ProductName), ProductName, ProductNameSize);
 }
 
 /**
@@ -211,48 +173,9 @@ DfciIdSupportGetSerialNumber (
   UINTN  *SerialNumberSize  OPTIONAL
   )
 {
-  EFI_STATUS               Status;
-  EFI_SMBIOS_HANDLE        SmbiosHandle;
-  EFI_SMBIOS_TABLE_HEADER  *Record;
-  SMBIOS_TYPE              Type;
-  SMBIOS_TABLE_TYPE3       *Type3Record;
-
   if (SerialNumber == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
-  SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;    // Reset handle
-  Type         = SMBIOS_TYPE_SYSTEM_ENCLOSURE; // Smbios type3
-  Status       = mSmbiosProtocol->GetNext (mSmbiosProtocol, &SmbiosHandle, &Type, &Record, NULL);
-  if (!EFI_ERROR (Status)) {
-    Type3Record = (SMBIOS_TABLE_TYPE3 *)Record;
-  }
-
-  Status = GetOptionalStringByIndex ((CHAR8 *)((UINT8 *)Type3Record + Type3Record->Hdr.Length), Type3Record->SerialNumber, SerialNumber, SerialNumberSize);
-  return Status;
-}
-
-/**
-  Constructor for DfciIdSupportLib.
-
-  @param  ImageHandle   ImageHandle of the loaded driver.
-  @param  SystemTable   Pointer to the EFI System Table.
-
-  @retval EFI_SUCCESS   The handlers were registered successfully.
-**/
-EFI_STATUS
-EFIAPI
-DfciIdSupportConstructor (
-  IN EFI_HANDLE        ImageHandle,
-  IN EFI_SYSTEM_TABLE  *SystemTable
-  )
-{
-  EFI_STATUS  Status;
-
-  Status = gBS->LocateProtocol (&gEfiSmbiosProtocolGuid, NULL, (VOID **)&mSmbiosProtocol);
-  if (EFI_ERROR (Status)) {
-    DEBUG ((EFI_D_ERROR, "Could not locate SMBIOS protocol.  %r\n", Status));
-  }
-
-  return Status;
+  return GetSmbiosString (SMBIOS_TYPE_SYSTEM_ENCLOSURE, OFFSET_OF (SMBIOS_TABLE_TYPE3, SerialNumber), SerialNumber, SerialNumberSize);
 }
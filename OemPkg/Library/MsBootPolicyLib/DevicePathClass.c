@@ -0,0 +1,167 @@
+/** @file
+  Cache of what MsBootPolicyLib knows about a device path.
+
+  The cache is an open addressing hash table.  A hit is checked against a copy of the device
+  path, so two paths with the same CRC32 can't share a class.  When the table is three quarters
+  full it is emptied, which keeps probes short and bounds the memory used.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Protocol/DevicePath.h>
+
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/DevicePathLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MsPlatformDevicesLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+#include "DevicePathClass.h"
+
+#define DEVICE_PATH_CACHE_SLOTS    512                              // Power of two.
+#define DEVICE_PATH_CACHE_ENTRIES  (DEVICE_PATH_CACHE_SLOTS * 3 / 4)
+
+typedef struct {
+  UINT32                      Hash;
+  UINT32                      Size;
+  EFI_DEVICE_PATH_PROTOCOL    *DevicePath;        // Copy of the path.  NULL for an empty slot.
+  DEVICE_PATH_CLASS           Class;
+} DEVICE_PATH_CACHE_ENTRY;
+
+STATIC DEVICE_PATH_CACHE_ENTRY   mCache[DEVICE_PATH_CACHE_SLOTS];
+STATIC UINTN                     mCacheCount       = 0;
+STATIC EFI_DEVICE_PATH_PROTOCOL  *mSdCardDevicePath = NULL;
+STATIC BOOLEAN                   mSdCardChecked    = FALSE;
+
+/**
+  Classifies a device path.
+
+  @param[in]  DevicePath    The device path.
+  @param[in]  Size          Size of the device path.
+  @param[out] Class         The class of the device path.
+
+**/
+STATIC
+VOID
+ClassifyDevicePath (
+  IN  CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN  UINTN                           Size,
+  OUT DEVICE_PATH_CLASS               *Class
+  )
+{
+  CONST EFI_DEVICE_PATH_PROTOCOL  *Node;
+  UINTN                           SdSize;
+
+  Class->IsSdCard = FALSE;
+  Class->IsUsb    = FALSE;
+
+  //
+  // The platform's SD card device path doesn't change, so it is only asked for once.
+  //
+  if (!mSdCardChecked) {
+    mSdCardDevicePath = GetSdCardDevicePath ();
+    mSdCardChecked    = TRUE;
+    if (NULL == mSdCardDevicePath) {
+      DEBUG ((DEBUG_INFO, "No SD Card check enabled.\n"));
+    }
+  }
+
+  if (NULL != mSdCardDevicePath) {
+    SdSize = GetDevicePathSize (mSdCardDevicePath);
+    if (Size > SdSize) {
+      // Compare the first part of the device path to the known path of the SDCARD.
+      if (0 == CompareMem (DevicePath, mSdCardDevicePath, SdSize - END_DEVICE_PATH_LENGTH)) {
+        Class->IsSdCard = TRUE;
+      }
+    }
+  }
+
+  for (Node = DevicePath; !IsDevicePathEnd (Node); Node = NextDevicePathNode (Node)) {
+    if (MESSAGING_DEVICE_PATH == Node->Type) {
+      // If any type of USB device
+      if ((MSG_USB_DP       == Node->SubType) ||
+          (MSG_USB_WWID_DP  == Node->SubType) ||
+          (MSG_USB_CLASS_DP == Node->SubType))
+      {
+        Class->IsUsb = TRUE;
+        break;
+      }
+    }
+  }
+}
+
+/**
+  Empties the cache.
+
+**/
+STATIC
+VOID
+ClearDevicePathCache (
+  VOID
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < DEVICE_PATH_CACHE_SLOTS; Index++) {
+    if (mCache[Index].DevicePath != NULL) {
+      FreePool (mCache[Index].DevicePath);
+    }
+  }
+
+  ZeroMem (mCache, sizeof (mCache));
+  mCacheCount = 0;
+}
+
+/**
+  Gets the class of a device path, from the cache if it is there.
+
+  @param[in]  DevicePath    A device path that IsDevicePathValid () accepted.
+  @param[out] Class         The class of the device path.
+
+**/
+VOID
+GetDevicePathClass (
+  IN  CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  OUT DEVICE_PATH_CLASS               *Class
+  )
+{
+  UINTN   Size;
+  UINT32  Hash;
+  UINTN   Slot;
+
+  Size = GetDevicePathSize (DevicePath);
+  Hash = 0;
+  gBS->CalculateCrc32 ((VOID *)DevicePath, Size, &Hash);
+
+  for (Slot = Hash & (DEVICE_PATH_CACHE_SLOTS - 1);
+       mCache[Slot].DevicePath != NULL;
+       Slot = (Slot + 1) & (DEVICE_PATH_CACHE_SLOTS - 1))
+  {
+    if ((mCache[Slot].Hash == Hash) && (mCache[Slot].Size == Size) &&
+        (CompareMem (mCache[Slot].DevicePath, DevicePath, Size) == 0))
+    {
+      CopyMem (Class, &mCache[Slot].Class, sizeof (DEVICE_PATH_CLASS));
+      return;
+    }
+  }
+
+  ClassifyDevicePath (DevicePath, Size, Class);
+
+  if (mCacheCount == DEVICE_PATH_CACHE_ENTRIES) {
+    ClearDevicePathCache ();
+    Slot = Hash & (DEVICE_PATH_CACHE_SLOTS - 1);
+  }
+
+  mCache[Slot].DevicePath = AllocateCopyPool (Size, DevicePath);
+  if (mCache[Slot].DevicePath != NULL) {
+    mCache[Slot].Hash = Hash;
+    mCache[Slot].Size = (UINT32)Size;
+    CopyMem (&mCache[Slot].Class, Class, sizeof (DEVICE_PATH_CLASS));
+    mCacheCount++;
+  }
+}
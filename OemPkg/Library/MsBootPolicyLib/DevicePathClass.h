@@ -0,0 +1,35 @@
+/** @file
+  Cache of what MsBootPolicyLib knows about a device path.
+
+  Every image load goes through MsBootPolicyLibIsDevicePathBootable (), so each device path is
+  classified once, as on the SD card or not and USB or not, and the class is kept in a hash table
+  keyed by the CRC32 of the path.  The class does not depend on any setting, so the cache never
+  has to be invalidated.  EnableUsbBoot is only read when the path is USB.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _DEVICE_PATH_CLASS_H_
+#define _DEVICE_PATH_CLASS_H_
+
+typedef struct {
+  BOOLEAN    IsSdCard;                    // Under the platform's SD card device path.
+  BOOLEAN    IsUsb;                       // Has a USB messaging node.
+} DEVICE_PATH_CLASS;
+
+/**
+  Gets the class of a device path, from the cache if it is there.
+
+  @param[in]  DevicePath    A device path that IsDevicePathValid () accepted.
+  @param[out] Class         The class of the device path.
+
+**/
+VOID
+GetDevicePathClass (
+  IN  CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  OUT DEVICE_PATH_CLASS               *Class
+  );
+
+#endif
@@ -29,6 +29,8 @@
 #include <Settings/BootMenuSettings.h>
 #include <Settings/DfciSettings.h>
 
+#include "DevicePathClass.h"
+
 static BOOT_SEQUENCE  BootSequenceUPH[] = {
   MsBootUSB,
   MsBootPXE4,
@@ -141,6 +143,10 @@ PrintDevicePath (
 {
   CHAR16  *ToText = NULL;
 
+  //
+  // Every image load comes through here, so only convert the path if it will be printed.
+  //
+  DEBUG_CODE_BEGIN ();
   if (DevicePath != NULL) {
     ToText = ConvertDevicePathToText (DevicePath, TRUE, TRUE);
   }
@@ -152,6 +158,7 @@ PrintDevicePath (
     FreePool (ToText);
   }
 
+  DEBUG_CODE_END ();
   return;
 }
 
@@ -293,10 +300,7 @@ MsBootPolicyLibIsDevicePathBootable (
 {
   EFI_STATUS                    Status;
   BOOLEAN                       rc = TRUE;
-  EFI_DEVICE_PATH_PROTOCOL      *SdCardDevicePath;
-  EFI_DEVICE_PATH_PROTOCOL      *Node;
-  UINTN                         Size;
-  UINTN                         SdSize;
+  DEVICE_PATH_CLASS             Class;
   BOOLEAN                       EnableUsbBoot = TRUE;
   DFCI_SETTING_ACCESS_PROTOCOL  *SettingsAccess;
   UINTN                         ValueSize;
@@ -326,25 +330,17 @@ MsBootPolicyLibIsDevicePathBootable (
     return FALSE;
   }
 
-  Size = GetDevicePathSize (DevicePath);
+  GetDevicePathClass (DevicePath, &Class);
 
-  SdCardDevicePath = GetSdCardDevicePath ();
-
-  if (NULL != SdCardDevicePath) {
-    PrintDevicePath (SdCardDevicePath);
-    SdSize =  GetDevicePathSize (SdCardDevicePath);
-    if (Size > SdSize) {
-      // Compare the first part of the device path to the known path of the SDCARD.
-      if (0 == CompareMem (DevicePath, SdCardDevicePath, SdSize - END_DEVICE_PATH_LENGTH)) {
-        DEBUG ((DEBUG_ERROR, "Boot from SD Card is not allowed.\n"));
-        rc = FALSE;
-      }
-    }
-  } else {
-    DEBUG ((DEBUG_INFO, "No SD Card check enabled.\n"));
+  if (Class.IsSdCard) {
+    DEBUG ((DEBUG_ERROR, "Boot from SD Card is not allowed.\n"));
+    rc = FALSE;
   }
 
-  if (rc) {
+  //
+  // EnableUsbBoot is only read for USB devices.  It is not cached, as DFCI can change it.
+  //
+  if (rc && Class.IsUsb) {
     EnableUsbBoot = TRUE;
     Status        = gBS->LocateProtocol (
                            &gDfciSettingAccessProtocolGuid,
@@ -369,21 +365,7 @@ MsBootPolicyLibIsDevicePathBootable (
 
     if (!EnableUsbBoot) {
       // Boot from USB is disabled
-      Node = DevicePath;
-      while (!IsDevicePathEnd (Node)) {
-        if (MESSAGING_DEVICE_PATH == Node->Type) {
-          // If any type of USB device
-          if ((MSG_USB_DP       == Node->SubType) ||             // don't allow booting
-              (MSG_USB_WWID_DP  == Node->SubType) ||
-              (MSG_USB_CLASS_DP == Node->SubType))
-          {
-            rc = FALSE;
-            break;
-          }
-        }
-
-        Node = NextDevicePathNode (Node);
-      }
+      rc = FALSE;
     }
   }
 
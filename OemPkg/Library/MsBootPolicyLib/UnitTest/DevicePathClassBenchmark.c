@@ -0,0 +1,504 @@
+/** @file -- DevicePathClassBenchmark.c
+
+  Host-based check and microbenchmark of the device path class cache of MsBootPolicyLib.
+
+  A few hundred load paths of the kinds a boot sees are built: drivers from firmware volumes,
+  option ROMs, NVMe, SATA, USB and SD card boot loaders, and network boot.  The cached classes
+  are checked against an uncached walk of each path, then the time of each is logged.  The
+  uncached walk converts the path and the SD card path to text, as the check did on every load
+  in DEBUG builds.  It does not read the DFCI setting, so a platform saves more than is shown.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Protocol/DevicePath.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/DevicePathLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MsPlatformDevicesLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UnitTestLib.h>
+
+#include <time.h>
+
+#include "../DevicePathClass.h"
+
+#define UNIT_TEST_APP_NAME     "DevicePathClass Benchmark"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define LOAD_PATH_COUNT     300
+#define LOAD_PATH_MAX_SIZE  256
+#define BENCHMARK_ROUNDS    200
+
+STATIC EFI_DEVICE_PATH_PROTOCOL  *mLoadPaths[LOAD_PATH_COUNT];
+STATIC EFI_DEVICE_PATH_PROTOCOL  *mSdCardPath = NULL;
+STATIC volatile UINTN            mSink;
+
+/**
+  CalculateCrc32 for the boot services table of the test.
+
+  @param[in]  Data        The buffer.
+  @param[in]  DataSize    Size of Data.
+  @param[out] Crc32       The CRC32 of Data.
+
+  @retval     EFI_SUCCESS   Always.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+HostCalculateCrc32 (
+  IN  VOID    *Data,
+  IN  UINTN   DataSize,
+  OUT UINT32  *Crc32
+  )
+{
+  *Crc32 = CalculateCrc32 (Data, DataSize);
+  return EFI_SUCCESS;
+}
+
+STATIC EFI_BOOT_SERVICES  mBootServices = {
+  .CalculateCrc32 = HostCalculateCrc32
+};
+
+EFI_BOOT_SERVICES  *gBS = &mBootServices;
+
+/**
+  The SD card device path of the test platform.
+
+  @return     The SD card device path.
+
+**/
+EFI_DEVICE_PATH_PROTOCOL *
+EFIAPI
+GetSdCardDevicePath (
+  VOID
+  )
+{
+  return mSdCardPath;
+}
+
+/**
+  Appends a node to a device path that is being built.
+
+  @param[in,out]  Path      The device path.  Has room for LOAD_PATH_MAX_SIZE bytes.
+  @param[in,out]  Offset    Where the node goes.  Moved past it.
+  @param[in]      Type      Node type.
+  @param[in]      SubType   Node subtype.
+  @param[in]      Data      Body of the node.
+  @param[in]      DataSize  Size of Data.
+
+**/
+STATIC
+VOID
+AppendNode (
+  IN OUT    UINT8  *Path,
+  IN OUT    UINTN  *Offset,
+  IN        UINT8  Type,
+  IN        UINT8  SubType,
+  IN  CONST VOID   *Data,
+  IN        UINTN  DataSize
+  )
+{
+  EFI_DEVICE_PATH_PROTOCOL  *Node;
+
+  ASSERT (*Offset + sizeof (*Node) + DataSize + END_DEVICE_PATH_LENGTH <= LOAD_PATH_MAX_SIZE);
+
+  Node          = (EFI_DEVICE_PATH_PROTOCOL *)&Path[*Offset];
+  Node->Type    = Type;
+  Node->SubType = SubType;
+  SetDevicePathNodeLength (Node, sizeof (*Node) + DataSize);
+  CopyMem (Node + 1, Data, DataSize);
+
+  *Offset += sizeof (*Node) + DataSize;
+  SetDevicePathEndNode (&Path[*Offset]);
+}
+
+/**
+  Appends the PCI root bridge and a PCI device.
+
+**/
+STATIC
+VOID
+AppendPciDevice (
+  IN OUT UINT8  *Path,
+  IN OUT UINTN  *Offset,
+  IN     UINT8  Device,
+  IN     UINT8  Function
+  )
+{
+  UINT32  Acpi[2];
+  UINT8   Pci[2];
+
+  Acpi[0] = EISA_PNP_ID (0x0A03);
+  Acpi[1] = 0;
+  AppendNode (Path, Offset, ACPI_DEVICE_PATH, ACPI_DP, Acpi, sizeof (Acpi));
+
+  Pci[0] = Function;
+  Pci[1] = Device;
+  AppendNode (Path, Offset, HARDWARE_DEVICE_PATH, HW_PCI_DP, Pci, sizeof (Pci));
+}
+
+/**
+  Appends a GPT partition and the default boot loader on it.
+
+**/
+STATIC
+VOID
+AppendBootLoader (
+  IN OUT UINT8  *Path,
+  IN OUT UINTN  *Offset,
+  IN     UINTN  Seed
+  )
+{
+  STATIC CONST CHAR16  FileName[] = L"\\EFI\\BOOT\\BOOTX64.EFI";
+  UINT8                HardDrive[38];
+
+  ZeroMem (HardDrive, sizeof (HardDrive));
+  HardDrive[0] = 1;                                           // Partition number.
+  HardDrive[5] = 0x08;                                        // Start LBA 2048.
+  WriteUnaligned32 ((UINT32 *)&HardDrive[12], (UINT32)(Seed * 0x10001 + 0x40000));
+  WriteUnaligned64 ((UINT64 *)&HardDrive[20], Seed * 0x9E3779B97F4A7C15ULL);
+  HardDrive[36] = MBR_TYPE_EFI_PARTITION_TABLE_HEADER;
+  HardDrive[37] = SIGNATURE_TYPE_GUID;
+  AppendNode (Path, Offset, MEDIA_DEVICE_PATH, MEDIA_HARDDRIVE_DP, HardDrive, sizeof (HardDrive));
+
+  AppendNode (Path, Offset, MEDIA_DEVICE_PATH, MEDIA_FILEPATH_DP, FileName, sizeof (FileName));
+}
+
+/**
+  Builds the SD card path and the load paths.  One in ten paths is under the SD card, one in
+  ten is USB, and the rest are as common as they are on a boot.
+
+**/
+STATIC
+VOID
+BuildLoadPaths (
+  VOID
+  )
+{
+  UINT8  Path[LOAD_PATH_MAX_SIZE];
+  UINT8  Data[40];
+  UINTN  Offset;
+  UINTN  Index;
+
+  Offset = 0;
+  AppendPciDevice (Path, &Offset, 0x1C, 0);
+  Data[0] = 0;                                                // SD slot.
+  AppendNode (Path, &Offset, MESSAGING_DEVICE_PATH, MSG_SD_DP, Data, 1);
+  mSdCardPath = AllocateCopyPool (Offset + END_DEVICE_PATH_LENGTH, Path);
+
+  for (Index = 0; Index < LOAD_PATH_COUNT; Index++) {
+    Offset = 0;
+    SetMem (Data, sizeof (Data), (UINT8)Index);
+    WriteUnaligned32 ((UINT32 *)Data, (UINT32)Index);
+
+    switch (Index % 10) {
+      case 0:
+      case 1:
+      case 2:
+      case 3:
+      case 4:
+        // A driver from a firmware volume.
+        AppendNode (Path, &Offset, MEDIA_DEVICE_PATH, MEDIA_PIWG_FW_VOL_DP, Data, sizeof (EFI_GUID));
+        AppendNode (Path, &Offset, MEDIA_DEVICE_PATH, MEDIA_PIWG_FW_FILE_DP, &Data[4], sizeof (EFI_GUID));
+        break;
+
+      case 5:
+        // An option ROM.
+        AppendPciDevice (Path, &Offset, (UINT8)(Index % 32), (UINT8)(Index % 8));
+        ZeroMem (Data, 20);
+        WriteUnaligned64 ((UINT64 *)&Data[12], 0xFFFF);
+        AppendNode (Path, &Offset, MEDIA_DEVICE_PATH, MEDIA_RELATIVE_OFFSET_RANGE_DP, Data, 20);
+        break;
+
+      case 6:
+        // A boot loader on NVMe.
+        AppendPciDevice (Path, &Offset, 0x1D, (UINT8)(Index % 8));
+        AppendNode (Path, &Offset, MESSAGING_DEVICE_PATH, MSG_NVME_NAMESPACE_DP, Data, 12);
+        AppendBootLoader (Path, &Offset, Index);
+        break;
+
+      case 7:
+        // A boot loader on SATA, or network boot.
+        AppendPciDevice (Path, &Offset, 0x17, 0);
+        if ((Index / 10) % 2 == 0) {
+          AppendNode (Path, &Offset, MESSAGING_DEVICE_PATH, MSG_SATA_DP, Data, 6);
+          AppendBootLoader (Path, &Offset, Index);
+        } else {
+          AppendNode (Path, &Offset, MESSAGING_DEVICE_PATH, MSG_MAC_ADDR_DP, Data, 33);
+          ZeroMem (Data, 23);
+          AppendNode (Path, &Offset, MESSAGING_DEVICE_PATH, MSG_IPv4_DP, Data, 23);
+        }
+
+        break;
+
+      case 8:
+        // A boot loader on a USB stick, through a hub.
+        AppendPciDevice (Path, &Offset, 0x14, 0);
+        Data[0] = (UINT8)(Index % 4);
+        Data[1] = 0;
+        AppendNode (Path, &Offset, MESSAGING_DEVICE_PATH, MSG_USB_DP, Data, 2);
+        Data[0] = (UINT8)(Index % 7);
+        AppendNode (Path, &Offset, MESSAGING_DEVICE_PATH, MSG_USB_DP, Data, 2);
+        AppendBootLoader (Path, &Offset, Index);
+        break;
+
+      default:
+        // A boot loader on the SD card.
+        Offset = GetDevicePathSize (mSdCardPath) - END_DEVICE_PATH_LENGTH;
+        CopyMem (Path, mSdCardPath, Offset);
+        AppendBootLoader (Path, &Offset, Index);
+        break;
+    }
+
+    mLoadPaths[Index] = AllocateCopyPool (Offset + END_DEVICE_PATH_LENGTH, Path);
+    ASSERT (mLoadPaths[Index] != NULL);
+  }
+}
+
+/**
+  Classifies a device path the way the LoadImage check did before the cache, including the
+  conversion to text that DEBUG builds did on every load.
+
+  @param[in]  DevicePath    The device path.
+  @param[out] Class         The class of the device path.
+
+**/
+STATIC
+VOID
+ClassifyUncached (
+  IN  CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  OUT DEVICE_PATH_CLASS               *Class
+  )
+{
+  CONST EFI_DEVICE_PATH_PROTOCOL  *Node;
+  EFI_DEVICE_PATH_PROTOCOL        *SdCardPath;
+  CHAR16                          *Text;
+  UINTN                           Size;
+  UINTN                           SdSize;
+
+  Class->IsSdCard = FALSE;
+  Class->IsUsb    = FALSE;
+
+  Text = ConvertDevicePathToText (DevicePath, TRUE, TRUE);
+  if (Text != NULL) {
+    mSink += Text[0];
+    FreePool (Text);
+  }
+
+  Size       = GetDevicePathSize (DevicePath);
+  SdCardPath = GetSdCardDevicePath ();
+  if (SdCardPath != NULL) {
+    Text = ConvertDevicePathToText (SdCardPath, TRUE, TRUE);
+    if (Text != NULL) {
+      mSink += Text[0];
+      FreePool (Text);
+    }
+
+    SdSize = GetDevicePathSize (SdCardPath);
+    if ((Size > SdSize) && (CompareMem (DevicePath, SdCardPath, SdSize - END_DEVICE_PATH_LENGTH) == 0)) {
+      Class->IsSdCard = TRUE;
+    }
+  }
+
+  for (Node = DevicePath; !IsDevicePathEnd (Node); Node = NextDevicePathNode (Node)) {
+    if ((DevicePathType (Node) == MESSAGING_DEVICE_PATH) &&
+        ((DevicePathSubType (Node) == MSG_USB_DP) ||
+         (DevicePathSubType (Node) == MSG_USB_WWID_DP) ||
+         (DevicePathSubType (Node) == MSG_USB_CLASS_DP)))
+    {
+      Class->IsUsb = TRUE;
+      break;
+    }
+  }
+}
+
+/**
+  Builds the load paths once for every test.
+
+  @param[in]  Context   Unused.
+
+  @retval     UNIT_TEST_PASSED    The paths are built.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+LoadPathsPrerequisite (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  if (mSdCardPath == NULL) {
+    BuildLoadPaths ();
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Checks the cached class of every load path against the uncached walk, over several rounds so
+  that both cache misses and hits are checked.
+
+  @param[in]  Context   Unused.
+
+  @retval     UNIT_TEST_PASSED                The test passed.
+  @retval     UNIT_TEST_ERROR_TEST_FAILED     The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+CachedClassesShouldMatch (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  DEVICE_PATH_CLASS  Cached;
+  DEVICE_PATH_CLASS  Expected;
+  UINTN              Round;
+  UINTN              Index;
+  UINTN              SdCardCount;
+  UINTN              UsbCount;
+
+  for (Round = 0; Round < 3; Round++) {
+    SdCardCount = 0;
+    UsbCount    = 0;
+
+    for (Index = 0; Index < LOAD_PATH_COUNT; Index++) {
+      UT_ASSERT_TRUE (IsDevicePathValid (mLoadPaths[Index], LOAD_PATH_MAX_SIZE));
+
+      ClassifyUncached (mLoadPaths[Index], &Expected);
+      GetDevicePathClass (mLoadPaths[Index], &Cached);
+
+      UT_ASSERT_EQUAL (Cached.IsSdCard, Expected.IsSdCard);
+      UT_ASSERT_EQUAL (Cached.IsUsb, Expected.IsUsb);
+
+      SdCardCount += Expected.IsSdCard ? 1 : 0;
+      UsbCount    += Expected.IsUsb ? 1 : 0;
+    }
+
+    UT_ASSERT_EQUAL (SdCardCount, LOAD_PATH_COUNT / 10);
+    UT_ASSERT_EQUAL (UsbCount, LOAD_PATH_COUNT / 10);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Times the uncached walk and the cache over every load path, and logs the time per load.
+
+  @param[in]  Context   Unused.
+
+  @retval     UNIT_TEST_PASSED    The times are logged.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BenchmarkDevicePathClass (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  DEVICE_PATH_CLASS  Class;
+  UINTN              Round;
+  UINTN              Index;
+  clock_t            Start;
+  clock_t            UncachedTicks;
+  clock_t            CachedTicks;
+  UINT64             Loads;
+
+  Loads = (UINT64)BENCHMARK_ROUNDS * LOAD_PATH_COUNT;
+
+  Start = clock ();
+  for (Round = 0; Round < BENCHMARK_ROUNDS; Round++) {
+    for (Index = 0; Index < LOAD_PATH_COUNT; Index++) {
+      ClassifyUncached (mLoadPaths[Index], &Class);
+      mSink += Class.IsUsb;
+    }
+  }
+
+  UncachedTicks = clock () - Start;
+
+  Start = clock ();
+  for (Round = 0; Round < BENCHMARK_ROUNDS; Round++) {
+    for (Index = 0; Index < LOAD_PATH_COUNT; Index++) {
+      GetDevicePathClass (mLoadPaths[Index], &Class);
+      mSink += Class.IsUsb;
+    }
+  }
+
+  CachedTicks = clock () - Start;
+
+  UT_LOG_INFO (
+    "%d load paths x %d rounds: uncached %ld ns/load, cached %ld ns/load\n",
+    LOAD_PATH_COUNT,
+    BENCHMARK_ROUNDS,
+    (long)((UINT64)UncachedTicks * 1000000000ULL / CLOCKS_PER_SEC / Loads),
+    (long)((UINT64)CachedTicks * 1000000000ULL / CLOCKS_PER_SEC / Loads)
+    );
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initializes the unit test framework, registers the tests and runs them.
+
+  @retval     EFI_SUCCESS           All tests were run.
+  @retval     EFI_OUT_OF_RESOURCES  The framework could not be set up.
+
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      ClassSuite;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&ClassSuite, Framework, "Device path class cache", "MsBootPolicyLib.DevicePathClass", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for ClassSuite\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (ClassSuite, "Cached classes should match the uncached walk", "Classes", CachedClassesShouldMatch, LoadPathsPrerequisite, NULL, NULL);
+  AddTestCase (ClassSuite, "Time per load, uncached and cached", "Benchmark", BenchmarkDevicePathClass, LoadPathsPrerequisite, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -0,0 +1,293 @@
+/** @file CtrDrbg.c
+
+  CTR_DRBG with AES-256 and no derivation function (NIST SP 800-90A section 10.2.1).
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseCryptLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+#include "CtrDrbg.h"
+
+/**
+  Increments V, a big-endian counter.
+
+  @param[in,out]  V   The counter.
+
+**/
+STATIC
+VOID
+IncrementV (
+  IN OUT UINT8  *V
+  )
+{
+  UINTN  Index;
+
+  for (Index = CTR_DRBG_BLOCK_SIZE; Index > 0; Index--) {
+    if (++V[Index - 1] != 0) {
+      break;
+    }
+  }
+}
+
+/**
+  Encrypts V with the current key.  A single block of CBC with a zero IV is ECB.
+
+  @param[in]  State   The DRBG.
+  @param[out] Block   CTR_DRBG_BLOCK_SIZE bytes of output.
+
+  @retval     TRUE    Block is encrypted.
+  @retval     FALSE   AES failed.
+
+**/
+STATIC
+BOOLEAN
+EncryptV (
+  IN  CTR_DRBG_STATE  *State,
+  OUT UINT8           *Block
+  )
+{
+  STATIC CONST UINT8  ZeroIv[CTR_DRBG_BLOCK_SIZE] = { 0 };
+
+  return AesCbcEncrypt (State->Aes, State->V, CTR_DRBG_BLOCK_SIZE, ZeroIv, Block);
+}
+
+/**
+  CTR_DRBG_Update: derives a new Key and V from the current ones and ProvidedData.
+
+  @param[in,out]  State         The DRBG.
+  @param[in]      ProvidedData  [Optional] CTR_DRBG_SEED_SIZE bytes.  NULL is all zeros.
+
+  @retval     TRUE    Key and V are updated.
+  @retval     FALSE   AES failed.
+
+**/
+STATIC
+BOOLEAN
+CtrDrbgUpdate (
+  IN OUT    CTR_DRBG_STATE  *State,
+  IN  CONST UINT8           *ProvidedData OPTIONAL
+  )
+{
+  UINT8    Temp[CTR_DRBG_SEED_SIZE];
+  UINTN    Offset;
+  BOOLEAN  Result = TRUE;
+
+  for (Offset = 0; Result && (Offset < sizeof (Temp)); Offset += CTR_DRBG_BLOCK_SIZE) {
+    IncrementV (State->V);
+    Result = EncryptV (State, &Temp[Offset]);
+  }
+
+  if (Result) {
+    if (ProvidedData != NULL) {
+      for (Offset = 0; Offset < sizeof (Temp); Offset++) {
+        Temp[Offset] ^= ProvidedData[Offset];
+      }
+    }
+
+    CopyMem (State->Key, Temp, CTR_DRBG_KEY_SIZE);
+    CopyMem (State->V, &Temp[CTR_DRBG_KEY_SIZE], CTR_DRBG_BLOCK_SIZE);
+    Result = AesInit (State->Aes, State->Key, CTR_DRBG_KEY_SIZE * 8);
+  }
+
+  ZeroMem (Temp, sizeof (Temp));
+  return Result;
+}
+
+/**
+  Sets the seed material for an instantiate or a reseed: Input XOR Extra.
+
+  @param[out] Seed    CTR_DRBG_SEED_SIZE bytes of seed material.
+  @param[in]  Input   CTR_DRBG_SEED_SIZE bytes of entropy input.
+  @param[in]  Extra   [Optional] CTR_DRBG_SEED_SIZE bytes to mix in.
+
+**/
+STATIC
+VOID
+GetSeedMaterial (
+  OUT       UINT8  *Seed,
+  IN  CONST UINT8  *Input,
+  IN  CONST UINT8  *Extra OPTIONAL
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < CTR_DRBG_SEED_SIZE; Index++) {
+    Seed[Index] = Input[Index] ^ ((Extra != NULL) ? Extra[Index] : 0);
+  }
+}
+
+/**
+  Instantiates a DRBG.
+
+  @param[out] State             DRBG to instantiate.
+  @param[in]  Entropy           CTR_DRBG_SEED_SIZE bytes of entropy input.
+  @param[in]  Personalization   [Optional] CTR_DRBG_SEED_SIZE bytes of personalization string.
+
+  @retval     EFI_SUCCESS             The DRBG is ready.
+  @retval     EFI_OUT_OF_RESOURCES    The AES context could not be allocated.
+  @retval     EFI_DEVICE_ERROR        AES failed.
+
+**/
+EFI_STATUS
+CtrDrbgInstantiate (
+  OUT       CTR_DRBG_STATE  *State,
+  IN  CONST UINT8           *Entropy,
+  IN  CONST UINT8           *Personalization OPTIONAL
+  )
+{
+  UINT8    Seed[CTR_DRBG_SEED_SIZE];
+  BOOLEAN  Result;
+
+  ZeroMem (State, sizeof (*State));
+
+  State->Aes = AllocatePool (AesGetContextSize ());
+  if (State->Aes == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  GetSeedMaterial (Seed, Entropy, Personalization);
+
+  Result = AesInit (State->Aes, State->Key, CTR_DRBG_KEY_SIZE * 8) &&
+           CtrDrbgUpdate (State, Seed);
+  ZeroMem (Seed, sizeof (Seed));
+
+  if (!Result) {
+    CtrDrbgUninstantiate (State);
+    return EFI_DEVICE_ERROR;
+  }
+
+  State->ReseedCounter = 1;
+  State->Instantiated  = TRUE;
+  return EFI_SUCCESS;
+}
+
+/**
+  Reseeds a DRBG.
+
+  @param[in,out]  State             The DRBG.
+  @param[in]      Entropy           CTR_DRBG_SEED_SIZE bytes of entropy input.
+  @param[in]      AdditionalInput   [Optional] CTR_DRBG_SEED_SIZE bytes of additional input.
+
+  @retval     EFI_SUCCESS             The DRBG is reseeded.
+  @retval     EFI_NOT_READY           The DRBG is not instantiated.
+  @retval     EFI_DEVICE_ERROR        AES failed.
+
+**/
+EFI_STATUS
+CtrDrbgReseed (
+  IN OUT    CTR_DRBG_STATE  *State,
+  IN  CONST UINT8           *Entropy,
+  IN  CONST UINT8           *AdditionalInput OPTIONAL
+  )
+{
+  UINT8    Seed[CTR_DRBG_SEED_SIZE];
+  BOOLEAN  Result;
+
+  if (!State->Instantiated) {
+    return EFI_NOT_READY;
+  }
+
+  GetSeedMaterial (Seed, Entropy, AdditionalInput);
+  Result = CtrDrbgUpdate (State, Seed);
+  ZeroMem (Seed, sizeof (Seed));
+
+  if (!Result) {
+    CtrDrbgUninstantiate (State);
+    return EFI_DEVICE_ERROR;
+  }
+
+  State->ReseedCounter = 1;
+  return EFI_SUCCESS;
+}
+
+/**
+  Generates random bytes.
+
+  @param[in,out]  State             The DRBG.
+  @param[out]     Output            Buffer for the random bytes.
+  @param[in]      OutputSize        Bytes to generate, at most CTR_DRBG_MAX_REQUEST.
+  @param[in]      AdditionalInput   [Optional] CTR_DRBG_SEED_SIZE bytes of additional input.
+
+  @retval     EFI_SUCCESS             Output holds OutputSize random bytes.
+  @retval     EFI_NOT_READY           The DRBG is not instantiated, or must be reseeded first.
+  @retval     EFI_INVALID_PARAMETER   OutputSize is too large.
+  @retval     EFI_DEVICE_ERROR        AES failed.
+
+**/
+EFI_STATUS
+CtrDrbgGenerate (
+  IN OUT    CTR_DRBG_STATE  *State,
+  OUT       UINT8           *Output,
+  IN        UINTN           OutputSize,
+  IN  CONST UINT8           *AdditionalInput OPTIONAL
+  )
+{
+  UINT8    Block[CTR_DRBG_BLOCK_SIZE];
+  UINTN    Size;
+  BOOLEAN  Result = TRUE;
+
+  if (!State->Instantiated || (State->ReseedCounter > CTR_DRBG_RESEED_INTERVAL)) {
+    return EFI_NOT_READY;
+  }
+
+  if (OutputSize > CTR_DRBG_MAX_REQUEST) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (AdditionalInput != NULL) {
+    Result = CtrDrbgUpdate (State, AdditionalInput);
+  }
+
+  while (Result && (OutputSize > 0)) {
+    IncrementV (State->V);
+    Result = EncryptV (State, Block);
+    if (!Result) {
+      break;
+    }
+
+    Size = MIN (OutputSize, sizeof (Block));
+    CopyMem (Output, Block, Size);
+    Output     += Size;
+    OutputSize -= Size;
+  }
+
+  ZeroMem (Block, sizeof (Block));
+
+  // Update the key so that the output can't be worked back from the state.
+  if (!Result || !CtrDrbgUpdate (State, AdditionalInput)) {
+    CtrDrbgUninstantiate (State);
+    return EFI_DEVICE_ERROR;
+  }
+
+  State->ReseedCounter++;
+  return EFI_SUCCESS;
+}
+
+/**
+  Scrubs a DRBG and frees its AES context.
+
+  @param[in,out]  State   The DRBG.
+
+**/
+VOID
+CtrDrbgUninstantiate (
+  IN OUT CTR_DRBG_STATE  *State
+  )
+{
+  if (State->Aes != NULL) {
+    ZeroMem (State->Aes, AesGetContextSize ());
+    FreePool (State->Aes);
+  }
+
+  ZeroMem (State, sizeof (*State));
+}
+
@@ -0,0 +1,107 @@
+/** @file -- CtrDrbg.h
+
+  CTR_DRBG with AES-256 and no derivation function (NIST SP 800-90A section 10.2.1).
+
+  The entropy input is a full seed, so it is used as is instead of being run through the
+  derivation function.  Additional input and the personalization string are optional and, if
+  present, are seed length bytes.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _CTR_DRBG_H_
+#define _CTR_DRBG_H_
+
+#define CTR_DRBG_KEY_SIZE    32
+#define CTR_DRBG_BLOCK_SIZE  16
+#define CTR_DRBG_SEED_SIZE   (CTR_DRBG_KEY_SIZE + CTR_DRBG_BLOCK_SIZE)
+
+//
+// Generate requests allowed between reseeds, and bytes allowed per request.  SP 800-90A allows
+// up to 2^48 requests of up to 2^19 bits.
+//
+#define CTR_DRBG_RESEED_INTERVAL  1024
+#define CTR_DRBG_MAX_REQUEST      0x10000
+
+typedef struct {
+  UINT8      Key[CTR_DRBG_KEY_SIZE];
+  UINT8      V[CTR_DRBG_BLOCK_SIZE];
+  UINT64     ReseedCounter;
+  BOOLEAN    Instantiated;
+  VOID       *Aes;                        // AES context for Key.
+} CTR_DRBG_STATE;
+
+/**
+  Instantiates a DRBG.
+
+  @param[out] State             DRBG to instantiate.
+  @param[in]  Entropy           CTR_DRBG_SEED_SIZE bytes of entropy input.
+  @param[in]  Personalization   [Optional] CTR_DRBG_SEED_SIZE bytes of personalization string.
+
+  @retval     EFI_SUCCESS             The DRBG is ready.
+  @retval     EFI_OUT_OF_RESOURCES    The AES context could not be allocated.
+  @retval     EFI_DEVICE_ERROR        AES failed.
+
+**/
+EFI_STATUS
+CtrDrbgInstantiate (
+  OUT       CTR_DRBG_STATE  *State,
+  IN  CONST UINT8           *Entropy,
+  IN  CONST UINT8           *Personalization OPTIONAL
+  );
+
+/**
+  Reseeds a DRBG.
+
+  @param[in,out]  State             The DRBG.
+  @param[in]      Entropy           CTR_DRBG_SEED_SIZE bytes of entropy input.
+  @param[in]      AdditionalInput   [Optional] CTR_DRBG_SEED_SIZE bytes of additional input.
+
+  @retval     EFI_SUCCESS             The DRBG is reseeded.
+  @retval     EFI_NOT_READY           The DRBG is not instantiated.
+  @retval     EFI_DEVICE_ERROR        AES failed.
+
+**/
+EFI_STATUS
+CtrDrbgReseed (
+  IN OUT    CTR_DRBG_STATE  *State,
+  IN  CONST UINT8           *Entropy,
+  IN  CONST UINT8           *AdditionalInput OPTIONAL
+  );
+
+/**
+  Generates random bytes.
+
+  @param[in,out]  State             The DRBG.
+  @param[out]     Output            Buffer for the random bytes.
+  @param[in]      OutputSize        Bytes to generate, at most CTR_DRBG_MAX_REQUEST.
+  @param[in]      AdditionalInput   [Optional] CTR_DRBG_SEED_SIZE bytes of additional input.
+
+  @retval     EFI_SUCCESS             Output holds OutputSize random bytes.
+  @retval     EFI_NOT_READY           The DRBG is not instantiated, or must be reseeded first.
+  @retval     EFI_INVALID_PARAMETER   OutputSize is too large.
+  @retval     EFI_DEVICE_ERROR        AES failed.
+
+**/
+EFI_STATUS
+CtrDrbgGenerate (
+  IN OUT    CTR_DRBG_STATE  *State,
+  OUT       UINT8           *Output,
+  IN        UINTN           OutputSize,
+  IN  CONST UINT8           *AdditionalInput OPTIONAL
+  );
+
+/**
+  Scrubs a DRBG and frees its AES context.
+
+  @param[in,out]  State   The DRBG.
+
+**/
+VOID
+CtrDrbgUninstantiate (
+  IN OUT CTR_DRBG_STATE  *State
+  );
+
+#endif
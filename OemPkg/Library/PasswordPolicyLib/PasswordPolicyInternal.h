@@ -38,6 +38,33 @@ typedef struct {
 
 #define PRIVATE_HASH_VER_1_VERSION_SIZE  sizeof(PRIVATE_HASH_VER_1)
 
+//
+// Version 2 Definitions
+//
+// The algorithm and iteration count are stored in the hash, so the cost can change without a new version.
+// New hashes use an iteration count calibrated to PcdPasswordHashTargetMs on the running CPU.
+//
+#define PRIVATE_HASH_VER_2_VERSION    2
+#define PRIVATE_HASH_VER_2_SALT_SIZE  32
+#define PRIVATE_HASH_VER_2_KEY_SIZE   SHA256_DIGEST_SIZE   // A single PBKDF2 block.
+
+#define PRIVATE_HASH_ALGORITHM_PBKDF2_SHA256  1
+
+typedef struct {
+  PASSWORD_HASH_HEADER    Header;
+  UINT16                  Algorithm;                    // PRIVATE_HASH_ALGORITHM_*
+  UINT32                  IterationCount;
+  UINT8                   Salt[PRIVATE_HASH_VER_2_SALT_SIZE];
+  UINT8                   Key[PRIVATE_HASH_VER_2_KEY_SIZE];
+} PRIVATE_HASH_VER_2;
+
+#define PRIVATE_HASH_VER_2_VERSION_SIZE  sizeof(PRIVATE_HASH_VER_2)
+
+//
+// Version used for new hashes.
+//
+#define PRIVATE_HASH_CURRENT_VERSION  PRIVATE_HASH_VER_2_VERSION
+
 #pragma pack()
 
 // Special version for Deleting a password
@@ -48,10 +75,14 @@ typedef struct {
 // Definitions for working with password tests.
 //
 typedef UINT32 PW_TEST_BITMAP;
-#define PW_TEST_STRING_NULL          (1 << 0)
-#define PW_TEST_STRING_TOO_SHORT     (1 << 1)
-#define PW_TEST_STRING_TOO_LONG      (1 << 2)
-#define PW_TEST_STRING_INVALID_CHAR  (1 << 3)
+#define PW_TEST_STRING_NULL             (1 << 0)
+#define PW_TEST_STRING_TOO_SHORT        (1 << 1)
+#define PW_TEST_STRING_TOO_LONG         (1 << 2)
+#define PW_TEST_STRING_INVALID_CHAR     (1 << 3)
+#define PW_TEST_STRING_TOO_FEW_CLASSES  (1 << 4)
+#define PW_TEST_STRING_REPEATED_CHAR    (1 << 5)
+#define PW_TEST_STRING_SEQUENCE         (1 << 6)
+#define PW_TEST_STRING_BANNED           (1 << 7)
 //
 // Data Store Union - A structure large enough to hold any password store.
 //
@@ -60,6 +91,7 @@ typedef union {
   PASSWORD_HASH_DELETED    Deleted;
   PASSWORD_HASH_HEADER     Hdr;
   PRIVATE_HASH_VER_1       Ver1;
+  PRIVATE_HASH_VER_2       Ver2;
 } INTERNAL_PASSWORD_HASH;
 
 #endif
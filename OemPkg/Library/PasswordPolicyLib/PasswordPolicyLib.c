@@ -9,8 +9,9 @@
 
 #include <PiDxe.h>
 
+#include <Protocol/MpService.h>
 #include <Protocol/MuPkcs5PasswordHash.h>
-#include <Protocol/Rng.h>               // Random number generation used for SALTs.
+#include <Protocol/Rng.h>               // Entropy for the DRBG that generates SALTs.
 
 #include <Library/BaseLib.h>
 #include <Library/BaseCryptLib.h>
@@ -18,9 +19,15 @@
 #include <Library/DebugLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/PasswordPolicyLib.h>
+#include <Library/PcdLib.h>
+#include <Library/RngLib.h>
+#include <Library/TimerLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 
+#include "CtrDrbg.h"
 #include "PasswordPolicyInternal.h"
+#include "PasswordPolicyRules.h"
+#include "Pbkdf2Sha256.h"
 
 typedef struct {
   UINT16    HashVersion;
@@ -28,49 +35,199 @@ typedef struct {
 } MS_PASSWORD_HASH;
 
 STATIC MS_PASSWORD_HASH  mPasswordHashVersions[] = {
-  { PRIVATE_HASH_VER_1_VERSION, sizeof (PRIVATE_HASH_VER_1) }
+  { PRIVATE_HASH_VER_1_VERSION, sizeof (PRIVATE_HASH_VER_1) },
+  { PRIVATE_HASH_VER_2_VERSION, sizeof (PRIVATE_HASH_VER_2) }
 };
 
-// A string containing all valid characters.
-STATIC CHAR16  *ValidChars = L"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789!@#$%^&*()?<>{}[]-_=+|.,;:'`~\"";
+// Iterations timed to calibrate the version 2 iteration count.
+#define PASSWORD_HASH_CALIBRATION_ITERATIONS  2000
+
+//
+// Background password hashes.  A task runs on an application processor when MP Services can
+// start one, and otherwise runs PASSWORD_HASH_SLICE_ITERATIONS iterations from each
+// PasswordPolicyPollPasswordHash () call.  The AP checks for cancellation between chunks.
+//
+// Slices are bounded by iterations rather than by time, so that polling doesn't depend on a
+// TimerLib.  4096 iterations take roughly 5 to 15 ms without the SHA extensions.
+//
+#define PASSWORD_HASH_TASK_SIGNATURE       SIGNATURE_32 ('P', 'W', 'H', 'T')
+#define PASSWORD_HASH_SLICE_ITERATIONS     4096
+#define PASSWORD_HASH_CHUNK_ITERATIONS     256
+
+struct _PASSWORD_HASH_TASK {
+  UINT32                    Signature;
+  PASSWORD_HASH             Store;
+  UINTN                     StoreSize;
+  EFI_STATUS                Status;           // Result once Pending is FALSE.
+  BOOLEAN                   Pending;          // The key in Store is still being derived by Pbkdf2.
+  BOOLEAN                   OnAp;             // Pbkdf2 is being run by an application processor.
+  volatile BOOLEAN          Cancel;           // Set by the BSP to stop the derivation.
+  volatile BOOLEAN          KeyReady;         // Set when Pbkdf2 has produced the key.
+  volatile BOOLEAN          ApDone;           // Set by the AP as the last thing it does with the task.
+  PBKDF2_SHA256_CONTEXT     Pbkdf2;
+};
 
 STATIC MU_PKCS5_PASSWORD_HASH_PROTOCOL  *mPkcs5Protocol = NULL;
 
+STATIC UINT32  mCalibratedIterationCount = 0;
+
+STATIC EFI_MP_SERVICES_PROTOCOL  *mMpServices = NULL;
+STATIC EFI_EVENT                 mApEvent     = NULL;     // Signaled by MP Services when the AP procedure returns.
+STATIC BOOLEAN                   mApBusy      = FALSE;    // mApEvent has not been signaled for the last AP started.
+
+//
+// Random bytes come from a CTR_DRBG that is seeded from both the RNG protocol and RngLib, and
+// reseeded every CTR_DRBG_RESEED_INTERVAL requests, so most requests don't reach the hardware.
+//
+STATIC CTR_DRBG_STATE  mDrbg;
+
+//
+// RNG protocol algorithms tried for entropy, in order.
+//
+STATIC EFI_GUID  *mEntropyAlgorithms[] = {
+  &gEfiRngAlgorithmRaw,
+  &gEfiRngAlgorithmSp80090Ctr256Guid,
+  &gEfiRngAlgorithmSp80090Hmac256Guid,
+  &gEfiRngAlgorithmSp80090Hash256Guid
+};
+
 /**
-  Determines whether a single character is valid.
+  Returns the size of a password store of the given version.
+
+  @param[in]  Version   Password store version.
+
+  @return     Size of the store, or 0 if the version is not recognized.
+
+**/
+STATIC
+UINTN
+GetPasswordStoreSize (
+  IN  UINT16  Version
+  )
+{
+  UINTN  Index;
 
-  CURRENT IMPLEMENTATION:
-    Search for character in valid char string.
-    Return TRUE if found.
+  for (Index = 0; Index < ARRAY_SIZE (mPasswordHashVersions); Index++) {
+    if (Version == mPasswordHashVersions[Index].HashVersion) {
+      return mPasswordHashVersions[Index].HashSize;
+    }
+  }
+
+  return 0;
+} // GetPasswordStoreSize()
 
-  @param[in]  Char    Character being evaluated.
+/**
+  Checks the fields that a version 2 store carries with it.
 
-  @retval     TRUE    Character is valid for a password.
+  @param[in]  Store   Version 2 password store.
+
+  @retval     TRUE    The algorithm is supported and the iteration count is usable.
   @retval     FALSE   Not.
 
 **/
 STATIC
 BOOLEAN
-IsValidChar (
-  IN  CHAR16  Char
+IsValidV2Store (
+  IN  CONST INTERNAL_PASSWORD_HASH  *Store
   )
 {
-  BOOLEAN  Result = FALSE;
-  UINTN    ValidCharsCount, Index;
+  return (BOOLEAN)((Store->Ver2.Algorithm == PRIVATE_HASH_ALGORITHM_PBKDF2_SHA256) &&
+                   (Store->Ver2.IterationCount != 0));
+} // IsValidV2Store()
 
-  // Assume FALSE unless the character is found.
+/**
+  Returns the time since a performance counter value.
 
-  // Search all valid characters for the character in question.
-  ValidCharsCount = StrLen (ValidChars);
-  for (Index = 0; Index < ValidCharsCount; Index++) {
-    if (Char == ValidChars[Index]) {
-      Result = TRUE;
-      break;
-    }
+  @param[in]  StartTicks    Performance counter value at the start of the interval.
+
+  @return     Elapsed time in nanoseconds.
+
+**/
+STATIC
+UINT64
+GetElapsedNanoSeconds (
+  IN  UINT64  StartTicks
+  )
+{
+  UINT64  EndTicks;
+  UINT64  CounterStart;
+  UINT64  CounterEnd;
+
+  EndTicks = GetPerformanceCounter ();
+  GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+  if (CounterStart > CounterEnd) {
+    return GetTimeInNanoSecond (StartTicks - EndTicks);
   }
 
-  return Result;
-} // IsValidChar()
+  return GetTimeInNanoSecond (EndTicks - StartTicks);
+} // GetElapsedNanoSeconds()
+
+/**
+  Measures how many PBKDF2 iterations take PcdPasswordHashTargetMs on this CPU.
+
+  The measurement is done once, the first time a new version 2 store is built.  The result
+  is limited to PcdPasswordHashMinIterations..PcdPasswordHashMaxIterations.  If the time
+  can't be measured, PcdPasswordHashMinIterations is used.
+
+  @return     Iteration count for new version 2 stores.
+
+**/
+STATIC
+UINT32
+GetCalibratedIterationCount (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       Password[PW_MIN_LENGTH * sizeof (CHAR16)];
+  UINT8       Salt[PRIVATE_HASH_VER_2_SALT_SIZE];
+  UINT8       Key[PRIVATE_HASH_VER_2_KEY_SIZE];
+  UINT64      StartTicks;
+  UINT64      ElapsedNs;
+  UINT64      Count;
+  UINT32      MinCount;
+  UINT32      MaxCount;
+
+  if (mCalibratedIterationCount != 0) {
+    return mCalibratedIterationCount;
+  }
+
+  MinCount = FixedPcdGet32 (PcdPasswordHashMinIterations);
+  MaxCount = MAX (FixedPcdGet32 (PcdPasswordHashMaxIterations), MinCount);
+
+  // Time the same computation a version 2 store uses, with a shorter iteration count.
+  //
+  SetMem (Password, sizeof (Password), 0x5A);
+  ZeroMem (Salt, sizeof (Salt));
+
+  StartTicks = GetPerformanceCounter ();
+  Status     = Pbkdf2Sha256 (Password, sizeof (Password), Salt, sizeof (Salt), PASSWORD_HASH_CALIBRATION_ITERATIONS, sizeof (Key), Key);
+  ElapsedNs  = GetElapsedNanoSeconds (StartTicks);
+
+  if (EFI_ERROR (Status) || (ElapsedNs == 0)) {
+    DEBUG ((DEBUG_WARN, "%a - Unable to time the password hash. Using the minimum iteration count.\n", __FUNCTION__));
+    Count = MinCount;
+  } else {
+    Count = DivU64x64Remainder (
+              MultU64x32 (MultU64x32 (FixedPcdGet32 (PcdPasswordHashTargetMs), 1000000), PASSWORD_HASH_CALIBRATION_ITERATIONS),
+              ElapsedNs,
+              NULL
+              );
+  }
+
+  mCalibratedIterationCount = (UINT32)MIN (MAX (Count, MinCount), MaxCount);
+
+  DEBUG ((
+    DEBUG_INFO,
+    "%a - %d iterations took %ld ns. Using %d iterations.\n",
+    __FUNCTION__,
+    PASSWORD_HASH_CALIBRATION_ITERATIONS,
+    ElapsedNs,
+    mCalibratedIterationCount
+    ));
+
+  return mCalibratedIterationCount;
+} // GetCalibratedIterationCount()
 
 /**
   This helper function will lookup and return the correct parameters
@@ -86,6 +243,8 @@ IsValidChar (
   @param[out] SaltSize    [Optional] Pointer used to return the correct salt size.
   @param[out] KeySize     [Optional] Pointer used to return the correct key size.
   @param[out] IterationCount  [Optional] Pointer used to return the correct iteration count.
+                              For version 2, this is the count for a new store.  Existing
+                              version 2 stores carry their own count.
 
   @retval     EFI_SUCCESS             Requested information has been returned.
   @retval     EFI_INVALID_PARAMETER   Unknown version requested.
@@ -103,101 +262,207 @@ GetPasswordStoreParameters (
 {
   DEBUG ((DEBUG_INFO, "%a: Entry\n", __FUNCTION__));
 
-  //
-  // Right off the bat, bail if we don't recognize the version.
-  // TODO: Update this test to include future versions if they're created.
-  if (Version != PRIVATE_HASH_VER_1_VERSION) {
-    return EFI_INVALID_PARAMETER;
-  }
+  switch (Version) {
+    case PRIVATE_HASH_VER_1_VERSION:
+      if (DigestSize) {
+        *DigestSize = PRIVATE_HASH_VER_1_HASH_DIGEST_SIZE;
+      }
 
-  //
-  // For now, we only have the one version, so we can
-  // quickly return these values if requested.
-  if (DigestSize) {
-    *DigestSize = PRIVATE_HASH_VER_1_HASH_DIGEST_SIZE;
-  }
+      if (SaltSize) {
+        *SaltSize = PRIVATE_HASH_VER_1_SALT_SIZE;
+      }
 
-  if (SaltSize) {
-    *SaltSize = PRIVATE_HASH_VER_1_SALT_SIZE;
-  }
+      if (KeySize) {
+        *KeySize = PRIVATE_HASH_VER_1_KEY_SIZE;
+      }
 
-  if (KeySize) {
-    *KeySize = PRIVATE_HASH_VER_1_KEY_SIZE;
-  }
+      if (IterationCount) {
+        *IterationCount = PRIVATE_HASH_VER_1_ITERATION_COUNT;
+      }
+
+      break;
+
+    case PRIVATE_HASH_VER_2_VERSION:
+      if (DigestSize) {
+        *DigestSize = SHA256_DIGEST_SIZE;
+      }
+
+      if (SaltSize) {
+        *SaltSize = PRIVATE_HASH_VER_2_SALT_SIZE;
+      }
+
+      if (KeySize) {
+        *KeySize = PRIVATE_HASH_VER_2_KEY_SIZE;
+      }
+
+      if (IterationCount) {
+        *IterationCount = GetCalibratedIterationCount ();
+      }
+
+      break;
 
-  if (IterationCount) {
-    *IterationCount = PRIVATE_HASH_VER_1_ITERATION_COUNT;
+    default:
+      return EFI_INVALID_PARAMETER;
   }
 
   return EFI_SUCCESS;
 } // GetPasswordStoreParameters()
 
 /**
-  Uses a pre-defined algorithm to generate a random SALT for
-  password hashing.
+  Gathers seed material for the DRBG from two sources: the RNG protocol and RngLib.  Either one
+  alone is enough.  A source that fails contributes zeros.
 
-  @param[out]  SaltBuffer     Pointer to the buffer where the SALT goes.
-  @param[in]   SaltBufferSize Size of the SALT buffer and number of random bytes requested.
+  @param[out] Entropy   CTR_DRBG_SEED_SIZE bytes from the RNG protocol.
+  @param[out] Extra     CTR_DRBG_SEED_SIZE bytes from RngLib, mixed in with Entropy.
 
-  @retval     TRUE    SALT generated and placed in SaltBuffer.
-  @retval     FALSE   SALT generation failed. Most likely due to insufficient entropy.
+  @retval     TRUE      At least one source produced its bytes.
+  @retval     FALSE     Neither did.
 
 **/
 STATIC
 BOOLEAN
-GenerateSalt (
-  OUT  UINT8  *SaltBuffer,
-  IN   UINTN  SaltBufferSize
+GetEntropyInput (
+  OUT UINT8  *Entropy,
+  OUT UINT8  *Extra
   )
 {
   EFI_STATUS        Status;
   EFI_RNG_PROTOCOL  *EfiRngProtocol;
+  BOOLEAN           HaveEntropy = FALSE;
+  BOOLEAN           HaveExtra   = TRUE;
+  UINT64            Random;
+  UINTN             Index;
 
-  DEBUG ((DEBUG_INFO, "%a: Entry\n", __FUNCTION__));
-
-  //
-  // SECURITY NOTE:
-  //  This currently leverages the RngProtocol -- which, in turn, leverages RDRAND -- as its
-  //  SOLE source of random. Before going to production, this method should be switched to a
-  //  shared method that pools entropy from multiple sources, rather than a single source.
-  //
+  ZeroMem (Entropy, CTR_DRBG_SEED_SIZE);
+  ZeroMem (Extra, CTR_DRBG_SEED_SIZE);
 
-  //
-  // Step 1: Locate the RNG protocol.
   Status = gBS->LocateProtocol (&gEfiRngProtocolGuid, NULL, (VOID **)&EfiRngProtocol);
+  for (Index = 0; !EFI_ERROR (Status) && !HaveEntropy && (Index < ARRAY_SIZE (mEntropyAlgorithms)); Index++) {
+    HaveEntropy = !EFI_ERROR (EfiRngProtocol->GetRNG (EfiRngProtocol, mEntropyAlgorithms[Index], CTR_DRBG_SEED_SIZE, Entropy));
+  }
 
-  //
-  // Step 2: Attempt to generate the random.
-  if (!EFI_ERROR (Status)) {
-    Status = EfiRngProtocol->GetRNG (
-                               EfiRngProtocol,                            // This
-                               &gEfiRngAlgorithmSp80090Ctr256Guid,        // RNGAlgorithm
-                               SaltBufferSize,                            // RNGValueLength
-                               SaltBuffer                                 // RNGValue
-                               );
-    if (!EFI_ERROR (Status)) {
-      return TRUE;
-    }
+  for (Index = 0; HaveExtra && (Index < CTR_DRBG_SEED_SIZE); Index += sizeof (Random)) {
+    HaveExtra = GetRandomNumber64 (&Random);
+    CopyMem (&Extra[Index], &Random, sizeof (Random));
+  }
 
-    Status = EfiRngProtocol->GetRNG (
-                               EfiRngProtocol,                             // This
-                               &gEfiRngAlgorithmSp80090Hmac256Guid,        // RNGAlgorithm
-                               SaltBufferSize,                             // RNGValueLength
-                               SaltBuffer                                  // RNGValue
-                               );
-    if (!EFI_ERROR (Status)) {
-      return TRUE;
+  Random = 0;
+
+  if (!HaveEntropy) {
+    DEBUG ((DEBUG_WARN, "%a - No entropy from the RNG protocol.\n", __FUNCTION__));
+    ZeroMem (Entropy, CTR_DRBG_SEED_SIZE);
+  }
+
+  if (!HaveExtra) {
+    DEBUG ((DEBUG_WARN, "%a - No entropy from RngLib.\n", __FUNCTION__));
+    ZeroMem (Extra, CTR_DRBG_SEED_SIZE);
+  }
+
+  return (BOOLEAN)(HaveEntropy || HaveExtra);
+} // GetEntropyInput()
+
+/**
+  Seeds the DRBG: instantiates it the first time, and reseeds it after that.
+
+  @retval     EFI_SUCCESS         The DRBG is ready for CTR_DRBG_RESEED_INTERVAL requests.
+  @retval     EFI_DEVICE_ERROR    There is no entropy.
+  @retval     Others              Error from CtrDrbgInstantiate () or CtrDrbgReseed ().
+
+**/
+STATIC
+EFI_STATUS
+SeedDrbg (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       Entropy[CTR_DRBG_SEED_SIZE];
+  UINT8       Extra[CTR_DRBG_SEED_SIZE];
+
+  if (!GetEntropyInput (Entropy, Extra)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  if (mDrbg.Instantiated) {
+    Status = CtrDrbgReseed (&mDrbg, Entropy, Extra);
+  } else {
+    Status = CtrDrbgInstantiate (&mDrbg, Entropy, Extra);
+  }
+
+  ZeroMem (Entropy, sizeof (Entropy));
+  ZeroMem (Extra, sizeof (Extra));
+
+  return Status;
+} // SeedDrbg()
+
+/**
+  Public interface for random bytes, such as salts, session keys and nonces.
+
+  The bytes come from a CTR_DRBG (NIST SP 800-90A) that this library seeds from the RNG protocol
+  and RngLib on first use, and reseeds every CTR_DRBG_RESEED_INTERVAL requests.
+
+  @param[out] Buffer  Buffer for the random bytes.
+  @param[in]  Size    Number of random bytes.
+
+  @retval     EFI_SUCCESS             Buffer holds Size random bytes.
+  @retval     EFI_INVALID_PARAMETER   Buffer is NULL.
+  @retval     EFI_DEVICE_ERROR        There is no entropy, or the DRBG failed.
+
+**/
+EFI_STATUS
+EFIAPI
+PasswordPolicyGetRandomBytes (
+  OUT UINT8  *Buffer,
+  IN  UINTN  Size
+  )
+{
+  EFI_STATUS  Status = EFI_SUCCESS;
+  UINTN       Chunk;
+
+  if ((Buffer == NULL) && (Size > 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (!mDrbg.Instantiated) {
+    Status = SeedDrbg ();
+  }
+
+  while (!EFI_ERROR (Status) && (Size > 0)) {
+    Chunk  = MIN (Size, CTR_DRBG_MAX_REQUEST);
+    Status = CtrDrbgGenerate (&mDrbg, Buffer, Chunk, NULL);
+    if (Status == EFI_NOT_READY) {
+      // Reseed, or instantiate again after an error.
+      Status = SeedDrbg ();
+      continue;
     }
 
-    Status = EfiRngProtocol->GetRNG (
-                               EfiRngProtocol,                             // This
-                               &gEfiRngAlgorithmSp80090Hash256Guid,        // RNGAlgorithm
-                               SaltBufferSize,                             // RNGValueLength
-                               SaltBuffer                                  // RNGValue
-                               );
+    Buffer += Chunk;
+    Size   -= Chunk;
   }
 
-  return !EFI_ERROR (Status);
+  return Status;
+} // PasswordPolicyGetRandomBytes()
+
+/**
+  Generates a random SALT for password hashing.
+
+  @param[out]  SaltBuffer     Pointer to the buffer where the SALT goes.
+  @param[in]   SaltBufferSize Size of the SALT buffer and number of random bytes requested.
+
+  @retval     TRUE    SALT generated and placed in SaltBuffer.
+  @retval     FALSE   SALT generation failed. Most likely due to insufficient entropy.
+
+**/
+STATIC
+BOOLEAN
+GenerateSalt (
+  OUT  UINT8  *SaltBuffer,
+  IN   UINTN  SaltBufferSize
+  )
+{
+  DEBUG ((DEBUG_INFO, "%a: Entry\n", __FUNCTION__));
+
+  return !EFI_ERROR (PasswordPolicyGetRandomBytes (SaltBuffer, SaltBufferSize));
 } // GenerateSalt()
 
 /**
@@ -206,31 +471,39 @@ GenerateSalt (
   IMPORTANT: Password must be copied to a fresh buffer by SafeCopyPassword().
              This function does not perform any bounds checking on the password.
 
-  @param[in]  OldStore    If present, OldStore Salt is used, otherwise, a new Salt is generated
-  @param[in]  Store       A pointer to an empty VER_1 hash structure to be populated.
+  @param[in]  OldStore    If present, the store is built with the version, salt and (for version 2)
+                          iteration count of OldStore.  Otherwise, a new current-version store is
+                          built with a new salt.
+  @param[in]  Store       A pointer to an empty hash structure, large enough for the version, to be populated.
   @param[in]  Password    A pointer to the password buffer to be operated upon.
+  @param[out] Pbkdf2      [Optional] If present and the key is derived with Pbkdf2Sha256 (), the derivation
+                          is only started in Pbkdf2.  The caller runs it to fill in the key.
 
   @retval     EFI_SUCCESS           Everything's groovy! Your password store has been built.
+  @retval     EFI_NOT_READY         The store is built except for the key, which Pbkdf2 will produce.
   @retval     EFI_INVALID_PARAMETER The version was not recognized. Returned by GetPasswordStoreParameters().
   @retval     EFI_OUT_OF_RESOURCES  There was insufficient entropy to generate the SALT.
   @retval     EFI_ABORTED           Password was too long.
-  @retval     Others                Error was returned from Pkcs5HashPassword().
+  @retval     Others                Error was returned from Pbkdf2Sha256() or Pkcs5HashPassword().
 
 **/
 STATIC
 EFI_STATUS
-BuildV1PasswordStore (
+BuildPasswordStore (
   IN       INTERNAL_PASSWORD_HASH  *OldStore OPTIONAL,
   IN       INTERNAL_PASSWORD_HASH  *Store,
-  IN CONST CHAR16                  *Password
+  IN CONST CHAR16                  *Password,
+  OUT      PBKDF2_SHA256_CONTEXT   *Pbkdf2 OPTIONAL
   )
 {
   EFI_STATUS  Status = EFI_SUCCESS;
+  UINT16      Version;
   UINTN       SaltSize;
   UINTN       DigestSize;
   UINTN       KeySize;
   UINTN       IterationCount;
   UINT8       *SaltBuffer;
+  UINT8       *OldSaltBuffer;
   UINT8       *KeyBuffer;
   UINTN       PasswordSize;
 
@@ -243,25 +516,91 @@ BuildV1PasswordStore (
   //
   // Step 1: Let's set up all the parameters.
   // NOTE: If this is an unknown version, GetPasswordStoreParameters() will return EFI_INVALID_PARAMETER.
-  Status = GetPasswordStoreParameters (PRIVATE_HASH_VER_1_VERSION, &DigestSize, &SaltSize, &KeySize, &IterationCount);
+  // NOTE: An existing version 2 store carries its own iteration count, so don't calibrate a new one.
+  Version = (OldStore != NULL) ? OldStore->Hdr.Version : PRIVATE_HASH_CURRENT_VERSION;
+  Status  = GetPasswordStoreParameters (
+              Version,
+              &DigestSize,
+              &SaltSize,
+              &KeySize,
+              ((OldStore != NULL) && (Version == PRIVATE_HASH_VER_2_VERSION)) ? NULL : &IterationCount
+              );
   if (EFI_ERROR (Status)) {
     return Status;
   }
 
-  Store->Ver1.Header.Version = PRIVATE_HASH_VER_1_VERSION;
+  if (Version == PRIVATE_HASH_VER_1_VERSION) {
+    Store->Ver1.Header.Version = PRIVATE_HASH_VER_1_VERSION;
 
-  SaltBuffer = &Store->Ver1.Salt[0];
-  KeyBuffer  = &Store->Ver1.Key[0];
+    SaltBuffer    = &Store->Ver1.Salt[0];
+    KeyBuffer     = &Store->Ver1.Key[0];
+    OldSaltBuffer = (OldStore != NULL) ? &OldStore->Ver1.Salt[0] : NULL;
+  } else {
+    if (OldStore != NULL) {
+      IterationCount = OldStore->Ver2.IterationCount;
+    }
+
+    Store->Ver2.Header.Version = PRIVATE_HASH_VER_2_VERSION;
+    Store->Ver2.Algorithm      = PRIVATE_HASH_ALGORITHM_PBKDF2_SHA256;
+    Store->Ver2.IterationCount = (UINT32)IterationCount;
+
+    SaltBuffer    = &Store->Ver2.Salt[0];
+    KeyBuffer     = &Store->Ver2.Key[0];
+    OldSaltBuffer = (OldStore != NULL) ? &OldStore->Ver2.Salt[0] : NULL;
+  }
 
   //
   // Step 2: If we need to provide the salt, let's do that now.
   //
-  if (NULL == OldStore) {
+  if (NULL == OldSaltBuffer) {
     if (!GenerateSalt (SaltBuffer, SaltSize)) {
       return EFI_OUT_OF_RESOURCES;
     }
   } else {
-    CopyMem (&Store->Ver1.Salt, OldStore->Ver1.Salt, SaltSize);
+    CopyMem (SaltBuffer, OldSaltBuffer, SaltSize);
+  }
+
+  // First, get the number of CHARs in the password.
+  PasswordSize = StrLen (Password);
+  // Now check for possible overflow.
+  if ((PasswordSize * sizeof (*Password)) < PasswordSize) {
+    DEBUG ((DEBUG_ERROR, "%a - Password is too long!\n", __FUNCTION__));
+    return EFI_ABORTED;
+  }
+
+  PasswordSize = PasswordSize * sizeof (*Password);
+
+  //
+  // Populate the key.  Pbkdf2Sha256() computes the output blocks side by side, and produces the
+  // same key as the PKCS5 protocol.  The protocol is only used for parameters it doesn't handle.
+  ZeroMem (KeyBuffer, KeySize);
+  if ((DigestSize == SHA256_DIGEST_SIZE) && (Pbkdf2 != NULL)) {
+    Status = Pbkdf2Sha256Init (
+               Pbkdf2,
+               (CONST UINT8 *)Password,
+               PasswordSize,
+               SaltBuffer,
+               SaltSize,
+               IterationCount,
+               KeySize,
+               KeyBuffer
+               );
+    if (Status != EFI_UNSUPPORTED) {
+      return EFI_ERROR (Status) ? Status : EFI_NOT_READY;
+    }
+  } else if (DigestSize == SHA256_DIGEST_SIZE) {
+    Status = Pbkdf2Sha256 (
+               (CONST UINT8 *)Password,
+               PasswordSize,
+               SaltBuffer,
+               SaltSize,
+               IterationCount,
+               KeySize,
+               KeyBuffer
+               );
+    if (Status != EFI_UNSUPPORTED) {
+      return Status;
+    }
   }
 
   if (mPkcs5Protocol == NULL) {
@@ -277,20 +616,7 @@ BuildV1PasswordStore (
     }
   }
 
-  // First, get the number of CHARs in the password.
-  PasswordSize = StrLen (Password);
-  // Now check for possible overflow.
-  if ((PasswordSize * sizeof (*Password)) < PasswordSize) {
-    DEBUG ((DEBUG_ERROR, "%a - Password is too long!\n", __FUNCTION__));
-    return EFI_ABORTED;
-  }
-
-  PasswordSize = PasswordSize * sizeof (*Password);
-
-  //
-  // Finally, populate the key.
-  ZeroMem (KeyBuffer, KeySize);
-  if (!EFI_ERROR (Status) && (mPkcs5Protocol != NULL)) {
+  if (mPkcs5Protocol != NULL) {
     Status = mPkcs5Protocol->HashPassword (
                                mPkcs5Protocol,
                                PasswordSize,        // PasswordSize
@@ -305,7 +631,7 @@ BuildV1PasswordStore (
   }
 
   return Status;
-} // BuildV1PasswordStore()
+} // BuildPasswordStore()
 
 /**
   Copies a password to a buffer, but will only copy the maximum
@@ -395,9 +721,9 @@ PasswordPolicyIsPwStringValid (
   OUT       PW_TEST_BITMAP  *Failures OPTIONAL
   )
 {
-  BOOLEAN  Result = TRUE;
-  UINTN    StringLen = 0, Index;
-  CHAR16   TempPassword[PW_MAX_LENGTH + 1];   // Maximum password length plus a NULL terminator.
+  BOOLEAN         Result = TRUE;
+  PW_TEST_BITMAP  RuleFailures;
+  CHAR16          TempPassword[PW_MAX_LENGTH + 1];   // Maximum password length plus a NULL terminator.
 
   DEBUG ((DEBUG_INFO, "%a: Entry\n", __FUNCTION__));
 
@@ -438,35 +764,19 @@ PasswordPolicyIsPwStringValid (
   //
 
   //
-  // Step 2: Check for strings that are too short.
+  // Step 2: Run the password rules: length, characters, and then strength.
   if (Result || Failures) {
-    // Run this test if either the last test passed or we want detailed results.
-    StringLen = StrLen (TempPassword);
-    if (StringLen < PW_MIN_LENGTH) {
+    // Run the rules if either the last test passed or we want detailed results.
+    RuleFailures = CheckPasswordRules (TempPassword, FALSE, (BOOLEAN)(Failures != NULL));
+    if (RuleFailures != 0) {
       if (Failures) {
-        *Failures |= PW_TEST_STRING_TOO_SHORT;
+        *Failures |= RuleFailures;
       }
 
       Result = FALSE;
     }
   }
 
-  //
-  // Step 3: Make sure that the string does not contain invalid characters.
-  if (Result || Failures) {
-    // Run this test if either the last test passed or we want detailed results.
-    for (Index = 0; Index < StringLen; Index++) {
-      if (!IsValidChar (TempPassword[Index])) {
-        if (Failures) {
-          *Failures |= PW_TEST_STRING_INVALID_CHAR;
-        }
-
-        Result = FALSE;
-        break;
-      }
-    }
-  }
-
   // Always put away your toys.
   PasswordPolicyCleansePwBuffer (TempPassword, sizeof (TempPassword));
 
@@ -477,7 +787,8 @@ PasswordPolicyIsPwStringValid (
   Public interface for validating a password hash.
 
   Will run internal checks on the password hash to verify that it has a supported
-  version and proper length.
+  version and proper length.  Version 2 hashes must also carry a supported algorithm
+  and a non-zero iteration count.
 
   @param[in]  PasswordHash            Pointer to the buffer containing the hash
   @param[in]  PasswordHashSize        Size of the buffer containing the hash.
@@ -495,7 +806,6 @@ PasswordPolicyValidatePasswordHash (
   )
 {
   CONST INTERNAL_PASSWORD_HASH  *PwdHash;
-  UINTN                         i;
   EFI_STATUS                    Status;
 
   DEBUG ((DEBUG_INFO, "%a: Entry\n", __FUNCTION__));
@@ -514,13 +824,9 @@ PasswordPolicyValidatePasswordHash (
     return EFI_SUCCESS;
   }
 
-  for (i = 0; i < ARRAY_SIZE (mPasswordHashVersions); i++) {
-    if (PwdHash->Hdr.Version == mPasswordHashVersions[i].HashVersion) {
-      if (PasswordHashSize == mPasswordHashVersions[i].HashSize) {
-        Status = EFI_SUCCESS;
-      }
-
-      break;
+  if (PasswordHashSize == GetPasswordStoreSize (PwdHash->Hdr.Version)) {
+    if ((PwdHash->Hdr.Version != PRIVATE_HASH_VER_2_VERSION) || IsValidV2Store (PwdHash)) {
+      Status = EFI_SUCCESS;
     }
   }
 
@@ -532,7 +838,31 @@ PasswordPolicyValidatePasswordHash (
 }
 
 /**
-  Public interface for generating the password hash.
+  Checks the length and the characters of a password.  The strength rules are left to
+  PasswordPolicyIsPwStringValid (), so that a stored password still hashes after the policy
+  is tightened.
+
+  @param[in]  Password  The password.
+
+  @retval     TRUE      The password can be hashed.
+  @retval     FALSE     Not.
+
+**/
+STATIC
+BOOLEAN
+IsPasswordFormatValid (
+  IN  CONST CHAR16  *Password
+  )
+{
+  if (StrnLenS (Password, PW_MAX_LENGTH + 1) > PW_MAX_LENGTH) {
+    return FALSE;
+  }
+
+  return (BOOLEAN)(CheckPasswordRules (Password, TRUE, FALSE) == 0);
+}
+
+/**
+  Generates a password hash, or starts generating it.
 
   Will run internal checks on the password before setting it. Returns an
   error if the password cannot be set.
@@ -541,28 +871,32 @@ PasswordPolicyValidatePasswordHash (
   @param[in]  Password              Pointer to a buffer containing the clear text password.
                                     If Password == NULL, generate a no-password "hash"
   @param[out] PasswordHash          Pointer to a pointer that will contain the address of the password hash
-                                    OldSalt == NULL : Version, Salt, and Key fields stored.
-                                    OldSalt != NULL : Key field updated using existing Version and Salt.
+                                    OldSalt == NULL : Current version with a new Salt and calibrated parameters.
+                                    OldSalt != NULL : Key field updated using existing Version, Salt and parameters.
   @param[out] PasswordHashSize      Pointer where to store the new has size
+  @param[out] Pbkdf2                [Optional] Passed to BuildPasswordStore ().
 
   @retval   EFI_SUCCESS             Requested operation has been successfully performed.
+  @retval   EFI_NOT_READY           PasswordHash was returned, but its key is still to be derived by Pbkdf2.
   @retval   EFI_INVALID_PARAMETER   There is something wrong with the formatting of
                                     the NewPassword.
   @retval   <other>                 Something else went wrong with the internal logic.
 
 **/
+STATIC
 EFI_STATUS
-EFIAPI
-PasswordPolicyGeneratePasswordHash (
-  IN   CONST PASSWORD_HASH  OldSalt   OPTIONAL,
-  IN   CONST CHAR16         *Password  OPTIONAL,
-  OUT        PASSWORD_HASH  *PasswordHash,
-  OUT        UINTN          *PasswordHashSize
+GeneratePasswordStore (
+  IN   CONST PASSWORD_HASH          OldSalt   OPTIONAL,
+  IN   CONST CHAR16                 *Password  OPTIONAL,
+  OUT        PASSWORD_HASH          *PasswordHash,
+  OUT        UINTN                  *PasswordHashSize,
+  OUT        PBKDF2_SHA256_CONTEXT  *Pbkdf2 OPTIONAL
   )
 {
   EFI_STATUS              Status = EFI_SUCCESS;
   INTERNAL_PASSWORD_HASH  *PwdHash;
   INTERNAL_PASSWORD_HASH  *OldStore;
+  UINTN                   HashSize;
 
   DEBUG ((DEBUG_INFO, "%a: Entry\n", __FUNCTION__));
 
@@ -570,7 +904,7 @@ PasswordPolicyGeneratePasswordHash (
   if ((PasswordHash == NULL) ||
       (PasswordHashSize == NULL) ||
       ((Password == NULL) && (OldSalt != NULL)) || // OldSalt cannot be present if Password == NULL
-      ((Password != NULL) && !PasswordPolicyIsPwStringValid (Password, NULL)))
+      ((Password != NULL) && !IsPasswordFormatValid (Password)))
   {
     Status = EFI_INVALID_PARAMETER;
     goto Exit;
@@ -592,34 +926,450 @@ PasswordPolicyGeneratePasswordHash (
   OldStore = (INTERNAL_PASSWORD_HASH *)OldSalt;
 
   if (NULL != OldStore) {
-    if (OldStore->Ver1.Header.Version != PRIVATE_HASH_VER_1_VERSION) {
-      Status = EFI_INVALID_PARAMETER;   // Currently, only support V1 password hash.
+    HashSize = GetPasswordStoreSize (OldStore->Hdr.Version);
+    if ((HashSize == 0) ||
+        ((OldStore->Hdr.Version == PRIVATE_HASH_VER_2_VERSION) && !IsValidV2Store (OldStore)))
+    {
+      Status = EFI_INVALID_PARAMETER;
       goto Exit;
     }
+  } else {
+    HashSize = GetPasswordStoreSize (PRIVATE_HASH_CURRENT_VERSION);
   }
 
-  PwdHash = (INTERNAL_PASSWORD_HASH *)AllocateZeroPool (PRIVATE_HASH_VER_1_VERSION_SIZE);
+  PwdHash = (INTERNAL_PASSWORD_HASH *)AllocateZeroPool (HashSize);
   if (NULL == PwdHash) {
     Status = EFI_OUT_OF_RESOURCES;
     goto Exit;
   }
 
   // Now build the store.
-  Status = BuildV1PasswordStore (
-             OldStore,                             // Old Salt? (Old PwdHash has old Salt)
+  Status = BuildPasswordStore (
+             OldStore,                             // Old Salt? (Old PwdHash has old Version, Salt and parameters)
              PwdHash,                              // Store
-             Password
-             );                                    // Password
-  if (EFI_ERROR (Status)) {
+             Password,                             // Password
+             Pbkdf2                                // Deferred key derivation?
+             );
+  if (EFI_ERROR (Status) && (Status != EFI_NOT_READY)) {
+    FreePool (PwdHash);
     Status = EFI_ABORTED;
     goto Exit;
   }
 
   *PasswordHash     = &PwdHash->HashBytes;
-  *PasswordHashSize = sizeof (PRIVATE_HASH_VER_1);
+  *PasswordHashSize = HashSize;
 
 Exit:
   DEBUG ((DEBUG_INFO, "%a: Exit. Code=%r\n", __FUNCTION__, Status));
 
   return Status;
+} // GeneratePasswordStore()
+
+/**
+  Public interface for generating the password hash.
+
+  Will run internal checks on the password before setting it. Returns an
+  error if the password cannot be set.
+
+  @param[in]  OldSalt               Pass in old PASSWORD_HASH to use the existing salt
+  @param[in]  Password              Pointer to a buffer containing the clear text password.
+                                    If Password == NULL, generate a no-password "hash"
+  @param[out] PasswordHash          Pointer to a pointer that will contain the address of the password hash
+                                    OldSalt == NULL : Current version with a new Salt and calibrated parameters.
+                                    OldSalt != NULL : Key field updated using existing Version, Salt and parameters.
+  @param[out] PasswordHashSize      Pointer where to store the new has size
+
+  @retval   EFI_SUCCESS             Requested operation has been successfully performed.
+  @retval   EFI_INVALID_PARAMETER   There is something wrong with the formatting of
+                                    the NewPassword.
+  @retval   <other>                 Something else went wrong with the internal logic.
+
+**/
+EFI_STATUS
+EFIAPI
+PasswordPolicyGeneratePasswordHash (
+  IN   CONST PASSWORD_HASH  OldSalt   OPTIONAL,
+  IN   CONST CHAR16         *Password  OPTIONAL,
+  OUT        PASSWORD_HASH  *PasswordHash,
+  OUT        UINTN          *PasswordHashSize
+  )
+{
+  return GeneratePasswordStore (OldSalt, Password, PasswordHash, PasswordHashSize, NULL);
 } // PasswordSupportGeneratePasswordHash()
+
+/**
+  Public interface for determining whether a password hash was built with the current
+  version and parameters.
+
+  A hash that is not current still validates.  Callers that have just authenticated the
+  password should replace it with a new hash from PasswordPolicyGeneratePasswordHash().
+
+  @param[in]  PasswordHash            Pointer to the buffer containing the hash.
+  @param[in]  PasswordHashSize        Size of the buffer containing the hash.
+
+  @retval     TRUE      The hash is current, or is the no-password hash.
+  @retval     FALSE     The hash should be regenerated.
+
+**/
+BOOLEAN
+EFIAPI
+PasswordPolicyIsPasswordHashCurrent (
+  IN  CONST PASSWORD_HASH  PasswordHash,
+  IN        UINTN          PasswordHashSize
+  )
+{
+  CONST INTERNAL_PASSWORD_HASH  *PwdHash;
+
+  if (EFI_ERROR (PasswordPolicyValidatePasswordHash (PasswordHash, PasswordHashSize))) {
+    return FALSE;
+  }
+
+  PwdHash = (INTERNAL_PASSWORD_HASH *)PasswordHash;
+  if ((PasswordHashSize >= PASSWORD_HASH_VER_DELETE_SIZE) &&
+      (PwdHash->Deleted.DeletedHash == PASSWORD_HASH_VER_DELETE))
+  {
+    return TRUE;
+  }
+
+  // A version 2 hash is kept while its iteration count is within the platform limits, rather
+  // than being rebuilt whenever the calibration measures a slightly different count.
+  //
+  return (BOOLEAN)((PwdHash->Hdr.Version == PRIVATE_HASH_CURRENT_VERSION) &&
+                   (PwdHash->Ver2.Algorithm == PRIVATE_HASH_ALGORITHM_PBKDF2_SHA256) &&
+                   (PwdHash->Ver2.IterationCount >= FixedPcdGet32 (PcdPasswordHashMinIterations)) &&
+                   (PwdHash->Ver2.IterationCount <= FixedPcdGet32 (PcdPasswordHashMaxIterations)));
+} // PasswordPolicyIsPasswordHashCurrent()
+
+/**
+  Runs the key derivation of a password hash task on an application processor.
+
+  This runs on the AP, so it must not use boot services or DEBUG output.
+
+  @param[in,out]  Buffer    The PASSWORD_HASH_TASK.
+
+**/
+STATIC
+VOID
+EFIAPI
+PasswordHashApProcedure (
+  IN OUT VOID  *Buffer
+  )
+{
+  PASSWORD_HASH_TASK  *Task;
+
+  Task = (PASSWORD_HASH_TASK *)Buffer;
+
+  while (!Task->Cancel) {
+    if (Pbkdf2Sha256Update (&Task->Pbkdf2, PASSWORD_HASH_CHUNK_ITERATIONS)) {
+      Task->KeyReady = TRUE;
+      break;
+    }
+  }
+
+  // The BSP may free the task as soon as it sees ApDone.
+  //
+  MemoryFence ();
+  Task->ApDone = TRUE;
+} // PasswordHashApProcedure()
+
+/**
+  Tries to start the key derivation of a task on an enabled application processor.
+
+  Only one task runs on an AP at a time.  MP Services signals mApEvent some time after the
+  procedure returns, so the next task can't use an AP until the last one has been reaped.
+
+  @param[in]  Task    The task.  Task->Pbkdf2 has been initialized.
+
+  @retval     EFI_SUCCESS       An AP is running the derivation.
+  @retval     EFI_NOT_READY     The AP from the last task is still busy.
+  @retval     Others            MP Services is not available, or no AP could be started.
+
+**/
+STATIC
+EFI_STATUS
+StartPasswordHashOnAp (
+  IN  PASSWORD_HASH_TASK  *Task
+  )
+{
+  EFI_STATUS                 Status;
+  EFI_PROCESSOR_INFORMATION  ProcessorInfo;
+  UINTN                      BspNumber;
+  UINTN                      ProcessorCount;
+  UINTN                      EnabledCount;
+  UINTN                      Index;
+
+  if (mMpServices == NULL) {
+    Status = gBS->LocateProtocol (&gEfiMpServiceProtocolGuid, NULL, (VOID **)&mMpServices);
+    if (EFI_ERROR (Status)) {
+      mMpServices = NULL;
+      return Status;
+    }
+  }
+
+  if (mApEvent == NULL) {
+    Status = gBS->CreateEvent (0, TPL_CALLBACK, NULL, NULL, &mApEvent);
+    if (EFI_ERROR (Status)) {
+      mApEvent = NULL;
+      return Status;
+    }
+  }
+
+  if (mApBusy) {
+    if (gBS->CheckEvent (mApEvent) != EFI_SUCCESS) {
+      return EFI_NOT_READY;
+    }
+
+    mApBusy = FALSE;
+  }
+
+  Status = mMpServices->WhoAmI (mMpServices, &BspNumber);
+  if (!EFI_ERROR (Status)) {
+    Status = mMpServices->GetNumberOfProcessors (mMpServices, &ProcessorCount, &EnabledCount);
+  }
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = EFI_NOT_FOUND;
+  for (Index = 0; Index < ProcessorCount; Index++) {
+    if (Index == BspNumber) {
+      continue;
+    }
+
+    if (EFI_ERROR (mMpServices->GetProcessorInfo (mMpServices, Index, &ProcessorInfo)) ||
+        ((ProcessorInfo.StatusFlag & PROCESSOR_ENABLED_BIT) == 0) ||
+        ((ProcessorInfo.StatusFlag & PROCESSOR_HEALTH_STATUS_BIT) == 0))
+    {
+      continue;
+    }
+
+    Status = mMpServices->StartupThisAP (
+                            mMpServices,
+                            PasswordHashApProcedure,
+                            Index,
+                            mApEvent,
+                            0,                  // No timeout.  The task can be cancelled instead.
+                            Task,
+                            NULL
+                            );
+    if (!EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_INFO, "%a - Password hash started on processor %d.\n", __FUNCTION__, Index));
+      mApBusy = TRUE;
+      return EFI_SUCCESS;
+    }
+  }
+
+  return Status;
+} // StartPasswordHashOnAp()
+
+/**
+  Returns how much of a task's key derivation is done.
+
+  @param[in]  Task    The task.
+
+  @return     Percentage complete, 0 to 100.
+
+**/
+STATIC
+UINTN
+GetPasswordHashProgress (
+  IN  PASSWORD_HASH_TASK  *Task
+  )
+{
+  if (!Task->Pending || (Task->Pbkdf2.TotalIterations == 0)) {
+    return 100;
+  }
+
+  return MIN ((Task->Pbkdf2.IterationsDone * 100) / Task->Pbkdf2.TotalIterations, 99);
+} // GetPasswordHashProgress()
+
+/**
+  Public interface for starting a password hash in the background.
+
+  Takes the same inputs as PasswordPolicyGeneratePasswordHash ().  The key derivation runs on
+  an application processor when MP Services can start one.  Otherwise it runs a slice at a
+  time from PasswordPolicyPollPasswordHash ().  Hashes that don't use the PBKDF2-SHA256
+  derivation are computed before this returns.
+
+  The password is not needed after this returns.
+
+  @param[in]  OldSalt               Pass in old PASSWORD_HASH to use the existing salt
+  @param[in]  Password              Pointer to a buffer containing the clear text password.
+                                    If Password == NULL, generate a no-password "hash"
+  @param[out] Task                  The new task.  Must be passed to PasswordPolicyFinishPasswordHash ().
+
+  @retval   EFI_SUCCESS             The task was started.
+  @retval   EFI_INVALID_PARAMETER   Task is NULL.
+  @retval   EFI_OUT_OF_RESOURCES    The task could not be allocated.
+
+**/
+EFI_STATUS
+EFIAPI
+PasswordPolicyStartPasswordHash (
+  IN   CONST PASSWORD_HASH       OldSalt   OPTIONAL,
+  IN   CONST CHAR16              *Password  OPTIONAL,
+  OUT        PASSWORD_HASH_TASK  **Task
+  )
+{
+  PASSWORD_HASH_TASK  *NewTask;
+  EFI_STATUS          Status;
+
+  DEBUG ((DEBUG_INFO, "%a: Entry\n", __FUNCTION__));
+
+  if (Task == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  NewTask = (PASSWORD_HASH_TASK *)AllocateZeroPool (sizeof (PASSWORD_HASH_TASK));
+  if (NewTask == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  NewTask->Signature = PASSWORD_HASH_TASK_SIGNATURE;
+
+  // Errors are reported by PasswordPolicyFinishPasswordHash (), like any other result.
+  //
+  NewTask->Status = GeneratePasswordStore (
+                      OldSalt,
+                      Password,
+                      &NewTask->Store,
+                      &NewTask->StoreSize,
+                      &NewTask->Pbkdf2
+                      );
+  if (NewTask->Status == EFI_NOT_READY) {
+    NewTask->Pending = TRUE;
+
+    Status = StartPasswordHashOnAp (NewTask);
+    if (!EFI_ERROR (Status)) {
+      NewTask->OnAp = TRUE;
+    } else {
+      DEBUG ((DEBUG_INFO, "%a - No AP for the password hash (%r). Hashing in slices.\n", __FUNCTION__, Status));
+    }
+  }
+
+  *Task = NewTask;
+
+  return EFI_SUCCESS;
+} // PasswordPolicyStartPasswordHash()
+
+/**
+  Public interface for checking on a background password hash.
+
+  If the task is not running on an application processor, runs the next slice of it,
+  PASSWORD_HASH_SLICE_ITERATIONS iterations.  Callers should keep the UI going between calls.
+
+  @param[in]  Task                  Task from PasswordPolicyStartPasswordHash ().
+  @param[out] PercentComplete       [Optional] Progress of the hash, 0 to 100.
+
+  @retval   EFI_NOT_READY           The hash is still being computed.
+  @retval   EFI_INVALID_PARAMETER   Task is not a password hash task.
+  @retval   <other>                 The hash is done.  This is the result
+                                    PasswordPolicyFinishPasswordHash () will return.
+
+**/
+EFI_STATUS
+EFIAPI
+PasswordPolicyPollPasswordHash (
+  IN         PASSWORD_HASH_TASK  *Task,
+  OUT        UINTN               *PercentComplete OPTIONAL
+  )
+{
+  if ((Task == NULL) || (Task->Signature != PASSWORD_HASH_TASK_SIGNATURE)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (Task->Pending) {
+    if (Task->OnAp) {
+      if (Task->ApDone) {
+        Task->Pending = FALSE;
+      }
+    } else if (Pbkdf2Sha256Update (&Task->Pbkdf2, PASSWORD_HASH_SLICE_ITERATIONS)) {
+      Task->KeyReady = TRUE;
+      Task->Pending  = FALSE;
+    }
+
+    if (!Task->Pending) {
+      Task->Status = Task->KeyReady ? EFI_SUCCESS : EFI_ABORTED;
+    }
+  }
+
+  if (PercentComplete != NULL) {
+    *PercentComplete = GetPasswordHashProgress (Task);
+  }
+
+  return Task->Pending ? EFI_NOT_READY : Task->Status;
+} // PasswordPolicyPollPasswordHash()
+
+/**
+  Public interface for completing or cancelling a background password hash.
+
+  If the hash is not done, waits for it, or cancels it when PasswordHash is NULL.  The task is
+  freed in either case.
+
+  @param[in]  Task                  Task from PasswordPolicyStartPasswordHash ().
+  @param[out] PasswordHash          [Optional] Receives the password hash, as from
+                                    PasswordPolicyGeneratePasswordHash ().  NULL to cancel the task.
+  @param[out] PasswordHashSize      [Optional] Receives the size of the password hash.
+
+  @retval   EFI_SUCCESS             The password hash was returned.
+  @retval   EFI_ABORTED             The task was cancelled.
+  @retval   EFI_INVALID_PARAMETER   Task is not a password hash task, or PasswordHash is present
+                                    without PasswordHashSize.
+  @retval   <other>                 The hash could not be generated.
+
+  Caller is responsible for freeing the returned PASSWORD_HASH
+
+**/
+EFI_STATUS
+EFIAPI
+PasswordPolicyFinishPasswordHash (
+  IN         PASSWORD_HASH_TASK  *Task,
+  OUT        PASSWORD_HASH       *PasswordHash OPTIONAL,
+  OUT        UINTN               *PasswordHashSize OPTIONAL
+  )
+{
+  EFI_STATUS  Status;
+
+  if ((Task == NULL) || (Task->Signature != PASSWORD_HASH_TASK_SIGNATURE) ||
+      ((PasswordHash != NULL) && (PasswordHashSize == NULL)))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (PasswordHash == NULL) {
+    Task->Cancel = TRUE;
+  }
+
+  if (Task->Pending) {
+    if (Task->OnAp) {
+      while (!Task->ApDone) {
+        CpuPause ();
+      }
+    } else if (!Task->Cancel) {
+      Task->KeyReady = Pbkdf2Sha256Update (&Task->Pbkdf2, MAX_UINTN);
+    }
+
+    Task->Pending = FALSE;
+    Task->Status  = Task->KeyReady ? EFI_SUCCESS : EFI_ABORTED;
+  }
+
+  Status = Task->Cancel ? EFI_ABORTED : Task->Status;
+
+  if (!EFI_ERROR (Status)) {
+    *PasswordHash     = Task->Store;
+    *PasswordHashSize = Task->StoreSize;
+  } else if (Task->Store != NULL) {
+    ZeroMem (Task->Store, Task->StoreSize);
+    FreePool (Task->Store);
+  }
+
+  // A cancelled derivation leaves key material in the context.
+  //
+  ZeroMem (Task, sizeof (PASSWORD_HASH_TASK));
+  FreePool (Task);
+
+  DEBUG ((DEBUG_INFO, "%a: Exit. Code=%r\n", __FUNCTION__, Status));
+
+  return Status;
+} // PasswordPolicyFinishPasswordHash()
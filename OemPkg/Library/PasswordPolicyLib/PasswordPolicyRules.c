@@ -0,0 +1,466 @@
+/** @file PasswordPolicyRules.c
+
+  Password strength rules.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiDxe.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseCryptLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/DxeServicesLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PasswordPolicyLib.h>
+#include <Library/PcdLib.h>
+
+#include "PasswordPolicyRules.h"
+
+//
+// Character classes counted by the PcdPasswordMinCharClasses rule.
+//
+typedef enum {
+  PwCharClassLower,
+  PwCharClassUpper,
+  PwCharClassDigit,
+  PwCharClassSymbol,
+  PwCharClassMax
+} PW_CHAR_CLASS;
+
+typedef struct {
+  BOOLEAN                        Compiled;
+  UINT32                         AllowedChars[(MAX_UINT16 + 1) / 32];   // One bit per CHAR16.
+  UINT8                          MinCharClasses;
+  UINT8                          MaxRepeatedChars;                      // 0 if repeats are not limited.
+  UINT8                          MaxSequenceLength;                     // 0 if sequences are not limited.
+  PASSWORD_BANNED_LIST_HEADER    *BannedList;                           // NULL if there is no list.
+} PASSWORD_POLICY;
+
+/**
+  A password rule.
+
+  @param[in]  Password    The password.
+  @param[in]  Length      Length of Password in characters.
+
+  @retval     TRUE        The password passes the rule.
+  @retval     FALSE       It doesn't.
+
+**/
+typedef
+BOOLEAN
+(*PASSWORD_RULE_CHECK)(
+  IN  CONST CHAR16  *Password,
+  IN        UINTN   Length
+  );
+
+typedef struct {
+  PW_TEST_BITMAP         Failure;       // Bit set when the rule fails.
+  BOOLEAN                Format;        // The rule applies to stored passwords, not only new ones.
+  PASSWORD_RULE_CHECK    Check;
+} PASSWORD_RULE;
+
+STATIC PASSWORD_POLICY  mPolicy;
+
+/**
+  Returns the class of a character.
+
+  @param[in]  Char    The character.
+
+  @return     Its class.
+
+**/
+STATIC
+PW_CHAR_CLASS
+GetCharClass (
+  IN  CHAR16  Char
+  )
+{
+  if ((Char >= L'a') && (Char <= L'z')) {
+    return PwCharClassLower;
+  }
+
+  if ((Char >= L'A') && (Char <= L'Z')) {
+    return PwCharClassUpper;
+  }
+
+  if ((Char >= L'0') && (Char <= L'9')) {
+    return PwCharClassDigit;
+  }
+
+  return PwCharClassSymbol;
+}
+
+/**
+  Folds an ASCII upper case letter to lower case.
+
+  @param[in]  Char    The character.
+
+  @return     The folded character.
+
+**/
+STATIC
+CHAR16
+FoldChar (
+  IN  CHAR16  Char
+  )
+{
+  if ((Char >= L'A') && (Char <= L'Z')) {
+    return Char - L'A' + L'a';
+  }
+
+  return Char;
+}
+
+/**
+  Loads the banned password list from the FV and checks its header.
+
+  @return     The list, or NULL if there is no valid list.
+
+**/
+STATIC
+PASSWORD_BANNED_LIST_HEADER *
+LoadBannedList (
+  VOID
+  )
+{
+  EFI_STATUS                   Status;
+  PASSWORD_BANNED_LIST_HEADER  *List = NULL;
+  UINTN                        Size  = 0;
+
+  Status = GetSectionFromAnyFv (
+             (EFI_GUID *)FixedPcdGetPtr (PcdPasswordBannedListFile),
+             EFI_SECTION_RAW,
+             0,
+             (VOID **)&List,
+             &Size
+             );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "%a - No banned password list. %r\n", __FUNCTION__, Status));
+    return NULL;
+  }
+
+  if ((Size < sizeof (*List)) ||
+      (List->Signature != PASSWORD_BANNED_LIST_SIGNATURE) ||
+      (List->Version != PASSWORD_BANNED_LIST_VERSION) ||
+      (List->HashCount == 0) ||
+      (List->HashCount > PASSWORD_BANNED_LIST_MAX_HASHES) ||
+      (List->BitCount == 0) ||
+      ((Size - sizeof (*List)) < ((UINTN)List->BitCount + 7) / 8))
+  {
+    DEBUG ((DEBUG_ERROR, "%a - The banned password list is not valid. Ignoring it.\n", __FUNCTION__));
+    FreePool (List);
+    return NULL;
+  }
+
+  DEBUG ((DEBUG_INFO, "%a - Banned password list: %d bits, %d hashes.\n", __FUNCTION__, List->BitCount, List->HashCount));
+  return List;
+}
+
+/**
+  Compiles the policy PCDs, once.
+
+**/
+STATIC
+VOID
+CompilePolicy (
+  VOID
+  )
+{
+  CONST CHAR16  *Allowed;
+
+  if (mPolicy.Compiled) {
+    return;
+  }
+
+  for (Allowed = (CONST CHAR16 *)FixedPcdGetPtr (PcdPasswordAllowedChars); *Allowed != L'\0'; Allowed++) {
+    mPolicy.AllowedChars[*Allowed / 32] |= (UINT32)1 << (*Allowed % 32);
+  }
+
+  mPolicy.MinCharClasses    = MIN (FixedPcdGet8 (PcdPasswordMinCharClasses), PwCharClassMax);
+  mPolicy.MaxRepeatedChars  = FixedPcdGet8 (PcdPasswordMaxRepeatedChars);
+  mPolicy.MaxSequenceLength = FixedPcdGet8 (PcdPasswordMaxSequenceLength);
+  mPolicy.BannedList        = LoadBannedList ();
+  mPolicy.Compiled          = TRUE;
+}
+
+/**
+  Checks the password for the minimum length.
+
+  @param[in]  Password    The password.
+  @param[in]  Length      Length of Password in characters.
+
+  @retval     TRUE        The password passes the rule.
+  @retval     FALSE       It doesn't.
+
+**/
+STATIC
+BOOLEAN
+CheckMinLength (
+  IN  CONST CHAR16  *Password,
+  IN        UINTN   Length
+  )
+{
+  return (BOOLEAN)(Length >= PW_MIN_LENGTH);
+}
+
+/**
+  Checks that every character of the password is allowed.
+
+  @param[in]  Password    The password.
+  @param[in]  Length      Length of Password in characters.
+
+  @retval     TRUE        The password passes the rule.
+  @retval     FALSE       It doesn't.
+
+**/
+STATIC
+BOOLEAN
+CheckAllowedChars (
+  IN  CONST CHAR16  *Password,
+  IN        UINTN   Length
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Length; Index++) {
+    if ((mPolicy.AllowedChars[Password[Index] / 32] & ((UINT32)1 << (Password[Index] % 32))) == 0) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Checks that the password uses at least PcdPasswordMinCharClasses character classes.
+
+  @param[in]  Password    The password.
+  @param[in]  Length      Length of Password in characters.
+
+  @retval     TRUE        The password passes the rule.
+  @retval     FALSE       It doesn't.
+
+**/
+STATIC
+BOOLEAN
+CheckCharClasses (
+  IN  CONST CHAR16  *Password,
+  IN        UINTN   Length
+  )
+{
+  UINTN  Index;
+  UINT8  Classes = 0;
+  UINT8  Count   = 0;
+
+  for (Index = 0; Index < Length; Index++) {
+    Classes |= (UINT8)(1 << GetCharClass (Password[Index]));
+  }
+
+  for ( ; Classes != 0; Classes &= Classes - 1) {
+    Count++;
+  }
+
+  return (BOOLEAN)(Count >= mPolicy.MinCharClasses);
+}
+
+/**
+  Checks that no character repeats more than PcdPasswordMaxRepeatedChars times in a row.
+
+  @param[in]  Password    The password.
+  @param[in]  Length      Length of Password in characters.
+
+  @retval     TRUE        The password passes the rule.
+  @retval     FALSE       It doesn't.
+
+**/
+STATIC
+BOOLEAN
+CheckRepeatedChars (
+  IN  CONST CHAR16  *Password,
+  IN        UINTN   Length
+  )
+{
+  UINTN  Index;
+  UINTN  Run = 1;
+
+  if (mPolicy.MaxRepeatedChars == 0) {
+    return TRUE;
+  }
+
+  for (Index = 1; Index < Length; Index++) {
+    Run = (Password[Index] == Password[Index - 1]) ? Run + 1 : 1;
+    if (Run > mPolicy.MaxRepeatedChars) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Checks that the password has no run of consecutive letters or digits, such as "abcd" or
+  "4321", longer than PcdPasswordMaxSequenceLength.  Letters are compared without case.
+
+  @param[in]  Password    The password.
+  @param[in]  Length      Length of Password in characters.
+
+  @retval     TRUE        The password passes the rule.
+  @retval     FALSE       It doesn't.
+
+**/
+STATIC
+BOOLEAN
+CheckSequences (
+  IN  CONST CHAR16  *Password,
+  IN        UINTN   Length
+  )
+{
+  UINTN   Index;
+  UINTN   Run  = 1;
+  INTN    Step = 0;
+  INTN    Delta;
+  CHAR16  Previous;
+  CHAR16  Current;
+
+  if (mPolicy.MaxSequenceLength == 0) {
+    return TRUE;
+  }
+
+  for (Index = 1; Index < Length; Index++) {
+    Previous = FoldChar (Password[Index - 1]);
+    Current  = FoldChar (Password[Index]);
+    Delta    = (INTN)Current - (INTN)Previous;
+
+    if (((Delta == 1) || (Delta == -1)) &&
+        (GetCharClass (Previous) == GetCharClass (Current)) &&
+        (GetCharClass (Current) != PwCharClassSymbol))
+    {
+      Run  = (Delta == Step) ? Run + 1 : 2;
+      Step = Delta;
+    } else {
+      Run  = 1;
+      Step = 0;
+    }
+
+    if (Run > mPolicy.MaxSequenceLength) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Checks that the password is not in the banned password list.  A Bloom filter can report a
+  password that isn't in the list, but never misses one that is.
+
+  @param[in]  Password    The password.
+  @param[in]  Length      Length of Password in characters.
+
+  @retval     TRUE        The password passes the rule.
+  @retval     FALSE       It doesn't.
+
+**/
+STATIC
+BOOLEAN
+CheckBannedList (
+  IN  CONST CHAR16  *Password,
+  IN        UINTN   Length
+  )
+{
+  CHAR16       Folded[PW_MAX_LENGTH];
+  UINT8        Digest[SHA256_DIGEST_SIZE];
+  UINT8        *Bits;
+  UINT64       H1;
+  UINT64       H2;
+  UINT64       Bit;
+  UINTN        Index;
+  BOOLEAN      Banned;
+
+  if ((mPolicy.BannedList == NULL) || (Length > ARRAY_SIZE (Folded))) {
+    return TRUE;
+  }
+
+  for (Index = 0; Index < Length; Index++) {
+    Folded[Index] = FoldChar (Password[Index]);
+  }
+
+  Banned = FALSE;
+  if (Sha256HashAll (Folded, Length * sizeof (CHAR16), Digest)) {
+    Banned = TRUE;
+    H1   = ReadUnaligned64 ((UINT64 *)&Digest[0]);
+    H2   = ReadUnaligned64 ((UINT64 *)&Digest[sizeof (UINT64)]) | 1;
+    Bits = (UINT8 *)(mPolicy.BannedList + 1);
+
+    for (Index = 0; Banned && (Index < mPolicy.BannedList->HashCount); Index++) {
+      DivU64x64Remainder (H1 + MultU64x64 (H2, Index), mPolicy.BannedList->BitCount, &Bit);
+      Banned = (BOOLEAN)((Bits[(UINTN)Bit / 8] & (1 << ((UINTN)Bit % 8))) != 0);
+    }
+  }
+
+  ZeroMem (Folded, sizeof (Folded));
+  ZeroMem (Digest, sizeof (Digest));
+
+  return (BOOLEAN) !Banned;
+}
+
+//
+// The rules, in the order they are reported.  The format rules come first so that a password
+// with a bad character isn't also reported as too common.
+//
+STATIC CONST PASSWORD_RULE  mPasswordRules[] = {
+  { PW_TEST_STRING_TOO_SHORT,       TRUE,  CheckMinLength     },
+  { PW_TEST_STRING_INVALID_CHAR,    TRUE,  CheckAllowedChars  },
+  { PW_TEST_STRING_TOO_FEW_CLASSES, FALSE, CheckCharClasses   },
+  { PW_TEST_STRING_REPEATED_CHAR,   FALSE, CheckRepeatedChars },
+  { PW_TEST_STRING_SEQUENCE,        FALSE, CheckSequences     },
+  { PW_TEST_STRING_BANNED,          FALSE, CheckBannedList    }
+};
+
+/**
+  Runs a password through the password rules.
+
+  @param[in]  Password      Password to check.  It must be NULL-terminated and at most
+                            PW_MAX_LENGTH characters long.
+  @param[in]  FormatOnly    TRUE to only check the length and the characters.  These rules
+                            hold for any password that could have been stored, while the
+                            strength rules only apply to a new password.
+  @param[in]  AllFailures   TRUE to run every rule, FALSE to stop at the first failure.
+
+  @return     The PW_TEST_* bits of the rules that failed.  0 if the password passes.
+
+**/
+PW_TEST_BITMAP
+CheckPasswordRules (
+  IN  CONST CHAR16  *Password,
+  IN        BOOLEAN FormatOnly,
+  IN        BOOLEAN AllFailures
+  )
+{
+  PW_TEST_BITMAP  Failures = 0;
+  UINTN           Length;
+  UINTN           Index;
+
+  CompilePolicy ();
+
+  Length = StrLen (Password);
+
+  for (Index = 0; Index < ARRAY_SIZE (mPasswordRules); Index++) {
+    if (FormatOnly && !mPasswordRules[Index].Format) {
+      continue;
+    }
+
+    if (!mPasswordRules[Index].Check (Password, Length)) {
+      Failures |= mPasswordRules[Index].Failure;
+      if (!AllFailures) {
+        break;
+      }
+    }
+  }
+
+  return Failures;
+}
@@ -0,0 +1,63 @@
+/** @file -- PasswordPolicyRules.h
+
+  Password strength rules.
+
+  The rules are a table that each candidate password is run through in order.  A failed rule
+  sets its own PW_TEST_* bit.  The policy comes from PCDs and is compiled the first time a
+  password is checked.  At that point the allowed characters become a bitmap with a bit for
+  every CHAR16, and the banned password list is loaded from its FV file.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _PASSWORD_POLICY_RULES_H_
+#define _PASSWORD_POLICY_RULES_H_
+
+//
+// Banned password list, stored as a Bloom filter in the raw section of the FV file named by
+// PcdPasswordBannedListFile.  Scripts/BuildPasswordBannedList.py builds it.
+//
+// A password is looked up by folding ASCII letters to lower case, hashing its UCS-2 characters
+// (without the terminator) with SHA-256, and taking H1 and H2 as the first two little-endian
+// UINT64s of the digest, with H2 made odd.  Bit (H1 + i * H2) mod BitCount must be set for
+// every i below HashCount.  Bit n is bit (n % 8) of byte (n / 8) of the bit array.
+//
+#define PASSWORD_BANNED_LIST_SIGNATURE  SIGNATURE_32 ('P', 'W', 'B', 'L')
+#define PASSWORD_BANNED_LIST_VERSION    1
+#define PASSWORD_BANNED_LIST_MAX_HASHES  32
+
+#pragma pack(1)
+
+typedef struct {
+  UINT32    Signature;                  // PASSWORD_BANNED_LIST_SIGNATURE
+  UINT16    Version;                    // PASSWORD_BANNED_LIST_VERSION
+  UINT16    HashCount;                  // Bits set per password, 1..PASSWORD_BANNED_LIST_MAX_HASHES.
+  UINT32    BitCount;                   // Size of the bit array that follows, in bits.
+  // UINT8  Bits[(BitCount + 7) / 8];
+} PASSWORD_BANNED_LIST_HEADER;
+
+#pragma pack()
+
+/**
+  Runs a password through the password rules.
+
+  @param[in]  Password      Password to check.  It must be NULL-terminated and at most
+                            PW_MAX_LENGTH characters long.
+  @param[in]  FormatOnly    TRUE to only check the length and the characters.  These rules
+                            hold for any password that could have been stored, while the
+                            strength rules only apply to a new password.
+  @param[in]  AllFailures   TRUE to run every rule, FALSE to stop at the first failure.
+
+  @return     The PW_TEST_* bits of the rules that failed.  0 if the password passes.
+
+**/
+PW_TEST_BITMAP
+CheckPasswordRules (
+  IN  CONST CHAR16  *Password,
+  IN        BOOLEAN FormatOnly,
+  IN        BOOLEAN AllFailures
+  );
+
+#endif
@@ -0,0 +1,606 @@
+/** @file -- Pbkdf2Sha256.c
+
+  PBKDF2-HMAC-SHA256 (RFC 8018) used to build password hashes.
+
+  Each PBKDF2 output block is a chain of IterationCount HMACs that does not depend on
+  the other blocks.  The SHA-256 compression below runs up to PBKDF2_SHA256_LANES of
+  those chains at once, one per output block still to compute.  The working variables are stored lane-minor, so every step of a
+  round is the same operation on each lane; compilers that vectorize turn the lane
+  loops into SIMD instructions, and on other targets the lanes still give the CPU
+  independent dependency chains to overlap.
+
+  On X64 CPUs that report the SHA extensions, each lane is compressed with
+  Sha256CompressShaNi() instead.
+
+  PasswordHashBenchmarkHostTest times the derivations on the host.  Compressing the key pads
+  once per password takes about half the time of hashing them in every HMAC.  A two block key
+  in lanes takes about three quarters of the time of its blocks one after the other.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseCryptLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+
+#if defined (MDE_CPU_X64)
+  #include <Register/Intel/Cpuid.h>
+#endif
+
+#include "Pbkdf2Sha256.h"
+
+#define SHA256_ROUNDS  64
+
+#define ROTR32(x, n)  (((x) >> (n)) | ((x) << (32 - (n))))
+#define BSIG0(x)      (ROTR32 (x, 2) ^ ROTR32 (x, 13) ^ ROTR32 (x, 22))
+#define BSIG1(x)      (ROTR32 (x, 6) ^ ROTR32 (x, 11) ^ ROTR32 (x, 25))
+#define SSIG0(x)      (ROTR32 (x, 7) ^ ROTR32 (x, 18) ^ ((x) >> 3))
+#define SSIG1(x)      (ROTR32 (x, 17) ^ ROTR32 (x, 19) ^ ((x) >> 10))
+#define CH(x, y, z)   (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z)  (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+
+STATIC CONST UINT32  mSha256K[SHA256_ROUNDS] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+STATIC CONST UINT32  mSha256Iv[SHA256_STATE_WORDS] = {
+  0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+#if defined (MDE_CPU_X64)
+STATIC BOOLEAN  mUseShaNi = FALSE;
+#endif
+
+/**
+  Reads a big-endian 32-bit value.
+
+  @param[in]  Buffer    Pointer to 4 bytes.
+
+  @return     The value.
+
+**/
+STATIC
+UINT32
+ReadBe32 (
+  IN CONST UINT8  *Buffer
+  )
+{
+  return ((UINT32)Buffer[0] << 24) | ((UINT32)Buffer[1] << 16) | ((UINT32)Buffer[2] << 8) | (UINT32)Buffer[3];
+}
+
+/**
+  Writes a big-endian 32-bit value.
+
+  @param[out] Buffer    Pointer to 4 bytes.
+  @param[in]  Value     The value.
+
+**/
+STATIC
+VOID
+WriteBe32 (
+  OUT UINT8   *Buffer,
+  IN  UINT32  Value
+  )
+{
+  Buffer[0] = (UINT8)(Value >> 24);
+  Buffer[1] = (UINT8)(Value >> 16);
+  Buffer[2] = (UINT8)(Value >> 8);
+  Buffer[3] = (UINT8)Value;
+}
+
+#if defined (MDE_CPU_X64)
+
+/**
+  Determines whether the CPU supports the instructions Sha256CompressShaNi() uses.
+
+  @retval     TRUE    The CPU supports the SHA extensions and SSE4.1.
+  @retval     FALSE   Not.
+
+**/
+STATIC
+BOOLEAN
+IsShaNiSupported (
+  VOID
+  )
+{
+  UINT32                                       MaxLeaf;
+  CPUID_VERSION_INFO_ECX                       VersionEcx;
+  CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS_EBX  ExtendedEbx;
+
+  AsmCpuid (CPUID_SIGNATURE, &MaxLeaf, NULL, NULL, NULL);
+  if (MaxLeaf < CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS) {
+    return FALSE;
+  }
+
+  AsmCpuid (CPUID_VERSION_INFO, NULL, NULL, &VersionEcx.Uint32, NULL);
+  AsmCpuidEx (
+    CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS,
+    CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS_SUB_LEAF_INFO,
+    NULL,
+    &ExtendedEbx.Uint32,
+    NULL,
+    NULL
+    );
+
+  return (BOOLEAN)((VersionEcx.Bits.SSE4_1 != 0) && (ExtendedEbx.Bits.SHA != 0));
+}
+
+#endif
+
+/**
+  Runs the SHA-256 compression function on one block of a single lane.
+
+  @param[in,out]  State       Hash state.
+  @param[in]      Block       Message block, as big-endian words.
+
+**/
+STATIC
+VOID
+Sha256CompressOne (
+  IN OUT UINT32        *State,
+  IN     CONST UINT32  *Block
+  )
+{
+  UINT32  W[SHA256_ROUNDS];
+  UINT32  V[SHA256_STATE_WORDS];
+  UINT32  T1;
+  UINT32  T2;
+  UINTN   Round;
+
+  CopyMem (W, Block, SHA256_BLOCK_SIZE);
+  for (Round = SHA256_BLOCK_WORDS; Round < SHA256_ROUNDS; Round++) {
+    W[Round] = SSIG1 (W[Round - 2]) + W[Round - 7] + SSIG0 (W[Round - 15]) + W[Round - 16];
+  }
+
+  CopyMem (V, State, sizeof (V));
+  for (Round = 0; Round < SHA256_ROUNDS; Round++) {
+    T1   = V[7] + BSIG1 (V[4]) + CH (V[4], V[5], V[6]) + mSha256K[Round] + W[Round];
+    T2   = BSIG0 (V[0]) + MAJ (V[0], V[1], V[2]);
+    V[7] = V[6];
+    V[6] = V[5];
+    V[5] = V[4];
+    V[4] = V[3] + T1;
+    V[3] = V[2];
+    V[2] = V[1];
+    V[1] = V[0];
+    V[0] = T1 + T2;
+  }
+
+  for (Round = 0; Round < SHA256_STATE_WORDS; Round++) {
+    State[Round] += V[Round];
+  }
+}
+
+/**
+  Runs the SHA-256 compression function on one block in every lane.
+
+  Only the first LaneCount lanes are used.  A key of one block, such as the
+  PASSWORD_HASH_VER_2 key, uses one lane, which is compressed on its own.  Otherwise every
+  lane is computed: the lane loops have a constant bound so that the compiler can vectorize
+  them, and a spare lane in a vector costs nothing.
+
+  @param[in,out]  State       Per-lane hash state.
+  @param[in]      Block       Per-lane message block, as big-endian words.
+  @param[in]      LaneCount   Number of lanes whose result is used.
+
+**/
+STATIC
+VOID
+Sha256CompressLanes (
+  IN OUT UINT32  State[][SHA256_STATE_WORDS],
+  IN     UINT32  Block[][SHA256_BLOCK_WORDS],
+  IN     UINTN   LaneCount
+  )
+{
+  UINT32  W[SHA256_ROUNDS][PBKDF2_SHA256_LANES];
+  UINT32  V[SHA256_STATE_WORDS][PBKDF2_SHA256_LANES];
+  UINT32  T1;
+  UINT32  T2;
+  UINTN   Round;
+  UINTN   Lane;
+  UINTN   Index;
+
+ #if defined (MDE_CPU_X64)
+  if (mUseShaNi) {
+    for (Lane = 0; Lane < LaneCount; Lane++) {
+      Sha256CompressShaNi (State[Lane], Block[Lane], 1);
+    }
+
+    return;
+  }
+
+ #endif
+
+  if (LaneCount == 1) {
+    Sha256CompressOne (State[0], Block[0]);
+    return;
+  }
+
+  for (Round = 0; Round < SHA256_BLOCK_WORDS; Round++) {
+    for (Lane = 0; Lane < PBKDF2_SHA256_LANES; Lane++) {
+      W[Round][Lane] = Block[Lane][Round];
+    }
+  }
+
+  for (Round = SHA256_BLOCK_WORDS; Round < SHA256_ROUNDS; Round++) {
+    for (Lane = 0; Lane < PBKDF2_SHA256_LANES; Lane++) {
+      W[Round][Lane] = SSIG1 (W[Round - 2][Lane]) + W[Round - 7][Lane] + SSIG0 (W[Round - 15][Lane]) + W[Round - 16][Lane];
+    }
+  }
+
+  for (Index = 0; Index < SHA256_STATE_WORDS; Index++) {
+    for (Lane = 0; Lane < PBKDF2_SHA256_LANES; Lane++) {
+      V[Index][Lane] = State[Lane][Index];
+    }
+  }
+
+  for (Round = 0; Round < SHA256_ROUNDS; Round++) {
+    for (Lane = 0; Lane < PBKDF2_SHA256_LANES; Lane++) {
+      T1         = V[7][Lane] + BSIG1 (V[4][Lane]) + CH (V[4][Lane], V[5][Lane], V[6][Lane]) + mSha256K[Round] + W[Round][Lane];
+      T2         = BSIG0 (V[0][Lane]) + MAJ (V[0][Lane], V[1][Lane], V[2][Lane]);
+      V[7][Lane] = V[6][Lane];
+      V[6][Lane] = V[5][Lane];
+      V[5][Lane] = V[4][Lane];
+      V[4][Lane] = V[3][Lane] + T1;
+      V[3][Lane] = V[2][Lane];
+      V[2][Lane] = V[1][Lane];
+      V[1][Lane] = V[0][Lane];
+      V[0][Lane] = T1 + T2;
+    }
+  }
+
+  for (Index = 0; Index < SHA256_STATE_WORDS; Index++) {
+    for (Lane = 0; Lane < PBKDF2_SHA256_LANES; Lane++) {
+      State[Lane][Index] += V[Index][Lane];
+    }
+  }
+}
+
+/**
+  Computes the midstate of a key pad: the SHA-256 state after compressing the pad block.
+
+  @param[in]  Key       HMAC key, zero padded to a block.
+  @param[in]  PadByte   0x36 for the inner pad, 0x5c for the outer pad.
+  @param[out] Midstate  The midstate.
+
+**/
+STATIC
+VOID
+ComputePadMidstate (
+  IN  CONST UINT8  *Key,
+  IN        UINT8  PadByte,
+  OUT       UINT32  *Midstate
+  )
+{
+  UINT32  State[PBKDF2_SHA256_LANES][SHA256_STATE_WORDS];
+  UINT32  Pad[PBKDF2_SHA256_LANES][SHA256_BLOCK_WORDS];
+  UINTN   Index;
+
+  CopyMem (State[0], mSha256Iv, sizeof (mSha256Iv));
+  for (Index = 0; Index < SHA256_BLOCK_WORDS; Index++) {
+    Pad[0][Index] = ReadBe32 (&Key[Index * sizeof (UINT32)]) ^ (PadByte * 0x01010101U);
+  }
+
+  Sha256CompressLanes (State, Pad, 1);
+  CopyMem (Midstate, State[0], sizeof (State[0]));
+
+  ZeroMem (State, sizeof (State));
+  ZeroMem (Pad, sizeof (Pad));
+}
+
+/**
+  Computes HMAC-SHA256 of the padded message block of every lane.  The result of each lane
+  is left in Context->State.
+
+  @param[in,out]  Context   PBKDF2 context.  Context->Message holds one padded message block per lane.
+
+**/
+STATIC
+VOID
+HmacSha256Lanes (
+  IN OUT PBKDF2_SHA256_CONTEXT  *Context
+  )
+{
+  UINTN  Lane;
+
+  for (Lane = 0; Lane < Context->LaneCount; Lane++) {
+    CopyMem (Context->State[Lane], Context->IpadState, sizeof (Context->IpadState));
+  }
+
+  Sha256CompressLanes (Context->State, Context->Message, Context->LaneCount);
+
+  // The inner digest is 32 bytes, so the padding and length of the outer message block never change.
+  //
+  for (Lane = 0; Lane < Context->LaneCount; Lane++) {
+    CopyMem (Context->Inner[Lane], Context->State[Lane], SHA256_DIGEST_SIZE);
+    CopyMem (Context->State[Lane], Context->OpadState, sizeof (Context->OpadState));
+  }
+
+  Sha256CompressLanes (Context->State, Context->Inner, Context->LaneCount);
+}
+
+/**
+  Starts a stepwise PBKDF2-HMAC-SHA256 derivation.  The password is only needed here.
+
+  @param[out] Context         Context to initialize.
+  @param[in]  Password        Password bytes.
+  @param[in]  PasswordSize    Size of Password in bytes.
+  @param[in]  Salt            Salt bytes.
+  @param[in]  SaltSize        Size of Salt in bytes.
+  @param[in]  IterationCount  PBKDF2 iteration count.
+  @param[in]  OutputSize      Size of the derived key in bytes.
+  @param[out] Output          Buffer that receives the derived key.  It must stay valid until
+                              Pbkdf2Sha256Update () returns TRUE.
+
+  @retval     EFI_SUCCESS             The context is ready for Pbkdf2Sha256Update ().
+  @retval     EFI_INVALID_PARAMETER   A buffer is NULL, or IterationCount or OutputSize is 0.
+  @retval     EFI_UNSUPPORTED         SaltSize is larger than PBKDF2_SHA256_MAX_SALT_SIZE.
+  @retval     EFI_DEVICE_ERROR        A password longer than a block could not be hashed.
+
+**/
+EFI_STATUS
+Pbkdf2Sha256Init (
+  OUT       PBKDF2_SHA256_CONTEXT  *Context,
+  IN  CONST UINT8                  *Password,
+  IN        UINTN                  PasswordSize,
+  IN  CONST UINT8                  *Salt,
+  IN        UINTN                  SaltSize,
+  IN        UINTN                  IterationCount,
+  IN        UINTN                  OutputSize,
+  OUT       UINT8                  *Output
+  )
+{
+  UINT8  Key[SHA256_BLOCK_SIZE];
+  UINTN  Lane;
+
+  if ((Context == NULL) || (Password == NULL) || (Salt == NULL) || (Output == NULL) || (IterationCount == 0) || (OutputSize == 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (SaltSize > PBKDF2_SHA256_MAX_SALT_SIZE) {
+    return EFI_UNSUPPORTED;
+  }
+
+ #if defined (MDE_CPU_X64)
+  mUseShaNi = IsShaNiSupported ();
+ #endif
+
+  ZeroMem (Context, sizeof (*Context));
+
+  //
+  // Compute the HMAC key pad midstates.  Keys longer than a block are hashed first.
+  //
+  ZeroMem (Key, sizeof (Key));
+  if (PasswordSize > SHA256_BLOCK_SIZE) {
+    if (!Sha256HashAll (Password, PasswordSize, Key)) {
+      return EFI_DEVICE_ERROR;
+    }
+  } else {
+    CopyMem (Key, Password, PasswordSize);
+  }
+
+  ComputePadMidstate (Key, 0x36, Context->IpadState);
+  ComputePadMidstate (Key, 0x5c, Context->OpadState);
+  ZeroMem (Key, sizeof (Key));
+
+  // The padding and length of the inner and outer message blocks of U2..Uc are fixed: a 32 byte
+  // message after one block of key pad.
+  //
+  for (Lane = 0; Lane < PBKDF2_SHA256_LANES; Lane++) {
+    Context->Inner[Lane][SHA256_STATE_WORDS]     = 0x80000000;
+    Context->Inner[Lane][SHA256_BLOCK_WORDS - 1] = (SHA256_BLOCK_SIZE + SHA256_DIGEST_SIZE) * 8;
+  }
+
+  CopyMem (Context->Salt, Salt, SaltSize);
+  Context->SaltSize        = SaltSize;
+  Context->IterationCount  = IterationCount;
+  Context->Output          = Output;
+  Context->OutputSize      = OutputSize;
+  Context->BlockCount      = (OutputSize + SHA256_DIGEST_SIZE - 1) / SHA256_DIGEST_SIZE;
+  Context->TotalIterations = ((Context->BlockCount + PBKDF2_SHA256_LANES - 1) / PBKDF2_SHA256_LANES) * IterationCount;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Computes U1 = PRF (Password, Salt || INT (BlockNumber)) for each lane of the current group,
+  and starts the running XOR with it.
+
+  @param[in,out]  Context   PBKDF2 context.
+
+**/
+STATIC
+VOID
+StartBlockGroup (
+  IN OUT PBKDF2_SHA256_CONTEXT  *Context
+  )
+{
+  UINT8   Block[SHA256_BLOCK_SIZE];
+  UINTN   BlockNumber;
+  UINTN   Lane;
+  UINTN   Index;
+  UINT64  MessageBits;
+
+  Context->LaneCount = MIN (PBKDF2_SHA256_LANES, Context->BlockCount - Context->FirstBlock);
+
+  MessageBits = (UINT64)(SHA256_BLOCK_SIZE + Context->SaltSize + sizeof (UINT32)) * 8;
+  for (Lane = 0; Lane < Context->LaneCount; Lane++) {
+    BlockNumber = Context->FirstBlock + Lane + 1;
+
+    ZeroMem (Block, sizeof (Block));
+    CopyMem (Block, Context->Salt, Context->SaltSize);
+    WriteBe32 (&Block[Context->SaltSize], (UINT32)BlockNumber);
+    Block[Context->SaltSize + sizeof (UINT32)] = 0x80;
+    WriteBe32 (&Block[SHA256_BLOCK_SIZE - 8], (UINT32)RShiftU64 (MessageBits, 32));
+    WriteBe32 (&Block[SHA256_BLOCK_SIZE - 4], (UINT32)MessageBits);
+
+    for (Index = 0; Index < SHA256_BLOCK_WORDS; Index++) {
+      Context->Message[Lane][Index] = ReadBe32 (&Block[Index * sizeof (UINT32)]);
+    }
+  }
+
+  HmacSha256Lanes (Context);
+  CopyMem (Context->Result, Context->State, sizeof (Context->Result));
+
+  // The later messages are the previous U, in the fixed padding of Context->Inner.
+  //
+  for (Lane = 0; Lane < Context->LaneCount; Lane++) {
+    CopyMem (Context->Message[Lane], Context->Inner[Lane], sizeof (Context->Message[Lane]));
+  }
+
+  Context->Iteration = 1;
+}
+
+/**
+  Writes the output blocks of the current group.
+
+  @param[in,out]  Context   PBKDF2 context.
+
+**/
+STATIC
+VOID
+FinishBlockGroup (
+  IN OUT PBKDF2_SHA256_CONTEXT  *Context
+  )
+{
+  UINT8  Digest[SHA256_DIGEST_SIZE];
+  UINTN  Lane;
+  UINTN  Index;
+  UINTN  CopySize;
+
+  for (Lane = 0; Lane < Context->LaneCount; Lane++) {
+    for (Index = 0; Index < SHA256_STATE_WORDS; Index++) {
+      WriteBe32 (&Digest[Index * sizeof (UINT32)], Context->Result[Lane][Index]);
+    }
+
+    CopySize = MIN (SHA256_DIGEST_SIZE, Context->OutputSize - (Context->FirstBlock + Lane) * SHA256_DIGEST_SIZE);
+    CopyMem (&Context->Output[(Context->FirstBlock + Lane) * SHA256_DIGEST_SIZE], Digest, CopySize);
+  }
+
+  ZeroMem (Digest, sizeof (Digest));
+
+  Context->FirstBlock += PBKDF2_SHA256_LANES;
+  Context->Iteration   = 0;
+}
+
+/**
+  Runs up to MaxIterations more iterations of a derivation started with Pbkdf2Sha256Init ().
+  When the key is complete, the context is scrubbed.
+
+  This function uses no boot services, so it may run on an application processor.
+
+  @param[in,out]  Context         Context from Pbkdf2Sha256Init ().
+  @param[in]      MaxIterations   Iterations to run before returning.
+
+  @retval     TRUE    The derived key is in the output buffer.
+  @retval     FALSE   More iterations are needed.
+
+**/
+BOOLEAN
+Pbkdf2Sha256Update (
+  IN OUT PBKDF2_SHA256_CONTEXT  *Context,
+  IN     UINTN                  MaxIterations
+  )
+{
+  UINTN  Lane;
+  UINTN  Index;
+
+  while ((Context->FirstBlock < Context->BlockCount) && (MaxIterations > 0)) {
+    if (Context->Iteration == 0) {
+      StartBlockGroup (Context);
+      MaxIterations--;
+      Context->IterationsDone++;
+    }
+
+    // Un = PRF (Password, Un-1), and the result is U1 ^ U2 ^ ... ^ Uc.
+    //
+    for ( ; (Context->Iteration < Context->IterationCount) && (MaxIterations > 0); Context->Iteration++) {
+      for (Lane = 0; Lane < Context->LaneCount; Lane++) {
+        CopyMem (Context->Message[Lane], Context->State[Lane], SHA256_DIGEST_SIZE);
+      }
+
+      HmacSha256Lanes (Context);
+
+      for (Lane = 0; Lane < Context->LaneCount; Lane++) {
+        for (Index = 0; Index < SHA256_STATE_WORDS; Index++) {
+          Context->Result[Lane][Index] ^= Context->State[Lane][Index];
+        }
+      }
+
+      MaxIterations--;
+      Context->IterationsDone++;
+    }
+
+    if (Context->Iteration == Context->IterationCount) {
+      FinishBlockGroup (Context);
+    }
+  }
+
+  if (Context->FirstBlock < Context->BlockCount) {
+    return FALSE;
+  }
+
+  // Scrub everything derived from the password.  The progress is kept for the caller.
+  //
+  ZeroMem (Context->IpadState, sizeof (Context->IpadState));
+  ZeroMem (Context->OpadState, sizeof (Context->OpadState));
+  ZeroMem (Context->Message, sizeof (Context->Message));
+  ZeroMem (Context->Inner, sizeof (Context->Inner));
+  ZeroMem (Context->State, sizeof (Context->State));
+  ZeroMem (Context->Result, sizeof (Context->Result));
+  Context->IterationsDone = Context->TotalIterations;
+
+  return TRUE;
+}
+
+/**
+  Derives a key from a password with PBKDF2-HMAC-SHA256.
+
+  @param[in]  Password        Password bytes.
+  @param[in]  PasswordSize    Size of Password in bytes.
+  @param[in]  Salt            Salt bytes.
+  @param[in]  SaltSize        Size of Salt in bytes.
+  @param[in]  IterationCount  PBKDF2 iteration count.
+  @param[in]  OutputSize      Size of the derived key in bytes.
+  @param[out] Output          Buffer that receives the derived key.
+
+  @retval     EFI_SUCCESS             The key was derived.
+  @retval     EFI_INVALID_PARAMETER   A buffer is NULL, or IterationCount or OutputSize is 0.
+  @retval     EFI_UNSUPPORTED         SaltSize is larger than PBKDF2_SHA256_MAX_SALT_SIZE.
+
+**/
+EFI_STATUS
+Pbkdf2Sha256 (
+  IN  CONST UINT8  *Password,
+  IN        UINTN  PasswordSize,
+  IN  CONST UINT8  *Salt,
+  IN        UINTN  SaltSize,
+  IN        UINTN  IterationCount,
+  IN        UINTN  OutputSize,
+  OUT       UINT8  *Output
+  )
+{
+  PBKDF2_SHA256_CONTEXT  Context;
+  EFI_STATUS             Status;
+
+  Status = Pbkdf2Sha256Init (&Context, Password, PasswordSize, Salt, SaltSize, IterationCount, OutputSize, Output);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Pbkdf2Sha256Update (&Context, MAX_UINTN);
+
+  return EFI_SUCCESS;
+}
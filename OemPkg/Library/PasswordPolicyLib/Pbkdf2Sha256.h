@@ -0,0 +1,157 @@
+/** @file -- Pbkdf2Sha256.h
+
+  PBKDF2-HMAC-SHA256 (RFC 8018) used to build password hashes.
+
+  The output blocks of PBKDF2 are independent of each other, so they are computed
+  side by side in PBKDF2_SHA256_LANES lanes rather than one after the other.  On X64
+  CPUs with the SHA extensions, the compression function runs on those instead.
+
+  The derivation can also be run in steps: Pbkdf2Sha256Init () takes the password and
+  parameters, and each Pbkdf2Sha256Update () runs a bounded number of iterations.  The
+  context holds no pointers except Output, so an application processor can run the
+  updates while the BSP keeps the UI going.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _PBKDF2_SHA256_H_
+#define _PBKDF2_SHA256_H_
+
+#define PBKDF2_SHA256_LANES  2
+
+#define SHA256_BLOCK_SIZE  64
+
+#define SHA256_STATE_WORDS  8
+#define SHA256_BLOCK_WORDS  16
+
+//
+// The salt and the 4 byte block number must fit in the single message block of the
+// first HMAC, along with the SHA-256 padding.
+//
+#define PBKDF2_SHA256_MAX_SALT_SIZE  (SHA256_BLOCK_SIZE - sizeof (UINT32) - 9)
+
+//
+// The HMAC key pads are the same for every HMAC of a password, so they are compressed once
+// and each HMAC starts from the resulting midstates.  The message blocks are big-endian words.
+//
+typedef struct {
+  UINT32            IpadState[SHA256_STATE_WORDS];
+  UINT32            OpadState[SHA256_STATE_WORDS];
+  UINT32            Message[PBKDF2_SHA256_LANES][SHA256_BLOCK_WORDS];
+  UINT32            Inner[PBKDF2_SHA256_LANES][SHA256_BLOCK_WORDS];
+  UINT32            State[PBKDF2_SHA256_LANES][SHA256_STATE_WORDS];
+  UINT32            Result[PBKDF2_SHA256_LANES][SHA256_STATE_WORDS];
+  UINTN             LaneCount;            // Lanes that hold an output block in the current group.
+  UINT8             Salt[PBKDF2_SHA256_MAX_SALT_SIZE];
+  UINTN             SaltSize;
+  UINTN             IterationCount;
+  UINT8             *Output;
+  UINTN             OutputSize;
+  UINTN             BlockCount;
+  UINTN             FirstBlock;           // First output block of the current group.
+  UINTN             Iteration;            // Next iteration of the current group.  0 if the group hasn't started.
+  UINTN             TotalIterations;      // Iterations needed for the whole key.
+  volatile UINTN    IterationsDone;       // Progress, readable from another processor.
+} PBKDF2_SHA256_CONTEXT;
+
+#if defined (MDE_CPU_X64)
+
+/**
+  SHA-256 compression function using the x86 SHA extensions.  The caller must check
+  that the CPU supports the SHA extensions and SSE4.1.
+
+  @param[in,out]  State       Hash state.
+  @param[in]      Blocks      Message blocks, as big-endian words.
+  @param[in]      BlockCount  Number of 64 byte blocks.
+
+**/
+VOID
+EFIAPI
+Sha256CompressShaNi (
+  IN OUT UINT32        *State,
+  IN     CONST UINT32  *Blocks,
+  IN     UINTN         BlockCount
+  );
+
+#endif
+
+/**
+  Starts a stepwise PBKDF2-HMAC-SHA256 derivation.  The password is only needed here.
+
+  @param[out] Context         Context to initialize.
+  @param[in]  Password        Password bytes.
+  @param[in]  PasswordSize    Size of Password in bytes.
+  @param[in]  Salt            Salt bytes.
+  @param[in]  SaltSize        Size of Salt in bytes.
+  @param[in]  IterationCount  PBKDF2 iteration count.
+  @param[in]  OutputSize      Size of the derived key in bytes.
+  @param[out] Output          Buffer that receives the derived key.  It must stay valid until
+                              Pbkdf2Sha256Update () returns TRUE.
+
+  @retval     EFI_SUCCESS             The context is ready for Pbkdf2Sha256Update ().
+  @retval     EFI_INVALID_PARAMETER   A buffer is NULL, or IterationCount or OutputSize is 0.
+  @retval     EFI_UNSUPPORTED         SaltSize is larger than PBKDF2_SHA256_MAX_SALT_SIZE.
+  @retval     EFI_DEVICE_ERROR        A password longer than a block could not be hashed.
+
+**/
+EFI_STATUS
+Pbkdf2Sha256Init (
+  OUT       PBKDF2_SHA256_CONTEXT  *Context,
+  IN  CONST UINT8                  *Password,
+  IN        UINTN                  PasswordSize,
+  IN  CONST UINT8                  *Salt,
+  IN        UINTN                  SaltSize,
+  IN        UINTN                  IterationCount,
+  IN        UINTN                  OutputSize,
+  OUT       UINT8                  *Output
+  );
+
+/**
+  Runs up to MaxIterations more iterations of a derivation started with Pbkdf2Sha256Init ().
+  When the key is complete, the context is scrubbed.
+
+  This function uses no boot services, so it may run on an application processor.
+
+  @param[in,out]  Context         Context from Pbkdf2Sha256Init ().
+  @param[in]      MaxIterations   Iterations to run before returning.
+
+  @retval     TRUE    The derived key is in the output buffer.
+  @retval     FALSE   More iterations are needed.
+
+**/
+BOOLEAN
+Pbkdf2Sha256Update (
+  IN OUT PBKDF2_SHA256_CONTEXT  *Context,
+  IN     UINTN                  MaxIterations
+  );
+
+/**
+  Derives a key from a password with PBKDF2-HMAC-SHA256.
+
+  @param[in]  Password        Password bytes.
+  @param[in]  PasswordSize    Size of Password in bytes.
+  @param[in]  Salt            Salt bytes.
+  @param[in]  SaltSize        Size of Salt in bytes.
+  @param[in]  IterationCount  PBKDF2 iteration count.
+  @param[in]  OutputSize      Size of the derived key in bytes.
+  @param[out] Output          Buffer that receives the derived key.
+
+  @retval     EFI_SUCCESS             The key was derived.
+  @retval     EFI_INVALID_PARAMETER   A buffer is NULL, or IterationCount or OutputSize is 0.
+  @retval     EFI_UNSUPPORTED         SaltSize is larger than PBKDF2_SHA256_MAX_SALT_SIZE.
+
+**/
+EFI_STATUS
+Pbkdf2Sha256 (
+  IN  CONST UINT8  *Password,
+  IN        UINTN  PasswordSize,
+  IN  CONST UINT8  *Salt,
+  IN        UINTN  SaltSize,
+  IN        UINTN  IterationCount,
+  IN        UINTN  OutputSize,
+  OUT       UINT8  *Output
+  );
+
+#endif
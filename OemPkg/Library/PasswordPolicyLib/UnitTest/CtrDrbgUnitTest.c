@@ -0,0 +1,212 @@
+/** @file -- CtrDrbgUnitTest.c
+
+  Host-based unit tests for the AES-256 CTR_DRBG of PasswordPolicyLib.
+
+  The known answer is the first AES-256 no df case of the NIST CAVP CTR_DRBG vectors
+  (drbgvectors_no_reseed, PredictionResistance = False): instantiate with EntropyInput and no
+  personalization string, generate 512 bits twice, and compare the second output with
+  ReturnedBits.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/UnitTestLib.h>
+
+#include "../CtrDrbg.h"
+
+#define UNIT_TEST_APP_NAME     "CTR_DRBG Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+STATIC CONST UINT8  mCavpEntropyInput[CTR_DRBG_SEED_SIZE] = {
+  0xdf, 0x5d, 0x73, 0xfa, 0xa4, 0x68, 0x64, 0x9e, 0xdd, 0xa3, 0x3b, 0x5c, 0xca, 0x79, 0xb0, 0xb0,
+  0x56, 0x00, 0x41, 0x9c, 0xcb, 0x7a, 0x87, 0x9d, 0xdf, 0xec, 0x9d, 0xb3, 0x2e, 0xe4, 0x94, 0xe5,
+  0x53, 0x1b, 0x51, 0xde, 0x16, 0xa3, 0x0f, 0x76, 0x92, 0x62, 0x47, 0x4c, 0x73, 0xbe, 0xc0, 0x10
+};
+
+STATIC CONST UINT8  mCavpReturnedBits[64] = {
+  0xd1, 0xc0, 0x7c, 0xd9, 0x5a, 0xf8, 0xa7, 0xf1, 0x10, 0x12, 0xc8, 0x4c, 0xe4, 0x8b, 0xb8, 0xcb,
+  0x87, 0x18, 0x9e, 0x99, 0xd4, 0x0f, 0xcc, 0xb1, 0x77, 0x1c, 0x61, 0x9b, 0xdf, 0x82, 0xab, 0x22,
+  0x80, 0xb1, 0xdc, 0x2f, 0x25, 0x81, 0xf3, 0x91, 0x64, 0xf7, 0xac, 0x0c, 0x51, 0x04, 0x94, 0xb3,
+  0xa4, 0x3c, 0x41, 0xb7, 0xdb, 0x17, 0x51, 0x4c, 0x87, 0xb1, 0x07, 0xae, 0x79, 0x3e, 0x01, 0xc5
+};
+
+STATIC CTR_DRBG_STATE  mState;
+
+/**
+  Scrubs the DRBG a test used.
+
+  @param[in]  Context   Unused.
+
+**/
+VOID
+EFIAPI
+CtrDrbgCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CtrDrbgUninstantiate (&mState);
+}
+
+/**
+  Checks the CAVP known answer.
+
+  @param[in]  Context   Unused.
+
+  @retval     UNIT_TEST_PASSED                The test passed.
+  @retval     UNIT_TEST_ERROR_TEST_FAILED     The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+CavpVectorShouldMatch (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8  Output[sizeof (mCavpReturnedBits)];
+
+  UT_ASSERT_NOT_EFI_ERROR (CtrDrbgInstantiate (&mState, mCavpEntropyInput, NULL));
+  UT_ASSERT_NOT_EFI_ERROR (CtrDrbgGenerate (&mState, Output, sizeof (Output), NULL));
+  UT_ASSERT_NOT_EFI_ERROR (CtrDrbgGenerate (&mState, Output, sizeof (Output), NULL));
+  UT_ASSERT_MEM_EQUAL (Output, mCavpReturnedBits, sizeof (Output));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Checks that output split over several requests differs from the output of one request, since
+  the key is updated after every request, and that a partial block is a prefix of a full one.
+
+  @param[in]  Context   Unused.
+
+  @retval     UNIT_TEST_PASSED                The test passed.
+  @retval     UNIT_TEST_ERROR_TEST_FAILED     The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+RequestsShouldUpdateTheKey (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8  Whole[2 * CTR_DRBG_BLOCK_SIZE];
+  UINT8  Split[2 * CTR_DRBG_BLOCK_SIZE];
+  UINT8  Partial[CTR_DRBG_BLOCK_SIZE - 1];
+
+  UT_ASSERT_NOT_EFI_ERROR (CtrDrbgInstantiate (&mState, mCavpEntropyInput, NULL));
+  UT_ASSERT_NOT_EFI_ERROR (CtrDrbgGenerate (&mState, Whole, sizeof (Whole), NULL));
+  CtrDrbgUninstantiate (&mState);
+
+  UT_ASSERT_NOT_EFI_ERROR (CtrDrbgInstantiate (&mState, mCavpEntropyInput, NULL));
+  UT_ASSERT_NOT_EFI_ERROR (CtrDrbgGenerate (&mState, Split, CTR_DRBG_BLOCK_SIZE, NULL));
+  UT_ASSERT_NOT_EFI_ERROR (CtrDrbgGenerate (&mState, &Split[CTR_DRBG_BLOCK_SIZE], CTR_DRBG_BLOCK_SIZE, NULL));
+  CtrDrbgUninstantiate (&mState);
+
+  UT_ASSERT_MEM_EQUAL (Split, Whole, CTR_DRBG_BLOCK_SIZE);
+  UT_ASSERT_TRUE (CompareMem (&Split[CTR_DRBG_BLOCK_SIZE], &Whole[CTR_DRBG_BLOCK_SIZE], CTR_DRBG_BLOCK_SIZE) != 0);
+
+  UT_ASSERT_NOT_EFI_ERROR (CtrDrbgInstantiate (&mState, mCavpEntropyInput, NULL));
+  UT_ASSERT_NOT_EFI_ERROR (CtrDrbgGenerate (&mState, Partial, sizeof (Partial), NULL));
+  UT_ASSERT_MEM_EQUAL (Partial, Whole, sizeof (Partial));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Checks that the DRBG refuses requests it must not serve.
+
+  @param[in]  Context   Unused.
+
+  @retval     UNIT_TEST_PASSED                The test passed.
+  @retval     UNIT_TEST_ERROR_TEST_FAILED     The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BadRequestsShouldFail (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8  Output[CTR_DRBG_BLOCK_SIZE];
+
+  ZeroMem (&mState, sizeof (mState));
+  UT_ASSERT_STATUS_EQUAL (CtrDrbgGenerate (&mState, Output, sizeof (Output), NULL), EFI_NOT_READY);
+  UT_ASSERT_STATUS_EQUAL (CtrDrbgReseed (&mState, mCavpEntropyInput, NULL), EFI_NOT_READY);
+
+  UT_ASSERT_NOT_EFI_ERROR (CtrDrbgInstantiate (&mState, mCavpEntropyInput, NULL));
+  UT_ASSERT_STATUS_EQUAL (CtrDrbgGenerate (&mState, Output, CTR_DRBG_MAX_REQUEST + 1, NULL), EFI_INVALID_PARAMETER);
+
+  // A DRBG that is due for a reseed refuses to generate until it gets one.
+  mState.ReseedCounter = CTR_DRBG_RESEED_INTERVAL + 1;
+  UT_ASSERT_STATUS_EQUAL (CtrDrbgGenerate (&mState, Output, sizeof (Output), NULL), EFI_NOT_READY);
+  UT_ASSERT_NOT_EFI_ERROR (CtrDrbgReseed (&mState, mCavpEntropyInput, NULL));
+  UT_ASSERT_NOT_EFI_ERROR (CtrDrbgGenerate (&mState, Output, sizeof (Output), NULL));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initializes the unit test framework, registers the tests and runs them.
+
+  @retval     EFI_SUCCESS           All tests were run.
+  @retval     EFI_OUT_OF_RESOURCES  The framework could not be set up.
+
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      DrbgSuite;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&DrbgSuite, Framework, "AES-256 CTR_DRBG", "PasswordPolicyLib.CtrDrbg", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for DrbgSuite\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (DrbgSuite, "The CAVP vector should match", "CavpVector", CavpVectorShouldMatch, NULL, CtrDrbgCleanup, NULL);
+  AddTestCase (DrbgSuite, "Each request should update the key", "KeyUpdate", RequestsShouldUpdateTheKey, NULL, CtrDrbgCleanup, NULL);
+  AddTestCase (DrbgSuite, "Bad requests should fail", "BadRequests", BadRequestsShouldFail, NULL, CtrDrbgCleanup, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -0,0 +1,631 @@
+/** @file -- PasswordHashBenchmark.c
+
+  Host-based check and microbenchmark of the key derivations behind setting a password and
+  unlocking with it.
+
+  Setting a password builds a current version store, whose key is one PBKDF2 block.  Unlocking
+  with a version 1 store rebuilds its 40 byte key, which is two PBKDF2 blocks.  Both run
+  Pbkdf2Sha256 () from BuildPasswordStore ().  Each path is derived with:
+
+    - Pkcs5HashPassword () of BaseCryptLib, which the PKCS5 protocol calls.
+    - A generic PBKDF2 that hashes both HMAC key pads in every HMAC and computes one output
+      block after another, as the PKCS5 protocol does.
+    - The pad midstates of Pbkdf2Sha256 (), one output block after another.
+    - Pbkdf2Sha256 (), with the pad midstates and the output blocks in lanes.
+    - Pbkdf2Sha256 () with the SHA extensions, on X64 hosts that have them.
+
+  The keys are checked against Pkcs5HashPassword (), then the time of each is logged.  All but
+  the first use the SHA-256 compression function of PasswordPolicyLib, so they differ only in
+  how PBKDF2 is driven.  The host OpenSSL behind Pkcs5HashPassword () may use the SHA
+  extensions, and firmware builds of OpenSSL do not, so its time is only for reference.
+
+  The library source is included rather than linked, to reach the compression function.  The
+  salt, the variable write and the MP Services dispatch of the firmware paths are not timed.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseCryptLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/UnitTestLib.h>
+
+#include <time.h>
+
+#if defined (MDE_CPU_X64)
+  #if defined (_MSC_VER)
+    #include <intrin.h>
+  #else
+    #include <cpuid.h>
+  #endif
+#endif
+
+#include "../Pbkdf2Sha256.c"
+#include "../PasswordPolicyInternal.h"
+
+#define UNIT_TEST_APP_NAME     "Password Hash Benchmark"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define BENCHMARK_ROUNDS  5
+#define MAX_KEY_SIZE      64
+
+//
+// New stores take PcdPasswordHashMinIterations when the iteration count can't be calibrated.
+// The default is the version 1 count, so both paths do the same number of iterations per block.
+//
+#define SET_PASSWORD_ITERATIONS  60000
+
+typedef
+EFI_STATUS
+(*DERIVE_KEY)(
+  IN  CONST UINT8  *Password,
+  IN        UINTN  PasswordSize,
+  IN  CONST UINT8  *Salt,
+  IN        UINTN  SaltSize,
+  IN        UINTN  IterationCount,
+  IN        UINTN  OutputSize,
+  OUT       UINT8  *Output
+  );
+
+typedef struct {
+  CONST CHAR8    *Name;
+  DERIVE_KEY     Derive;
+} DERIVE_METHOD;
+
+typedef struct {
+  CONST CHAR8    *Name;
+  UINTN          SaltSize;
+  UINTN          KeySize;
+  UINTN          IterationCount;
+} PASSWORD_HASH_PATH;
+
+STATIC CONST CHAR16  mPassword[] = L"Tr0ub4dor&3-Staple";
+
+STATIC PASSWORD_HASH_PATH  mSetPasswordPath = {
+  "Set password (version 2 store)",
+  PRIVATE_HASH_VER_2_SALT_SIZE,
+  PRIVATE_HASH_VER_2_KEY_SIZE,
+  SET_PASSWORD_ITERATIONS
+};
+
+STATIC PASSWORD_HASH_PATH  mUnlockPath = {
+  "Unlock (version 1 store)",
+  PRIVATE_HASH_VER_1_SALT_SIZE,
+  PRIVATE_HASH_VER_1_KEY_SIZE,
+  PRIVATE_HASH_VER_1_ITERATION_COUNT
+};
+
+/**
+  Selects the compression function used by the next derivation.
+
+  @param[in]  UseShaNi    TRUE for the SHA extensions, FALSE for the portable code.
+
+**/
+STATIC
+VOID
+SelectShaNi (
+  IN BOOLEAN  UseShaNi
+  )
+{
+ #if defined (MDE_CPU_X64)
+  mUseShaNi = UseShaNi;
+ #endif
+}
+
+/**
+  Derives a key with Pkcs5HashPassword () of BaseCryptLib.
+
+  @retval     EFI_SUCCESS         The key was derived.
+  @retval     EFI_DEVICE_ERROR    Pkcs5HashPassword () failed.
+
+**/
+STATIC
+EFI_STATUS
+Pkcs5Pbkdf2Sha256 (
+  IN  CONST UINT8  *Password,
+  IN        UINTN  PasswordSize,
+  IN  CONST UINT8  *Salt,
+  IN        UINTN  SaltSize,
+  IN        UINTN  IterationCount,
+  IN        UINTN  OutputSize,
+  OUT       UINT8  *Output
+  )
+{
+  if (!Pkcs5HashPassword (PasswordSize, (CONST CHAR8 *)Password, SaltSize, Salt, IterationCount, SHA256_DIGEST_SIZE, OutputSize, Output)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Computes HMAC-SHA256 of a message of one block or less, compressing both key pads.
+
+  @param[in]  Key           HMAC key, zero padded to a block.
+  @param[in]  Message       Message bytes.
+  @param[in]  MessageSize   Size of Message.  At most SHA256_BLOCK_SIZE - 9.
+  @param[out] Digest        The HMAC.
+
+**/
+STATIC
+VOID
+GenericHmacSha256 (
+  IN  CONST UINT8  *Key,
+  IN  CONST UINT8  *Message,
+  IN        UINTN  MessageSize,
+  OUT       UINT8  *Digest
+  )
+{
+  UINT32  State[PBKDF2_SHA256_LANES][SHA256_STATE_WORDS];
+  UINT32  Block[PBKDF2_SHA256_LANES][SHA256_BLOCK_WORDS];
+  UINT8   Bytes[SHA256_BLOCK_SIZE];
+  UINT8   PadByte;
+  UINTN   Pass;
+  UINTN   Index;
+
+  for (Pass = 0; Pass < 2; Pass++) {
+    PadByte = (Pass == 0) ? 0x36 : 0x5c;
+
+    CopyMem (State[0], mSha256Iv, sizeof (mSha256Iv));
+    for (Index = 0; Index < SHA256_BLOCK_WORDS; Index++) {
+      Block[0][Index] = ReadBe32 (&Key[Index * sizeof (UINT32)]) ^ (PadByte * 0x01010101U);
+    }
+
+    Sha256CompressLanes (State, Block, 1);
+
+    ZeroMem (Bytes, sizeof (Bytes));
+    CopyMem (Bytes, Message, MessageSize);
+    Bytes[MessageSize] = 0x80;
+    WriteBe32 (&Bytes[SHA256_BLOCK_SIZE - 4], (UINT32)((SHA256_BLOCK_SIZE + MessageSize) * 8));
+    for (Index = 0; Index < SHA256_BLOCK_WORDS; Index++) {
+      Block[0][Index] = ReadBe32 (&Bytes[Index * sizeof (UINT32)]);
+    }
+
+    Sha256CompressLanes (State, Block, 1);
+
+    for (Index = 0; Index < SHA256_STATE_WORDS; Index++) {
+      WriteBe32 (&Digest[Index * sizeof (UINT32)], State[0][Index]);
+    }
+
+    // The outer HMAC hashes the inner digest.
+    //
+    Message     = Digest;
+    MessageSize = SHA256_DIGEST_SIZE;
+  }
+}
+
+/**
+  Derives a key with a generic PBKDF2-HMAC-SHA256 that computes every HMAC from the key pads,
+  one output block after another.  The password must fit in a block.
+
+  @retval     EFI_SUCCESS             The key was derived.
+  @retval     EFI_UNSUPPORTED         The password or the salt is too long.
+
+**/
+STATIC
+EFI_STATUS
+GenericPbkdf2Sha256 (
+  IN  CONST UINT8  *Password,
+  IN        UINTN  PasswordSize,
+  IN  CONST UINT8  *Salt,
+  IN        UINTN  SaltSize,
+  IN        UINTN  IterationCount,
+  IN        UINTN  OutputSize,
+  OUT       UINT8  *Output
+  )
+{
+  UINT8  Key[SHA256_BLOCK_SIZE];
+  UINT8  Message[PBKDF2_SHA256_MAX_SALT_SIZE + sizeof (UINT32)];
+  UINT8  U[SHA256_DIGEST_SIZE];
+  UINT8  T[SHA256_DIGEST_SIZE];
+  UINTN  Block;
+  UINTN  Iteration;
+  UINTN  Index;
+  UINTN  Offset;
+
+  if ((PasswordSize > SHA256_BLOCK_SIZE) || (SaltSize > PBKDF2_SHA256_MAX_SALT_SIZE)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  SelectShaNi (FALSE);
+
+  ZeroMem (Key, sizeof (Key));
+  CopyMem (Key, Password, PasswordSize);
+  CopyMem (Message, Salt, SaltSize);
+
+  for (Block = 1, Offset = 0; Offset < OutputSize; Block++, Offset += SHA256_DIGEST_SIZE) {
+    WriteBe32 (&Message[SaltSize], (UINT32)Block);
+    GenericHmacSha256 (Key, Message, SaltSize + sizeof (UINT32), U);
+    CopyMem (T, U, sizeof (T));
+
+    for (Iteration = 1; Iteration < IterationCount; Iteration++) {
+      GenericHmacSha256 (Key, U, sizeof (U), U);
+      for (Index = 0; Index < sizeof (T); Index++) {
+        T[Index] ^= U[Index];
+      }
+    }
+
+    CopyMem (&Output[Offset], T, MIN (sizeof (T), OutputSize - Offset));
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Derives a key with the pad midstates of Pbkdf2Sha256 (), one output block after another.
+
+  @retval     EFI_SUCCESS   The key was derived.
+  @retval     Others        Error returned by Pbkdf2Sha256Init ().
+
+**/
+STATIC
+EFI_STATUS
+OneLanePbkdf2Sha256 (
+  IN  CONST UINT8  *Password,
+  IN        UINTN  PasswordSize,
+  IN  CONST UINT8  *Salt,
+  IN        UINTN  SaltSize,
+  IN        UINTN  IterationCount,
+  IN        UINTN  OutputSize,
+  OUT       UINT8  *Output
+  )
+{
+  PBKDF2_SHA256_CONTEXT  Context;
+  EFI_STATUS             Status;
+  UINTN                  Block;
+  UINTN                  BlockCount;
+
+  BlockCount = (OutputSize + SHA256_DIGEST_SIZE - 1) / SHA256_DIGEST_SIZE;
+  for (Block = 0; Block < BlockCount; Block++) {
+    Status = Pbkdf2Sha256Init (&Context, Password, PasswordSize, Salt, SaltSize, IterationCount, OutputSize, Output);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    // A group that ends after this block has one lane.
+    //
+    SelectShaNi (FALSE);
+    Context.FirstBlock = Block;
+    Context.BlockCount = Block + 1;
+    Pbkdf2Sha256Update (&Context, MAX_UINTN);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Derives a key with Pbkdf2Sha256 () on the portable compression function.
+
+  @retval     EFI_SUCCESS   The key was derived.
+  @retval     Others        Error returned by Pbkdf2Sha256Init ().
+
+**/
+STATIC
+EFI_STATUS
+LanesPbkdf2Sha256 (
+  IN  CONST UINT8  *Password,
+  IN        UINTN  PasswordSize,
+  IN  CONST UINT8  *Salt,
+  IN        UINTN  SaltSize,
+  IN        UINTN  IterationCount,
+  IN        UINTN  OutputSize,
+  OUT       UINT8  *Output
+  )
+{
+  PBKDF2_SHA256_CONTEXT  Context;
+  EFI_STATUS             Status;
+
+  Status = Pbkdf2Sha256Init (&Context, Password, PasswordSize, Salt, SaltSize, IterationCount, OutputSize, Output);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  SelectShaNi (FALSE);
+  Pbkdf2Sha256Update (&Context, MAX_UINTN);
+
+  return EFI_SUCCESS;
+}
+
+#if defined (MDE_CPU_X64)
+
+/**
+  Determines whether the host CPU supports the SHA extensions and SSE4.1.  The host BaseLib
+  does not report real CPUID values, so the compiler intrinsics are used.
+
+  @retval     TRUE    The CPU supports them.
+  @retval     FALSE   Not.
+
+**/
+STATIC
+BOOLEAN
+HostSupportsShaNi (
+  VOID
+  )
+{
+  UINT32  Ecx1;
+  UINT32  Ebx7;
+
+ #if defined (_MSC_VER)
+  int  Registers[4];
+
+  __cpuid (Registers, 0);
+  if (Registers[0] < 7) {
+    return FALSE;
+  }
+
+  __cpuid (Registers, 1);
+  Ecx1 = (UINT32)Registers[2];
+  __cpuidex (Registers, 7, 0);
+  Ebx7 = (UINT32)Registers[1];
+ #else
+  UINT32  Eax;
+  UINT32  Ebx;
+  UINT32  Ecx;
+  UINT32  Edx;
+
+  if (__get_cpuid_max (0, NULL) < 7) {
+    return FALSE;
+  }
+
+  __cpuid (1, Eax, Ebx, Ecx, Edx);
+  Ecx1 = Ecx;
+  __cpuid_count (7, 0, Eax, Ebx, Ecx, Edx);
+  Ebx7 = Ebx;
+ #endif
+
+  return (BOOLEAN)(((Ecx1 & BIT19) != 0) && ((Ebx7 & BIT29) != 0));
+}
+
+/**
+  Derives a key with Pbkdf2Sha256 () on the SHA extensions.
+
+  @retval     EFI_SUCCESS       The key was derived.
+  @retval     EFI_UNSUPPORTED   The host CPU lacks the SHA extensions.
+  @retval     Others            Error returned by Pbkdf2Sha256Init ().
+
+**/
+STATIC
+EFI_STATUS
+ShaNiPbkdf2Sha256 (
+  IN  CONST UINT8  *Password,
+  IN        UINTN  PasswordSize,
+  IN  CONST UINT8  *Salt,
+  IN        UINTN  SaltSize,
+  IN        UINTN  IterationCount,
+  IN        UINTN  OutputSize,
+  OUT       UINT8  *Output
+  )
+{
+  PBKDF2_SHA256_CONTEXT  Context;
+  EFI_STATUS             Status;
+
+  if (!HostSupportsShaNi ()) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = Pbkdf2Sha256Init (&Context, Password, PasswordSize, Salt, SaltSize, IterationCount, OutputSize, Output);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  SelectShaNi (TRUE);
+  Pbkdf2Sha256Update (&Context, MAX_UINTN);
+  SelectShaNi (FALSE);
+
+  return EFI_SUCCESS;
+}
+
+#endif
+
+STATIC CONST DERIVE_METHOD  mMethods[] = {
+  { "PKCS5 (host OpenSSL)",             Pkcs5Pbkdf2Sha256   },
+  { "Generic HMAC, one block at a time", GenericPbkdf2Sha256 },
+  { "Midstates, one block at a time",   OneLanePbkdf2Sha256 },
+  { "Midstates and lanes",              LanesPbkdf2Sha256   },
+ #if defined (MDE_CPU_X64)
+  { "Midstates and SHA extensions",     ShaNiPbkdf2Sha256   },
+ #endif
+};
+
+/**
+  Derives the key of a path with a method.
+
+  @param[in]  Path      The password hash path.
+  @param[in]  Method    The derivation.
+  @param[out] Key       The key.  MAX_KEY_SIZE bytes.
+
+  @return     The status returned by the derivation.
+
+**/
+STATIC
+EFI_STATUS
+DerivePathKey (
+  IN  CONST PASSWORD_HASH_PATH  *Path,
+  IN  CONST DERIVE_METHOD       *Method,
+  OUT       UINT8               *Key
+  )
+{
+  UINT8  Salt[PBKDF2_SHA256_MAX_SALT_SIZE];
+  UINTN  Index;
+
+  for (Index = 0; Index < Path->SaltSize; Index++) {
+    Salt[Index] = (UINT8)(0xA5 ^ (Index * 7));
+  }
+
+  SetMem (Key, MAX_KEY_SIZE, 0);
+  return Method->Derive (
+                   (CONST UINT8 *)mPassword,
+                   sizeof (mPassword) - sizeof (CHAR16),
+                   Salt,
+                   Path->SaltSize,
+                   Path->IterationCount,
+                   Path->KeySize,
+                   Key
+                   );
+}
+
+/**
+  Checks that every method derives the key Pkcs5HashPassword () does, on both paths.
+
+  @param[in]  Context   Unused.
+
+  @retval     UNIT_TEST_PASSED                The test passed.
+  @retval     UNIT_TEST_ERROR_TEST_FAILED     The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+KeysShouldMatchPkcs5 (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CONST PASSWORD_HASH_PATH  *Paths[2];
+  UINT8                     Expected[MAX_KEY_SIZE];
+  UINT8                     Key[MAX_KEY_SIZE];
+  EFI_STATUS                Status;
+  UINTN                     PathIndex;
+  UINTN                     Index;
+
+  Paths[0] = &mSetPasswordPath;
+  Paths[1] = &mUnlockPath;
+
+  for (PathIndex = 0; PathIndex < ARRAY_SIZE (Paths); PathIndex++) {
+    Status = DerivePathKey (Paths[PathIndex], &mMethods[0], Expected);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+
+    for (Index = 1; Index < ARRAY_SIZE (mMethods); Index++) {
+      Status = DerivePathKey (Paths[PathIndex], &mMethods[Index], Key);
+      if (Status == EFI_UNSUPPORTED) {
+        continue;
+      }
+
+      UT_ASSERT_NOT_EFI_ERROR (Status);
+      UT_ASSERT_MEM_EQUAL (Key, Expected, MAX_KEY_SIZE);
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Times every method on a path, and logs the time per key.
+
+  @param[in]  Context   The PASSWORD_HASH_PATH to time.
+
+  @retval     UNIT_TEST_PASSED                The times are logged.
+  @retval     UNIT_TEST_ERROR_TEST_FAILED     A derivation failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BenchmarkPasswordHashPath (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CONST PASSWORD_HASH_PATH  *Path;
+  UINT8                     Key[MAX_KEY_SIZE];
+  EFI_STATUS                Status;
+  UINTN                     Index;
+  UINTN                     Round;
+  clock_t                   Start;
+  clock_t                   Ticks;
+
+  Path = (CONST PASSWORD_HASH_PATH *)Context;
+
+  UT_LOG_INFO (
+    "%a: %u byte key, %u iterations, %u rounds\n",
+    Path->Name,
+    (UINT32)Path->KeySize,
+    (UINT32)Path->IterationCount,
+    (UINT32)BENCHMARK_ROUNDS
+    );
+
+  for (Index = 0; Index < ARRAY_SIZE (mMethods); Index++) {
+    Status = EFI_SUCCESS;
+    Start  = clock ();
+    for (Round = 0; (Round < BENCHMARK_ROUNDS) && !EFI_ERROR (Status); Round++) {
+      Status = DerivePathKey (Path, &mMethods[Index], Key);
+    }
+
+    Ticks = clock () - Start;
+
+    if (Status == EFI_UNSUPPORTED) {
+      UT_LOG_INFO ("  %-36a not supported by this CPU\n", mMethods[Index].Name);
+      continue;
+    }
+
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_LOG_INFO (
+      "  %-36a %lu us/key\n",
+      mMethods[Index].Name,
+      (UINT64)Ticks * 1000000ULL / CLOCKS_PER_SEC / BENCHMARK_ROUNDS
+      );
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initializes the unit test framework, registers the tests and runs them.
+
+  @retval     EFI_SUCCESS           All tests were run.
+  @retval     EFI_OUT_OF_RESOURCES  The framework could not be set up.
+
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      HashSuite;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&HashSuite, Framework, "Password hash paths", "PasswordPolicyLib.PasswordHash", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for HashSuite\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (HashSuite, "Keys should match the PKCS5 hash", "Keys", KeysShouldMatchPkcs5, NULL, NULL, NULL);
+  AddTestCase (HashSuite, "Time per key, set password", "SetPassword", BenchmarkPasswordHashPath, NULL, NULL, &mSetPasswordPath);
+  AddTestCase (HashSuite, "Time per key, unlock", "Unlock", BenchmarkPasswordHashPath, NULL, NULL, &mUnlockPath);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -0,0 +1,379 @@
+/** @file -- Pbkdf2Sha256UnitTest.c
+
+  Host-based unit tests for the PBKDF2-HMAC-SHA256 implementation in PasswordPolicyLib.
+
+  The known answers are the PBKDF2-HMAC-SHA256 vectors of RFC 7914 section 11, and the
+  RFC 6070 inputs run through PBKDF2-HMAC-SHA256.  The host BaseLib reports no CPUID
+  features, so these tests cover the portable compression function.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/UnitTestLib.h>
+
+#include "../Pbkdf2Sha256.h"
+
+#define UNIT_TEST_APP_NAME     "PBKDF2-HMAC-SHA256 Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define MAX_TEST_OUTPUT_SIZE  128
+
+typedef struct {
+  CONST CHAR8    *Password;
+  UINTN          PasswordSize;
+  CONST CHAR8    *Salt;
+  UINTN          SaltSize;
+  UINTN          IterationCount;
+  UINTN          OutputSize;
+  CONST UINT8    *Expected;
+} PBKDF2_TEST_VECTOR;
+
+//
+// RFC 6070 inputs.
+//
+STATIC CONST UINT8  mRfc6070Dk1[] = {
+  0x12, 0x0f, 0xb6, 0xcf, 0xfc, 0xf8, 0xb3, 0x2c, 0x43, 0xe7, 0x22, 0x52, 0x56, 0xc4, 0xf8, 0x37,
+  0xa8, 0x65, 0x48, 0xc9, 0x2c, 0xcc, 0x35, 0x48, 0x08, 0x05, 0x98, 0x7c, 0xb7, 0x0b, 0xe1, 0x7b
+};
+
+STATIC CONST UINT8  mRfc6070Dk2[] = {
+  0xae, 0x4d, 0x0c, 0x95, 0xaf, 0x6b, 0x46, 0xd3, 0x2d, 0x0a, 0xdf, 0xf9, 0x28, 0xf0, 0x6d, 0xd0,
+  0x2a, 0x30, 0x3f, 0x8e, 0xf3, 0xc2, 0x51, 0xdf, 0xd6, 0xe2, 0xd8, 0x5a, 0x95, 0x47, 0x4c, 0x43
+};
+
+STATIC CONST UINT8  mRfc6070Dk4096[] = {
+  0xc5, 0xe4, 0x78, 0xd5, 0x92, 0x88, 0xc8, 0x41, 0xaa, 0x53, 0x0d, 0xb6, 0x84, 0x5c, 0x4c, 0x8d,
+  0x96, 0x28, 0x93, 0xa0, 0x01, 0xce, 0x4e, 0x11, 0xa4, 0x96, 0x38, 0x73, 0xaa, 0x98, 0x13, 0x4a
+};
+
+STATIC CONST UINT8  mRfc6070DkLong[] = {
+  0x34, 0x8c, 0x89, 0xdb, 0xcb, 0xd3, 0x2b, 0x2f, 0x32, 0xd8, 0x14, 0xb8, 0x11, 0x6e, 0x84, 0xcf,
+  0x2b, 0x17, 0x34, 0x7e, 0xbc, 0x18, 0x00, 0x18, 0x1c, 0x4e, 0x2a, 0x1f, 0xb8, 0xdd, 0x53, 0xe1,
+  0xc6, 0x35, 0x51, 0x8c, 0x7d, 0xac, 0x47, 0xe9
+};
+
+STATIC CONST UINT8  mRfc6070DkNul[] = {
+  0x89, 0xb6, 0x9d, 0x05, 0x16, 0xf8, 0x29, 0x89, 0x3c, 0x69, 0x62, 0x26, 0x65, 0x0a, 0x86, 0x87
+};
+
+//
+// RFC 7914 section 11.
+//
+STATIC CONST UINT8  mRfc7914Dk1[] = {
+  0x55, 0xac, 0x04, 0x6e, 0x56, 0xe3, 0x08, 0x9f, 0xec, 0x16, 0x91, 0xc2, 0x25, 0x44, 0xb6, 0x05,
+  0xf9, 0x41, 0x85, 0x21, 0x6d, 0xde, 0x04, 0x65, 0xe6, 0x8b, 0x9d, 0x57, 0xc2, 0x0d, 0xac, 0xbc,
+  0x49, 0xca, 0x9c, 0xcc, 0xf1, 0x79, 0xb6, 0x45, 0x99, 0x16, 0x64, 0xb3, 0x9d, 0x77, 0xef, 0x31,
+  0x7c, 0x71, 0xb8, 0x45, 0xb1, 0xe3, 0x0b, 0xd5, 0x09, 0x11, 0x20, 0x41, 0xd3, 0xa1, 0x97, 0x83
+};
+
+STATIC CONST UINT8  mRfc7914Dk80000[] = {
+  0x4d, 0xdc, 0xd8, 0xf6, 0x0b, 0x98, 0xbe, 0x21, 0x83, 0x0c, 0xee, 0x5e, 0xf2, 0x27, 0x01, 0xf9,
+  0x64, 0x1a, 0x44, 0x18, 0xd0, 0x4c, 0x04, 0x14, 0xae, 0xff, 0x08, 0x87, 0x6b, 0x34, 0xab, 0x56,
+  0xa1, 0xd4, 0x25, 0xa1, 0x22, 0x58, 0x33, 0x54, 0x9a, 0xdb, 0x84, 0x1b, 0x51, 0xc9, 0xb3, 0x17,
+  0x6a, 0x27, 0x2b, 0xde, 0xbb, 0xa1, 0xd0, 0x78, 0x47, 0x8f, 0x62, 0xb3, 0x97, 0xf3, 0x3c, 0x8d
+};
+
+//
+// Three output blocks, the last one partial, so the last lane group is short.  Computed with an
+// independent implementation.
+//
+STATIC CONST UINT8  mThreeBlockDk[] = {
+  0xad, 0x35, 0x24, 0x0a, 0xc6, 0x83, 0xfe, 0xbf, 0xaf, 0x3c, 0xd4, 0x9d, 0x84, 0x54, 0x73, 0xfb,
+  0xbb, 0xaa, 0x24, 0x37, 0xf5, 0xf8, 0x2d, 0x5a, 0x41, 0x5a, 0xe0, 0x0a, 0xc7, 0x6c, 0x6b, 0xfc,
+  0xcf, 0x9a, 0x9b, 0x8d, 0x6d, 0x2f, 0xe4, 0xa1, 0xe7, 0x00, 0xc4, 0x46, 0x0b, 0x04, 0x0d, 0xbe,
+  0xd6, 0x92, 0xc1, 0xcb, 0x85, 0xa7, 0x47, 0xf3, 0x55, 0x88, 0xc0, 0x89, 0x30, 0xfc, 0xfc, 0x41,
+  0xac, 0x48, 0x08, 0x20, 0x86, 0x06
+};
+
+//
+// A password longer than a block, which is hashed before it is used as the HMAC key.
+//
+STATIC CONST UINT8  mLongPasswordDk[] = {
+  0xa5, 0x30, 0x0b, 0xaa, 0x06, 0xce, 0x2b, 0x53, 0x68, 0xf2, 0x64, 0x4e, 0x23, 0x76, 0x80, 0x28,
+  0xc7, 0xa3, 0x70, 0xbe, 0x60, 0x3f, 0x93, 0x7d, 0xfe, 0x65, 0xb8, 0xb2, 0xdb, 0x90, 0x8e, 0x77
+};
+
+STATIC CONST PBKDF2_TEST_VECTOR  mRfc6070Vectors[] = {
+  { "password",                 8,  "salt",                                 4,  1,    sizeof (mRfc6070Dk1),    mRfc6070Dk1    },
+  { "password",                 8,  "salt",                                 4,  2,    sizeof (mRfc6070Dk2),    mRfc6070Dk2    },
+  { "password",                 8,  "salt",                                 4,  4096, sizeof (mRfc6070Dk4096), mRfc6070Dk4096 },
+  { "passwordPASSWORDpassword", 24, "saltSALTsaltSALTsaltSALTsaltSALTsalt", 36, 4096, sizeof (mRfc6070DkLong), mRfc6070DkLong },
+  { "pass\0word",               9,  "sa\0lt",                               5,  4096, sizeof (mRfc6070DkNul),  mRfc6070DkNul  }
+};
+
+STATIC CONST PBKDF2_TEST_VECTOR  mMultiBlockVectors[] = {
+  { "passwd",   6, "salt", 4, 1,     sizeof (mRfc7914Dk1),     mRfc7914Dk1     },
+  { "Password", 8, "NaCl", 4, 80000, sizeof (mRfc7914Dk80000), mRfc7914Dk80000 },
+  { "password", 8, "salt", 4, 3,     sizeof (mThreeBlockDk),   mThreeBlockDk   }
+};
+
+STATIC CONST PBKDF2_TEST_VECTOR  mLongPasswordVector = {
+  "passwordPASSWORDpasswordpasswordPASSWORDpasswordpasswordPASSWORDpassword", 72, "salt", 4, 2, sizeof (mLongPasswordDk), mLongPasswordDk
+};
+
+/**
+  Runs Pbkdf2Sha256 () on each vector of a table and checks the derived keys.
+
+  @param[in]  Vectors       Test vectors.
+  @param[in]  VectorCount   Number of vectors.
+
+  @retval     UNIT_TEST_PASSED                Every key matched.
+  @retval     UNIT_TEST_ERROR_TEST_FAILED     A derivation failed or a key did not match.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+CheckVectors (
+  IN CONST PBKDF2_TEST_VECTOR  *Vectors,
+  IN       UINTN               VectorCount
+  )
+{
+  UINT8       Output[MAX_TEST_OUTPUT_SIZE];
+  EFI_STATUS  Status;
+  UINTN       Index;
+
+  for (Index = 0; Index < VectorCount; Index++) {
+    UT_ASSERT_TRUE (Vectors[Index].OutputSize <= sizeof (Output));
+
+    SetMem (Output, sizeof (Output), 0xAA);
+    Status = Pbkdf2Sha256 (
+               (CONST UINT8 *)Vectors[Index].Password,
+               Vectors[Index].PasswordSize,
+               (CONST UINT8 *)Vectors[Index].Salt,
+               Vectors[Index].SaltSize,
+               Vectors[Index].IterationCount,
+               Vectors[Index].OutputSize,
+               Output
+               );
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_MEM_EQUAL (Output, Vectors[Index].Expected, Vectors[Index].OutputSize);
+
+    // Nothing past the requested size is written.
+    //
+    if (Vectors[Index].OutputSize < sizeof (Output)) {
+      UT_ASSERT_EQUAL (Output[Vectors[Index].OutputSize], 0xAA);
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Checks the RFC 6070 inputs.
+
+  @param[in]  Context   Unused.
+
+  @retval     UNIT_TEST_PASSED                The test passed.
+  @retval     UNIT_TEST_ERROR_TEST_FAILED     The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+Rfc6070VectorsShouldMatch (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  return CheckVectors (mRfc6070Vectors, ARRAY_SIZE (mRfc6070Vectors));
+}
+
+/**
+  Checks keys of more than one output block, including a short last lane group.
+
+  @param[in]  Context   Unused.
+
+  @retval     UNIT_TEST_PASSED                The test passed.
+  @retval     UNIT_TEST_ERROR_TEST_FAILED     The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+MultiBlockVectorsShouldMatch (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  return CheckVectors (mMultiBlockVectors, ARRAY_SIZE (mMultiBlockVectors));
+}
+
+/**
+  Checks a password longer than the SHA-256 block size.
+
+  @param[in]  Context   Unused.
+
+  @retval     UNIT_TEST_PASSED                The test passed.
+  @retval     UNIT_TEST_ERROR_TEST_FAILED     The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+LongPasswordShouldMatch (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  return CheckVectors (&mLongPasswordVector, 1);
+}
+
+/**
+  Runs every multi-block vector through Pbkdf2Sha256Init () and Pbkdf2Sha256Update () in
+  small steps that do not line up with the lane groups, and checks the progress and the key.
+
+  @param[in]  Context   Unused.
+
+  @retval     UNIT_TEST_PASSED                The test passed.
+  @retval     UNIT_TEST_ERROR_TEST_FAILED     The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+StepwiseUpdateShouldMatch (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  STATIC CONST UINTN        StepSizes[] = { 1, 2, 7, 1000 };
+  PBKDF2_SHA256_CONTEXT     Pbkdf2;
+  CONST PBKDF2_TEST_VECTOR  *Vector;
+  UINT8                     Output[MAX_TEST_OUTPUT_SIZE];
+  EFI_STATUS                Status;
+  UINTN                     Index;
+  UINTN                     Step;
+  UINTN                     Done;
+  BOOLEAN                   Complete;
+
+  for (Index = 0; Index < ARRAY_SIZE (mMultiBlockVectors); Index++) {
+    Vector = &mMultiBlockVectors[Index];
+    for (Step = 0; Step < ARRAY_SIZE (StepSizes); Step++) {
+      ZeroMem (Output, sizeof (Output));
+      Status = Pbkdf2Sha256Init (
+                 &Pbkdf2,
+                 (CONST UINT8 *)Vector->Password,
+                 Vector->PasswordSize,
+                 (CONST UINT8 *)Vector->Salt,
+                 Vector->SaltSize,
+                 Vector->IterationCount,
+                 Vector->OutputSize,
+                 Output
+                 );
+      UT_ASSERT_NOT_EFI_ERROR (Status);
+      UT_ASSERT_EQUAL (Pbkdf2.IterationsDone, 0);
+
+      // Each step runs exactly StepSizes[Step] iterations until the last one.
+      //
+      do {
+        Done     = Pbkdf2.IterationsDone;
+        Complete = Pbkdf2Sha256Update (&Pbkdf2, StepSizes[Step]);
+        if (!Complete) {
+          UT_ASSERT_EQUAL (Pbkdf2.IterationsDone, Done + StepSizes[Step]);
+          UT_ASSERT_TRUE (Pbkdf2.IterationsDone < Pbkdf2.TotalIterations);
+        }
+      } while (!Complete);
+
+      UT_ASSERT_EQUAL (Pbkdf2.IterationsDone, Pbkdf2.TotalIterations);
+      UT_ASSERT_MEM_EQUAL (Output, Vector->Expected, Vector->OutputSize);
+
+      // A finished derivation stays finished.
+      //
+      UT_ASSERT_TRUE (Pbkdf2Sha256Update (&Pbkdf2, 1));
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Checks that bad parameters are rejected.
+
+  @param[in]  Context   Unused.
+
+  @retval     UNIT_TEST_PASSED                The test passed.
+  @retval     UNIT_TEST_ERROR_TEST_FAILED     The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BadParametersShouldFail (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8  Salt[PBKDF2_SHA256_MAX_SALT_SIZE + 1];
+  UINT8  Output[SHA256_DIGEST_SIZE];
+
+  ZeroMem (Salt, sizeof (Salt));
+
+  UT_ASSERT_STATUS_EQUAL (Pbkdf2Sha256 (NULL, 0, Salt, 4, 1, sizeof (Output), Output), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (Pbkdf2Sha256 ((CONST UINT8 *)"p", 1, NULL, 4, 1, sizeof (Output), Output), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (Pbkdf2Sha256 ((CONST UINT8 *)"p", 1, Salt, 4, 1, sizeof (Output), NULL), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (Pbkdf2Sha256 ((CONST UINT8 *)"p", 1, Salt, 4, 0, sizeof (Output), Output), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (Pbkdf2Sha256 ((CONST UINT8 *)"p", 1, Salt, 4, 1, 0, Output), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (Pbkdf2Sha256 ((CONST UINT8 *)"p", 1, Salt, sizeof (Salt), 1, sizeof (Output), Output), EFI_UNSUPPORTED);
+  UT_ASSERT_NOT_EFI_ERROR (Pbkdf2Sha256 ((CONST UINT8 *)"p", 1, Salt, PBKDF2_SHA256_MAX_SALT_SIZE, 1, sizeof (Output), Output));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initializes the unit test framework, registers the tests and runs them.
+
+  @retval     EFI_SUCCESS           All tests were run.
+  @retval     EFI_OUT_OF_RESOURCES  The framework could not be set up.
+
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      Pbkdf2Suite;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&Pbkdf2Suite, Framework, "PBKDF2-HMAC-SHA256", "PasswordPolicyLib.Pbkdf2Sha256", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for Pbkdf2Suite\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (Pbkdf2Suite, "RFC 6070 inputs should match", "Rfc6070", Rfc6070VectorsShouldMatch, NULL, NULL, NULL);
+  AddTestCase (Pbkdf2Suite, "Multi-block keys should match", "MultiBlock", MultiBlockVectorsShouldMatch, NULL, NULL, NULL);
+  AddTestCase (Pbkdf2Suite, "Passwords longer than a block should match", "LongPassword", LongPasswordShouldMatch, NULL, NULL, NULL);
+  AddTestCase (Pbkdf2Suite, "Stepwise updates should match", "Stepwise", StepwiseUpdateShouldMatch, NULL, NULL, NULL);
+  AddTestCase (Pbkdf2Suite, "Bad parameters should fail", "BadParameters", BadParametersShouldFail, NULL, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -0,0 +1,326 @@
+/** @file -- Sha256ShaNiUnitTest.c
+
+  Host-based unit tests that check Sha256CompressShaNi () against the portable SHA-256
+  compression function of PasswordPolicyLib, on pseudo-random states and blocks.
+
+  The portable compression function is STATIC, so the library source is included here
+  rather than linked.  The tests are skipped when the host CPU lacks the SHA extensions.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/UnitTestLib.h>
+
+#if defined (_MSC_VER)
+  #include <intrin.h>
+#else
+  #include <cpuid.h>
+#endif
+
+#include "../Pbkdf2Sha256.c"
+
+#define UNIT_TEST_APP_NAME     "SHA-256 SHA Extensions Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define RANDOM_SEED     0x9E3779B97F4A7C15ULL
+#define RANDOM_ROUNDS   4096
+#define MAX_RUN_BLOCKS  8
+
+STATIC UINT64  mRandomState;
+
+/**
+  Returns the next value of a xorshift64 generator, so a failure can be reproduced.
+
+  @return     A pseudo-random 32-bit value.
+
+**/
+STATIC
+UINT32
+NextRandom (
+  VOID
+  )
+{
+  mRandomState ^= mRandomState << 13;
+  mRandomState ^= mRandomState >> 7;
+  mRandomState ^= mRandomState << 17;
+
+  return (UINT32)(mRandomState >> 32);
+}
+
+/**
+  Fills a buffer of 32-bit words with pseudo-random values.
+
+  @param[out] Words       Buffer to fill.
+  @param[in]  WordCount   Number of words.
+
+**/
+STATIC
+VOID
+FillRandom (
+  OUT UINT32  *Words,
+  IN  UINTN   WordCount
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < WordCount; Index++) {
+    Words[Index] = NextRandom ();
+  }
+}
+
+/**
+  Determines whether the host CPU supports the instructions Sha256CompressShaNi () uses.
+  The host BaseLib does not report real CPUID values, so the compiler intrinsics are used.
+
+  @retval     TRUE    The CPU supports the SHA extensions and SSE4.1.
+  @retval     FALSE   Not.
+
+**/
+STATIC
+BOOLEAN
+HostSupportsShaNi (
+  VOID
+  )
+{
+  UINT32  Ecx1;
+  UINT32  Ebx7;
+
+ #if defined (_MSC_VER)
+  int  Registers[4];
+
+  __cpuid (Registers, 0);
+  if (Registers[0] < 7) {
+    return FALSE;
+  }
+
+  __cpuid (Registers, 1);
+  Ecx1 = (UINT32)Registers[2];
+  __cpuidex (Registers, 7, 0);
+  Ebx7 = (UINT32)Registers[1];
+ #else
+  UINT32  Eax;
+  UINT32  Ebx;
+  UINT32  Ecx;
+  UINT32  Edx;
+
+  if (__get_cpuid_max (0, NULL) < 7) {
+    return FALSE;
+  }
+
+  __cpuid (1, Eax, Ebx, Ecx, Edx);
+  Ecx1 = Ecx;
+  __cpuid_count (7, 0, Eax, Ebx, Ecx, Edx);
+  Ebx7 = Ebx;
+ #endif
+
+  return (BOOLEAN)(((Ecx1 & BIT19) != 0) && ((Ebx7 & BIT29) != 0));
+}
+
+/**
+  Skips a test when the host CPU lacks the SHA extensions, and resets the generator.
+
+  @param[in]  Context   Unused.
+
+  @retval     UNIT_TEST_PASSED    The test can run.
+  @retval     UNIT_TEST_SKIPPED   The CPU lacks the SHA extensions.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ShaNiPrerequisite (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  if (!HostSupportsShaNi ()) {
+    UT_LOG_WARNING ("The host CPU does not support the SHA extensions.\n");
+    return UNIT_TEST_SKIPPED;
+  }
+
+  mRandomState = RANDOM_SEED;
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Compresses single random blocks in every lane through Sha256CompressLanes (), once on
+  the portable path and once on the SHA extensions path, and compares the states.
+
+  @param[in]  Context   Unused.
+
+  @retval     UNIT_TEST_PASSED                The test passed.
+  @retval     UNIT_TEST_ERROR_TEST_FAILED     The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SingleBlocksShouldMatch (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT32  Block[PBKDF2_SHA256_LANES][SHA256_BLOCK_WORDS];
+  UINT32  Portable[PBKDF2_SHA256_LANES][SHA256_STATE_WORDS];
+  UINT32  ShaNi[PBKDF2_SHA256_LANES][SHA256_STATE_WORDS];
+  UINTN   Round;
+
+  for (Round = 0; Round < RANDOM_ROUNDS; Round++) {
+    FillRandom (&Block[0][0], sizeof (Block) / sizeof (UINT32));
+    FillRandom (&Portable[0][0], sizeof (Portable) / sizeof (UINT32));
+    CopyMem (ShaNi, Portable, sizeof (ShaNi));
+
+    mUseShaNi = FALSE;
+    Sha256CompressLanes (Portable, Block, PBKDF2_SHA256_LANES);
+    mUseShaNi = TRUE;
+    Sha256CompressLanes (ShaNi, Block, PBKDF2_SHA256_LANES);
+    mUseShaNi = FALSE;
+
+    UT_ASSERT_MEM_EQUAL (ShaNi, Portable, sizeof (Portable));
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Compresses runs of random blocks with one Sha256CompressShaNi () call, and compares the
+  state with the portable function run on the blocks one at a time.
+
+  @param[in]  Context   Unused.
+
+  @retval     UNIT_TEST_PASSED                The test passed.
+  @retval     UNIT_TEST_ERROR_TEST_FAILED     The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BlockRunsShouldMatch (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT32  Blocks[MAX_RUN_BLOCKS][SHA256_BLOCK_WORDS];
+  UINT32  Block[PBKDF2_SHA256_LANES][SHA256_BLOCK_WORDS];
+  UINT32  Portable[PBKDF2_SHA256_LANES][SHA256_STATE_WORDS];
+  UINT32  ShaNi[SHA256_STATE_WORDS];
+  UINTN   Round;
+  UINTN   BlockCount;
+  UINTN   Index;
+  UINTN   Lane;
+
+  mUseShaNi = FALSE;
+
+  for (Round = 0; Round < RANDOM_ROUNDS / MAX_RUN_BLOCKS; Round++) {
+    BlockCount = (NextRandom () % MAX_RUN_BLOCKS) + 1;
+    FillRandom (&Blocks[0][0], BlockCount * SHA256_BLOCK_WORDS);
+    FillRandom (ShaNi, SHA256_STATE_WORDS);
+
+    for (Lane = 0; Lane < PBKDF2_SHA256_LANES; Lane++) {
+      CopyMem (Portable[Lane], ShaNi, sizeof (ShaNi));
+    }
+
+    for (Index = 0; Index < BlockCount; Index++) {
+      for (Lane = 0; Lane < PBKDF2_SHA256_LANES; Lane++) {
+        CopyMem (Block[Lane], Blocks[Index], sizeof (Block[Lane]));
+      }
+
+      Sha256CompressLanes (Portable, Block, 1);
+    }
+
+    Sha256CompressShaNi (ShaNi, &Blocks[0][0], BlockCount);
+
+    UT_ASSERT_MEM_EQUAL (ShaNi, Portable[0], sizeof (ShaNi));
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Checks that a zero block count leaves the state alone.
+
+  @param[in]  Context   Unused.
+
+  @retval     UNIT_TEST_PASSED                The test passed.
+  @retval     UNIT_TEST_ERROR_TEST_FAILED     The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ZeroBlocksShouldNotChangeState (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT32  State[SHA256_STATE_WORDS];
+  UINT32  Block[SHA256_BLOCK_WORDS];
+
+  CopyMem (State, mSha256Iv, sizeof (State));
+  FillRandom (Block, SHA256_BLOCK_WORDS);
+
+  Sha256CompressShaNi (State, Block, 0);
+
+  UT_ASSERT_MEM_EQUAL (State, mSha256Iv, sizeof (State));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initializes the unit test framework, registers the tests and runs them.
+
+  @retval     EFI_SUCCESS           All tests were run.
+  @retval     EFI_OUT_OF_RESOURCES  The framework could not be set up.
+
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      ShaNiSuite;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&ShaNiSuite, Framework, "SHA-256 SHA extensions", "PasswordPolicyLib.Sha256ShaNi", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for ShaNiSuite\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (ShaNiSuite, "Single blocks should match the portable path", "SingleBlocks", SingleBlocksShouldMatch, ShaNiPrerequisite, NULL, NULL);
+  AddTestCase (ShaNiSuite, "Block runs should match the portable path", "BlockRuns", BlockRunsShouldMatch, ShaNiPrerequisite, NULL, NULL);
+  AddTestCase (ShaNiSuite, "Zero blocks should not change the state", "ZeroBlocks", ZeroBlocksShouldNotChangeState, ShaNiPrerequisite, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -55,6 +55,25 @@ PasswordPolicyCleansePwBuffer (
   return;
 } // PasswordPolicyCleansePwBuffer()
 
+/**
+  Public interface for random bytes, such as salts, session keys and nonces.
+
+  @param[out] Buffer  Buffer for the random bytes.
+  @param[in]  Size    Number of random bytes.
+
+  @retval     EFI_UNSUPPORTED   Always.
+
+**/
+EFI_STATUS
+EFIAPI
+PasswordPolicyGetRandomBytes (
+  OUT UINT8  *Buffer,
+  IN  UINTN  Size
+  )
+{
+  return EFI_UNSUPPORTED;
+} // PasswordPolicyGetRandomBytes()
+
 /**
   Public interface for validating password strings.
 
@@ -138,3 +157,113 @@ PasswordPolicyGeneratePasswordHash (
 {
   return EFI_UNSUPPORTED;
 } // PasswordSupportGeneratePasswordHash()
+
+/**
+  Public interface for determining whether a password hash was built with the current
+  version and parameters.
+
+  A hash that is not current still validates.  Callers that have just authenticated the
+  password should replace it with a new hash from PasswordPolicyGeneratePasswordHash().
+
+  @param[in]  PasswordHash            Pointer to the buffer containing the hash.
+  @param[in]  PasswordHashSize        Size of the buffer containing the hash.
+
+  @retval     TRUE      The hash is current, or is the no-password hash.
+  @retval     FALSE     The hash should be regenerated.
+
+**/
+BOOLEAN
+EFIAPI
+PasswordPolicyIsPasswordHashCurrent (
+  IN  CONST PASSWORD_HASH  PasswordHash,
+  IN        UINTN          PasswordHashSize
+  )
+{
+  return TRUE;
+}
+
+/**
+  Public interface for starting a password hash in the background.
+
+  Takes the same inputs as PasswordPolicyGeneratePasswordHash ().  The key derivation runs on
+  an application processor when MP Services can start one.  Otherwise it runs a slice at a
+  time from PasswordPolicyPollPasswordHash ().
+
+  The password is not needed after this returns.
+
+  @param[in]  OldSalt               Pass in old PASSWORD_HASH to use the existing salt
+  @param[in]  Password              Pointer to a buffer containing the clear text password.
+                                    If Password == NULL, generate a no-password "hash"
+  @param[out] Task                  The new task.  Must be passed to PasswordPolicyFinishPasswordHash ().
+
+  @retval   EFI_SUCCESS             The task was started.
+  @retval   EFI_INVALID_PARAMETER   Task is NULL.
+  @retval   EFI_OUT_OF_RESOURCES    The task could not be allocated.
+
+**/
+EFI_STATUS
+EFIAPI
+PasswordPolicyStartPasswordHash (
+  IN   CONST PASSWORD_HASH       OldSalt   OPTIONAL,
+  IN   CONST CHAR16              *Password  OPTIONAL,
+  OUT        PASSWORD_HASH_TASK  **Task
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  Public interface for checking on a background password hash.
+
+  If the task is not running on an application processor, runs the next slice of it.
+  Callers should keep the UI going between calls.
+
+  @param[in]  Task                  Task from PasswordPolicyStartPasswordHash ().
+  @param[out] PercentComplete       [Optional] Progress of the hash, 0 to 100.
+
+  @retval   EFI_NOT_READY           The hash is still being computed.
+  @retval   EFI_INVALID_PARAMETER   Task is not a password hash task.
+  @retval   <other>                 The hash is done.  This is the result
+                                    PasswordPolicyFinishPasswordHash () will return.
+
+**/
+EFI_STATUS
+EFIAPI
+PasswordPolicyPollPasswordHash (
+  IN         PASSWORD_HASH_TASK  *Task,
+  OUT        UINTN               *PercentComplete OPTIONAL
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  Public interface for completing or cancelling a background password hash.
+
+  If the hash is not done, waits for it, or cancels it when PasswordHash is NULL.  The task is
+  freed in either case.
+
+  @param[in]  Task                  Task from PasswordPolicyStartPasswordHash ().
+  @param[out] PasswordHash          [Optional] Receives the password hash, as from
+                                    PasswordPolicyGeneratePasswordHash ().  NULL to cancel the task.
+  @param[out] PasswordHashSize      [Optional] Receives the size of the password hash.
+
+  @retval   EFI_SUCCESS             The password hash was returned.
+  @retval   EFI_ABORTED             The task was cancelled.
+  @retval   EFI_INVALID_PARAMETER   Task is not a password hash task, or PasswordHash is present
+                                    without PasswordHashSize.
+  @retval   <other>                 The hash could not be generated.
+
+  Caller is responsible for freeing the returned PASSWORD_HASH
+
+**/
+EFI_STATUS
+EFIAPI
+PasswordPolicyFinishPasswordHash (
+  IN         PASSWORD_HASH_TASK  *Task,
+  OUT        PASSWORD_HASH       *PasswordHash OPTIONAL,
+  OUT        UINTN               *PasswordHashSize OPTIONAL
+  )
+{
+  return EFI_UNSUPPORTED;
+}
@@ -7,38 +7,58 @@
 
   The UEFI System Password set/delete interface
 
+  PasswordStoreDxe owns the store and installs PasswordStoreProtocol.  This library forwards its
+  calls to that protocol, so no module that links it reads the variable or keeps a copy of the
+  stored hash.  Without the protocol, no password is accepted and the store can't be changed.
+
+  The library also implements PasswordStoreSessionLib.  A session is only started by
+  PasswordStoreStartSession () and only its token is honored, so a NULL password is never taken
+  as an earlier login.
+
 **/
 
 #include <PiDxe.h>
 
-// Platform defined variable to hold the password hash
-
-#include <Guid/PasswordStoreVariable.h>
+#include <Protocol/PasswordStoreProtocol.h>
 
-#include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
-#include <Library/MemoryAllocationLib.h>
-#include <Library/PasswordPolicyLib.h>
 #include <Library/PasswordStoreLib.h>
+#include <Library/PasswordStoreSessionLib.h>
 #include <Library/UefiBootServicesTableLib.h>
-#include <Library/UefiRuntimeServicesTableLib.h>
-#include <Library/UefiLib.h>
 
 #include "PasswordStoreInternal.h"
 
-#define PASSWORD_STORE_LIB_INSTALLED_GUID \
-  { /* 68e6a3c8-2138-4846-a085-73eab4c344e0 */ \
-    0x68e6a3c8, 0x2138, 0x4846, {0xa0, 0x85, 0x73, 0xea, 0xb4, 0xc3, 0x44, 0xe0 } \
-  }
+STATIC PASSWORD_STORE_PROTOCOL  *mPasswordStore = NULL;
+
+/**
+  Gets PasswordStoreProtocol, the first time it is needed.
+
+  @return     The protocol, or NULL if PasswordStoreDxe has not installed it.
+
+**/
+STATIC
+PASSWORD_STORE_PROTOCOL *
+GetPasswordStore (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
 
-CONST CHAR16  *mPasswordName = {
-  PASSWORD_STORE_ADMIN_VARIABLE_NAME
-};
+  if (mPasswordStore == NULL) {
+    Status = gBS->LocateProtocol (
+                    &gOemPasswordStoreProtocolGuid,
+                    NULL,
+                    (VOID **)&mPasswordStore
+                    );
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a - PasswordStoreProtocol not found. Is PasswordStoreDxe included? %r\n", __FUNCTION__, Status));
+      mPasswordStore = NULL;
+    }
+  }
 
-STATIC       EFI_GUID       mPasswordStoreInstalledGuid = PASSWORD_STORE_LIB_INSTALLED_GUID;
-STATIC       PASSWORD_HASH  mNullPasswordHash;
-STATIC       UINTN          mNullPasswordHashSize;
+  return mPasswordStore;
+} // GetPasswordStore()
 
 /**
   Set the password variable.
@@ -47,6 +67,7 @@ STATIC       UINTN          mNullPasswordHashSize;
   @param[in]  PasswordHashSize    Size of the password hash
 
   @retval     EFI_SUCCESS   Password stored successfully.
+  @retval     EFI_NOT_READY PasswordStoreProtocol is not installed.
   @retval     Others        Something went wrong. Investigate further.
 **/
 EFI_STATUS
@@ -56,32 +77,15 @@ PasswordStoreSetPassword (
   IN        UINTN  PasswordHashSize
   )
 {
-  EFI_STATUS     Status;
-  PASSWORD_HASH  PasswordHash;
-
-  if (PasswordHashValue == NULL) {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  PasswordHash = (PASSWORD_HASH)PasswordHashValue;
-  Status       = PasswordPolicyValidatePasswordHash (PasswordHash, PasswordHashSize);
-  if (EFI_ERROR (Status)) {
-    return Status;
-  }
+  PASSWORD_STORE_PROTOCOL  *Store;
 
-  Status = gRT->SetVariable (
-                  PASSWORD_STORE_ADMIN_VARIABLE_NAME,
-                  &PASSWORD_STORE_ADMIN_NAMESPACE_GUID,
-                  PASSWORD_STORE_ADMIN_VARIABLE_ATTRS,
-                  PasswordHashSize,
-                  (VOID *)PasswordHash
-                  );
-  if (EFI_ERROR (Status)) {
-    Status = EFI_ABORTED;
+  Store = GetPasswordStore ();
+  if (Store == NULL) {
+    return EFI_NOT_READY;
   }
 
-  return Status;
-}
+  return Store->SetPassword (Store, PasswordHashValue, PasswordHashSize);
+} // PasswordStoreSetPassword()
 
 /**
   Public interface for determining whether a given password is set.
@@ -98,39 +102,15 @@ EFIAPI
 PasswordStoreIsPasswordSet (
   )
 {
-  EFI_STATUS     Status;
-  BOOLEAN        Result = FALSE;
-  UINTN          BufferSize;
-  PASSWORD_HASH  Store = NULL;
-
-  // Attempt to retrieve the password.
-  Status = GetVariable2 (
-             PASSWORD_STORE_ADMIN_VARIABLE_NAME,
-             &PASSWORD_STORE_ADMIN_NAMESPACE_GUID,
-             (VOID **)&Store,
-             &BufferSize
-             );
-
-  // If it's missing entirely, we need to set it.
-  if ((Status == EFI_NOT_FOUND) || (BufferSize == 0)) {
-    Status = PasswordStoreSetPassword (mNullPasswordHash, mNullPasswordHashSize);
-  }
-  // Determine whether the current password is valid.
-  else if (!EFI_ERROR (Status) && (BufferSize > 0)) {
-    // Determine whether the current password is the NULL password.
-    if ((BufferSize != mNullPasswordHashSize) &&
-        (CompareMem (Store, mNullPasswordHash, mNullPasswordHashSize) != 0))
-    {
-      Result = TRUE;
-    }
-  }
+  PASSWORD_STORE_PROTOCOL  *Store;
 
-  if (NULL != Store) {
-    FreePool (Store);
+  Store = GetPasswordStore ();
+  if (Store == NULL) {
+    return FALSE;
   }
 
-  return Result;
-} // IsPasswordSet()
+  return Store->IsPasswordSet (Store);
+} // PasswordStoreIsPasswordSet()
 
 /**
   Public interface for validating a password against the current password.
@@ -141,13 +121,16 @@ PasswordStoreIsPasswordSet (
         being authenticated. This is to accommodate changing valid character sets.
         Will still make sure that string does not exceed max buffer size.
 
+  NOTE: The password is checked with the hash, unless it is the password that started the
+        current session.  See PasswordStoreStartSession ().
+
   @param[in]  Password  String being evaluated.
 
   @retval     TRUE      Password matches the stored password for Handle.
   @retval     TRUE      No password is currently set.
-  @retval     TRUE      Password is NULL and Handle has previously authenticated successfully.
-  @retval     FALSE     No Password is set for Handle.
+  @retval     FALSE     Password is NULL and a password is set.
   @retval     FALSE     Supplied Password does not match stored password for Handle.
+  @retval     FALSE     PasswordStoreProtocol is not installed.
 
 **/
 BOOLEAN
@@ -156,220 +139,134 @@ PasswordStoreAuthenticatePassword (
   IN  CONST CHAR16  *Password
   )
 {
-  EFI_STATUS     Status = EFI_SUCCESS;
-  BOOLEAN        Result = FALSE;
-  UINTN          DataSize;
-  CHAR16         TempPassword[PW_MAX_LENGTH + 1];       // Maximum password length plus a NULL terminator.
-  PASSWORD_HASH  CurStore = NULL;
-  PASSWORD_HASH  NewStore = NULL;
-
-  // If there is no password set, all accesses should authenticate.
-  if (!PasswordStoreIsPasswordSet ()) {
-    return TRUE;
-  }
+  PASSWORD_STORE_PROTOCOL  *Store;
 
-  // If no password is supplied, return the cached Authentication state.
-  // NOTE: This cache exists so that calling functions don't have to hold on to
-  //       a copy of the password buffer to authenticate future actions (and so
-  //       that the user doesn't have to enter their password half a dozen times).
-  //       This should be replaced with a more robust "Session token" if this system
-  //       is leveraged for anything more complicated than FrontPage admin password.
-  if ((Password == NULL) || (Password[0] == '\0')) {
-    return FALSE;  // if or not a null password is set is checked in IsPasswordSet
+  Store = GetPasswordStore ();
+  if (Store == NULL) {
+    return FALSE;
   }
 
-  // Prep the password for evaluation.
-  PasswordPolicySafeCopyPassword (
-    TempPassword,
-    ARRAY_SIZE (TempPassword),
-    Password
-    );
-
-  //
-  // Step 1: Retrieve the current store.
-  Status = GetVariable2 (
-             PASSWORD_STORE_ADMIN_VARIABLE_NAME,
-             &PASSWORD_STORE_ADMIN_NAMESPACE_GUID,
-             (VOID **)&CurStore,
-             &DataSize
-             );
-  // NOTE: DataSize should now reflect the size of the variable when it was saved.
-
-  //
-  // Step 2: If the current store was retrieved, build a new store to compare it to.
-  if (!EFI_ERROR (Status)) {
-    // Build out the rest of the store so that we can compare the keys.
-    Status = PasswordPolicyGeneratePasswordHash (
-               CurStore,                                        // Use existing Version and Salt
-               TempPassword,                                    // Password
-               &NewStore,                                       // Store
-               &DataSize
-               );
-  }
+  return Store->AuthenticatePassword (Store, Password, NULL);
+} // PasswordStoreAuthenticatePassword()
 
-  // Always put away your toys.
-  PasswordPolicyCleansePwBuffer (TempPassword, sizeof (TempPassword));
+/**
+  Validates a password with the hash and, if it matches a set password, starts a session.
 
-  //
-  // Step 3: Compare the store.
-  // NOTE: Sure, it would be faster to just compare the key, but I don't think this hurts anything.
-  if (!EFI_ERROR (Status)) {
-    Result = (CompareMem (CurStore, NewStore, DataSize) == 0);
-  }
+  @param[in]  Password  String being evaluated.
+  @param[out] Token     Receives the token of the session.  Zeroed if no session was started.
 
-  if (NULL != CurStore) {
-    FreePool (CurStore);
-  }
+  @retval     TRUE      Password matches the stored password.
+  @retval     TRUE      No password is currently set.
+  @retval     FALSE     Password is NULL, does not match, or PasswordStoreProtocol is not
+                        installed.
 
-  if (NULL != NewStore) {
-    FreePool (NewStore);
+**/
+BOOLEAN
+EFIAPI
+PasswordStoreStartSession (
+  IN  CONST CHAR16                  *Password,
+  OUT PASSWORD_STORE_SESSION_TOKEN  *Token
+  )
+{
+  PASSWORD_STORE_PROTOCOL  *Store;
+
+  ZeroMem (Token, sizeof (*Token));
+
+  Store = GetPasswordStore ();
+  if (Store == NULL) {
+    return FALSE;
   }
 
-  return Result;
-} // AuthenticatePassword()
+  return Store->AuthenticatePassword (Store, Password, Token);
+} // PasswordStoreStartSession()
 
 /**
-  Deletes all passwords and resets password infrastructure to factory condition.
-  Published as a public function so that it can be invoked in a useful driver.
+  Checks a token from PasswordStoreStartSession () without the password hash.
 
-  @retval     EFI_SUCCESS   Reset is complete.
-  @retval     Others        Something went wrong. Investigate further.
+  @param[in]  Token     Token of the session.
+
+  @retval     TRUE      The session is still current, or no password is set.
+  @retval     FALSE     Not, or PasswordStoreProtocol is not installed.
 
 **/
-EFI_STATUS
+BOOLEAN
 EFIAPI
-PasswordStoreResetPasswordLib (
-  VOID
+PasswordStoreAuthenticateSession (
+  IN  CONST PASSWORD_STORE_SESSION_TOKEN  *Token
   )
 {
-  EFI_STATUS  Status;
-  CHAR16      *PasswordName;
-
-  // Attempt to delete the password.
-  PasswordName = (CHAR16 *)mPasswordName;
-  Status       = gRT->SetVariable (
-                        PasswordName,
-                        &PASSWORD_STORE_ADMIN_NAMESPACE_GUID,
-                        0,
-                        0,
-                        NULL
-                        );
-  if (Status == EFI_NOT_FOUND) {
-    Status = EFI_SUCCESS;
-  }
+  PASSWORD_STORE_PROTOCOL  *Store;
 
-  if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "%a - Failed to properly reset password! Status = %r.\n", __FUNCTION__, Status));
-    ASSERT (FALSE);
+  Store = GetPasswordStore ();
+  if (Store == NULL) {
+    return FALSE;
   }
 
-  return Status;
-} // ResetPasswordLib()
+  return Store->AuthenticateSession (Store, Token);
+} // PasswordStoreAuthenticateSession()
 
 /**
-  Performs any initialization that is necessary for the functions in this
-  library to behave as expected.
+  Ends the session of a token from PasswordStoreStartSession (), if it is still current.
+
+  @param[in]  Token     Token of the session.
+
+**/
+VOID
+EFIAPI
+PasswordStoreEndSession (
+  IN  CONST PASSWORD_STORE_SESSION_TOKEN  *Token
+  )
+{
+  PASSWORD_STORE_PROTOCOL  *Store;
 
-  Only necessary to run once per boot.
+  Store = GetPasswordStore ();
+  if (Store != NULL) {
+    Store->EndSession (Store, Token);
+  }
+} // PasswordStoreEndSession()
+
+/**
+  Deletes all passwords and resets password infrastructure to factory condition.
   Published as a public function so that it can be invoked in a useful driver.
 
-  @retval     EFI_SUCCESS   Initialization is complete.
+  @retval     EFI_SUCCESS   Reset is complete.
+  @retval     EFI_NOT_READY PasswordStoreProtocol is not installed.
   @retval     Others        Something went wrong. Investigate further.
 
 **/
 EFI_STATUS
 EFIAPI
-PasswordStoreInitializeLib (
+PasswordStoreResetPasswordLib (
   VOID
   )
 {
-  EFI_STATUS     Status;
-  CHAR16         *PasswordName;
-  UINT32         Attributes;
-  UINTN          DataSize;
-  PASSWORD_HASH  Store;
-
-  PasswordName = (CHAR16 *)mPasswordName;
-  // 1. Load Variable
-  Status = GetVariable3 (
-             PasswordName,
-             &PASSWORD_STORE_ADMIN_NAMESPACE_GUID,
-             (VOID **)&Store,
-             &DataSize,
-             &Attributes
-             );
-  if (!EFI_ERROR (Status)) {
-    FreePool (Store);
-  }
-
-  // Make sure that password is found and has the correct attributes.
-  if ((Status == EFI_NOT_FOUND) || (Attributes != PASSWORD_STORE_ADMIN_VARIABLE_ATTRS)) {
-    // If invalid, initialize it.
-    Status = PasswordStoreSetPassword (mNullPasswordHash, mNullPasswordHashSize);
-  }
+  PASSWORD_STORE_PROTOCOL  *Store;
 
-  if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "%a - Failed to properly initialize password! Status = %r.\n", __FUNCTION__, Status));
-    ASSERT (FALSE);
+  Store = GetPasswordStore ();
+  if (Store == NULL) {
+    return EFI_NOT_READY;
   }
 
-  return Status;
-} // PasswordStoreInitializePasswordLib()
+  return Store->Reset (Store);
+} // ResetPasswordLib()
 
 /**
-The constructor function initializes the Lib for Dxe.
-
-This constructor is only needed for MsSettingsManager support.
-The design is to have the PCD false fall all modules except the 1 that should support the MsSettingsManager.  Because this
-is a build time PCD
-
-The constructor function publishes Performance and PerformanceEx protocol, allocates memory to log DXE performance
-and merges PEI performance data to DXE performance log.
-It will ASSERT() if one of these operations fails and it will always return EFI_SUCCESS.
+  Performs any initialization that is necessary for the functions in this
+  library to behave as expected.
 
-@param  ImageHandle   The firmware allocated handle for the EFI image.
-@param  SystemTable   A pointer to the EFI System Table.
+  PasswordStoreDxe initializes the store before it installs the protocol, so this only checks
+  that the protocol is there.
+  Published as a public function so that it can be invoked in a useful driver.
 
-@retval EFI_SUCCESS   The constructor always returns EFI_SUCCESS.
+  @retval     EFI_SUCCESS   Initialization is complete.
+  @retval     EFI_NOT_READY PasswordStoreProtocol is not installed.
 
 **/
 EFI_STATUS
 EFIAPI
-PasswordStoreLibConstructor (
-  IN EFI_HANDLE        ImageHandle,
-  IN EFI_SYSTEM_TABLE  *SystemTable
+PasswordStoreInitializeLib (
+  VOID
   )
 {
-  EFI_STATUS  Status;
-  VOID        *Dummy;
-
-  Status = PasswordPolicyGeneratePasswordHash (NULL, NULL, &mNullPasswordHash, &mNullPasswordHashSize);
-
-  Status = gBS->LocateProtocol (
-                  &mPasswordStoreInstalledGuid,
-                  NULL,
-                  (VOID **)&Dummy
-                  );
-
-  if (Status == EFI_NOT_FOUND) {
-    // Only initialize the library once regardless of the number of instances of this
-    // library
-
-    Status = gBS->InstallProtocolInterface (
-                    &gImageHandle,
-                    &mPasswordStoreInstalledGuid,
-                    EFI_NATIVE_INTERFACE,
-                    NULL
-                    );
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "%a: - Unable to install already-installed protocol- %r\n", __FUNCTION__, Status));
-    }
-
-    PasswordStoreInitializeLib ();
-
-    // There is an assumption that the Password Variable will be locked.  That will
-    // be up to the platform.
-  }
-
-  return EFI_SUCCESS;
-}
+  return (GetPasswordStore () != NULL) ? EFI_SUCCESS : EFI_NOT_READY;
+} // PasswordStoreInitializePasswordLib()
@@ -0,0 +1,561 @@
+/** @file SmbiosStringLib.c
+
+  Indexed access to SMBIOS records and strings.
+
+  The SMBIOS table is walked once with two passes of GetNext().  The first pass
+  sizes the index, the second copies every record and its string set into a single
+  buffer, converting each string to UCS-2 along the way.  Records are grouped by
+  type, so a (type, instance, string number) lookup is three array indexes.
+
+  SmbiosDxe republishes the SMBIOS configuration table whenever a record is added,
+  removed or has a string updated.  Installing a configuration table signals the
+  event group of the table GUID, which marks the index stale.  It is rebuilt on
+  the next lookup.  If the events can't be created, every lookup walks the table
+  and compares a checksum of its records with the one taken when the index was
+  built, and the index is rebuilt if they differ.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiDxe.h>
+
+#include <Guid/SmBios.h>
+#include <Protocol/Smbios.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/SmbiosStringLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+typedef struct {
+  CONST CHAR8     *Ascii;
+  CONST CHAR16    *Unicode;
+  UINTN           Length;               // Characters, excluding the NULL terminator
+} SMBIOS_STRING_ENTRY;
+
+typedef struct {
+  CONST EFI_SMBIOS_TABLE_HEADER    *Record;
+  CONST SMBIOS_STRING_ENTRY        *Strings;
+  UINTN                            StringCount;
+} SMBIOS_RECORD_ENTRY;
+
+typedef struct {
+  UINTN    First;                       // Index of the first record of this type in mRecords
+  UINTN    Count;
+} SMBIOS_TYPE_ENTRY;
+
+STATIC CONST SMBIOS_STRING_ENTRY  mEmptyString = { "", L"", 0 };
+
+STATIC EFI_SMBIOS_PROTOCOL  *mSmbiosProtocol   = NULL;
+STATIC VOID                 *mIndexBuffer      = NULL;
+STATIC SMBIOS_RECORD_ENTRY  *mRecords          = NULL;
+STATIC BOOLEAN              mIndexStale        = TRUE;
+STATIC EFI_EVENT            mSmbiosTableEvent  = NULL;
+STATIC EFI_EVENT            mSmbios3TableEvent = NULL;
+STATIC BOOLEAN              mTableTracked      = FALSE;     // Table changes are signalled to SmbiosTableChanged ().
+STATIC UINT32               mIndexChecksum     = 0;         // GetTableChecksum () when the index was built.
+STATIC SMBIOS_TYPE_ENTRY    mTypes[MAX_UINT8 + 1];
+
+/**
+  Counts the strings in the string set that follows the formatted area of a record.
+
+  @param[in]  Record        SMBIOS record.
+  @param[out] AsciiSize     Size of all the strings, including their NULL terminators.
+
+  @return     Number of strings in the string set.
+
+**/
+STATIC
+UINTN
+CountRecordStrings (
+  IN  CONST EFI_SMBIOS_TABLE_HEADER  *Record,
+  OUT UINTN                          *AsciiSize
+  )
+{
+  CONST CHAR8  *String;
+  UINTN        Length;
+  UINTN        Count;
+
+  Count      = 0;
+  *AsciiSize = 0;
+  String     = (CONST CHAR8 *)Record + Record->Length;
+
+  //
+  // A record without strings is followed by two NULL bytes, so the loop is not entered.
+  //
+  while (*String != '\0') {
+    Length      = AsciiStrLen (String);
+    String     += Length + 1;
+    *AsciiSize += Length + 1;
+    Count++;
+  }
+
+  return Count;
+}
+
+/**
+  Checksums every record of the SMBIOS table, in table order.
+
+  @return     The checksum.
+
+**/
+STATIC
+UINT32
+GetTableChecksum (
+  VOID
+  )
+{
+  EFI_SMBIOS_HANDLE        SmbiosHandle;
+  EFI_SMBIOS_TABLE_HEADER  *Record;
+  UINTN                    AsciiSize;
+  UINT32                   RecordCrc;
+  UINT32                   Checksum;
+
+  Checksum     = 0;
+  SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
+  while (!EFI_ERROR (mSmbiosProtocol->GetNext (mSmbiosProtocol, &SmbiosHandle, NULL, &Record, NULL))) {
+    CountRecordStrings (Record, &AsciiSize);
+    RecordCrc = 0;
+    gBS->CalculateCrc32 (Record, Record->Length + AsciiSize, &RecordCrc);
+    Checksum = LRotU32 (Checksum, 1) ^ RecordCrc;
+  }
+
+  return Checksum;
+}
+
+/**
+  Frees the index.
+
+**/
+STATIC
+VOID
+FreeIndex (
+  VOID
+  )
+{
+  if (mIndexBuffer != NULL) {
+    FreePool (mIndexBuffer);
+    mIndexBuffer = NULL;
+  }
+
+  mRecords    = NULL;
+  mIndexStale = TRUE;
+  ZeroMem (mTypes, sizeof (mTypes));
+}
+
+/**
+  Parses the SMBIOS table into the index.
+
+  @retval EFI_SUCCESS           Index built.
+  @retval EFI_NOT_FOUND         The SMBIOS protocol is not available, or the table is empty.
+  @retval EFI_OUT_OF_RESOURCES  Unable to allocate the index.
+
+**/
+STATIC
+EFI_STATUS
+BuildIndex (
+  VOID
+  )
+{
+  EFI_STATUS               Status;
+  EFI_SMBIOS_HANDLE        SmbiosHandle;
+  EFI_SMBIOS_TABLE_HEADER  *Record;
+  SMBIOS_RECORD_ENTRY      *Entry;
+  SMBIOS_STRING_ENTRY      *Strings;
+  UINT8                    *Data;
+  CHAR8                    *Ascii;
+  CHAR16                   *Unicode;
+  UINTN                    RecordCount;
+  UINTN                    StringCount;
+  UINTN                    DataSize;
+  UINTN                    UnicodeSize;
+  UINTN                    AsciiSize;
+  UINTN                    Count;
+  UINTN                    Index;
+  UINTN                    Type;
+
+  FreeIndex ();
+
+  if (mSmbiosProtocol == NULL) {
+    Status = gBS->LocateProtocol (&gEfiSmbiosProtocolGuid, NULL, (VOID **)&mSmbiosProtocol);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a - Could not locate SMBIOS protocol. %r\n", __FUNCTION__, Status));
+      mSmbiosProtocol = NULL;
+      return EFI_NOT_FOUND;
+    }
+  }
+
+  //
+  // Pass 1 - size the index and count the records of each type.
+  //
+  RecordCount  = 0;
+  StringCount  = 0;
+  DataSize     = 0;
+  UnicodeSize  = 0;
+  SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
+  while (!EFI_ERROR (mSmbiosProtocol->GetNext (mSmbiosProtocol, &SmbiosHandle, NULL, &Record, NULL))) {
+    Count = CountRecordStrings (Record, &AsciiSize);
+    mTypes[Record->Type].Count++;
+    RecordCount++;
+    StringCount += Count;
+    DataSize    += ALIGN_VALUE (Record->Length + AsciiSize, sizeof (UINT64));
+    UnicodeSize += AsciiSize * sizeof (CHAR16);
+  }
+
+  if (RecordCount == 0) {
+    DEBUG ((DEBUG_WARN, "%a - SMBIOS table is empty.\n", __FUNCTION__));
+    return EFI_NOT_FOUND;
+  }
+
+  Index = 0;
+  for (Type = 0; Type <= MAX_UINT8; Type++) {
+    mTypes[Type].First = Index;
+    Index             += mTypes[Type].Count;
+    mTypes[Type].Count = 0;
+  }
+
+  mIndexBuffer = AllocatePool (
+                   RecordCount * sizeof (SMBIOS_RECORD_ENTRY) +
+                   StringCount * sizeof (SMBIOS_STRING_ENTRY) +
+                   DataSize + UnicodeSize
+                   );
+  if (mIndexBuffer == NULL) {
+    DEBUG ((DEBUG_ERROR, "%a - Unable to allocate the SMBIOS index.\n", __FUNCTION__));
+    ZeroMem (mTypes, sizeof (mTypes));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  mRecords = (SMBIOS_RECORD_ENTRY *)mIndexBuffer;
+  Strings  = (SMBIOS_STRING_ENTRY *)(mRecords + RecordCount);
+  Data     = (UINT8 *)(Strings + StringCount);
+  Unicode  = (CHAR16 *)(Data + DataSize);
+
+  //
+  // Pass 2 - copy each record with its string set, and convert the strings.
+  //
+  SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;
+  while (!EFI_ERROR (mSmbiosProtocol->GetNext (mSmbiosProtocol, &SmbiosHandle, NULL, &Record, NULL))) {
+    Count = CountRecordStrings (Record, &AsciiSize);
+    Entry = &mRecords[mTypes[Record->Type].First + mTypes[Record->Type].Count];
+    mTypes[Record->Type].Count++;
+
+    CopyMem (Data, Record, Record->Length + AsciiSize);
+    Entry->Record      = (CONST EFI_SMBIOS_TABLE_HEADER *)Data;
+    Entry->Strings     = Strings;
+    Entry->StringCount = Count;
+
+    Ascii = (CHAR8 *)Data + Record->Length;
+    for (Index = 0; Index < Count; Index++) {
+      Strings->Length = AsciiStrLen (Ascii);
+      AsciiStrToUnicodeStrS (Ascii, Unicode, Strings->Length + 1);
+      Strings->Ascii   = Ascii;
+      Strings->Unicode = Unicode;
+      Ascii           += Strings->Length + 1;
+      Unicode         += Strings->Length + 1;
+      Strings++;
+    }
+
+    Data += ALIGN_VALUE (Record->Length + AsciiSize, sizeof (UINT64));
+  }
+
+  DEBUG ((DEBUG_INFO, "%a - Indexed %d SMBIOS records with %d strings.\n", __FUNCTION__, RecordCount, StringCount));
+  if (!mTableTracked) {
+    mIndexChecksum = GetTableChecksum ();
+  }
+
+  mIndexStale = FALSE;
+  return EFI_SUCCESS;
+}
+
+/**
+  Finds a record in the index, rebuilding the index first if it is stale.
+
+  @param[in]  Type          SMBIOS record type.
+  @param[in]  Instance      Zero based instance of the record type.
+
+  @return     The index entry of the record, or NULL if it does not exist.
+
+**/
+STATIC
+CONST SMBIOS_RECORD_ENTRY *
+LookupRecord (
+  IN SMBIOS_TYPE  Type,
+  IN UINTN        Instance
+  )
+{
+  if (!mIndexStale && !mTableTracked && (GetTableChecksum () != mIndexChecksum)) {
+    mIndexStale = TRUE;
+  }
+
+  if (mIndexStale && EFI_ERROR (BuildIndex ())) {
+    return NULL;
+  }
+
+  if (Instance >= mTypes[Type].Count) {
+    return NULL;
+  }
+
+  return &mRecords[mTypes[Type].First + Instance];
+}
+
+/**
+  Finds a string in the index.
+
+  @param[in]  Type          SMBIOS record type.
+  @param[in]  Instance      Zero based instance of the record type.
+  @param[in]  StringNumber  One based string number.  Zero returns the empty string.
+
+  @return     The index entry of the string, or NULL if it does not exist.
+
+**/
+STATIC
+CONST SMBIOS_STRING_ENTRY *
+LookupString (
+  IN SMBIOS_TYPE          Type,
+  IN UINTN                Instance,
+  IN SMBIOS_TABLE_STRING  StringNumber
+  )
+{
+  CONST SMBIOS_RECORD_ENTRY  *Entry;
+
+  Entry = LookupRecord (Type, Instance);
+  if (Entry == NULL) {
+    return NULL;
+  }
+
+  if (StringNumber == 0) {
+    return &mEmptyString;
+  }
+
+  if (StringNumber > Entry->StringCount) {
+    return NULL;
+  }
+
+  return &Entry->Strings[StringNumber - 1];
+}
+
+/**
+  Returns the formatted area of an SMBIOS record.
+
+  @param[in]  Type          SMBIOS record type.
+  @param[in]  Instance      Zero based instance of the record type.
+  @param[out] Record        Pointer to the formatted area of the record.
+
+  @retval EFI_SUCCESS           Record returned.
+  @retval EFI_INVALID_PARAMETER Record is NULL.
+  @retval EFI_NOT_FOUND         The record does not exist, or the SMBIOS table is not available.
+
+**/
+EFI_STATUS
+EFIAPI
+SmbiosStringGetRecord (
+  IN  SMBIOS_TYPE                    Type,
+  IN  UINTN                          Instance,
+  OUT CONST EFI_SMBIOS_TABLE_HEADER  **Record
+  )
+{
+  CONST SMBIOS_RECORD_ENTRY  *Entry;
+
+  if (Record == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Entry = LookupRecord (Type, Instance);
+  if (Entry == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  *Record = Entry->Record;
+  return EFI_SUCCESS;
+}
+
+/**
+  Returns an ASCII string of an SMBIOS record.
+
+  String number 0 means "no string" in SMBIOS and returns an empty string.
+
+  @param[in]  Type          SMBIOS record type.
+  @param[in]  Instance      Zero based instance of the record type.
+  @param[in]  StringNumber  One based string number, as stored in the formatted area.
+  @param[out] String        Pointer to the string.
+  @param[out] Size          Optional size of the string in bytes, including the NULL terminator.
+
+  @retval EFI_SUCCESS           String returned.
+  @retval EFI_INVALID_PARAMETER String is NULL.
+  @retval EFI_NOT_FOUND         The record or the string does not exist.
+
+**/
+EFI_STATUS
+EFIAPI
+SmbiosStringGetAscii (
+  IN  SMBIOS_TYPE          Type,
+  IN  UINTN                Instance,
+  IN  SMBIOS_TABLE_STRING  StringNumber,
+  OUT CONST CHAR8          **String,
+  OUT UINTN                *Size   OPTIONAL
+  )
+{
+  CONST SMBIOS_STRING_ENTRY  *Entry;
+
+  if (String == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Entry = LookupString (Type, Instance, StringNumber);
+  if (Entry == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  *String = Entry->Ascii;
+  if (Size != NULL) {
+    *Size = Entry->Length + 1;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Returns a UCS-2 string of an SMBIOS record.
+
+  String number 0 means "no string" in SMBIOS and returns an empty string.
+
+  @param[in]  Type          SMBIOS record type.
+  @param[in]  Instance      Zero based instance of the record type.
+  @param[in]  StringNumber  One based string number, as stored in the formatted area.
+  @param[out] String        Pointer to the string.
+  @param[out] Size          Optional size of the string in bytes, including the NULL terminator.
+
+  @retval EFI_SUCCESS           String returned.
+  @retval EFI_INVALID_PARAMETER String is NULL.
+  @retval EFI_NOT_FOUND         The record or the string does not exist.
+
+**/
+EFI_STATUS
+EFIAPI
+SmbiosStringGetUnicode (
+  IN  SMBIOS_TYPE          Type,
+  IN  UINTN                Instance,
+  IN  SMBIOS_TABLE_STRING  StringNumber,
+  OUT CONST CHAR16         **String,
+  OUT UINTN                *Size   OPTIONAL
+  )
+{
+  CONST SMBIOS_STRING_ENTRY  *Entry;
+
+  if (String == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Entry = LookupString (Type, Instance, StringNumber);
+  if (Entry == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  *String = Entry->Unicode;
+  if (Size != NULL) {
+    *Size = (Entry->Length + 1) * sizeof (CHAR16);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Marks the index stale when the SMBIOS configuration table is republished.
+
+  @param[in]  Event         Event whose notification function is being invoked.
+  @param[in]  Context       Not used.
+
+**/
+STATIC
+VOID
+EFIAPI
+SmbiosTableChanged (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  mIndexStale = TRUE;
+}
+
+/**
+  Constructor for SmbiosStringLib.
+
+  @param  ImageHandle   ImageHandle of the loaded driver.
+  @param  SystemTable   Pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS   Always.  Without the table change notifications, every lookup checks
+                        the table for changes.
+**/
+EFI_STATUS
+EFIAPI
+SmbiosStringLibConstructor (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = gBS->CreateEventEx (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  SmbiosTableChanged,
+                  NULL,
+                  &gEfiSmbiosTableGuid,
+                  &mSmbiosTableEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - Unable to register for SMBIOS table changes. %r\n", __FUNCTION__, Status));
+    return EFI_SUCCESS;
+  }
+
+  Status = gBS->CreateEventEx (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  SmbiosTableChanged,
+                  NULL,
+                  &gEfiSmbios3TableGuid,
+                  &mSmbios3TableEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - Unable to register for SMBIOS 3 table changes. %r\n", __FUNCTION__, Status));
+    gBS->CloseEvent (mSmbiosTableEvent);
+    mSmbiosTableEvent = NULL;
+    return EFI_SUCCESS;
+  }
+
+  mTableTracked = TRUE;
+  return EFI_SUCCESS;
+}
+
+/**
+  Destructor for SmbiosStringLib.
+
+  @param  ImageHandle   ImageHandle of the loaded driver.
+  @param  SystemTable   Pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS   Always.
+**/
+EFI_STATUS
+EFIAPI
+SmbiosStringLibDestructor (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  if (mSmbiosTableEvent != NULL) {
+    gBS->CloseEvent (mSmbiosTableEvent);
+    mSmbiosTableEvent = NULL;
+  }
+
+  if (mSmbios3TableEvent != NULL) {
+    gBS->CloseEvent (mSmbios3TableEvent);
+    mSmbios3TableEvent = NULL;
+  }
+
+  FreeIndex ();
+  return EFI_SUCCESS;
+}
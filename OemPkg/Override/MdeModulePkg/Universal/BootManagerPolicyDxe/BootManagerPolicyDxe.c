@@ -9,6 +9,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Uefi.h>
 #include <Protocol/BootManagerPolicy.h>
 #include <Protocol/ManagedNetwork.h>
+#include <Protocol/OemConnectAllComplete.h>   // MU_CHANGE
 #include <Library/BaseMemoryLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiLib.h>
@@ -20,6 +21,42 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 //  CHAR16 mNetworkDeviceList[] = L"_NDL";    // MU_CHANGE
 
+// MU_CHANGE Begin
+
+/**
+  Connects all controllers and installs gOemConnectAllCompleteGuid, so that FrontPage knows it
+  can skip its own full connect.
+
+**/
+STATIC
+VOID
+ConnectAllAndRecord (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  EFI_HANDLE  Handle;
+  VOID        *Dummy;
+
+  EfiBootManagerConnectAll ();
+
+  Status = gBS->LocateProtocol (&gOemConnectAllCompleteGuid, NULL, &Dummy);
+  if (EFI_ERROR (Status)) {
+    Handle = NULL;
+    Status = gBS->InstallMultipleProtocolInterfaces (
+                    &Handle,
+                    &gOemConnectAllCompleteGuid,
+                    NULL,
+                    NULL
+                    );
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a - Failed to install connect-all marker. %r\n", __FUNCTION__, Status));
+    }
+  }
+}
+
+// MU_CHANGE End
+
 /**
   Connect all the system drivers to controllers and create the network device list in NV storage.
 
@@ -39,7 +76,7 @@ ConnectAllAndCreateNetworkDeviceList (
   EFI_DEVICE_PATH_PROTOCOL  *Devices;
   EFI_DEVICE_PATH_PROTOCOL  *TempDevicePath;
 
-  EfiBootManagerConnectAll ();
+  ConnectAllAndRecord ();   // MU_CHANGE
 
   Status = gBS->LocateHandleBuffer (ByProtocol, &gEfiManagedNetworkServiceBindingProtocolGuid, NULL, &HandleCount, &Handles);
   if (EFI_ERROR (Status)) {
@@ -105,7 +142,7 @@ ConnectNetwork (
                     NULL
                     );
     DEBUG ((DEBUG_INFO, "%a Starting Network Stack\n", __FUNCTION__));
-    EfiBootManagerConnectAll ();
+    ConnectAllAndRecord ();   // MU_CHANGE
     DEBUG ((DEBUG_INFO, "%a Connecting done\n", __FUNCTION__));
   }
 
@@ -187,7 +224,7 @@ BootManagerPolicyConnectDevicePath (
   }
 
   if (DevicePath == NULL) {
-    EfiBootManagerConnectAll ();
+    ConnectAllAndRecord ();   // MU_CHANGE
     return EFI_SUCCESS;
   }
 
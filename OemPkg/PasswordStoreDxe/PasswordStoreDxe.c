@@ -0,0 +1,868 @@
+/** @file PasswordStoreDxe.c
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+  Owns the storage location for the platform ADMIN Password and publishes PasswordStoreProtocol.
+
+  The driver reads the password variable once, keeps the stored hash in memory, and installs
+  PasswordStoreProtocol from its entry point.  PasswordStoreLib forwards its calls to the protocol,
+  so the protocol lives in a resident driver rather than in whichever module linked the library
+  first.
+
+  A caller of PasswordStoreProtocol.AuthenticatePassword can ask for a session token, which
+  AuthenticateSession then accepts without rerunning the password hash.  The driver keeps one
+  session at a time, until its caller ends it or ReadyToBoot.  It holds keyed tags of the token,
+  of the password and of the store the password matched, under a key drawn for each session, and
+  neither the token nor the password.  Changing the stored hash ends the session.
+
+  While the session lasts, AuthenticatePassword accepts the password that started it by its tag,
+  so callers that only have the password, such as DFCI, don't rerun the hash either.  Any other
+  password is still checked with the hash.
+
+**/
+
+#include <PiDxe.h>
+
+// Platform defined variable to hold the password hash
+
+#include <Guid/PasswordStoreVariable.h>
+
+#include <Protocol/PasswordStoreProtocol.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseCryptLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PasswordPolicyLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+#include <Library/UefiLib.h>
+
+CONST CHAR16  *mPasswordName = {
+  PASSWORD_STORE_ADMIN_VARIABLE_NAME
+};
+
+STATIC       PASSWORD_HASH  mNullPasswordHash;
+STATIC       UINTN          mNullPasswordHashSize;
+
+STATIC PASSWORD_HASH  mStore               = NULL;     // Copy of the variable.  NULL until read.
+STATIC UINTN          mStoreSize           = 0;
+STATIC EFI_HANDLE     mPasswordStoreHandle = NULL;
+
+#define PASSWORD_STORE_SESSION_KEY_SIZE  32
+
+typedef struct {
+  BOOLEAN    Active;
+  UINT8      Key[PASSWORD_STORE_SESSION_KEY_SIZE];
+  UINT8      StoreTag[SHA256_DIGEST_SIZE];        // HMAC of the store the password was verified against.
+  UINT8      TokenTag[SHA256_DIGEST_SIZE];        // HMAC of the token given to the caller.
+  UINT8      PasswordTag[SHA256_DIGEST_SIZE];     // HMAC of the password that started the session.
+} PASSWORD_STORE_SESSION;
+
+STATIC PASSWORD_STORE_SESSION  mSession;
+STATIC BOOLEAN                 mSessionExpired = FALSE;     // Set at ReadyToBoot.  No new sessions after that.
+STATIC EFI_EVENT               mReadyToBootEvent;
+
+/**
+  Ends the authenticated session, if there is one.
+
+**/
+STATIC
+VOID
+EndSession (
+  VOID
+  )
+{
+  ZeroMem (&mSession, sizeof (mSession));
+} // EndSession()
+
+/**
+  Starts an authenticated session for a password that was just verified against Store.  Any
+  earlier session ends.
+
+  @param[in]  Store         The store the password was verified against.
+  @param[in]  StoreSize     Size of Store.
+  @param[in]  Password      The password that was verified.
+  @param[out] Token         Receives the token of the session.  Zeroed if no session was started.
+
+**/
+STATIC
+VOID
+StartSession (
+  IN  CONST UINT8                         *Store,
+  IN        UINTN                         StoreSize,
+  IN  CONST CHAR16                        *Password,
+  OUT       PASSWORD_STORE_SESSION_TOKEN  *Token
+  )
+{
+  EndSession ();
+  ZeroMem (Token, sizeof (*Token));
+
+  if (mSessionExpired) {
+    return;
+  }
+
+  if (EFI_ERROR (PasswordPolicyGetRandomBytes (mSession.Key, sizeof (mSession.Key))) ||
+      EFI_ERROR (PasswordPolicyGetRandomBytes (Token->Bytes, sizeof (Token->Bytes))))
+  {
+    DEBUG ((DEBUG_WARN, "%a - No random bytes for the session. Not caching the login.\n", __FUNCTION__));
+    EndSession ();
+    ZeroMem (Token, sizeof (*Token));
+    return;
+  }
+
+  if (!HmacSha256All (Store, StoreSize, mSession.Key, sizeof (mSession.Key), mSession.StoreTag) ||
+      !HmacSha256All (Token->Bytes, sizeof (Token->Bytes), mSession.Key, sizeof (mSession.Key), mSession.TokenTag) ||
+      !HmacSha256All (Password, StrSize (Password), mSession.Key, sizeof (mSession.Key), mSession.PasswordTag))
+  {
+    EndSession ();
+    ZeroMem (Token, sizeof (*Token));
+    return;
+  }
+
+  mSession.Active = TRUE;
+} // StartSession()
+
+/**
+  Checks that the authenticated session was started against Store.
+
+  @param[in]  Store         The current store.
+  @param[in]  StoreSize     Size of Store.
+
+  @retval     TRUE      There is a session, and its password was verified against Store.
+  @retval     FALSE     Not.
+
+**/
+STATIC
+BOOLEAN
+IsSessionStore (
+  IN  CONST UINT8  *Store,
+  IN        UINTN  StoreSize
+  )
+{
+  UINT8    Tag[SHA256_DIGEST_SIZE];
+  BOOLEAN  Result;
+
+  if (!mSession.Active || mSessionExpired) {
+    return FALSE;
+  }
+
+  Result = HmacSha256All (Store, StoreSize, mSession.Key, sizeof (mSession.Key), Tag) &&
+           (CompareMem (Tag, mSession.StoreTag, sizeof (Tag)) == 0);
+
+  ZeroMem (Tag, sizeof (Tag));
+
+  return Result;
+} // IsSessionStore()
+
+/**
+  Checks a session token against the authenticated session.
+
+  @param[in]  Store         The current store.
+  @param[in]  StoreSize     Size of Store.
+  @param[in]  Token         The token to check.
+
+  @retval     TRUE      There is a session for the current store, and Token is its token.
+  @retval     FALSE     Not.  The password must be verified with the hash.
+
+**/
+STATIC
+BOOLEAN
+IsSessionValid (
+  IN  CONST UINT8                         *Store,
+  IN        UINTN                         StoreSize,
+  IN  CONST PASSWORD_STORE_SESSION_TOKEN  *Token
+  )
+{
+  UINT8    Tag[SHA256_DIGEST_SIZE];
+  BOOLEAN  Result;
+
+  if (!IsSessionStore (Store, StoreSize)) {
+    return FALSE;
+  }
+
+  Result = HmacSha256All (Token->Bytes, sizeof (Token->Bytes), mSession.Key, sizeof (mSession.Key), Tag) &&
+           (CompareMem (Tag, mSession.TokenTag, sizeof (Tag)) == 0);
+
+  ZeroMem (Tag, sizeof (Tag));
+
+  return Result;
+} // IsSessionValid()
+
+/**
+  Checks a password against the one that started the authenticated session.
+
+  @param[in]  Store         The current store.
+  @param[in]  StoreSize     Size of Store.
+  @param[in]  Password      The password to check.
+
+  @retval     TRUE      There is a session for the current store, and Password started it.
+  @retval     FALSE     Not.  The password must be verified with the hash.
+
+**/
+STATIC
+BOOLEAN
+IsSessionPassword (
+  IN  CONST UINT8   *Store,
+  IN        UINTN   StoreSize,
+  IN  CONST CHAR16  *Password
+  )
+{
+  UINT8    Tag[SHA256_DIGEST_SIZE];
+  BOOLEAN  Result;
+
+  if (!IsSessionStore (Store, StoreSize)) {
+    return FALSE;
+  }
+
+  Result = HmacSha256All (Password, StrSize (Password), mSession.Key, sizeof (mSession.Key), Tag) &&
+           (CompareMem (Tag, mSession.PasswordTag, sizeof (Tag)) == 0);
+
+  ZeroMem (Tag, sizeof (Tag));
+
+  return Result;
+} // IsSessionPassword()
+
+/**
+  Ends the authenticated session at ReadyToBoot.  Nothing past this point gets to skip the
+  password.
+
+  @param[in]  Event     Event whose notification function is being invoked.
+  @param[in]  Context   Not used.
+
+**/
+STATIC
+VOID
+EFIAPI
+PasswordStoreReadyToBoot (
+  IN  EFI_EVENT  Event,
+  IN  VOID       *Context
+  )
+{
+  mSessionExpired = TRUE;
+  EndSession ();
+
+  gBS->CloseEvent (Event);
+} // PasswordStoreReadyToBoot()
+
+/**
+  Replaces the copy of the stored hash.
+
+  @param[in]  Store         [Optional] The new store.  NULL drops the copy, so the next query reads
+                            the variable again.
+  @param[in]  StoreSize     Size of Store.
+
+**/
+STATIC
+VOID
+UpdateCachedStore (
+  IN  CONST UINT8  *Store OPTIONAL,
+  IN        UINTN  StoreSize
+  )
+{
+  if (mStore != NULL) {
+    FreePool (mStore);
+    mStore     = NULL;
+    mStoreSize = 0;
+  }
+
+  if ((Store != NULL) && (StoreSize > 0)) {
+    mStore = AllocateCopyPool (StoreSize, Store);
+    if (mStore != NULL) {
+      mStoreSize = StoreSize;
+    }
+  }
+} // UpdateCachedStore()
+
+/**
+  Gets the stored hash.  It is read from memory, and from the variable only when there is no
+  copy.
+
+  @param[out] Store         [Optional] A copy of the store.  The caller frees it.  NULL if only
+                            the size is needed.
+  @param[out] StoreSize     Size of the store.
+
+  @retval     EFI_SUCCESS   The store was found.
+  @retval     Others        Error from GetVariable2 ().
+
+**/
+STATIC
+EFI_STATUS
+GetStore (
+  OUT PASSWORD_HASH  *Store OPTIONAL,
+  OUT UINTN          *StoreSize
+  )
+{
+  EFI_STATUS     Status;
+  PASSWORD_HASH  Buffer = NULL;
+  UINTN          BufferSize = 0;
+
+  if (mStore != NULL) {
+    *StoreSize = mStoreSize;
+    if (Store != NULL) {
+      *Store = AllocateCopyPool (mStoreSize, mStore);
+      if (*Store == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+    }
+
+    return EFI_SUCCESS;
+  }
+
+  Status = GetVariable2 (
+             PASSWORD_STORE_ADMIN_VARIABLE_NAME,
+             &PASSWORD_STORE_ADMIN_NAMESPACE_GUID,
+             (VOID **)&Buffer,
+             &BufferSize
+             );
+  *StoreSize = BufferSize;
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  UpdateCachedStore (Buffer, BufferSize);
+
+  if (Store != NULL) {
+    *Store = Buffer;
+  } else {
+    FreePool (Buffer);
+  }
+
+  return EFI_SUCCESS;
+} // GetStore()
+
+/**
+  Set the password variable, and the copy of it.
+
+  @param[in]  PasswordHash        Pointer to the password hash
+  @param[in]  PasswordHashSize    Size of the password hash
+
+  @retval     EFI_SUCCESS   Password stored successfully.
+  @retval     Others        Something went wrong. Investigate further.
+**/
+STATIC
+EFI_STATUS
+LocalSetPassword (
+  IN  CONST UINT8  *PasswordHashValue,
+  IN        UINTN  PasswordHashSize
+  )
+{
+  EFI_STATUS     Status;
+  PASSWORD_HASH  PasswordHash;
+
+  if (PasswordHashValue == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  PasswordHash = (PASSWORD_HASH)PasswordHashValue;
+  Status       = PasswordPolicyValidatePasswordHash (PasswordHash, PasswordHashSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  // A new password has to be logged in with again.
+  EndSession ();
+
+  Status = gRT->SetVariable (
+                  PASSWORD_STORE_ADMIN_VARIABLE_NAME,
+                  &PASSWORD_STORE_ADMIN_NAMESPACE_GUID,
+                  PASSWORD_STORE_ADMIN_VARIABLE_ATTRS,
+                  PasswordHashSize,
+                  (VOID *)PasswordHash
+                  );
+  if (EFI_ERROR (Status)) {
+    // The variable may or may not have changed, so read it again next time.
+    UpdateCachedStore (NULL, 0);
+    Status = EFI_ABORTED;
+  } else {
+    UpdateCachedStore (PasswordHash, PasswordHashSize);
+  }
+
+  return Status;
+}
+
+/**
+  Determines whether a password is set.
+
+  NOTE: Will initialize the Password Store if it doesn't exist
+
+  @retval     TRUE    Password is set.
+  @retval     FALSE   Password is not set, or an error occurred preventing
+                      the check from completing successfully.
+
+**/
+STATIC
+BOOLEAN
+LocalIsPasswordSet (
+  VOID
+  )
+{
+  EFI_STATUS     Status;
+  BOOLEAN        Result = FALSE;
+  UINTN          BufferSize;
+  PASSWORD_HASH  Store = NULL;
+
+  // Attempt to retrieve the password.  Answer from the copy without allocating.
+  if (mStore != NULL) {
+    Status     = EFI_SUCCESS;
+    BufferSize = mStoreSize;
+  } else {
+    Status = GetStore (&Store, &BufferSize);
+  }
+
+  // If it's missing entirely, we need to set it.
+  if ((Status == EFI_NOT_FOUND) || (BufferSize == 0)) {
+    Status = LocalSetPassword (mNullPasswordHash, mNullPasswordHashSize);
+  }
+  // Determine whether the current password is valid.
+  else if (!EFI_ERROR (Status) && (BufferSize > 0)) {
+    // Determine whether the current password is the NULL password.
+    if ((BufferSize != mNullPasswordHashSize) &&
+        (CompareMem ((Store != NULL) ? Store : mStore, mNullPasswordHash, mNullPasswordHashSize) != 0))
+    {
+      Result = TRUE;
+    }
+  }
+
+  if (NULL != Store) {
+    FreePool (Store);
+  }
+
+  return Result;
+} // IsPasswordSet()
+
+/**
+  Validates a password against the current password.
+
+  If no password is currently set, will return FALSE.
+
+  NOTE: This function does NOT perform string validation on the password
+        being authenticated. This is to accommodate changing valid character sets.
+        Will still make sure that string does not exceed max buffer size.
+
+  NOTE: If the password matches a hash that was built with older hash parameters, the
+        stored hash is rebuilt with the current parameters.
+
+  NOTE: While a session lasts, the password that started it is accepted without the hash,
+        unless the caller asks for a new session.
+
+  @param[in]  Password  String being evaluated.
+  @param[out] Token     [Optional] Receives the token of a new session if Password matches a
+                        set password.  Zeroed in every other case.
+
+  @retval     TRUE      Password matches the stored password for Handle.
+  @retval     TRUE      No password is currently set.
+  @retval     FALSE     Password is NULL and a password is set.
+  @retval     FALSE     Supplied Password does not match stored password for Handle.
+
+**/
+STATIC
+BOOLEAN
+LocalAuthenticatePassword (
+  IN  CONST CHAR16                  *Password,
+  OUT PASSWORD_STORE_SESSION_TOKEN  *Token OPTIONAL
+  )
+{
+  EFI_STATUS     Status = EFI_SUCCESS;
+  BOOLEAN        Result = FALSE;
+  UINTN          DataSize;
+  UINTN          CurStoreSize = 0;
+  CHAR16         TempPassword[PW_MAX_LENGTH + 1];       // Maximum password length plus a NULL terminator.
+  PASSWORD_HASH  CurStore = NULL;
+  PASSWORD_HASH  NewStore = NULL;
+
+  if (Token != NULL) {
+    ZeroMem (Token, sizeof (*Token));
+  }
+
+  // If there is no password set, all accesses should authenticate.
+  if (!LocalIsPasswordSet ()) {
+    return TRUE;
+  }
+
+  // A missing password is not a login.  Earlier logins are only honored through a session token.
+  if (Password == NULL) {
+    return FALSE;
+  }
+
+  //
+  // Step 1: Retrieve the current store.
+  Status = GetStore (&CurStore, &DataSize);
+  // NOTE: DataSize should now reflect the size of the variable when it was saved.
+  if (EFI_ERROR (Status)) {
+    return FALSE;
+  }
+
+  CurStoreSize = DataSize;
+
+  // Prep the password for evaluation.
+  PasswordPolicySafeCopyPassword (
+    TempPassword,
+    ARRAY_SIZE (TempPassword),
+    Password
+    );
+
+  //
+  // Step 2: The password that started the current session needs no hash.
+  if ((Token == NULL) && IsSessionPassword (CurStore, CurStoreSize, TempPassword)) {
+    PasswordPolicyCleansePwBuffer (TempPassword, sizeof (TempPassword));
+    FreePool (CurStore);
+    return TRUE;
+  }
+
+  //
+  // Step 3: Build out the rest of the store so that we can compare the keys.
+  Status = PasswordPolicyGeneratePasswordHash (
+             CurStore,                                        // Use existing Version and Salt
+             TempPassword,                                    // Password
+             &NewStore,                                       // Store
+             &DataSize
+             );
+
+  //
+  // Step 4: Compare the store.
+  // NOTE: Sure, it would be faster to just compare the key, but I don't think this hurts anything.
+  if (!EFI_ERROR (Status)) {
+    Result = (CompareMem (CurStore, NewStore, DataSize) == 0);
+  }
+
+  if (NULL != NewStore) {
+    FreePool (NewStore);
+    NewStore = NULL;
+  }
+
+  //
+  // Step 5: While the password is at hand, bring an old hash up to the current parameters.
+  // The password has already been authenticated, so a failure here is only logged.
+  if (Result && !PasswordPolicyIsPasswordHashCurrent (CurStore, CurStoreSize)) {
+    Status = PasswordPolicyGeneratePasswordHash (NULL, TempPassword, &NewStore, &DataSize);
+    if (!EFI_ERROR (Status)) {
+      Status = LocalSetPassword (NewStore, DataSize);
+    }
+
+    DEBUG ((DEBUG_INFO, "%a - Rehashed the password with the current parameters. Status = %r.\n", __FUNCTION__, Status));
+
+    // Storing the new hash ended any session, so a new one is bound to the new hash.
+    if (!EFI_ERROR (Status)) {
+      FreePool (CurStore);
+      CurStore     = NewStore;
+      CurStoreSize = DataSize;
+      NewStore     = NULL;
+    }
+  }
+
+  //
+  // Step 6: Start a session for a caller that wants one, so that its later checks don't need the hash.
+  if (Result && (Token != NULL)) {
+    StartSession (CurStore, CurStoreSize, TempPassword, Token);
+  }
+
+  // Always put away your toys.
+  PasswordPolicyCleansePwBuffer (TempPassword, sizeof (TempPassword));
+
+  if (NULL != CurStore) {
+    FreePool (CurStore);
+  }
+
+  if (NULL != NewStore) {
+    FreePool (NewStore);
+  }
+
+  return Result;
+} // AuthenticatePassword()
+
+/**
+  Deletes the password variable and the copy of it, and ends the session.
+
+  @retval     EFI_SUCCESS   Reset is complete.
+  @retval     Others        Something went wrong. Investigate further.
+
+**/
+STATIC
+EFI_STATUS
+LocalResetPassword (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  CHAR16      *PasswordName;
+
+  EndSession ();
+  UpdateCachedStore (NULL, 0);
+
+  // Attempt to delete the password.
+  PasswordName = (CHAR16 *)mPasswordName;
+  Status       = gRT->SetVariable (
+                        PasswordName,
+                        &PASSWORD_STORE_ADMIN_NAMESPACE_GUID,
+                        0,
+                        0,
+                        NULL
+                        );
+  if (Status == EFI_NOT_FOUND) {
+    Status = EFI_SUCCESS;
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - Failed to properly reset password! Status = %r.\n", __FUNCTION__, Status));
+    ASSERT (FALSE);
+  }
+
+  return Status;
+} // LocalResetPassword()
+
+/**
+  PasswordStoreProtocol.IsPasswordSet.
+
+  @param[in]  This      Not used.
+
+  @retval     TRUE      A password is set.
+  @retval     FALSE     No password is set, or the store could not be read.
+
+**/
+STATIC
+BOOLEAN
+EFIAPI
+ProtocolIsPasswordSet (
+  IN  PASSWORD_STORE_PROTOCOL  *This
+  )
+{
+  return LocalIsPasswordSet ();
+}
+
+/**
+  PasswordStoreProtocol.AuthenticatePassword.
+
+  @param[in]  This      Not used.
+  @param[in]  Password  Password to check.
+  @param[out] Token     [Optional] Receives the token of a new session.
+
+  @retval     TRUE      The password is accepted.
+  @retval     FALSE     Not.
+
+**/
+STATIC
+BOOLEAN
+EFIAPI
+ProtocolAuthenticatePassword (
+  IN  PASSWORD_STORE_PROTOCOL       *This,
+  IN  CONST CHAR16                  *Password,
+  OUT PASSWORD_STORE_SESSION_TOKEN  *Token OPTIONAL
+  )
+{
+  return LocalAuthenticatePassword (Password, Token);
+}
+
+/**
+  PasswordStoreProtocol.AuthenticateSession.
+
+  @param[in]  This      Not used.
+  @param[in]  Token     Token from AuthenticatePassword.
+
+  @retval     TRUE      The token is accepted, or no password is set.
+  @retval     FALSE     Not.
+
+**/
+STATIC
+BOOLEAN
+EFIAPI
+ProtocolAuthenticateSession (
+  IN  PASSWORD_STORE_PROTOCOL             *This,
+  IN  CONST PASSWORD_STORE_SESSION_TOKEN  *Token
+  )
+{
+  if (!LocalIsPasswordSet ()) {
+    return TRUE;
+  }
+
+  // LocalIsPasswordSet () leaves a copy of the store.
+  if ((Token == NULL) || (mStore == NULL)) {
+    return FALSE;
+  }
+
+  return IsSessionValid (mStore, mStoreSize, Token);
+}
+
+/**
+  PasswordStoreProtocol.EndSession.
+
+  @param[in]  This      Not used.
+  @param[in]  Token     Token from AuthenticatePassword.
+
+**/
+STATIC
+VOID
+EFIAPI
+ProtocolEndSession (
+  IN  PASSWORD_STORE_PROTOCOL             *This,
+  IN  CONST PASSWORD_STORE_SESSION_TOKEN  *Token
+  )
+{
+  if ((Token != NULL) && (mStore != NULL) && IsSessionValid (mStore, mStoreSize, Token)) {
+    EndSession ();
+  }
+}
+
+/**
+  PasswordStoreProtocol.SetPassword.
+
+  @param[in]  This              Not used.
+  @param[in]  PasswordHash      The password hash.
+  @param[in]  PasswordHashSize  Size of PasswordHash.
+
+  @retval     EFI_SUCCESS   Password stored successfully.
+  @retval     Others        Something went wrong. Investigate further.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+ProtocolSetPassword (
+  IN  PASSWORD_STORE_PROTOCOL  *This,
+  IN  CONST UINT8              *PasswordHash,
+  IN  UINTN                    PasswordHashSize
+  )
+{
+  return LocalSetPassword (PasswordHash, PasswordHashSize);
+}
+
+/**
+  PasswordStoreProtocol.Reset.
+
+  @param[in]  This      Not used.
+
+  @retval     EFI_SUCCESS   Reset is complete.
+  @retval     Others        Something went wrong. Investigate further.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+ProtocolReset (
+  IN  PASSWORD_STORE_PROTOCOL  *This
+  )
+{
+  return LocalResetPassword ();
+}
+
+STATIC PASSWORD_STORE_PROTOCOL  mPasswordStoreProtocol = {
+  PASSWORD_STORE_PROTOCOL_REVISION,
+  ProtocolIsPasswordSet,
+  ProtocolAuthenticatePassword,
+  ProtocolSetPassword,
+  ProtocolReset,
+  ProtocolAuthenticateSession,
+  ProtocolEndSession
+};
+
+/**
+  Initializes the password variable.  The variable read here becomes the copy of the store.
+
+  @retval     EFI_SUCCESS   Initialization is complete.
+  @retval     Others        Something went wrong. Investigate further.
+
+**/
+STATIC
+EFI_STATUS
+InitializeStore (
+  VOID
+  )
+{
+  EFI_STATUS     Status;
+  CHAR16         *PasswordName;
+  UINT32         Attributes;
+  UINTN          DataSize;
+  PASSWORD_HASH  Store;
+
+  PasswordName = (CHAR16 *)mPasswordName;
+  // 1. Load Variable
+  Status = GetVariable3 (
+             PasswordName,
+             &PASSWORD_STORE_ADMIN_NAMESPACE_GUID,
+             (VOID **)&Store,
+             &DataSize,
+             &Attributes
+             );
+  if (!EFI_ERROR (Status)) {
+    UpdateCachedStore (Store, DataSize);
+    FreePool (Store);
+  }
+
+  // Make sure that password is found and has the correct attributes.
+  if ((Status == EFI_NOT_FOUND) || (Attributes != PASSWORD_STORE_ADMIN_VARIABLE_ATTRS)) {
+    // If invalid, initialize it.
+    Status = LocalSetPassword (mNullPasswordHash, mNullPasswordHashSize);
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - Failed to properly initialize password! Status = %r.\n", __FUNCTION__, Status));
+    ASSERT (FALSE);
+  }
+
+  return Status;
+} // InitializeStore()
+
+/**
+  Entry point of the driver.  Initializes the password variable and installs
+  PasswordStoreProtocol.
+
+  There can only be one store.  The driver does not start if the protocol is already installed.
+
+  @param  ImageHandle   The firmware allocated handle for the EFI image.
+  @param  SystemTable   A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS           The protocol is installed.
+  @retval EFI_ALREADY_STARTED   Another module already installed the protocol.
+  @retval Others                The driver could not start.
+
+**/
+EFI_STATUS
+EFIAPI
+PasswordStoreDxeEntry (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS  Status;
+  VOID        *Interface;
+
+  Status = gBS->LocateProtocol (&gOemPasswordStoreProtocolGuid, NULL, &Interface);
+  if (!EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: - PasswordStoreProtocol is already installed.\n", __FUNCTION__));
+    return EFI_ALREADY_STARTED;
+  }
+
+  Status = PasswordPolicyGeneratePasswordHash (NULL, NULL, &mNullPasswordHash, &mNullPasswordHashSize);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: - Unable to build the no-password hash. %r\n", __FUNCTION__, Status));
+    return Status;
+  }
+
+  // There is an assumption that the Password Variable will be locked.  That will
+  // be up to the platform.  The copy is only updated by writes through this driver.
+  InitializeStore ();
+
+  // Sessions end at ReadyToBoot.
+  Status = EfiCreateEventReadyToBootEx (TPL_CALLBACK, PasswordStoreReadyToBoot, NULL, &mReadyToBootEvent);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: - Unable to register for ReadyToBoot. Logins won't be cached. %r\n", __FUNCTION__, Status));
+    mSessionExpired = TRUE;
+  }
+
+  Status = gBS->InstallMultipleProtocolInterfaces (
+                  &mPasswordStoreHandle,
+                  &gOemPasswordStoreProtocolGuid,
+                  &mPasswordStoreProtocol,
+                  NULL
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: - Unable to install PasswordStoreProtocol. %r\n", __FUNCTION__, Status));
+    if (!mSessionExpired) {
+      gBS->CloseEvent (mReadyToBootEvent);
+    }
+  }
+
+  return Status;
+} // PasswordStoreDxeEntry()
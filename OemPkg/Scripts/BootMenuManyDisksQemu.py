@@ -0,0 +1,255 @@
+# @file
+# Boots a QEMU virtual machine with many virtio disks, to check that the BootMenu boot order list
+# shows a boot option for each of them.
+#
+# BDS creates a boot option for every block device, so each blank virtio disk becomes one. The
+# boot order list is built when Boot configuration is opened on FrontPage. The script waits for
+# FrontPage in the firmware debug log, opens Boot configuration with keys sent through the QEMU
+# monitor, and quits QEMU once RebuildOrderList() has logged the list. It then checks the last
+# list that was built. The firmware must be a DEBUG build that boots to FrontPage.
+#
+# Usage:
+#   BootMenuManyDisksQemu.py --firmware <QEMU_EFI.fd>                  AARCH64 virt machine.
+#   BootMenuManyDisksQemu.py --arch X64 --firmware <OVMF.fd>           X64 q35 machine.
+#   BootMenuManyDisksQemu.py --firmware <fd> --disks 64 --timeout 300  Give up after 300 s.
+#   BootMenuManyDisksQemu.py --firmware <fd> --keys tab,down,ret       Another FrontPage menu.
+#   BootMenuManyDisksQemu.py --check <log>                             Only check an earlier log.
+#
+# Copyright (c) Microsoft Corporation.
+# SPDX-License-Identifier: BSD-2-Clause-Patent
+##
+import argparse
+import os
+import re
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+DISK_SIZE = 1024 * 1024
+
+# Slots used on each pci-bridge. Slot 0 is left free.
+BRIDGE_SLOTS = 31
+
+# Lines logged by RebuildOrderList() in OemPkg/BootMenu/BootMenu.c.
+OPTION_LINE = re.compile(r"RebuildOrderList Indx=(\d+), Hash=([0-9a-fA-F]+), Attr=[0-9a-fA-F]+, (.*)")
+TRUNCATED_LINE = re.compile(r"RebuildOrderList More than \d+ boot options")
+
+# Logged by FrontPage once its forms are set up.
+FRONT_PAGE_LINE = re.compile(r"INFO \[FP\]: FpInitializeFrontPage took")
+
+# Boot configuration is the third entry of the FrontPage top menu, which starts on PC info.
+DEFAULT_KEYS = "down,down,ret"
+
+# Seconds to wait after FrontPage is up before keys are sent, and for the log to go quiet after
+# the list was built.
+SETTLE = 5
+QUIET = 3
+
+MACHINES = {
+    "AARCH64": ["qemu-system-aarch64", "-machine", "virt", "-cpu", "cortex-a57"],
+    "X64": ["qemu-system-x86_64", "-machine", "q35"],
+}
+
+
+def disk_args(directory, count):
+    args = []
+    for index in range(count):
+        bridge = index // BRIDGE_SLOTS
+        if index % BRIDGE_SLOTS == 0:
+            args += ["-device", "pci-bridge,id=bridge%d,chassis_nr=%d" % (bridge, bridge + 1)]
+
+        path = os.path.join(directory, "disk%03d.img" % index)
+        with open(path, "wb") as f:
+            f.truncate(DISK_SIZE)
+
+        args += [
+            "-drive", "if=none,id=disk%d,format=raw,file=%s" % (index, path),
+            "-device", "virtio-blk-pci,drive=disk%d,bus=bridge%d,addr=%d" % (index, bridge, (index % BRIDGE_SLOTS) + 1),
+        ]
+
+    return args
+
+
+def log_args(arch, log):
+    # ArmVirtQemu writes DEBUG output to the serial port. OVMF writes it to the debug console.
+    if arch == "X64":
+        return ["-serial", "null", "-debugcon", "file:%s" % log, "-global", "isa-debugcon.iobase=0x402"]
+
+    return ["-serial", "file:%s" % log]
+
+
+class Monitor:
+    """The QEMU human monitor, on a UNIX socket."""
+
+    def __init__(self, path):
+        self.path = path
+        self.sock = None
+
+    def command(self, line):
+        if self.sock is None:
+            self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            self.sock.connect(self.path)
+        self.sock.sendall((line + "\n").encode())
+        time.sleep(0.2)
+
+    def close(self):
+        if self.sock is not None:
+            self.sock.close()
+
+
+def log_size(log):
+    try:
+        return os.path.getsize(log)
+    except OSError:
+        return 0
+
+
+def wait_for_line(log, pattern, process, deadline):
+    # Poll the debug log until a line matches. Returns False if QEMU exits or time runs out.
+    offset = 0
+    pending = ""
+    while time.monotonic() < deadline and process.poll() is None:
+        if log_size(log) > offset:
+            with open(log, "r", errors="replace") as f:
+                f.seek(offset)
+                data = f.read()
+                offset = f.tell()
+            lines = (pending + data).split("\n")
+            pending = lines.pop()
+            if any(pattern.search(line) for line in lines):
+                return True
+        time.sleep(0.5)
+
+    return False
+
+
+def wait_for_quiet(log, process, deadline):
+    # RebuildOrderList() logs one line per option. Wait until the log stops growing.
+    size = log_size(log)
+    quiet_since = time.monotonic()
+    while time.monotonic() < deadline and process.poll() is None:
+        time.sleep(0.5)
+        if log_size(log) != size:
+            size = log_size(log)
+            quiet_since = time.monotonic()
+        elif time.monotonic() - quiet_since >= QUIET:
+            return
+
+
+def drive(command, log, monitor_path, keys, timeout):
+    # Runs QEMU, opens Boot configuration and quits once the boot order list was logged.
+    if os.path.exists(log):
+        os.remove(log)
+
+    deadline = time.monotonic() + timeout
+    process = subprocess.Popen(command)
+    monitor = Monitor(monitor_path)
+    try:
+        if not wait_for_line(log, FRONT_PAGE_LINE, process, deadline):
+            print("FrontPage did not start within %d seconds." % timeout)
+            return
+
+        time.sleep(SETTLE)
+        for key in keys:
+            monitor.command("sendkey %s" % key)
+
+        if wait_for_line(log, OPTION_LINE, process, deadline):
+            wait_for_quiet(log, process, deadline)
+        else:
+            print("Boot configuration was not opened within %d seconds." % timeout)
+    finally:
+        if process.poll() is None:
+            try:
+                monitor.command("quit")
+                process.wait(10)
+            except (OSError, subprocess.TimeoutExpired):
+                process.kill()
+                process.wait()
+        monitor.close()
+
+
+def last_order_list(log):
+    # Each rebuild starts over, so keep only the options of the last one.
+    options = []
+    truncated = False
+    previous = None
+    with open(log, "r", errors="replace") as f:
+        for line in f:
+            match = OPTION_LINE.search(line)
+            if match:
+                index = int(match.group(1))
+                if previous is not None and index <= previous:
+                    options = []
+                    truncated = False
+                previous = index
+                options.append((int(match.group(2), 16), match.group(3).strip()))
+            elif TRUNCATED_LINE.search(line):
+                truncated = True
+
+    return options, truncated
+
+
+def check(log, disks):
+    options, truncated = last_order_list(log)
+    if not options:
+        print("FAIL: No boot order list in %s." % log)
+        return 1
+
+    print("The last boot order list shows %d boot options." % len(options))
+    if truncated:
+        print("FAIL: BootMenu dropped boot options from the list.")
+        return 1
+
+    if len(options) < disks:
+        print("FAIL: %d virtio disks, but only %d boot options are shown." % (disks, len(options)))
+        return 1
+
+    print("PASS")
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Check the BootMenu boot order list with many virtio disks.")
+    parser.add_argument("--firmware", help="firmware image passed to QEMU with -bios")
+    parser.add_argument("--arch", choices=sorted(MACHINES), default="AARCH64", help="firmware architecture")
+    parser.add_argument("--disks", type=int, default=40, help="number of virtio disks (default: 40)")
+    parser.add_argument("--qemu", help="QEMU executable (default: qemu-system-<arch> from PATH)")
+    parser.add_argument("--memory", default="2048", help="guest memory in MB (default: 2048)")
+    parser.add_argument("--timeout", type=int, default=600, help="seconds before QEMU is stopped (default: 600)")
+    parser.add_argument("--keys", default=DEFAULT_KEYS, help="QEMU key names that open Boot configuration (default: %s)" % DEFAULT_KEYS)
+    parser.add_argument("--display", action="store_true", help="show the QEMU display")
+    parser.add_argument("--log", default="BootMenuManyDisks.log", help="firmware debug log")
+    parser.add_argument("--check", metavar="LOG", help="only check an existing debug log")
+    args = parser.parse_args()
+
+    if args.check:
+        return check(args.check, args.disks)
+
+    if not args.firmware:
+        parser.error("--firmware is required unless --check is given")
+
+    command = list(MACHINES[args.arch])
+    if args.qemu:
+        command[0] = args.qemu
+
+    command += ["-m", args.memory, "-bios", args.firmware, "-net", "none"]
+    command += log_args(args.arch, args.log)
+    if args.arch == "AARCH64":
+        command += ["-device", "virtio-gpu-pci", "-device", "qemu-xhci", "-device", "usb-kbd"]
+    if not args.display:
+        command += ["-display", "none"]
+
+    with tempfile.TemporaryDirectory(prefix="BootMenuDisks") as directory:
+        monitor = os.path.join(directory, "monitor.sock")
+        command += ["-monitor", "unix:%s,server,nowait" % monitor]
+        command += disk_args(directory, args.disks)
+        print(" ".join(command))
+        drive(command, args.log, monitor, args.keys.split(","), args.timeout)
+
+    return check(args.log, args.disks)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
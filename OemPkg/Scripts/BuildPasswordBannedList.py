@@ -0,0 +1,79 @@
+# @file
+# Builds the banned password list that PasswordPolicyLib checks new passwords against.
+#
+# The list is a Bloom filter.  Its layout is defined in
+# OemPkg/Library/PasswordPolicyLib/PasswordPolicyRules.h.  Add the output to an FV as the raw
+# section of the file named by PcdPasswordBannedListFile:
+#
+#   FILE FREEFORM = PCD(gOemPkgTokenSpaceGuid.PcdPasswordBannedListFile) {
+#     SECTION RAW = $(PLATFORM_PACKAGE)/PasswordBannedList.bin
+#   }
+#
+# Usage:
+#   BuildPasswordBannedList.py <word list> <output>                  One password per line.
+#   BuildPasswordBannedList.py <word list> <output> --fp-rate 0.0001  Target false positive rate.
+#
+# Copyright (c) Microsoft Corporation.
+# SPDX-License-Identifier: BSD-2-Clause-Patent
+##
+import argparse
+import hashlib
+import math
+import struct
+import sys
+
+SIGNATURE = struct.unpack("<I", b"PWBL")[0]
+VERSION = 1
+HEADER = struct.Struct("<IHHI")
+MAX_HASHES = 32
+
+
+def fold(password):
+    # Only ASCII letters are folded, as in the firmware.
+    return "".join(chr(ord(c) + 32) if "A" <= c <= "Z" else c for c in password)
+
+
+def bit_indexes(password, hash_count, bit_count):
+    digest = hashlib.sha256(fold(password).encode("utf-16-le")).digest()
+    h1, h2 = struct.unpack_from("<QQ", digest)
+    h2 |= 1
+    return [((h1 + i * h2) & 0xFFFFFFFFFFFFFFFF) % bit_count for i in range(hash_count)]
+
+
+def build(passwords, fp_rate):
+    count = max(len(passwords), 1)
+    bit_count = int(math.ceil(-count * math.log(fp_rate) / (math.log(2) ** 2)))
+    bit_count = max((bit_count + 7) // 8 * 8, 8)
+    hash_count = min(max(int(round(bit_count / count * math.log(2))), 1), MAX_HASHES)
+
+    bits = bytearray(bit_count // 8)
+    for password in passwords:
+        for bit in bit_indexes(password, hash_count, bit_count):
+            bits[bit // 8] |= 1 << (bit % 8)
+
+    return HEADER.pack(SIGNATURE, VERSION, hash_count, bit_count) + bytes(bits), hash_count, bit_count
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build the banned password Bloom filter.")
+    parser.add_argument("wordlist", help="text file with one password per line")
+    parser.add_argument("output", help="binary file to write")
+    parser.add_argument("--fp-rate", type=float, default=0.001, help="false positive rate (default: 0.001)")
+    args = parser.parse_args()
+
+    if not 0 < args.fp_rate < 1:
+        parser.error("--fp-rate must be between 0 and 1")
+
+    with open(args.wordlist, "r", encoding="utf-8") as f:
+        passwords = sorted({line.rstrip("\r\n") for line in f if line.strip()})
+
+    data, hash_count, bit_count = build(passwords, args.fp_rate)
+    with open(args.output, "wb") as f:
+        f.write(data)
+
+    print("%d passwords, %d bytes, %d hashes" % (len(passwords), len(data), hash_count))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
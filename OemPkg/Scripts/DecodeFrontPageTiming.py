@@ -0,0 +1,90 @@
+# @file
+# Decodes the FrontPageTiming variable published by FrontPage.
+#
+# The record layout is defined in OemPkg/Include/Guid/FrontPageTiming.h.
+#
+# Usage:
+#   DecodeFrontPageTiming.py                    Read the variable through Linux efivarfs.
+#   DecodeFrontPageTiming.py <file>             Decode a raw variable dump or an efivarfs file.
+#   DecodeFrontPageTiming.py --csv [<file>]     Print comma separated values, one row per phase.
+#
+# Copyright (c) Microsoft Corporation.
+# SPDX-License-Identifier: BSD-2-Clause-Patent
+##
+import argparse
+import struct
+import sys
+
+EFIVARFS_PATH = "/sys/firmware/efi/efivars/FrontPageTiming-a41ca8f9-7b4d-4e97-86a6-2b66b1a72ed3"
+
+SIGNATURE = struct.unpack("<I", b"FPTM")[0]
+HEADER = struct.Struct("<IHHQ")
+ENTRY = struct.Struct("<IIQQ")
+
+# FRONT_PAGE_TIMING_PHASE, in order.
+PHASE_NAMES = [
+    "FirstPaint",
+    "ConnectConsoles",
+    "ConnectAll",
+    "SetGraphicsConsoleMode",
+    "InitializeUIToolKit",
+    "InitializeFrontPage",
+    "SmbiosStrings",
+    "FirmwareVersions",
+    "SecureBootStatus",
+    "PasswordChallenge",
+    "UserAlerts",
+]
+
+
+def decode(data):
+    # efivarfs files start with the 4 byte variable attributes.
+    if len(data) >= 4 + HEADER.size and struct.unpack_from("<I", data, 4)[0] == SIGNATURE:
+        data = data[4:]
+
+    if len(data) < HEADER.size:
+        raise ValueError("record is too short")
+
+    signature, version, count, entry_us = HEADER.unpack_from(data, 0)
+    if signature != SIGNATURE:
+        raise ValueError("bad signature 0x%08X" % signature)
+    if len(data) < HEADER.size + count * ENTRY.size:
+        raise ValueError("record holds fewer than %d entries" % count)
+
+    entries = []
+    for index in range(count):
+        phase, runs, start_us, duration_us = ENTRY.unpack_from(data, HEADER.size + index * ENTRY.size)
+        name = PHASE_NAMES[phase] if phase < len(PHASE_NAMES) else "Phase%d" % phase
+        entries.append((name, runs, start_us, duration_us))
+
+    return version, entry_us, entries
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the FrontPage startup timing record.")
+    parser.add_argument("file", nargs="?", default=EFIVARFS_PATH, help="variable dump (default: efivarfs)")
+    parser.add_argument("--csv", action="store_true", help="print comma separated values")
+    args = parser.parse_args()
+
+    with open(args.file, "rb") as f:
+        version, entry_us, entries = decode(f.read())
+
+    if args.csv:
+        print("Phase,Count,StartUs,DurationUs")
+        for name, runs, start_us, duration_us in entries:
+            print("%s,%d,%d,%d" % (name, runs, start_us, duration_us))
+        return 0
+
+    print("FrontPage timing record version %d, entry at %d us" % (version, entry_us))
+    print("%-24s %6s %12s %12s" % ("Phase", "Count", "Start (us)", "Total (us)"))
+    for name, runs, start_us, duration_us in entries:
+        if runs == 0:
+            print("%-24s %6s %12s %12s" % (name, "-", "-", "-"))
+        else:
+            print("%-24s %6d %12d %12d" % (name, runs, start_us, duration_us))
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())